@@ -26,6 +26,10 @@ RETRO_BEGIN_DECLS
 /* So we don't get complete line-noise when fast-forwarding audio. */
 #define AUDIO_CHUNK_SIZE_NONBLOCKING   2048
 
+/* Frames taken through every stage of the audio pipeline
+ * at once, so that intermediate buffers stay in L1. */
+#define AUDIO_FLUSH_BLOCK_FRAMES       256
+
 #define AUDIO_MAX_RATIO                16
 #define AUDIO_MIN_RATIO                0.0625
 
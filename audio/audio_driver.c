@@ -390,50 +390,41 @@ bool audio_driver_find_driver(
 }
 
 /**
- * Writes audio samples to audio driver's output.
- * Will first perform DSP processing (if enabled) and resampling.
+ * Runs one block of audio through the DSP filter (if enabled), the
+ * resampler and the mixer. The block is small enough that the
+ * intermediate buffers stay in L1 from one stage to the next.
  *
  * @param audio_st The overall state of the audio driver.
- * @param slowmotion_ratio The factor by which slow motion extends the core's runtime
- * (e.g. a value of 2 means the core is running at half speed).
- * @param audio_fastforward_mute True if no audio should be output while the game is in fast-forward.
- * @param data Audio output data that was most recently provided by the core.
+ * @param src_data Resampler parameters; \c data_out must point to
+ * the block's place in the output buffer. On return, holds the
+ * number of frames written there.
+ * @param data The block's input samples.
  * @param samples The size of \c data, in samples.
- * @param is_slowmotion True if the player is currently running the game in slow motion.
- * @param is_fastmotion True if the player is currently running the game in fast-forward.
+ * @param gain Volume to apply to the input.
+ * @param passthrough True if the ratio is exactly 1.0
+ * and the resampler can be skipped.
  **/
-static void audio_driver_flush(
+static void audio_driver_flush_block(
       audio_driver_state_t *audio_st,
-      float slowmotion_ratio,
-      bool audio_fastforward_mute,
+      struct resampler_data *src_data,
       const int16_t *data, size_t samples,
-      bool is_slowmotion, bool is_fastforward)
+      float gain, bool passthrough)
 {
-   struct resampler_data src_data;
-   float audio_volume_gain           = (audio_st->mute_enable ||
-         (audio_fastforward_mute && is_fastforward))
-               ? 0.0f
-               : audio_st->volume_gain;
-
-   src_data.data_out                 = NULL;
-   src_data.output_frames            = 0;
-   /* We'll assign a proper output to the resampler later in this function */
-
-   convert_s16_to_float(audio_st->input_data, data, samples,
-         audio_volume_gain);
-   /* The resampler operates on floating-point frames,
-    * so we gotta convert the input first */
+   float *out                        = (float*)src_data->data_out;
 
-   src_data.data_in                  = audio_st->input_data;
-   src_data.input_frames             = samples >> 1;
-   /* Remember, we allocated buffers that are twice as big as needed.
-    * (see audio_driver_init) */
+   src_data->data_in                 = audio_st->input_data;
+   src_data->input_frames            = samples >> 1;
+   src_data->output_frames           = 0;
 
 #ifdef HAVE_DSP_FILTER
    if (audio_st->dsp)
    { /* If we want to process our audio for reasons besides resampling... */
       struct retro_dsp_data dsp_data;
 
+      /* The resampler operates on floating-point frames,
+       * so we gotta convert the input first */
+      convert_s16_to_float(audio_st->input_data, data, samples, gain);
+
       dsp_data.input                 = audio_st->input_data;
       dsp_data.input_frames          = (unsigned)(samples >> 1);
       dsp_data.output                = NULL;
@@ -448,15 +439,92 @@ static void audio_driver_flush(
 
       if (dsp_data.output)
       { /* If the DSP filter succeeded... */
-         src_data.data_in            = dsp_data.output;
-         src_data.input_frames       = dsp_data.output_frames;
+         src_data->data_in           = dsp_data.output;
+         src_data->input_frames      = dsp_data.output_frames;
          /* Then let's pass the DSP's output to the resampler's input */
       }
+
+      if (passthrough)
+      {
+         memcpy(out, src_data->data_in,
+               src_data->input_frames * 2 * sizeof(float));
+         src_data->output_frames     = src_data->input_frames;
+      }
+      else
+         audio_st->resampler->process(
+               audio_st->resampler_data, src_data);
+   }
+   else
+#endif
+   if (passthrough)
+   {
+      /* Nothing to resample, convert straight into the output */
+      convert_s16_to_float(out, data, samples, gain);
+      src_data->output_frames        = src_data->input_frames;
+   }
+   else
+   {
+      convert_s16_to_float(audio_st->input_data, data, samples, gain);
+      audio_st->resampler->process(
+            audio_st->resampler_data, src_data);
+   }
+
+#ifdef HAVE_AUDIOMIXER
+   if (audio_st->flags & AUDIO_FLAG_MIXER_ACTIVE)
+   {
+      bool override                       = true;
+      float mixer_gain                    = 0.0f;
+      bool audio_driver_mixer_mute_enable = audio_st->mixer_mute_enable;
+
+      if (!audio_driver_mixer_mute_enable)
+      {
+         if (audio_st->mixer_volume_gain == 1.0f)
+            override                      = false;
+         mixer_gain                       = audio_st->mixer_volume_gain;
+
+      }
+      audio_mixer_mix(out, src_data->output_frames, mixer_gain, override);
    }
 #endif
+}
+
+/**
+ * Writes audio samples to audio driver's output.
+ * Will first perform DSP processing (if enabled) and resampling.
+ *
+ * @param audio_st The overall state of the audio driver.
+ * @param slowmotion_ratio The factor by which slow motion extends the core's runtime
+ * (e.g. a value of 2 means the core is running at half speed).
+ * @param audio_fastforward_mute True if no audio should be output while the game is in fast-forward.
+ * @param data Audio output data that was most recently provided by the core.
+ * @param samples The size of \c data, in samples.
+ * @param is_slowmotion True if the player is currently running the game in slow motion.
+ * @param is_fastmotion True if the player is currently running the game in fast-forward.
+ **/
+static void audio_driver_flush(
+      audio_driver_state_t *audio_st,
+      float slowmotion_ratio,
+      bool audio_fastforward_mute,
+      const int16_t *data, size_t samples,
+      bool is_slowmotion, bool is_fastforward)
+{
+   struct resampler_data src_data;
+   size_t i;
+   size_t output_frames              = 0;
+   bool passthrough                  = false;
+   bool convert_s16                  = !(audio_st->flags & AUDIO_FLAG_USE_FLOAT);
+   /* audio_driver_sample() hands us the conversion buffer as input,
+    * converting the output back to s16 has to wait until the end */
+   bool convert_blocks               = convert_s16
+         && (data != audio_st->output_samples_conv_buf);
+   float audio_volume_gain           = (audio_st->mute_enable ||
+         (audio_fastforward_mute && is_fastforward))
+               ? 0.0f
+               : audio_st->volume_gain;
 
-   src_data.data_out                 = audio_st->output_samples_buf;
-   /* Now the resampler will write to the driver state's scratch buffer */
+   src_data.data_out                 = NULL;
+   src_data.output_frames            = 0;
+   src_data.input_frames             = samples >> 1;
 
    /* Count samples. */
    {
@@ -528,47 +596,48 @@ static void audio_driver_flush(
       audio_st->last_flush_time = flush_time;
    }
 
-   audio_st->resampler->process(
-         audio_st->resampler_data, &src_data);
+   /* Core and output rates match and rate control is off:
+    * the ratio can't drift, so the resampler is never needed */
+   passthrough              = !(audio_st->flags & AUDIO_FLAG_CONTROL)
+         && (src_data.ratio == 1.0);
 
-#ifdef HAVE_AUDIOMIXER
-   if (audio_st->flags & AUDIO_FLAG_MIXER_ACTIVE)
+   /* Run the audio through every stage one block at a time */
+   for (i = 0; i < samples; i += AUDIO_FLUSH_BLOCK_FRAMES * 2)
    {
-      bool override                       = true;
-      float mixer_gain                    = 0.0f;
-      bool audio_driver_mixer_mute_enable = audio_st->mixer_mute_enable;
+      size_t block_samples  = MIN(AUDIO_FLUSH_BLOCK_FRAMES * 2, samples - i);
 
-      if (!audio_driver_mixer_mute_enable)
-      {
-         if (audio_st->mixer_volume_gain == 1.0f)
-            override                      = false;
-         mixer_gain                       = audio_st->mixer_volume_gain;
+      src_data.data_out     = audio_st->output_samples_buf + output_frames * 2;
+      audio_driver_flush_block(audio_st, &src_data,
+            data + i, block_samples, audio_volume_gain, passthrough);
 
-      }
-      audio_mixer_mix(audio_st->output_samples_buf,
-            src_data.output_frames, mixer_gain, override);
+      if (convert_blocks)
+         convert_float_to_s16(
+               audio_st->output_samples_conv_buf + output_frames * 2,
+               (const float*)src_data.data_out, src_data.output_frames * 2);
+
+      output_frames        += src_data.output_frames;
    }
-#endif
 
    /* Now we write our processed audio output to the driver.
     * It may not be played immediately, depending on the driver implementation. */
    {
       const void *output_data = audio_st->output_samples_buf;
-      unsigned output_frames  = (unsigned)src_data.output_frames; /* Unit: frames */
+      unsigned output_bytes   = (unsigned)output_frames * 2;
 
-      if (audio_st->flags & AUDIO_FLAG_USE_FLOAT)
-         output_frames       *= sizeof(float); /* Unit: bytes */
-      else
+      if (convert_s16)
       {
-         convert_float_to_s16(audio_st->output_samples_conv_buf,
-               (const float*)output_data, output_frames * 2);
+         if (!convert_blocks)
+            convert_float_to_s16(audio_st->output_samples_conv_buf,
+                  (const float*)output_data, output_frames * 2);
 
          output_data          = audio_st->output_samples_conv_buf;
-         output_frames       *= sizeof(int16_t);  /* Unit: bytes */
+         output_bytes        *= sizeof(int16_t);
       }
+      else
+         output_bytes        *= sizeof(float);
 
       audio_st->current_audio->write(audio_st->context_audio_data,
-            output_data, output_frames * 2);
+            output_data, output_bytes);
    }
 }
 
@@ -439,6 +439,10 @@
 #define DEFAULT_THREADED_DATA_RUNLOOP_ENABLE false
 #endif
 
+/* Number of threaded task workers (0 = automatic,
+ * based on the amount of CPU cores). */
+#define DEFAULT_THREADED_DATA_RUNLOOP_WORKERS 0
+
 /* Set to true if HW render cores should get their private context. */
 #define DEFAULT_VIDEO_SHARED_CONTEXT false
 
@@ -1218,6 +1222,10 @@
  * depending on the save state buffer. */
 #define DEFAULT_REWIND_ENABLE false
 
+/* Compresses rewind states on a worker thread while
+ * the core runs the next frame. */
+#define DEFAULT_REWIND_THREADED false
+
 /* When set, any time a cheat is toggled it is immediately applied. */
 #define DEFAULT_APPLY_CHEATS_AFTER_TOGGLE false
 
@@ -1242,6 +1250,14 @@
 #define DEFAULT_REWIND_GRANULARITY 1
 #endif
 
+/* RAM for older rewind states, deflated, once they no longer
+ * fit in the rewind buffer. 0 drops them instead. */
+#define DEFAULT_REWIND_COLD_BUFFER_SIZE 0
+
+/* Size of the file in the cache directory that the oldest
+ * compressed rewind states spill into. Requires the above. */
+#define DEFAULT_REWIND_SPILL_SIZE 0
+
 /* Pause gameplay when window loses focus. */
 #if defined(EMSCRIPTEN)
 #define DEFAULT_PAUSE_NONACTIVE false
@@ -1578,6 +1594,15 @@
 
 #define DEFAULT_GFX_THUMBNAIL_UPSCALE_THRESHOLD 0
 
+/* Size limit (in MB) of the cache of decoded images,
+ * 0 disables it */
+#define DEFAULT_IMAGE_CACHE_SIZE 256
+
+/* Memory budget (in MB) of thumbnail textures kept
+ * uploaded after scrolling off screen, 0 disables
+ * the texture cache (and thumbnail prefetching) */
+#define DEFAULT_MENU_THUMBNAIL_CACHE_SIZE 64
+
 #ifdef HAVE_MENU
 #if defined(RS90) || defined(MIYOO)
 /* The RS-90 has a hardware clock that is neither
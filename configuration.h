@@ -94,6 +94,8 @@ typedef struct settings
    {
       size_t placeholder;
       size_t rewind_buffer_size;
+      size_t rewind_cold_buffer_size;
+      size_t rewind_spill_size;
    } sizes;
 
    video_viewport_t video_viewport_custom; /* int alignment */
@@ -218,9 +220,11 @@ typedef struct settings
       unsigned rewind_granularity;
       unsigned rewind_buffer_size_step;
       unsigned autosave_interval;
+      unsigned threaded_data_runloop_workers;
       unsigned replay_checkpoint_interval;
       unsigned replay_max_keep;
       unsigned savestate_max_keep;
+      unsigned image_cache_size;
       unsigned network_cmd_port;
       unsigned network_remote_base_port;
       unsigned keymapper_port;
@@ -271,6 +275,7 @@ typedef struct settings
       unsigned gfx_thumbnails;
       unsigned menu_left_thumbnails;
       unsigned gfx_thumbnail_upscale_threshold;
+      unsigned menu_thumbnail_cache_size;
       unsigned menu_rgui_thumbnail_downscaler;
       unsigned menu_rgui_thumbnail_delay;
       unsigned menu_rgui_color_theme;
@@ -941,6 +946,7 @@ typedef struct settings
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_threaded;
       bool fastforward_frameskip;
       bool vrr_runloop_enable;
       bool menu_throttle_framerate;
@@ -186,9 +186,13 @@ enum gl2_flags
    GL2_FLAG_MENU_TEXTURE_ENABLE    = (1 << 19),
    GL2_FLAG_MENU_TEXTURE_FULLSCREEN= (1 << 20),
    GL2_FLAG_NONE                   = (1 << 21),
-   GL2_FLAG_FRAME_DUPE_LOCK        = (1 << 22)
+   GL2_FLAG_FRAME_DUPE_LOCK        = (1 << 22),
+   GL2_FLAG_PBO_READBACK_MAPPED    = (1 << 23)
 };
 
+/* Depth of the asynchronous PBO readback ring used for GPU recording. */
+#define GL2_PBO_READBACK_RING 4
+
 struct gl2
 {
    const shader_backend_t *shader;
@@ -215,7 +219,7 @@ struct gl2
    GLuint pbo;
    GLuint *overlay_tex;
    GLuint menu_texture;
-   GLuint pbo_readback[4];
+   GLuint pbo_readback[GL2_PBO_READBACK_RING];
    GLuint texture[GFX_MAX_TEXTURES];
    GLuint hw_render_fbo[GFX_MAX_TEXTURES];
 
@@ -232,9 +236,15 @@ struct gl2
    unsigned vp_out_height;
    unsigned tex_w;
    unsigned tex_h;
+   unsigned max_texture_size;
    unsigned base_size; /* 2 or 4 */
    unsigned overlays;
-   unsigned pbo_readback_index;
+   unsigned pbo_readback_index;   /* Next slot to read back into. */
+   unsigned pbo_readback_count;   /* Slots the recorder has not taken yet. */
+   unsigned pbo_readback_mapped;  /* Slot handed out to the recorder. */
+   unsigned pbo_readback_frames;
+   unsigned pbo_readback_late;
+   unsigned pbo_readback_dropped;
    unsigned last_width[GFX_MAX_TEXTURES];
    unsigned last_height[GFX_MAX_TEXTURES];
 
@@ -256,7 +266,6 @@ struct gl2
    struct video_fbo_rect fbo_rect[GFX_MAX_SHADERS];   /* unsigned alignment */
 
    char device_str[128];
-   bool pbo_readback_valid[4];
 };
 
 bool gl2_load_luts(
@@ -114,6 +114,7 @@ typedef struct gl3
    unsigned overlays;
    unsigned version_major;
    unsigned version_minor;
+   unsigned max_texture_size;
    unsigned vp_out_width;
    unsigned vp_out_height;
    unsigned rotation;
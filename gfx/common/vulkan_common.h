@@ -587,6 +587,11 @@ typedef struct vk
       struct scaler_ctx scaler_bgr;
       struct scaler_ctx scaler_rgb;
       struct vk_texture staging[VULKAN_MAX_SWAPCHAIN_IMAGES];
+      /* Bit per frame index, set while a readback in
+       * staging[] has not been taken by the recorder yet. */
+      uint32_t pending;
+      unsigned frames;
+      unsigned dropped;
    } readback;
 
    struct
@@ -607,6 +612,7 @@ typedef struct vk
       VkDescriptorSetLayout set_layout;
       VkPipelineLayout layout;
       VkPipelineCache cache;
+      size_t cache_size; /* Of the data last loaded or saved */
    } pipelines;
 
    struct
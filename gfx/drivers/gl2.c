@@ -214,6 +214,7 @@ typedef struct gl2_renderchain_data
 
 #ifdef HAVE_GL_SYNC
    GLsync fences[MAX_FENCES];
+   GLsync pbo_readback_fences[GL2_PBO_READBACK_RING];
 #endif
 
    GLuint vao;
@@ -732,6 +733,47 @@ static void gl2_raster_font_upload_atlas(gl2_raster_t *font)
    free(tmp);
 }
 
+/* Uploads the region of the atlas changed by the
+ * font renderer since the last upload */
+static void gl2_raster_font_update_atlas(gl2_raster_t *font)
+{
+   int i, j;
+   uint8_t *tmp;
+   const struct font_atlas *atlas = font->atlas;
+
+   if (!atlas->dirty_width || !atlas->dirty_height)
+   {
+      gl2_raster_font_upload_atlas(font);
+      return;
+   }
+
+   if (!(tmp = (uint8_t*)malloc(atlas->dirty_width
+         * atlas->dirty_height * 2)))
+      return;
+
+   for (i = 0; i < (int)atlas->dirty_height; ++i)
+   {
+      const uint8_t *src = &atlas->buffer[(atlas->dirty_y + i)
+         * atlas->width + atlas->dirty_x];
+      uint8_t       *dst = &tmp[i * atlas->dirty_width * 2];
+
+      for (j = 0; j < (int)atlas->dirty_width; ++j)
+      {
+         *dst++ = 0xff;
+         *dst++ = *src++;
+      }
+   }
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+   glTexSubImage2D(GL_TEXTURE_2D, 0,
+         atlas->dirty_x, atlas->dirty_y,
+         atlas->dirty_width, atlas->dirty_height,
+         GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, tmp);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+   free(tmp);
+}
+
 static void *gl2_raster_font_init(void *data,
       const char *font_path, float font_size,
       bool is_threaded)
@@ -814,7 +856,7 @@ static void gl2_raster_font_draw_vertices(gl2_t *gl,
 {
    if (font->atlas->dirty)
    {
-      gl2_raster_font_upload_atlas(font);
+      gl2_raster_font_update_atlas(font);
       font->atlas->dirty   = false;
    }
 
@@ -2166,6 +2208,96 @@ static void gl2_renderchain_bind_prev_texture(
    }
 }
 
+#ifdef HAVE_GL_ASYNC_READBACK
+/* Releases the ring slot last handed out by gl2_pbo_readback_map(). */
+static void gl2_pbo_readback_unmap(gl2_t *gl)
+{
+   if (!(gl->flags & GL2_FLAG_PBO_READBACK_MAPPED))
+      return;
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER,
+         gl->pbo_readback[gl->pbo_readback_mapped]);
+   glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   gl->flags &= ~GL2_FLAG_PBO_READBACK_MAPPED;
+}
+
+/* Maps the oldest frame in the PBO readback ring.
+ * Never waits on the GPU: if the readback has not
+ * completed yet, sets late and returns NULL so the
+ * caller can try again on the next frame. */
+static const uint8_t *gl2_pbo_readback_map(gl2_t *gl, bool *late)
+{
+   unsigned slot;
+   const uint8_t *ptr              = NULL;
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+   gl2_renderchain_data_t *chain   = (gl2_renderchain_data_t*)
+      gl->renderchain_data;
+#endif
+
+   *late                           = false;
+
+   gl2_pbo_readback_unmap(gl);
+
+   if (!gl->pbo_readback_count)
+      return NULL;
+
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+   if (!(gl->flags & GL2_FLAG_HAVE_SYNC))
+#endif
+   {
+      /* No fences, so stay most of the ring behind
+       * to give the GPU time to finish. */
+      if (gl->pbo_readback_count < GL2_PBO_READBACK_RING - 1)
+         return NULL;
+   }
+
+   slot = (gl->pbo_readback_index + GL2_PBO_READBACK_RING
+         - gl->pbo_readback_count) % GL2_PBO_READBACK_RING;
+
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+   if (chain->pbo_readback_fences[slot])
+   {
+      if (glClientWaitSync(chain->pbo_readback_fences[slot],
+               GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+      {
+         *late = true;
+         return NULL;
+      }
+
+      glDeleteSync(chain->pbo_readback_fences[slot]);
+      chain->pbo_readback_fences[slot] = NULL;
+   }
+#endif
+
+   gl->pbo_readback_count--;
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[slot]);
+#ifdef HAVE_OPENGLES3
+   ptr = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+         0, gl->vp.width * gl->vp.height * sizeof(uint32_t),
+         GL_MAP_READ_BIT);
+#else
+   ptr = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+#endif
+   /* The buffer stays mapped after unbinding it. */
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   if (!ptr)
+   {
+      RARCH_ERR("[GL]: Failed to map pixel unpack buffer.\n");
+      return NULL;
+   }
+
+   gl->pbo_readback_mapped  = slot;
+   gl->pbo_readback_frames++;
+   gl->flags               |= GL2_FLAG_PBO_READBACK_MAPPED;
+
+   return ptr;
+}
+#endif
+
 static bool gl2_renderchain_read_viewport(
       gl2_t *gl,
       uint8_t *buffer, bool is_idle)
@@ -2180,50 +2312,28 @@ static bool gl2_renderchain_read_viewport(
 #ifdef HAVE_GL_ASYNC_READBACK
    if (gl->flags & GL2_FLAG_PBO_READBACK_ENABLE)
    {
-      const uint8_t *ptr  = NULL;
+      bool late           = false;
+      const uint8_t *ptr  = gl2_pbo_readback_map(gl, &late);
 
       /* Don't readback if we're in menu mode.
        * We haven't buffered up enough frames yet, come back later. */
-      if (!gl->pbo_readback_valid[gl->pbo_readback_index])
+      if (!ptr)
          goto error;
 
-      gl->pbo_readback_valid[gl->pbo_readback_index] = false;
-      glBindBuffer(GL_PIXEL_PACK_BUFFER,
-            gl->pbo_readback[gl->pbo_readback_index]);
-
 #ifdef HAVE_OPENGLES3
       /* Slower path, but should work on all implementations at least. */
-      ptr        = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER,
-            0, num_pixels * sizeof(uint32_t), GL_MAP_READ_BIT);
-
-      if (ptr)
-      {
-         int y;
-         for (y = 0; y < gl->vp.height; y++)
-         {
-            video_frame_convert_rgba_to_bgr(
-                  (const void*)ptr,
-                  buffer,
-                  gl->vp.width);
-         }
-      }
+      video_frame_convert_rgba_to_bgr(
+            (const void*)ptr,
+            buffer,
+            num_pixels);
 #else
-      ptr = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-      if (ptr)
       {
          struct scaler_ctx *ctx = &gl->pbo_readback_scaler;
          scaler_ctx_scale_direct(ctx, buffer, ptr);
       }
 #endif
 
-      if (!ptr)
-      {
-         RARCH_ERR("[GL]: Failed to map pixel unpack buffer.\n");
-         goto error;
-      }
-
-      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      gl2_pbo_readback_unmap(gl);
    }
    else
 #endif
@@ -3398,17 +3508,45 @@ static void gl2_pbo_async_readback(gl2_t *gl)
    GLenum type = GL_UNSIGNED_INT_8_8_8_8_REV;
 #endif
 
-   gl2_renderchain_bind_pbo(
-         gl->pbo_readback[gl->pbo_readback_index++]);
-   gl->pbo_readback_index &= 3;
+   unsigned slot;
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+   gl2_renderchain_data_t *chain = (gl2_renderchain_data_t*)
+      gl->renderchain_data;
+#endif
+
+#ifdef HAVE_GL_ASYNC_READBACK
+   /* Whoever took the previous frame is done with it by now. */
+   gl2_pbo_readback_unmap(gl);
+#endif
+
+   /* The recorder fell behind and the ring is full,
+    * overwrite the oldest frame. */
+   if (gl->pbo_readback_count == GL2_PBO_READBACK_RING)
+   {
+      gl->pbo_readback_count--;
+      gl->pbo_readback_dropped++;
+   }
 
-   /* 4 frames back, we can readback. */
-   gl->pbo_readback_valid[gl->pbo_readback_index] = true;
+   slot                   = gl->pbo_readback_index;
+   gl->pbo_readback_index = (slot + 1) % GL2_PBO_READBACK_RING;
 
+   gl2_renderchain_bind_pbo(gl->pbo_readback[slot]);
    gl2_renderchain_readback(gl, gl->renderchain_data,
          gl2_get_alignment(gl->vp.width * sizeof(uint32_t)),
          fmt, type, NULL);
    gl2_renderchain_unbind_pbo();
+
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+   if (gl->flags & GL2_FLAG_HAVE_SYNC)
+   {
+      if (chain->pbo_readback_fences[slot])
+         glDeleteSync(chain->pbo_readback_fences[slot]);
+      chain->pbo_readback_fences[slot] =
+         glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   }
+#endif
+
+   gl->pbo_readback_count++;
 }
 
 static bool gl2_frame(void *data, const void *frame,
@@ -3836,7 +3974,27 @@ static void gl2_free(void *data)
 
    if (gl->flags & GL2_FLAG_PBO_READBACK_ENABLE)
    {
-      glDeleteBuffers(4, gl->pbo_readback);
+#if defined(HAVE_GL_SYNC) && !defined(HAVE_OPENGLES)
+      unsigned i;
+      gl2_renderchain_data_t *chain = (gl2_renderchain_data_t*)
+         gl->renderchain_data;
+
+      for (i = 0; i < GL2_PBO_READBACK_RING; i++)
+      {
+         if (chain->pbo_readback_fences[i])
+            glDeleteSync(chain->pbo_readback_fences[i]);
+         chain->pbo_readback_fences[i] = NULL;
+      }
+#endif
+#ifdef HAVE_GL_ASYNC_READBACK
+      gl2_pbo_readback_unmap(gl);
+#endif
+      RARCH_LOG("[GL]: Readback ring: %u frames read back, %u late, %u dropped.\n",
+            gl->pbo_readback_frames,
+            gl->pbo_readback_late,
+            gl->pbo_readback_dropped);
+
+      glDeleteBuffers(GL2_PBO_READBACK_RING, gl->pbo_readback);
       scaler_ctx_gen_reset(&gl->pbo_readback_scaler);
    }
 
@@ -4018,9 +4176,15 @@ static bool gl2_init_pbo_readback(gl2_t *gl)
 #if !defined(HAVE_OPENGLES2) && !defined(HAVE_PSGL)
    int i;
 
-   glGenBuffers(4, gl->pbo_readback);
+   gl->pbo_readback_index   = 0;
+   gl->pbo_readback_count   = 0;
+   gl->pbo_readback_frames  = 0;
+   gl->pbo_readback_late    = 0;
+   gl->pbo_readback_dropped = 0;
+
+   glGenBuffers(GL2_PBO_READBACK_RING, gl->pbo_readback);
 
-   for (i = 0; i < 4; i++)
+   for (i = 0; i < GL2_PBO_READBACK_RING; i++)
    {
       gl2_renderchain_bind_pbo(gl->pbo_readback[i]);
       gl2_renderchain_init_pbo(gl->vp.width *
@@ -4045,7 +4209,7 @@ static bool gl2_init_pbo_readback(gl2_t *gl)
       {
          gl->flags             &= ~GL2_FLAG_PBO_READBACK_ENABLE;
          RARCH_ERR("[GL]: Failed to initialize pixel conversion for PBO.\n");
-         glDeleteBuffers(4, gl->pbo_readback);
+         glDeleteBuffers(GL2_PBO_READBACK_RING, gl->pbo_readback);
          return false;
       }
    }
@@ -4340,6 +4504,12 @@ static void *gl2_init(const video_info_t *video,
    if (!string_is_empty(version))
       sscanf(version, "%d.%d", &gl->version_major, &gl->version_minor);
 
+   {
+      GLint max_texture_size = 0;
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+      gl->max_texture_size   = (unsigned)max_texture_size;
+   }
+
    {
       size_t len    = 0;
 
@@ -4616,7 +4786,8 @@ static void *gl2_init(const video_info_t *video,
       gl->flags |=  GL2_FLAG_PBO_READBACK_ENABLE;
       if (gl2_init_pbo_readback(gl))
       {
-         RARCH_LOG("[GL]: Async PBO readback enabled.\n");
+         RARCH_LOG("[GL]: Async PBO readback enabled, %u frames deep.\n",
+               GL2_PBO_READBACK_RING);
       }
    }
    else
@@ -4882,6 +5053,52 @@ static bool gl2_read_viewport(void *data, uint8_t *buffer, bool is_idle)
    return gl2_renderchain_read_viewport(gl, buffer, is_idle);
 }
 
+#if defined(HAVE_GL_ASYNC_READBACK) && !defined(HAVE_OPENGLES)
+static bool gl2_read_viewport_ring(void *data,
+      struct video_readback_frame *frame)
+{
+   bool late             = false;
+   const uint8_t *ptr    = NULL;
+   gl2_t *gl             = (gl2_t*)data;
+
+   if (!gl || !(gl->flags & GL2_FLAG_PBO_READBACK_ENABLE))
+      return false;
+   if (!frame)
+      return true;
+
+   if (gl->flags & GL2_FLAG_SHARED_CONTEXT_USE)
+      gl->ctx_driver->bind_hw_render(gl->ctx_data, false);
+
+   ptr                   = gl2_pbo_readback_map(gl, &late);
+
+   if (gl->flags & GL2_FLAG_SHARED_CONTEXT_USE)
+      gl->ctx_driver->bind_hw_render(gl->ctx_data, true);
+
+   frame->width          = gl->vp.width;
+   frame->height         = gl->vp.height;
+   frame->pitch          = -(int)(gl->vp.width * sizeof(uint32_t));
+
+   if (!ptr)
+   {
+      /* Keep the recording in step with the display
+       * rather than stalling until the GPU catches up. */
+      if (!late || !gl->pbo_readback_frames)
+         return false;
+
+      gl->pbo_readback_late++;
+      frame->data        = NULL;
+      frame->is_dupe     = true;
+      return true;
+   }
+
+   /* glReadPixels() stores the rows bottom-up. */
+   frame->data           = ptr
+      + (gl->vp.height - 1) * gl->vp.width * sizeof(uint32_t);
+   frame->is_dupe        = false;
+   return true;
+}
+#endif
+
 #if 0
 #define READ_RAW_GL_FRAME_TEST
 #endif
@@ -5237,6 +5454,12 @@ static uint32_t gl2_get_flags(void *data)
    return flags;
 }
 
+static unsigned gl2_get_max_texture_size(void *data)
+{
+   gl2_t *gl = (gl2_t*)data;
+   return gl ? gl->max_texture_size : 0;
+}
+
 static const video_poke_interface_t gl2_poke_interface = {
    gl2_get_flags,
    gl2_load_texture,
@@ -5262,7 +5485,13 @@ static const video_poke_interface_t gl2_poke_interface = {
    NULL, /* set_hdr_max_nits */
    NULL, /* set_hdr_paper_white_nits */
    NULL, /* set_hdr_contrast */
-   NULL  /* set_hdr_expand_gamut */
+   NULL, /* set_hdr_expand_gamut */
+#if defined(HAVE_GL_ASYNC_READBACK) && !defined(HAVE_OPENGLES)
+   gl2_read_viewport_ring,
+#else
+   NULL, /* read_viewport_ring */
+#endif
+   gl2_get_max_texture_size
 };
 
 static void gl2_get_poke_interface(void *data,
@@ -460,6 +460,31 @@ static void gl3_raster_font_upload_atlas(gl3_raster_t *font)
    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+/* Uploads the region of the atlas changed by the
+ * font renderer since the last upload */
+static void gl3_raster_font_update_atlas(gl3_raster_t *font)
+{
+   const struct font_atlas *atlas = font->atlas;
+
+   if (!font->tex || !atlas->dirty_width || !atlas->dirty_height)
+   {
+      gl3_raster_font_upload_atlas(font);
+      return;
+   }
+
+   glBindTexture(GL_TEXTURE_2D, font->tex);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, atlas->width);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   glTexSubImage2D(GL_TEXTURE_2D, 0,
+                   atlas->dirty_x, atlas->dirty_y,
+                   atlas->dirty_width, atlas->dirty_height,
+                   GL_RED, GL_UNSIGNED_BYTE,
+                   atlas->buffer + atlas->dirty_y * atlas->width + atlas->dirty_x);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+   glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 static void *gl3_raster_font_init(void *data,
       const char *font_path, float font_size,
       bool is_threaded)
@@ -532,7 +557,7 @@ static void gl3_raster_font_draw_vertices(gl3_t *gl,
 {
    if (font->atlas->dirty)
    {
-      gl3_raster_font_upload_atlas(font);
+      gl3_raster_font_update_atlas(font);
       font->atlas->dirty   = false;
    }
 
@@ -1875,6 +1900,12 @@ static void *gl3_init(const video_info_t *video,
    if (!string_is_empty(version))
       sscanf(version, "%u.%u", &gl->version_major, &gl->version_minor);
 
+   {
+      GLint max_texture_size = 0;
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+      gl->max_texture_size   = (unsigned)max_texture_size;
+   }
+
    video_driver_set_gpu_api_version_string(version);
 
 #ifdef _WIN32
@@ -3017,6 +3048,12 @@ static retro_proc_address_t gl3_get_proc_address(
    return NULL;
 }
 
+static unsigned gl3_get_max_texture_size(void *data)
+{
+   gl3_t *gl = (gl3_t*)data;
+   return gl ? gl->max_texture_size : 0;
+}
+
 static const video_poke_interface_t gl3_poke_interface = {
    gl3_get_flags,
    gl3_load_texture,
@@ -3042,7 +3079,9 @@ static const video_poke_interface_t gl3_poke_interface = {
    NULL, /* set_hdr_max_nits */
    NULL, /* set_hdr_paper_white_nits */
    NULL, /* set_hdr_contrast */
-   NULL  /* set_hdr_expand_gamut */
+   NULL, /* set_hdr_expand_gamut */
+   NULL, /* read_viewport_ring */
+   gl3_get_max_texture_size
 };
 
 static void gl3_get_poke_interface(void *data,
@@ -19,14 +19,18 @@
 #include <string.h>
 
 #include <retro_assert.h>
+#include <encodings/crc32.h>
 #include <encodings/utf.h>
 #include <compat/strl.h>
+#include <features/features_cpu.h>
+#include <file/file_path.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
 #include <formats/image.h>
 #include <retro_inline.h>
 #include <retro_miscellaneous.h>
 #include <retro_math.h>
+#include <streams/file_stream.h>
 #include <string/stdstring.h>
 #include <libretro.h>
 
@@ -2903,22 +2907,203 @@ static bool vulkan_init_filter_chain(vk_t *vk)
    return true;
 }
 
+#define VULKAN_PIPELINE_CACHE_MAGIC   "RAVKPLCH"
+#define VULKAN_PIPELINE_CACHE_VERSION 1
+
+/* Header of the pipeline cache file, followed by the data from
+ * vkGetPipelineCacheData(). Drivers are expected to reject data
+ * that isn't theirs, but some crash on it instead, so the file
+ * is only handed back to the device and driver that wrote it. */
+struct vulkan_pipeline_cache_header
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t vendor_id;
+   uint32_t device_id;
+   uint32_t driver_version;
+   uint8_t uuid[VK_UUID_SIZE];
+   uint32_t data_size;
+   uint32_t data_crc;
+};
+
+/* One file per GPU, for systems with several of them */
+static bool vulkan_pipeline_cache_path(vk_t *vk, char *s, size_t len)
+{
+   char name[64];
+   settings_t *settings = config_get_ptr();
+   const char *dir      = settings->paths.directory_cache;
+
+   if (string_is_empty(dir))
+      return false;
+
+   snprintf(name, sizeof(name), "vulkan_pipeline_cache_%04x_%04x.bin",
+         vk->context->gpu_properties.vendorID,
+         vk->context->gpu_properties.deviceID);
+   fill_pathname_join_special(s, dir, name, len);
+   return true;
+}
+
+/* Returns the pipeline cache data saved by a previous session,
+ * or NULL if there is none this device and driver can use. */
+static void *vulkan_load_pipeline_cache(vk_t *vk, size_t *size)
+{
+   struct vulkan_pipeline_cache_header header;
+   char path[PATH_MAX_LENGTH];
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+   void *buf                               = NULL;
+   int64_t len                             = 0;
+   uint8_t *data                           = NULL;
+
+   if (     !vulkan_pipeline_cache_path(vk, path, sizeof(path))
+         || !path_is_valid(path)
+         || !filestream_read_file(path, &buf, &len))
+      return NULL;
+
+   if ((size_t)len < sizeof(header))
+      goto error;
+
+   memcpy(&header, buf, sizeof(header));
+   data = (uint8_t*)buf + sizeof(header);
+
+   if (     memcmp(header.magic, VULKAN_PIPELINE_CACHE_MAGIC,
+               sizeof(header.magic))
+         || header.version        != VULKAN_PIPELINE_CACHE_VERSION
+         || header.vendor_id      != props->vendorID
+         || header.device_id      != props->deviceID
+         || header.driver_version != props->driverVersion
+         || memcmp(header.uuid, props->pipelineCacheUUID, VK_UUID_SIZE))
+   {
+      RARCH_LOG("[Vulkan]: Pipeline cache was saved by another device"
+            " or driver, ignoring it.\n");
+      goto error;
+   }
+
+   if (     header.data_size != (uint64_t)len - sizeof(header)
+         || header.data_crc  != encoding_crc32(0, data, header.data_size))
+   {
+      RARCH_WARN("[Vulkan]: Pipeline cache is corrupt, ignoring it.\n");
+      goto error;
+   }
+
+   /* The data goes to the start of the buffer handed back */
+   memmove(buf, data, header.data_size);
+   *size = header.data_size;
+   return buf;
+
+error:
+   free(buf);
+   return NULL;
+}
+
+/* Writes the pipeline cache to disk if it grew since it was
+ * loaded or last saved. */
+static void vulkan_save_pipeline_cache(vk_t *vk)
+{
+   struct vulkan_pipeline_cache_header header;
+   char path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH + 4];
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+   size_t size                             = 0;
+   uint8_t *buf                            = NULL;
+   RFILE *file                             = NULL;
+   bool written                            = false;
+
+   if (     vk->pipelines.cache == VK_NULL_HANDLE
+         || !vulkan_pipeline_cache_path(vk, path, sizeof(path)))
+      return;
+
+   if (     vkGetPipelineCacheData(vk->context->device,
+               vk->pipelines.cache, &size, NULL) != VK_SUCCESS
+         || size == 0
+         || size == vk->pipelines.cache_size
+         || size > UINT32_MAX)
+      return;
+
+   if (!(buf = (uint8_t*)malloc(sizeof(header) + size)))
+      return;
+
+   /* The size may shrink between both calls, never grow */
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &size, buf + sizeof(header))
+         != VK_SUCCESS)
+      goto end;
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, VULKAN_PIPELINE_CACHE_MAGIC, sizeof(header.magic));
+   header.version        = VULKAN_PIPELINE_CACHE_VERSION;
+   header.vendor_id      = props->vendorID;
+   header.device_id      = props->deviceID;
+   header.driver_version = props->driverVersion;
+   memcpy(header.uuid, props->pipelineCacheUUID, VK_UUID_SIZE);
+   header.data_size      = (uint32_t)size;
+   header.data_crc       = encoding_crc32(0, buf + sizeof(header), size);
+   memcpy(buf, &header, sizeof(header));
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+   if (!(file = filestream_open(tmp_path, RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto end;
+
+   written = filestream_write(file, buf, sizeof(header) + size)
+      == (int64_t)(sizeof(header) + size);
+
+   if (filestream_close(file) != 0)
+      written = false;
+
+   if (written)
+   {
+      filestream_delete(path);
+      written = (filestream_rename(tmp_path, path) == 0);
+   }
+
+   if (written)
+   {
+      RARCH_LOG("[Vulkan]: Saved %u bytes of pipeline cache.\n",
+            (unsigned)size);
+      vk->pipelines.cache_size = size;
+   }
+   else
+      filestream_delete(tmp_path);
+
+end:
+   free(buf);
+}
+
 static void vulkan_init_static_resources(vk_t *vk)
 {
    int i;
    uint32_t blank[4 * 4];
    VkCommandPoolCreateInfo pool_info;
    VkPipelineCacheCreateInfo cache;
+   size_t cache_size          = 0;
+   void *cache_data           = vulkan_load_pipeline_cache(vk, &cache_size);
 
-   /* Create the pipeline cache. */
+   /* Create the pipeline cache, from the previous session's data. */
    cache.sType                = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
    cache.pNext                = NULL;
    cache.flags                = 0;
-   cache.initialDataSize      = 0;
-   cache.pInitialData         = NULL;
+   cache.initialDataSize      = cache_size;
+   cache.pInitialData         = cache_data;
+
+   if (     vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache) != VK_SUCCESS
+         && cache_data)
+   {
+      RARCH_WARN("[Vulkan]: Pipeline cache was rejected by the driver.\n");
+      cache_size            = 0;
+      cache.initialDataSize = 0;
+      cache.pInitialData    = NULL;
+      vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache);
+   }
 
-   vkCreatePipelineCache(vk->context->device,
-         &cache, NULL, &vk->pipelines.cache);
+   if (cache_size)
+      RARCH_LOG("[Vulkan]: Loaded %u bytes of pipeline cache.\n",
+            (unsigned)cache_size);
+
+   vk->pipelines.cache_size   = cache_size;
+   free(cache_data);
 
    pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
    pool_info.pNext            = NULL;
@@ -2939,6 +3124,7 @@ static void vulkan_init_static_resources(vk_t *vk)
 static void vulkan_deinit_static_resources(vk_t *vk)
 {
    int i;
+   vulkan_save_pipeline_cache(vk);
    vkDestroyPipelineCache(vk->context->device,
          vk->pipelines.cache, NULL);
    vulkan_destroy_texture(
@@ -2951,6 +3137,11 @@ static void vulkan_deinit_static_resources(vk_t *vk)
    free(vk->hw.wait_dst_stages);
    free(vk->hw.semaphores);
 
+   if (vk->flags & VK_FLAG_READBACK_STREAMED)
+      RARCH_LOG("[Vulkan]: Readback ring: %u frames read back, %u dropped.\n",
+            vk->readback.frames,
+            vk->readback.dropped);
+
    for (i = 0; i < VULKAN_MAX_SWAPCHAIN_IMAGES; i++)
       if (vk->readback.staging[i].memory != VK_NULL_HANDLE)
          vulkan_destroy_texture(
@@ -3183,6 +3374,9 @@ static void vulkan_init_readback(vk_t *vk, settings_t *settings)
    }
 
    vk->flags                          |=  VK_FLAG_READBACK_STREAMED;
+   vk->readback.pending                =  0;
+   vk->readback.frames                 =  0;
+   vk->readback.dropped                =  0;
 
    vk->readback.scaler_bgr.in_width    = vk->vp.width;
    vk->readback.scaler_bgr.in_height   = vk->vp.height;
@@ -3227,6 +3421,7 @@ static void *vulkan_init(const video_info_t *video,
    unsigned temp_height               = 0;
    const gfx_ctx_driver_t *ctx_driver = NULL;
    settings_t *settings               = config_get_ptr();
+   retro_time_t pipelines_start       = 0;
 #ifdef VULKAN_HDR_SWAPCHAIN
    vulkan_hdr_uniform_t* mapped_ubo   = NULL;
 #endif
@@ -3361,6 +3556,7 @@ static void *vulkan_init(const video_info_t *video,
          { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         VULKAN_DESCRIPTOR_MANAGER_BLOCK_SETS },
       };
 
+      pipelines_start = cpu_features_get_time_usec();
       vulkan_init_static_resources(vk);
 
       vk->num_swapchain_images = vk->context->num_swapchain_images;
@@ -3419,6 +3615,12 @@ static void *vulkan_init(const video_info_t *video,
       goto error;
    }
 
+   if (pipelines_start)
+      RARCH_LOG("[Vulkan]: Created pipelines and filter chain in %.2f ms"
+            " (%u bytes of pipeline cache loaded).\n",
+            (cpu_features_get_time_usec() - pipelines_start) / 1000.0,
+            (unsigned)vk->pipelines.cache_size);
+
    if (vk->ctx_driver->input_driver)
    {
       const char *joypad_name = settings->arrays.input_joypad_driver;
@@ -3603,10 +3805,13 @@ static bool vulkan_suppress_screensaver(void *data, bool enable)
 static bool vulkan_set_shader(void *data,
       enum rarch_shader_type type, const char *path)
 {
+   retro_time_t start;
    vk_t *vk = (vk_t*)data;
    if (!vk)
       return false;
 
+   start    = cpu_features_get_time_usec();
+
    if (vk->filter_chain)
       vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
    vk->filter_chain = NULL;
@@ -3630,6 +3835,11 @@ static bool vulkan_set_shader(void *data,
       return false;
    }
 
+   RARCH_LOG("[Vulkan]: Switched preset in %.2f ms.\n",
+         (cpu_features_get_time_usec() - start) / 1000.0);
+
+   /* Keep the pipelines of the new preset for the next session */
+   vulkan_save_pipeline_cache(vk);
    return true;
 }
 
@@ -3792,6 +4002,7 @@ static void vulkan_set_viewport(void *data, unsigned viewport_width,
 
 static void vulkan_readback(vk_t *vk)
 {
+   unsigned frame_index;
    VkBufferImageCopy region;
    struct vk_texture *staging;
    struct video_viewport vp;
@@ -3820,12 +4031,28 @@ static void vulkan_readback(vk_t *vk)
    region.imageExtent.height              = vp.height;
    region.imageExtent.depth               = 1;
 
-   staging  = &vk->readback.staging[vk->context->current_frame_index];
-   *staging = vulkan_create_texture(vk,
-         staging->memory != VK_NULL_HANDLE ? staging : NULL,
-         vk->vp.width, vk->vp.height,
-         VK_FORMAT_B8G8R8A8_UNORM, /* Formats don't matter for readback since it's a raw copy. */
-         NULL, NULL, VULKAN_TEXTURE_READBACK);
+   frame_index = vk->context->current_frame_index;
+   staging     = &vk->readback.staging[frame_index];
+
+   /* The staging buffers form the readback ring, one per frame
+    * in flight. Only recreate them if the viewport changed. */
+   if (     staging->memory == VK_NULL_HANDLE
+         || staging->width  != vk->vp.width
+         || staging->height != vk->vp.height)
+   {
+      *staging = vulkan_create_texture(vk,
+            staging->memory != VK_NULL_HANDLE ? staging : NULL,
+            vk->vp.width, vk->vp.height,
+            VK_FORMAT_B8G8R8A8_UNORM, /* Formats don't matter for readback since it's a raw copy. */
+            NULL, NULL, VULKAN_TEXTURE_READBACK);
+      VK_MAP_PERSISTENT_TEXTURE(vk->context->device, staging);
+   }
+
+   /* The recorder never took the frame which was read back
+    * into this buffer last time around. */
+   if (vk->readback.pending & (1u << frame_index))
+      vk->readback.dropped++;
+   vk->readback.pending |= (1u << frame_index);
 
    vkCmdCopyImageToBuffer(vk->cmd, vk->backbuffer->image,
          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -5336,6 +5563,46 @@ static void vulkan_get_video_output_next(void *data)
       vk->ctx_driver->get_video_output_next(vk->ctx_data);
 }
 
+static bool vulkan_read_viewport_ring(void *data,
+      struct video_readback_frame *frame)
+{
+   unsigned frame_index;
+   struct vk_texture *staging = NULL;
+   vk_t *vk                   = (vk_t*)data;
+
+   /* The recorder only takes BGRA, anything else
+    * goes through read_viewport and the scalers. */
+   if (     !vk
+         || !(vk->flags & VK_FLAG_READBACK_STREAMED)
+         || vk->context->swapchain_format != VK_FORMAT_B8G8R8A8_UNORM)
+      return false;
+   if (!frame)
+      return true;
+
+   /* The fence for this frame index was waited on when
+    * the swapchain image was acquired, so the readback
+    * into its staging buffer is complete. */
+   frame_index                = vk->context->current_frame_index;
+   staging                    = &vk->readback.staging[frame_index];
+
+   if (     !(vk->readback.pending & (1u << frame_index))
+         || !staging->mapped)
+      return false;
+
+   if (staging->flags & VK_TEX_FLAG_NEED_MANUAL_CACHE_MANAGEMENT)
+      VULKAN_SYNC_TEXTURE_TO_CPU(vk->context->device, staging->memory);
+
+   vk->readback.pending      &= ~(1u << frame_index);
+   vk->readback.frames++;
+
+   frame->data                = staging->mapped;
+   frame->width               = staging->width;
+   frame->height              = staging->height;
+   frame->pitch               = (int)staging->stride;
+   frame->is_dupe             = false;
+   return true;
+}
+
 static const video_poke_interface_t vulkan_poke_interface = {
    vulkan_get_flags,
    vulkan_load_texture,
@@ -5362,13 +5629,14 @@ static const video_poke_interface_t vulkan_poke_interface = {
    vulkan_set_hdr_max_nits,
    vulkan_set_hdr_paper_white_nits,
    vulkan_set_hdr_contrast,
-   vulkan_set_hdr_expand_gamut
+   vulkan_set_hdr_expand_gamut,
 #else
    NULL, /* set_hdr_max_nits */
    NULL, /* set_hdr_paper_white_nits */
    NULL, /* set_hdr_contrast */
-   NULL  /* set_hdr_expand_gamut */
+   NULL, /* set_hdr_expand_gamut */
 #endif /* VULKAN_HDR_SWAPCHAIN */
+   vulkan_read_viewport_ring
 };
 
 static void vulkan_get_poke_interface(void *data,
@@ -5429,22 +5697,22 @@ static bool vulkan_read_viewport(void *data, uint8_t *buffer, bool is_idle)
 
       if (ctx)
       {
-         if (staging->memory == VK_NULL_HANDLE)
+         if (     staging->memory == VK_NULL_HANDLE
+               || !staging->mapped)
             return false;
 
          buffer += 3 * (vk->vp.height - 1) * vk->vp.width;
-         vkMapMemory(vk->context->device, staging->memory,
-               staging->offset, staging->size, 0, (void**)&src);
+         src     = (const uint8_t*)staging->mapped;
 
-         if (     (staging->flags & VK_TEX_FLAG_NEED_MANUAL_CACHE_MANAGEMENT)
-               && (staging->memory != VK_NULL_HANDLE))
+         if (staging->flags & VK_TEX_FLAG_NEED_MANUAL_CACHE_MANAGEMENT)
             VULKAN_SYNC_TEXTURE_TO_CPU(vk->context->device, staging->memory);
 
          ctx->in_stride  =  (int)staging->stride;
          ctx->out_stride = -(int)vk->vp.width * 3;
          scaler_ctx_scale_direct(ctx, buffer, src);
 
-         vkUnmapMemory(vk->context->device, staging->memory);
+         vk->readback.pending &= ~(1u << vk->context->current_frame_index);
+         vk->readback.frames++;
       }
    }
    else
@@ -5477,6 +5745,8 @@ static bool vulkan_read_viewport(void *data, uint8_t *buffer, bool is_idle)
          VK_MAP_PERSISTENT_TEXTURE(vk->context->device, staging);
       }
 
+      vk->readback.pending = 0;
+
       if (     (staging->flags & VK_TEX_FLAG_NEED_MANUAL_CACHE_MANAGEMENT)
             && (staging->memory != VK_NULL_HANDLE))
          VULKAN_SYNC_TEXTURE_TO_CPU(vk->context->device, staging->memory);
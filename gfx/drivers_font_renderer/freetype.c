@@ -35,7 +35,6 @@
 
 #if defined(HAVE_FONTCONFIG_SUPPORT)
 #include <fontconfig/fontconfig.h>
-#include "../../msg_hash.h"
 #endif
 
 #ifdef WIIU
@@ -43,38 +42,84 @@
 #endif
 
 #include FT_FREETYPE_H
+#include <array/rhmap.h>
+#include <encodings/utf.h>
+
 #include "../font_driver.h"
+#include "../video_driver.h"
+#include "../../msg_hash.h"
+#include "../../verbosity.h"
 
 #define FT_ATLAS_ROWS 16
 #define FT_ATLAS_COLS 16
 #define FT_ATLAS_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
+/* Menu languages with large glyph sets get several
+ * pages of FT_ATLAS_SIZE slots, stacked vertically
+ * in the same atlas texture */
+#define FT_ATLAS_MAX_PAGES 4
+/* No page is added past this atlas height, nor past
+ * the texture size limit of the video driver */
+#if defined(HAVE_OPENGLES2) && !defined(HAVE_OPENGLES3)
+#define FT_ATLAS_MAX_HEIGHT 1024
+#else
+#define FT_ATLAS_MAX_HEIGHT 2048
+#endif
 /* Padding is required between each glyph in
  * the atlas to prevent texture bleed when
  * drawing with linear filtering enabled */
 #define FT_ATLAS_PADDING 1
+/* Buckets of the codepoint lookup table,
+ * must be a power of two */
+#define FT_ATLAS_HASH_SIZE 0x400
+#define FT_ATLAS_HASH(charcode) ((charcode) & (FT_ATLAS_HASH_SIZE - 1))
 
 typedef struct freetype_atlas_slot
 {
-   struct freetype_atlas_slot* next;   /* ptr alignment */
-   struct font_glyph glyph;            /* unsigned alignment */
+   struct freetype_atlas_slot *next;       /* ptr alignment */
+   struct freetype_atlas_slot **prev_next; /* ptr alignment */
+   struct freetype_atlas_slot *lru_prev;   /* ptr alignment */
+   struct freetype_atlas_slot *lru_next;   /* ptr alignment */
+   struct font_glyph glyph;                /* unsigned alignment */
    unsigned charcode;
-   unsigned last_used;
-}freetype_atlas_slot_t;
+   bool in_use;
+} freetype_atlas_slot_t;
+
+struct freetype_glyph_stats
+{
+   unsigned hits;
+   unsigned misses;
+   unsigned rasterized_again; /* Misses on evicted glyphs */
+};
 
 typedef struct freetype_renderer
 {
    FT_Library lib;                                   /* ptr alignment   */
    FT_Face face;                                     /* ptr alignment   */
    struct font_atlas atlas;                          /* ptr alignment   */
-   freetype_atlas_slot_t atlas_slots[FT_ATLAS_SIZE]; /* ptr alignment   */
-   freetype_atlas_slot_t* uc_map[0x100];             /* ptr alignment   */
+   freetype_atlas_slot_t *atlas_slots;               /* ptr alignment   */
+   /* Slots from most to least recently used,
+    * the tail is the next one to be evicted */
+   freetype_atlas_slot_t *lru_head;                  /* ptr alignment   */
+   freetype_atlas_slot_t *lru_tail;                  /* ptr alignment   */
+   freetype_atlas_slot_t *uc_map[FT_ATLAS_HASH_SIZE]; /* ptr alignment  */
+   uint8_t *evicted; /* RHMAP, keyed by charcode + 1    ptr alignment   */
    void *file_data;                                  /* ptr alignment   */
+   uint64_t stats_frame;
+   struct freetype_glyph_stats frame_stats;          /* unsigned alignment */
+   struct freetype_glyph_stats total_stats;          /* unsigned alignment */
+   unsigned peak_frame_misses;
+   unsigned num_slots;
    unsigned max_glyph_width;
    unsigned max_glyph_height;
-   unsigned usage_counter;
    struct font_line_metrics line_metrics;            /* float alignment */
 } ft_font_renderer_t;
 
+struct freetype_codepoint_uses
+{
+   uint32_t charcode;
+   unsigned uses;
+};
+
 static struct font_atlas *font_renderer_ft_get_atlas(void *data)
 {
    ft_font_renderer_t *handle = (ft_font_renderer_t*)data;
@@ -89,7 +134,17 @@ static void font_renderer_ft_free(void *data)
    if (!handle)
       return;
 
+   if (handle->total_stats.misses)
+      RARCH_DBG("[FreeType]: Glyph atlas: %u hits, %u misses"
+            " (%u re-rasterized), at most %u misses in a frame.\n",
+            handle->total_stats.hits,
+            handle->total_stats.misses,
+            handle->total_stats.rasterized_again,
+            handle->peak_frame_misses);
+
    free(handle->atlas.buffer);
+   free(handle->atlas_slots);
+   RHMAP_FREE(handle->evicted);
 
    if (handle->face)
       FT_Done_Face(handle->face);
@@ -101,29 +156,91 @@ static void font_renderer_ft_free(void *data)
    free(handle);
 }
 
+static void font_renderer_ft_lru_unlink(ft_font_renderer_t *handle,
+      freetype_atlas_slot_t *slot)
+{
+   if (slot->lru_prev)
+      slot->lru_prev->lru_next = slot->lru_next;
+   else
+      handle->lru_head         = slot->lru_next;
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   else
+      handle->lru_tail         = slot->lru_prev;
+}
+
+static void font_renderer_ft_lru_push(ft_font_renderer_t *handle,
+      freetype_atlas_slot_t *slot)
+{
+   slot->lru_prev              = NULL;
+   slot->lru_next              = handle->lru_head;
+   if (handle->lru_head)
+      handle->lru_head->lru_prev = slot;
+   else
+      handle->lru_tail         = slot;
+   handle->lru_head            = slot;
+}
+
 static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
 {
-   int i, map_id;
-   unsigned oldest = 0;
-
-   for (i = 1; i < FT_ATLAS_SIZE; i++)
-      if ((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
-
-   /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if (handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
+   freetype_atlas_slot_t *slot = handle->lru_tail;
+
+   if (slot->in_use)
+   {
+      /* Remove from map */
+      *slot->prev_next         = slot->next;
+      if (slot->next)
+         slot->next->prev_next = slot->prev_next;
+      slot->in_use             = false;
+      RHMAP_SET(handle->evicted, slot->charcode + 1, 1);
+   }
+
+   font_renderer_ft_lru_unlink(handle, slot);
+   font_renderer_ft_lru_push(handle, slot);
+   return slot;
+}
+
+/* Grows the region of the atlas which has to be
+ * uploaded again by the video driver */
+static void font_renderer_ft_mark_dirty(struct font_atlas *atlas,
+      unsigned x, unsigned y, unsigned width, unsigned height)
+{
+   if (x + width > atlas->width)
+      width  = atlas->width  - x;
+   if (y + height > atlas->height)
+      height = atlas->height - y;
+
+   if (!atlas->dirty)
+   {
+      atlas->dirty_x      = x;
+      atlas->dirty_y      = y;
+      atlas->dirty_width  = width;
+      atlas->dirty_height = height;
+      atlas->dirty        = true;
+   }
+   /* A zero size region already covers the whole atlas */
+   else if (atlas->dirty_width && atlas->dirty_height)
    {
-      freetype_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while (ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
+      unsigned x2         = MAX(atlas->dirty_x + atlas->dirty_width,  x + width);
+      unsigned y2         = MAX(atlas->dirty_y + atlas->dirty_height, y + height);
+      atlas->dirty_x      = MIN(atlas->dirty_x, x);
+      atlas->dirty_y      = MIN(atlas->dirty_y, y);
+      atlas->dirty_width  = x2 - atlas->dirty_x;
+      atlas->dirty_height = y2 - atlas->dirty_y;
    }
+}
+
+static void font_renderer_ft_update_stats(ft_font_renderer_t *handle)
+{
+   uint64_t frame = video_state_get_ptr()->frame_count;
+
+   if (frame == handle->stats_frame)
+      return;
 
-   return &handle->atlas_slots[oldest];
+   if (handle->frame_stats.misses > handle->peak_frame_misses)
+      handle->peak_frame_misses = handle->frame_stats.misses;
+   handle->stats_frame = frame;
+   memset(&handle->frame_stats, 0, sizeof(handle->frame_stats));
 }
 
 static const struct font_glyph *font_renderer_ft_get_glyph(
@@ -138,19 +255,35 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
    if (!handle)
       return NULL;
 
-   map_id     = charcode & 0xFF;
+   font_renderer_ft_update_stats(handle);
+
+   map_id     = FT_ATLAS_HASH(charcode);
    atlas_slot = handle->uc_map[map_id];
 
    while (atlas_slot)
    {
       if (atlas_slot->charcode == charcode)
       {
-         atlas_slot->last_used = handle->usage_counter++;
+         if (handle->lru_head != atlas_slot)
+         {
+            font_renderer_ft_lru_unlink(handle, atlas_slot);
+            font_renderer_ft_lru_push(handle, atlas_slot);
+         }
+         handle->frame_stats.hits++;
+         handle->total_stats.hits++;
          return &atlas_slot->glyph;
       }
       atlas_slot = atlas_slot->next;
    }
 
+   handle->frame_stats.misses++;
+   handle->total_stats.misses++;
+   if (RHMAP_HAS(handle->evicted, charcode + 1))
+   {
+      handle->frame_stats.rasterized_again++;
+      handle->total_stats.rasterized_again++;
+   }
+
    if (FT_Load_Char(handle->face, charcode, FT_LOAD_RENDER))
       return NULL;
 
@@ -159,7 +292,11 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
 
    atlas_slot                      = font_renderer_get_slot(handle);
    atlas_slot->charcode            = charcode;
+   atlas_slot->in_use              = true;
    atlas_slot->next                = handle->uc_map[map_id];
+   atlas_slot->prev_next           = &handle->uc_map[map_id];
+   if (atlas_slot->next)
+      atlas_slot->next->prev_next  = &atlas_slot->next;
    handle->uc_map[map_id]          = atlas_slot;
 
    /* Some glyphs can be blank. */
@@ -204,13 +341,110 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
          memset(dst, 0, handle->max_glyph_width * sizeof(uint8_t));
          dst += handle->atlas.width;
       }
+
+      font_renderer_ft_mark_dirty(&handle->atlas,
+            atlas_slot->glyph.atlas_offset_x,
+            atlas_slot->glyph.atlas_offset_y,
+            MAX(atlas_slot->glyph.width,  handle->max_glyph_width),
+            MAX(atlas_slot->glyph.height, handle->max_glyph_height));
    }
 
-   handle->atlas.dirty = true;
-   atlas_slot->last_used = handle->usage_counter++;
    return &atlas_slot->glyph;
 }
 
+static unsigned font_renderer_ft_get_atlas_pages(void)
+{
+   switch (*msg_hash_get_uint(MSG_HASH_USER_LANGUAGE))
+   {
+      case RETRO_LANGUAGE_JAPANESE:
+      case RETRO_LANGUAGE_KOREAN:
+      case RETRO_LANGUAGE_CHINESE_TRADITIONAL:
+      case RETRO_LANGUAGE_CHINESE_SIMPLIFIED:
+         return FT_ATLAS_MAX_PAGES;
+      case RETRO_LANGUAGE_ARABIC:
+      case RETRO_LANGUAGE_PERSIAN:
+         /* Shaped text uses the presentation forms */
+         return 2;
+      default:
+         break;
+   }
+
+   return 1;
+}
+
+static int font_renderer_ft_uses_cmp(const void *a, const void *b)
+{
+   const struct freetype_codepoint_uses *left  =
+      (const struct freetype_codepoint_uses*)a;
+   const struct freetype_codepoint_uses *right =
+      (const struct freetype_codepoint_uses*)b;
+
+   if (left->uses != right->uses)
+      return (left->uses < right->uses) ? -1 : 1;
+   return (left->charcode < right->charcode) ? -1 : 1;
+}
+
+/* Rasterizes the @count glyphs outside of Latin-1
+ * which the menu strings of the current language
+ * use the most, the most used one last so that it
+ * is the last to be evicted */
+static void font_renderer_ft_prewarm_language(
+      ft_font_renderer_t *handle, unsigned count)
+{
+   size_t i, cap;
+   size_t num_uses                       = 0;
+   unsigned *uses                        = NULL;
+   struct freetype_codepoint_uses *order = NULL;
+
+   for (i = MSG_UNKNOWN + 1; i < MSG_LAST; i++)
+   {
+      const char *str = msg_hash_to_str((enum msg_hash_enums)i);
+
+      if (!str)
+         continue;
+
+      while (*str)
+      {
+         ptrdiff_t idx;
+         uint32_t charcode = utf8_walk(&str);
+
+         if (charcode <= 0xFF)
+            continue;
+
+         if ((idx = RHMAP_IDX(uses, charcode + 1)) != -1)
+            uses[idx]++;
+         else
+            RHMAP_SET(uses, charcode + 1, 1);
+      }
+   }
+
+   if (!RHMAP_LEN(uses))
+      goto end;
+
+   if (!(order = (struct freetype_codepoint_uses*)malloc(
+         RHMAP_LEN(uses) * sizeof(*order))))
+      goto end;
+
+   for (i = 0, cap = RHMAP_CAP(uses); i != cap; i++)
+   {
+      if (RHMAP_KEY(uses, i))
+      {
+         order[num_uses].charcode = RHMAP_KEY(uses, i) - 1;
+         order[num_uses].uses     = uses[i];
+         num_uses++;
+      }
+   }
+
+   qsort(order, num_uses, sizeof(*order), font_renderer_ft_uses_cmp);
+
+   for (i = (num_uses > count) ? num_uses - count : 0; i < num_uses; i++)
+      font_renderer_ft_get_glyph(handle, order[i].charcode);
+
+end:
+   free(order);
+   RHMAP_FREE(uses);
+}
+
 static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_size)
 {
    unsigned i, x, y;
@@ -221,13 +455,31 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
    unsigned max_height         = round((handle->face->bbox.yMax - handle->face->bbox.yMin) 
          * font_size / handle->face->units_per_EM);
 
+   unsigned pages              = font_renderer_ft_get_atlas_pages();
+   unsigned page_height        = (max_height + FT_ATLAS_PADDING) * FT_ATLAS_ROWS;
    unsigned atlas_width        = (max_width  + FT_ATLAS_PADDING) * FT_ATLAS_COLS;
-   unsigned atlas_height       = (max_height + FT_ATLAS_PADDING) * FT_ATLAS_ROWS;
+   unsigned max_atlas_height   = video_driver_get_max_texture_size();
+   unsigned atlas_height;
+   uint8_t *atlas_buffer       = NULL;
+
+   if (!max_atlas_height || max_atlas_height > FT_ATLAS_MAX_HEIGHT)
+      max_atlas_height         = FT_ATLAS_MAX_HEIGHT;
+
+   while (pages > 1 && page_height * pages > max_atlas_height)
+      pages--;
+
+   atlas_height                = page_height * pages;
 
-   uint8_t *atlas_buffer       = (uint8_t*)calloc(atlas_width * atlas_height, 1);
+   if (!(atlas_buffer = (uint8_t*)calloc(atlas_width * atlas_height, 1)))
+      return false;
 
-   if (!atlas_buffer)
+   handle->num_slots           = FT_ATLAS_SIZE * pages;
+   if (!(handle->atlas_slots   = (freetype_atlas_slot_t*)calloc(
+         handle->num_slots, sizeof(*handle->atlas_slots))))
+   {
+      free(atlas_buffer);
       return false;
+   }
 
    handle->max_glyph_width     = max_width;
    handle->max_glyph_height    = max_height;
@@ -236,16 +488,23 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
    handle->atlas.height        = atlas_height;
    slot                        = handle->atlas_slots;
 
-   for (y = 0; y < FT_ATLAS_ROWS; y++)
+   for (y = 0; y < FT_ATLAS_ROWS * pages; y++)
    {
       for (x = 0; x < FT_ATLAS_COLS; x++)
       {
          slot->glyph.atlas_offset_x = x * (max_width  + FT_ATLAS_PADDING);
          slot->glyph.atlas_offset_y = y * (max_height + FT_ATLAS_PADDING);
+         font_renderer_ft_lru_push(handle, slot);
          slot++;
       }
    }
 
+   /* Leave half of the extra pages to text
+    * which doesn't come from the menu */
+   if (pages > 1 && font_driver_get_prewarm())
+      font_renderer_ft_prewarm_language(handle,
+            (handle->num_slots - FT_ATLAS_SIZE) / 2);
+
    for (i = 0; i < 256; i++)
       font_renderer_ft_get_glyph(handle, i);
 
@@ -253,6 +512,11 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
       if (ISALNUM(i))
          font_renderer_ft_get_glyph(handle, i);
 
+   /* Only count the glyphs requested for drawing */
+   memset(&handle->frame_stats, 0, sizeof(handle->frame_stats));
+   memset(&handle->total_stats, 0, sizeof(handle->total_stats));
+   RHMAP_CLEAR(handle->evicted);
+
    return true;
 }
 
@@ -30,6 +30,7 @@
 #include <cstdlib>
 #include <mutex>
 
+#include "slang_cache.hpp"
 #include "../../verbosity.h"
 
 using namespace glslang;
@@ -45,26 +46,35 @@ struct SlangProcess
       TBuiltInResource Resources;
 };
 
-/* We don't use glslang from multiple threads, but to be sure.
- * Initializing TLS and freeing it for glslang works around 
- * a really bizarre issue where the TLS key is suddenly 
- * corrupted *somehow*.
+/* Passes of a preset are compiled from several threads at once,
+ * which glslang supports once the process is initialized, but its
+ * initialization and finalization aren't thread-safe themselves.
+ * The process stays initialized while any thread compiles, and is
+ * finalized after the last one; initializing TLS and freeing it
+ * for glslang works around a really bizarre issue where the TLS
+ * key is suddenly corrupted *somehow*.
  */
 static std::mutex glslang_global_lock;
+static unsigned glslang_process_users;
 
-struct SlangProcessHolder
+void glslang::acquire_process()
 {
-   SlangProcessHolder()
-   {
-      glslang_global_lock.lock();
+   std::lock_guard<std::mutex> holder(glslang_global_lock);
+   if (glslang_process_users++ == 0)
       InitializeProcess();
-   }
+}
 
-   ~SlangProcessHolder()
-   {
+void glslang::release_process()
+{
+   std::lock_guard<std::mutex> holder(glslang_global_lock);
+   if (--glslang_process_users == 0)
       FinalizeProcess();
-      glslang_global_lock.unlock();
-   }
+}
+
+struct SlangProcessHolder
+{
+   SlangProcessHolder()  { glslang::acquire_process(); }
+   ~SlangProcessHolder() { glslang::release_process(); }
 };
 
 SlangProcess::SlangProcess()
@@ -388,7 +398,16 @@ SlangProcess::SlangProcess()
    }
 }
 
-bool glslang::compile_spirv(const string &source, Stage stage,
+/* Part of the SPIR-V cache key, so that a different glslang
+ * compiles everything again */
+static const string &glslang_compiler_version(void)
+{
+   static const string version = string(GetEsslVersionString())
+      + " " + to_string(GetSpirvGeneratorVersion());
+   return version;
+}
+
+static bool glslang_compile(const string &source, glslang::Stage stage,
       std::vector<uint32_t> *spirv)
 {
    string msg;
@@ -457,3 +476,17 @@ bool glslang::compile_spirv(const string &source, Stage stage,
    GlslangToSpv(*program.getIntermediate(language), *spirv);
    return true;
 }
+
+bool glslang::compile_spirv(const string &source, Stage stage,
+      std::vector<uint32_t> *spirv)
+{
+   if (slang_cache_load_spirv(source, stage,
+            glslang_compiler_version(), spirv))
+      return true;
+
+   if (!glslang_compile(source, stage, spirv))
+      return false;
+
+   slang_cache_store_spirv(source, stage, glslang_compiler_version(), *spirv);
+   return true;
+}
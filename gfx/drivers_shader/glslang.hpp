@@ -18,6 +18,11 @@ namespace glslang
     };
 
     bool compile_spirv(const std::string &source, Stage stage, std::vector<uint32_t> *spirv);
+
+    /* Keep glslang initialized across compile_spirv() calls,
+     * which otherwise rebuild its built-in symbol tables. */
+    void acquire_process();
+    void release_process();
 }
 
 #endif
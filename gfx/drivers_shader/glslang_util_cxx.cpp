@@ -19,10 +19,14 @@
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <features/features_cpu.h>
 #include <file/file_path.h>
 #include <file/config_file.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
+#ifdef HAVE_THREADS
+#include <rthreads/tpool.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "../../config.h"
@@ -250,3 +254,107 @@ error:
 
    return false;
 }
+
+struct glslang_pass_job
+{
+   const std::function<bool(unsigned)> *fn;
+   retro_time_t time;
+   unsigned index;
+   bool ok;
+};
+
+static void glslang_run_pass(void *data)
+{
+   glslang_pass_job *job = (glslang_pass_job*)data;
+   retro_time_t start    = cpu_features_get_time_usec();
+
+   job->ok               = (*job->fn)(job->index);
+   job->time             = cpu_features_get_time_usec() - start;
+}
+
+bool glslang_run_passes(unsigned count, const char *what,
+      const std::function<bool(unsigned)> &fn)
+{
+   unsigned i;
+   std::vector<glslang_pass_job> jobs(count);
+   retro_time_t start = cpu_features_get_time_usec();
+   unsigned threads   = 1;
+   bool ok            = true;
+#ifdef HAVE_THREADS
+   tpool_t *tp        = NULL;
+
+   threads            = cpu_features_get_core_amount();
+   if (threads > count)
+      threads = count;
+   if (threads > GLSLANG_MAX_THREADS)
+      threads = GLSLANG_MAX_THREADS;
+   if (threads > 1 && !(tp = tpool_create(threads)))
+      threads = 1;
+#endif
+
+   for (i = 0; i < count; i++)
+   {
+      jobs[i].fn    = &fn;
+      jobs[i].time  = 0;
+      jobs[i].index = i;
+      jobs[i].ok    = false;
+#ifdef HAVE_THREADS
+      if (tp && tpool_add_work(tp, glslang_run_pass, &jobs[i]))
+         continue;
+#endif
+      glslang_run_pass(&jobs[i]);
+   }
+
+#ifdef HAVE_THREADS
+   if (tp)
+   {
+      tpool_wait(tp);
+      tpool_destroy(tp);
+   }
+#endif
+
+   for (i = 0; i < count; i++)
+   {
+      if (jobs[i].ok)
+         RARCH_LOG("[slang]: %s pass #%u in %.2f ms.\n",
+               what, i, jobs[i].time / 1000.0);
+      else
+         ok = false;
+   }
+
+   RARCH_LOG("[slang]: %s %u passes in %.2f ms on %u thread(s).\n",
+         what, count, (cpu_features_get_time_usec() - start) / 1000.0,
+         threads);
+
+   return ok;
+}
+
+bool glslang_compile_shaders(const struct video_shader *shader,
+      std::vector<glslang_output> *outputs)
+{
+   bool ret;
+
+   outputs->clear();
+   outputs->resize(shader->passes);
+
+#if defined(HAVE_GLSLANG)
+   glslang::acquire_process();
+#endif
+   ret = glslang_run_passes(shader->passes, "Compiled",
+         [&](unsigned i) -> bool
+         {
+            if (!glslang_compile_shader(shader->pass[i].source.path,
+                     &(*outputs)[i]))
+            {
+               RARCH_ERR("[slang]: Failed to compile pass #%u: \"%s\".\n",
+                     i, shader->pass[i].source.path);
+               return false;
+            }
+            return true;
+         });
+#if defined(HAVE_GLSLANG)
+   glslang::release_process();
+#endif
+
+   return ret;
+}
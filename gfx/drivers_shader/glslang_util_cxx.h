@@ -21,6 +21,7 @@
 
 #include <lists/string_list.h>
 
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -53,8 +54,33 @@ struct glslang_output
    glslang_meta meta;
 };
 
+/* Maximum number of threads a preset's passes are compiled and reflected on */
+#define GLSLANG_MAX_THREADS 16
+
+struct video_shader;
+
 bool glslang_compile_shader(const char *shader_path, glslang_output *output);
 
+/**
+ * glslang_run_passes:
+ * @what  : Logged with the time each pass took, e.g. "Compiled".
+ *
+ * Calls @fn for passes 0 to @count - 1 on a worker pool, which
+ * must not touch the graphics API, and waits for all of them.
+ *
+ * Returns: false if @fn failed for any pass.
+ **/
+bool glslang_run_passes(unsigned count, const char *what,
+      const std::function<bool(unsigned)> &fn);
+
+/**
+ * glslang_compile_shaders:
+ *
+ * Compiles all passes of @shader concurrently into @outputs.
+ **/
+bool glslang_compile_shaders(const struct video_shader *shader,
+      std::vector<glslang_output> *outputs);
+
 /* Helpers for internal use. */
 bool glslang_parse_meta(const struct string_list *lines, glslang_meta *meta);
 
@@ -896,6 +896,7 @@ public:
                    const uint32_t *spirv,
                    size_t spirv_words);
 
+   bool reflect();
    bool build();
    bool init_feedback();
 
@@ -1058,19 +1059,13 @@ private:
    void reflect_parameter_array(const char *name, std::vector<slang_texture_semantic_meta> &meta);
 };
 
-bool Pass::build()
+/* Doesn't touch GL, passes are reflected concurrently */
+bool Pass::reflect()
 {
    std::unordered_map<std::string, slang_semantic_map> semantic_map;
    unsigned i;
    unsigned j = 0;
 
-   framebuffer.reset();
-   framebuffer_feedback.reset();
-
-   if (!final_pass)
-      framebuffer = std::unique_ptr<Framebuffer>(
-            new Framebuffer(pass_info.rt_format, pass_info.max_levels));
-
    for (i = 0; i < parameters.size(); i++)
    {
       if (!slang_set_unique_map(semantic_map, parameters[i].id,
@@ -1098,6 +1093,18 @@ bool Pass::build()
          filtered_parameters.push_back(parameters[i]);
    }
 
+   return true;
+}
+
+bool Pass::build()
+{
+   framebuffer.reset();
+   framebuffer_feedback.reset();
+
+   if (!final_pass)
+      framebuffer = std::unique_ptr<Framebuffer>(
+            new Framebuffer(pass_info.rt_format, pass_info.max_levels));
+
    if (!init_pipeline())
       return false;
 
@@ -2243,6 +2250,10 @@ bool gl3_filter_chain::init()
    if (!init_alias())
       return false;
 
+   if (!glslang_run_passes((unsigned)passes.size(), "Reflected",
+            [&](unsigned j) { return passes[j]->reflect(); }))
+      return false;
+
    for (i = 0; i < passes.size(); i++)
    {
       RARCH_LOG("[slang]: Building pass #%u (%s)\n", i,
@@ -2479,6 +2490,7 @@ gl3_filter_chain_t *gl3_filter_chain_create_from_preset(
       const char *path, glslang_filter_chain_filter filter)
 {
    unsigned i;
+   std::vector<glslang_output> outputs;
    std::unique_ptr<video_shader> shader{ new video_shader() };
    if (!shader)
       return nullptr;
@@ -2499,9 +2511,17 @@ gl3_filter_chain_t *gl3_filter_chain_create_from_preset(
 
    shader->num_parameters = 0;
 
+   /* Passes are independent until their programs are built */
+   if (!glslang_compile_shaders(shader.get(), &outputs))
+   {
+      RARCH_ERR("[GLCore]: Failed to compile shader preset: \"%s\".\n",
+            path);
+      return nullptr;
+   }
+
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output             = outputs[i];
       struct gl3_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -2517,13 +2537,6 @@ gl3_filter_chain_t *gl3_filter_chain_create_from_preset(
       pass_info.address       = GLSLANG_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
-      {
-         RARCH_ERR("[GLCore]: Failed to compile shader: \"%s\".\n",
-               pass->source.path);
-         return nullptr;
-      }
-
       for (auto &meta_param : output.meta.parameters)
       {
          if (shader->num_parameters >= GFX_MAX_PARAMETERS)
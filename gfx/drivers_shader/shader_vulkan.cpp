@@ -532,6 +532,7 @@ class Pass
             const uint32_t *spirv,
             size_t spirv_words);
 
+      bool reflect();
       bool build();
       bool init_feedback();
 
@@ -1629,6 +1630,10 @@ bool vulkan_filter_chain::init()
    if (!init_alias())
       return false;
 
+   if (!glslang_run_passes((unsigned)passes.size(), "Reflected",
+            [&](unsigned j) { return passes[j]->reflect(); }))
+      return false;
+
    for (i = 0; i < passes.size(); i++)
    {
 #ifdef VULKAN_DEBUG
@@ -2399,21 +2404,13 @@ bool Pass::init_feedback()
    return true;
 }
 
-bool Pass::build()
+/* Doesn't touch Vulkan, passes are reflected concurrently */
+bool Pass::reflect()
 {
    unsigned i;
    unsigned j = 0;
    std::unordered_map<std::string, slang_semantic_map> semantic_map;
 
-   framebuffer.reset();
-   fb_feedback.reset();
-
-   if (!final_pass)
-      framebuffer = std::unique_ptr<Framebuffer>(
-            new Framebuffer(device, memory_properties,
-               current_framebuffer_size,
-               pass_info.rt_format, pass_info.max_levels));
-
    for (i = 0; i < parameters.size(); i++)
    {
       if (!slang_set_unique_map(
@@ -2442,6 +2439,20 @@ bool Pass::build()
          filtered_parameters.push_back(parameters[i]);
    }
 
+   return true;
+}
+
+bool Pass::build()
+{
+   framebuffer.reset();
+   fb_feedback.reset();
+
+   if (!final_pass)
+      framebuffer = std::unique_ptr<Framebuffer>(
+            new Framebuffer(device, memory_properties,
+               current_framebuffer_size,
+               pass_info.rt_format, pass_info.max_levels));
+
    return init_pipeline();
 }
 
@@ -3042,6 +3053,7 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
       const char *path, glslang_filter_chain_filter filter)
 {
    unsigned i;
+   std::vector<glslang_output> outputs;
    std::unique_ptr<video_shader> shader{ new video_shader() };
 
    if (!shader)
@@ -3064,9 +3076,17 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
 
    shader->num_parameters = 0;
 
+   /* Passes are independent until their pipelines are built */
+   if (!glslang_compile_shaders(shader.get(), &outputs))
+   {
+      RARCH_ERR("[Vulkan]: Failed to compile shader preset: \"%s\".\n",
+            path);
+      goto error;
+   }
+
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output             = outputs[i];
       struct vulkan_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -3082,13 +3102,6 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
       pass_info.address       = GLSLANG_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
-      {
-         RARCH_ERR("[Vulkan]: Failed to compile shader: \"%s\".\n",
-               pass->source.path);
-         goto error;
-      }
-
       for (auto &meta_param : output.meta.parameters)
       {
          if (shader->num_parameters >= GFX_MAX_PARAMETERS)
@@ -0,0 +1,756 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <retro_dirent.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "slang_cache.hpp"
+#include "../../verbosity.h"
+
+#define SLANG_CACHE_MAGIC       "RASLANGC"
+/* Bump when the compile options or the reflection change */
+#define SLANG_CACHE_VERSION     1
+#define SLANG_CACHE_BYTE_ORDER  0x01020304
+#define SLANG_CACHE_MAX_PAYLOAD (16 * 1024 * 1024)
+#define SLANG_CACHE_SPIRV_MAGIC 0x07230203
+/* Every edit of a shader adds files, the least recently used
+ * ones are deleted once they take up more than this */
+#define SLANG_CACHE_MAX_SIZE    (64 * 1024 * 1024)
+/* In seconds, temporary files older than this are abandoned */
+#define SLANG_CACHE_TMP_MAX_AGE (60 * 60)
+
+enum slang_cache_kind
+{
+   SLANG_CACHE_SPIRV = 0,
+   SLANG_CACHE_REFLECTION
+};
+
+/* Header of a cache file, in the byte order of the machine that
+ * wrote it. The file is named after 'hash', 'check' is a second
+ * hash of the same key guarding against collisions. The payload
+ * follows: SPIR-V words, or the serialized reflection. */
+struct slang_cache_header
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t byte_order;
+   uint32_t kind;
+   uint32_t payload_size;
+   uint64_t hash;
+   uint64_t check;
+};
+
+struct slang_cache_hasher
+{
+   uint64_t hash  = 0xcbf29ce484222325ULL;
+   uint64_t check = 0x6a09e667f3bcc909ULL;
+
+   /* 64-bit FNV-1a, and a second hash with another multiplier */
+   void add(const void *data, size_t len)
+   {
+      const uint8_t *p = (const uint8_t*)data;
+
+      while (len--)
+      {
+         hash   ^= *p;
+         hash   *= 0x100000001b3ULL;
+         check  += *p++;
+         check  *= 0x9e3779b97f4a7c15ULL;
+         check  ^= check >> 29;
+      }
+   }
+
+   void add_u32(uint32_t v) { add(&v, sizeof(v)); }
+
+   void add_string(const std::string &s)
+   {
+      add_u32((uint32_t)s.size());
+      add(s.data(), s.size());
+   }
+
+   void add_words(const std::vector<uint32_t> &words)
+   {
+      add_u32((uint32_t)words.size());
+      add(words.data(), words.size() * sizeof(uint32_t));
+   }
+};
+
+struct slang_cache_reader
+{
+   const uint8_t *data;
+   size_t size;
+   size_t pos;
+   bool ok;
+
+   bool has(size_t len)
+   {
+      if (!ok || len > size - pos)
+         ok = false;
+      return ok;
+   }
+
+   uint32_t u32()
+   {
+      uint32_t v = 0;
+      if (has(sizeof(v)))
+      {
+         memcpy(&v, data + pos, sizeof(v));
+         pos += sizeof(v);
+      }
+      return v;
+   }
+
+   uint64_t u64()
+   {
+      uint64_t v = 0;
+      if (has(sizeof(v)))
+      {
+         memcpy(&v, data + pos, sizeof(v));
+         pos += sizeof(v);
+      }
+      return v;
+   }
+};
+
+struct slang_cache_entry
+{
+   uint64_t size;
+   int64_t last_used; /* Time of last use, or of writing */
+};
+
+static std::mutex slang_cache_lock;
+static std::string slang_cache_dir;
+static struct slang_cache_stats slang_cache_stats_st;
+/* Files in the cache directory, keyed by file name */
+static std::unordered_map<std::string, slang_cache_entry> slang_cache_entries;
+static uint64_t slang_cache_total_size;
+static unsigned slang_cache_tmp_counter;
+static bool slang_cache_scanned;
+
+static void slang_cache_file_name(const slang_cache_hasher &key,
+      enum slang_cache_kind kind, char *s, size_t len)
+{
+   snprintf(s, len, "%016llx%s",
+         (unsigned long long)key.hash,
+         kind == SLANG_CACHE_SPIRV ? ".spv" : ".refl");
+}
+
+static void slang_cache_file_path(const std::string &dir,
+      const slang_cache_hasher &key, enum slang_cache_kind kind,
+      char *s, size_t len)
+{
+   char name[32];
+
+   slang_cache_file_name(key, kind, name, sizeof(name));
+   fill_pathname_join_special(s, dir.c_str(), name, len);
+}
+
+static void slang_cache_forget(const std::string &name)
+{
+   auto it = slang_cache_entries.find(name);
+
+   if (it != slang_cache_entries.end())
+   {
+      slang_cache_total_size -= it->second.size;
+      slang_cache_entries.erase(it);
+   }
+}
+
+/* Builds the index of the files already in the cache, the
+ * first time one is written; called with the lock held */
+static void slang_cache_scan(void)
+{
+   struct RDIR *dir;
+
+   slang_cache_scanned = true;
+
+   if (!(dir = retro_opendir(slang_cache_dir.c_str())))
+      return;
+
+   while (retro_readdir(dir))
+   {
+      char file_path[PATH_MAX_LENGTH];
+      slang_cache_entry entry;
+      int64_t size, mtime;
+      const char *name = retro_dirent_get_name(dir);
+
+      if (retro_dirent_is_dir(dir, NULL))
+         continue;
+
+      fill_pathname_join_special(file_path, slang_cache_dir.c_str(), name,
+            sizeof(file_path));
+
+      /* Left over by an interrupted write; recent ones may still
+       * be written by another instance */
+      if (string_ends_with(name, ".tmp"))
+      {
+         if (     path_get_size_mtime(file_path, &size, &mtime)
+               && mtime < (int64_t)time(NULL) - SLANG_CACHE_TMP_MAX_AGE)
+            filestream_delete(file_path);
+         continue;
+      }
+
+      if (     (  !string_ends_with(name, ".spv")
+               && !string_ends_with(name, ".refl"))
+            || !path_get_size_mtime(file_path, &size, &mtime))
+         continue;
+
+      entry.size      = (uint64_t)size;
+      entry.last_used = mtime;
+      slang_cache_forget(name);
+      slang_cache_entries[name] = entry;
+      slang_cache_total_size   += entry.size;
+   }
+
+   retro_closedir(dir);
+}
+
+/* Deletes the least recently used files until the cache is
+ * back to 3/4 of its size limit; called with the lock held */
+static void slang_cache_evict(void)
+{
+   size_t i;
+   uint64_t target = SLANG_CACHE_MAX_SIZE - SLANG_CACHE_MAX_SIZE / 4;
+   std::vector<std::pair<int64_t, std::string> > victims;
+
+   victims.reserve(slang_cache_entries.size());
+   for (const auto &it : slang_cache_entries)
+      victims.push_back(std::make_pair(it.second.last_used, it.first));
+
+   std::sort(victims.begin(), victims.end());
+
+   for (i = 0; i < victims.size() && slang_cache_total_size > target; i++)
+   {
+      char file_path[PATH_MAX_LENGTH];
+
+      fill_pathname_join_special(file_path, slang_cache_dir.c_str(),
+            victims[i].second.c_str(), sizeof(file_path));
+      filestream_delete(file_path);
+      slang_cache_forget(victims[i].second);
+      slang_cache_stats_st.evictions++;
+   }
+}
+
+/* Keeps the least recently used order up to date */
+static void slang_cache_touch(const slang_cache_hasher &key,
+      enum slang_cache_kind kind)
+{
+   char name[32];
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+
+   slang_cache_file_name(key, kind, name, sizeof(name));
+
+   auto it = slang_cache_entries.find(name);
+   if (it != slang_cache_entries.end())
+      it->second.last_used = (int64_t)time(NULL);
+}
+
+/* Accounts for a file just written, deleting old ones if
+ * that takes the cache over its size limit */
+static void slang_cache_add(const std::string &dir,
+      const slang_cache_hasher &key, enum slang_cache_kind kind,
+      uint64_t size)
+{
+   char name[32];
+   slang_cache_entry entry;
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+
+   /* The directory changed while writing */
+   if (dir != slang_cache_dir)
+      return;
+
+   if (!slang_cache_scanned)
+      slang_cache_scan();
+
+   slang_cache_file_name(key, kind, name, sizeof(name));
+
+   entry.size      = size;
+   entry.last_used = (int64_t)time(NULL);
+   slang_cache_forget(name);
+   slang_cache_entries[name] = entry;
+   slang_cache_total_size   += entry.size;
+
+   if (slang_cache_total_size > SLANG_CACHE_MAX_SIZE)
+      slang_cache_evict();
+}
+
+/* Returns the payload of the cache file for 'key', or an empty
+ * vector when there is none or it can't be used */
+static std::vector<uint8_t> slang_cache_read(const slang_cache_hasher &key,
+      enum slang_cache_kind kind)
+{
+   std::vector<uint8_t> payload;
+   struct slang_cache_header header;
+   char file_path[PATH_MAX_LENGTH];
+   std::string dir;
+   void *buf   = NULL;
+   int64_t len = 0;
+
+   slang_cache_lock.lock();
+   dir = slang_cache_dir;
+   slang_cache_lock.unlock();
+
+   if (dir.empty())
+      return payload;
+
+   slang_cache_file_path(dir, key, kind, file_path, sizeof(file_path));
+
+   if (     !path_is_valid(file_path)
+         || !filestream_read_file(file_path, &buf, &len))
+      return payload;
+
+   if ((size_t)len >= sizeof(header))
+   {
+      memcpy(&header, buf, sizeof(header));
+
+      if (     !memcmp(header.magic, SLANG_CACHE_MAGIC, sizeof(header.magic))
+            && header.version      == SLANG_CACHE_VERSION
+            && header.byte_order   == SLANG_CACHE_BYTE_ORDER
+            && header.kind         == (uint32_t)kind
+            && header.hash         == key.hash
+            && header.check        == key.check
+            && header.payload_size == (uint64_t)len - sizeof(header))
+         payload.assign((const uint8_t*)buf + sizeof(header),
+               (const uint8_t*)buf + len);
+   }
+
+   free(buf);
+
+   if (!payload.empty())
+      slang_cache_touch(key, kind);
+   return payload;
+}
+
+static void slang_cache_write(const slang_cache_hasher &key,
+      enum slang_cache_kind kind, const void *payload, size_t payload_size)
+{
+   struct slang_cache_header header;
+   char file_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH + 32];
+   std::string dir;
+   unsigned tmp_counter;
+   RFILE *file;
+   bool written;
+
+   if (payload_size > SLANG_CACHE_MAX_PAYLOAD)
+      return;
+
+   slang_cache_lock.lock();
+   dir         = slang_cache_dir;
+   tmp_counter = slang_cache_tmp_counter++;
+   slang_cache_lock.unlock();
+
+   if (dir.empty())
+      return;
+
+   if (!path_is_directory(dir.c_str()) && !path_mkdir(dir.c_str()))
+      return;
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, SLANG_CACHE_MAGIC, sizeof(header.magic));
+   header.version      = SLANG_CACHE_VERSION;
+   header.byte_order   = SLANG_CACHE_BYTE_ORDER;
+   header.kind         = kind;
+   header.payload_size = (uint32_t)payload_size;
+   header.hash         = key.hash;
+   header.check        = key.check;
+
+   slang_cache_file_path(dir, key, kind, file_path, sizeof(file_path));
+   /* Unique, passes may be compiled concurrently, and several
+    * instances may share the cache directory */
+#ifdef _WIN32
+   snprintf(tmp_path, sizeof(tmp_path), "%s.%u.%u.tmp", file_path,
+         (unsigned)_getpid(), tmp_counter);
+#else
+   snprintf(tmp_path, sizeof(tmp_path), "%s.%u.%u.tmp", file_path,
+         (unsigned)getpid(), tmp_counter);
+#endif
+
+   if (!(file = filestream_open(tmp_path, RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return;
+
+   written =
+         filestream_write(file, &header, sizeof(header)) == sizeof(header)
+      && filestream_write(file, payload, payload_size)
+         == (int64_t)payload_size;
+
+   if (filestream_close(file) != 0)
+      written = false;
+
+   if (written)
+   {
+      filestream_delete(file_path);
+      written = (filestream_rename(tmp_path, file_path) == 0);
+   }
+
+   if (!written)
+      filestream_delete(tmp_path);
+   else
+      slang_cache_add(dir, key, kind, sizeof(header) + payload_size);
+}
+
+static bool slang_cache_is_enabled(void)
+{
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+   return !slang_cache_dir.empty();
+}
+
+static void slang_cache_count(bool hit, enum slang_cache_kind kind)
+{
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+
+   if (kind == SLANG_CACHE_SPIRV)
+   {
+      if (hit)
+         slang_cache_stats_st.spirv_hits++;
+      else
+         slang_cache_stats_st.spirv_misses++;
+   }
+   else
+   {
+      if (hit)
+         slang_cache_stats_st.reflection_hits++;
+      else
+         slang_cache_stats_st.reflection_misses++;
+   }
+}
+
+static slang_cache_hasher slang_cache_spirv_key(const std::string &source,
+      unsigned stage, const std::string &compiler)
+{
+   slang_cache_hasher key;
+
+   key.add_u32(SLANG_CACHE_SPIRV);
+   key.add_u32(stage);
+   key.add_string(compiler);
+   key.add_string(source);
+   return key;
+}
+
+bool slang_cache_load_spirv(const std::string &source, unsigned stage,
+      const std::string &compiler, std::vector<uint32_t> *spirv)
+{
+   uint32_t magic = 0;
+   std::vector<uint8_t> payload;
+
+   if (!slang_cache_is_enabled())
+      return false;
+
+   payload = slang_cache_read(
+         slang_cache_spirv_key(source, stage, compiler), SLANG_CACHE_SPIRV);
+
+   if (payload.size() >= sizeof(magic))
+      memcpy(&magic, payload.data(), sizeof(magic));
+
+   if (     magic != SLANG_CACHE_SPIRV_MAGIC
+         || (payload.size() % sizeof(uint32_t)) != 0)
+   {
+      slang_cache_count(false, SLANG_CACHE_SPIRV);
+      return false;
+   }
+
+   spirv->resize(payload.size() / sizeof(uint32_t));
+   memcpy(spirv->data(), payload.data(), payload.size());
+   slang_cache_count(true, SLANG_CACHE_SPIRV);
+   return true;
+}
+
+void slang_cache_store_spirv(const std::string &source, unsigned stage,
+      const std::string &compiler, const std::vector<uint32_t> &spirv)
+{
+   slang_cache_write(slang_cache_spirv_key(source, stage, compiler),
+         SLANG_CACHE_SPIRV, spirv.data(), spirv.size() * sizeof(uint32_t));
+}
+
+template <typename P>
+static void slang_cache_hash_map(slang_cache_hasher &key,
+      const std::unordered_map<std::string, P> *m)
+{
+   std::vector<const std::pair<const std::string, P>*> entries;
+
+   if (!m)
+   {
+      key.add_u32(0xffffffff);
+      return;
+   }
+
+   /* Iteration order of the map isn't stable */
+   for (auto &entry : *m)
+      entries.push_back(&entry);
+   std::sort(entries.begin(), entries.end(),
+         [](const std::pair<const std::string, P> *a,
+            const std::pair<const std::string, P> *b)
+         { return a->first < b->first; });
+
+   key.add_u32((uint32_t)entries.size());
+   for (auto entry : entries)
+   {
+      key.add_string(entry->first);
+      key.add_u32((uint32_t)entry->second.semantic);
+      key.add_u32(entry->second.index);
+   }
+}
+
+static slang_cache_hasher slang_cache_reflection_key(
+      const std::vector<uint32_t> &vertex,
+      const std::vector<uint32_t> &fragment,
+      const slang_reflection &reflection)
+{
+   slang_cache_hasher key;
+
+   key.add_u32(SLANG_CACHE_REFLECTION);
+   key.add_words(vertex);
+   key.add_words(fragment);
+   key.add_u32(reflection.pass_number);
+   slang_cache_hash_map(key, reflection.texture_semantic_map);
+   slang_cache_hash_map(key, reflection.texture_semantic_uniform_map);
+   slang_cache_hash_map(key, reflection.semantic_map);
+   return key;
+}
+
+static void slang_cache_put_u32(std::vector<uint8_t> &buf, uint32_t v)
+{
+   const uint8_t *p = (const uint8_t*)&v;
+   buf.insert(buf.end(), p, p + sizeof(v));
+}
+
+static void slang_cache_put_u64(std::vector<uint8_t> &buf, uint64_t v)
+{
+   const uint8_t *p = (const uint8_t*)&v;
+   buf.insert(buf.end(), p, p + sizeof(v));
+}
+
+#define SLANG_CACHE_FLAG_TEXTURE       (1 << 0)
+#define SLANG_CACHE_FLAG_UNIFORM       (1 << 1)
+#define SLANG_CACHE_FLAG_PUSH_CONSTANT (1 << 2)
+
+/* Serialized sizes, to check counts against what is left */
+#define SLANG_CACHE_TEXTURE_META_SIZE  (8 + 8 + 4 + 4 + 4)
+#define SLANG_CACHE_SEMANTIC_META_SIZE (8 + 8 + 4 + 4)
+
+static void slang_cache_put_semantic(std::vector<uint8_t> &buf,
+      const slang_semantic_meta &meta)
+{
+   slang_cache_put_u64(buf, meta.ubo_offset);
+   slang_cache_put_u64(buf, meta.push_constant_offset);
+   slang_cache_put_u32(buf, meta.num_components);
+   slang_cache_put_u32(buf,
+           (meta.uniform       ? SLANG_CACHE_FLAG_UNIFORM       : 0)
+         | (meta.push_constant ? SLANG_CACHE_FLAG_PUSH_CONSTANT : 0));
+}
+
+static void slang_cache_get_semantic(slang_cache_reader &reader,
+      slang_semantic_meta &meta)
+{
+   uint32_t flags;
+
+   meta                      = slang_semantic_meta();
+   meta.ubo_offset           = (size_t)reader.u64();
+   meta.push_constant_offset = (size_t)reader.u64();
+   meta.num_components       = reader.u32();
+   flags                     = reader.u32();
+   meta.uniform              = !!(flags & SLANG_CACHE_FLAG_UNIFORM);
+   meta.push_constant        = !!(flags & SLANG_CACHE_FLAG_PUSH_CONSTANT);
+}
+
+bool slang_cache_load_reflection(const std::vector<uint32_t> &vertex,
+      const std::vector<uint32_t> &fragment, slang_reflection *reflection)
+{
+   unsigned i;
+   uint32_t count;
+   slang_cache_reader reader;
+   std::vector<uint8_t> payload;
+   slang_reflection result;
+
+   if (!slang_cache_is_enabled())
+      return false;
+
+   payload     = slang_cache_read(slang_cache_reflection_key(
+            vertex, fragment, *reflection), SLANG_CACHE_REFLECTION);
+   reader.data = payload.data();
+   reader.size = payload.size();
+   reader.pos  = 0;
+   reader.ok   = !payload.empty();
+
+   result.ubo_size                 = (size_t)reader.u64();
+   result.push_constant_size       = (size_t)reader.u64();
+   result.ubo_binding              = reader.u32();
+   result.ubo_stage_mask           = reader.u32();
+   result.push_constant_stage_mask = reader.u32();
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS && reader.ok; i++)
+   {
+      unsigned j;
+
+      count = reader.u32();
+      if (!reader.has((size_t)count * SLANG_CACHE_TEXTURE_META_SIZE))
+         break;
+
+      result.semantic_textures[i].resize(count);
+      for (j = 0; j < count; j++)
+      {
+         uint32_t flags;
+         slang_texture_semantic_meta &meta = result.semantic_textures[i][j];
+
+         meta.ubo_offset           = (size_t)reader.u64();
+         meta.push_constant_offset = (size_t)reader.u64();
+         meta.binding              = reader.u32();
+         meta.stage_mask           = reader.u32();
+         flags                     = reader.u32();
+         meta.texture              = !!(flags & SLANG_CACHE_FLAG_TEXTURE);
+         meta.uniform              = !!(flags & SLANG_CACHE_FLAG_UNIFORM);
+         meta.push_constant        = !!(flags & SLANG_CACHE_FLAG_PUSH_CONSTANT);
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      slang_cache_get_semantic(reader, result.semantics[i]);
+
+   count = reader.u32();
+   if (reader.has((size_t)count * SLANG_CACHE_SEMANTIC_META_SIZE))
+   {
+      result.semantic_float_parameters.resize(count);
+      for (i = 0; i < count; i++)
+         slang_cache_get_semantic(reader,
+               result.semantic_float_parameters[i]);
+   }
+
+   if (!reader.ok || reader.pos != reader.size)
+   {
+      slang_cache_count(false, SLANG_CACHE_REFLECTION);
+      return false;
+   }
+
+   /* The maps and pass number stay the caller's */
+   result.texture_semantic_map         = reflection->texture_semantic_map;
+   result.texture_semantic_uniform_map = reflection->texture_semantic_uniform_map;
+   result.semantic_map                 = reflection->semantic_map;
+   result.pass_number                  = reflection->pass_number;
+   *reflection                         = std::move(result);
+
+   slang_cache_count(true, SLANG_CACHE_REFLECTION);
+   return true;
+}
+
+void slang_cache_store_reflection(const std::vector<uint32_t> &vertex,
+      const std::vector<uint32_t> &fragment,
+      const slang_reflection &reflection)
+{
+   unsigned i;
+   std::vector<uint8_t> buf;
+
+   slang_cache_put_u64(buf, reflection.ubo_size);
+   slang_cache_put_u64(buf, reflection.push_constant_size);
+   slang_cache_put_u32(buf, reflection.ubo_binding);
+   slang_cache_put_u32(buf, reflection.ubo_stage_mask);
+   slang_cache_put_u32(buf, reflection.push_constant_stage_mask);
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      slang_cache_put_u32(buf,
+            (uint32_t)reflection.semantic_textures[i].size());
+      for (auto &meta : reflection.semantic_textures[i])
+      {
+         slang_cache_put_u64(buf, meta.ubo_offset);
+         slang_cache_put_u64(buf, meta.push_constant_offset);
+         slang_cache_put_u32(buf, meta.binding);
+         slang_cache_put_u32(buf, meta.stage_mask);
+         slang_cache_put_u32(buf,
+                 (meta.texture       ? SLANG_CACHE_FLAG_TEXTURE       : 0)
+               | (meta.uniform       ? SLANG_CACHE_FLAG_UNIFORM       : 0)
+               | (meta.push_constant ? SLANG_CACHE_FLAG_PUSH_CONSTANT : 0));
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      slang_cache_put_semantic(buf, reflection.semantics[i]);
+
+   slang_cache_put_u32(buf,
+         (uint32_t)reflection.semantic_float_parameters.size());
+   for (auto &meta : reflection.semantic_float_parameters)
+      slang_cache_put_semantic(buf, meta);
+
+   slang_cache_write(slang_cache_reflection_key(vertex, fragment, reflection),
+         SLANG_CACHE_REFLECTION, buf.data(), buf.size());
+}
+
+void slang_cache_set_dir(const char *dir)
+{
+   char cache_dir[PATH_MAX_LENGTH];
+
+   cache_dir[0] = '\0';
+
+   if (!string_is_empty(dir))
+      fill_pathname_join_special(cache_dir, dir, SLANG_CACHE_DIR,
+            sizeof(cache_dir));
+
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+
+   if (slang_cache_dir != cache_dir)
+   {
+      slang_cache_dir = cache_dir;
+      slang_cache_entries.clear();
+      slang_cache_total_size = 0;
+      slang_cache_scanned    = false;
+   }
+}
+
+void slang_cache_get_stats(struct slang_cache_stats *stats)
+{
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+   *stats = slang_cache_stats_st;
+}
+
+void slang_cache_deinit(void)
+{
+   std::lock_guard<std::mutex> holder(slang_cache_lock);
+   struct slang_cache_stats *stats = &slang_cache_stats_st;
+
+   if (     stats->spirv_hits      || stats->spirv_misses
+         || stats->reflection_hits || stats->reflection_misses)
+      RARCH_LOG("[slang]: Cache: %u of %u shader stages and %u of %u"
+            " reflections loaded from the cache, %u files evicted.\n",
+            stats->spirv_hits, stats->spirv_hits + stats->spirv_misses,
+            stats->reflection_hits,
+            stats->reflection_hits + stats->reflection_misses,
+            stats->evictions);
+
+   memset(stats, 0, sizeof(*stats));
+   slang_cache_dir.clear();
+   slang_cache_entries.clear();
+   slang_cache_total_size = 0;
+   slang_cache_scanned    = false;
+}
@@ -0,0 +1,54 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLANG_CACHE_H_
+#define SLANG_CACHE_H_
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Directory of the slang cache, inside the cache directory */
+#define SLANG_CACHE_DIR "slang_cache"
+
+struct slang_cache_stats
+{
+   unsigned spirv_hits;
+   unsigned spirv_misses;
+   unsigned reflection_hits;
+   unsigned reflection_misses;
+   unsigned evictions;         /* Files deleted to stay under the size limit */
+};
+
+/**
+ * slang_cache_set_dir:
+ * @dir : Cache directory, NULL or empty to disable the cache.
+ *
+ * Loading a slang preset does it with the current settings.
+ **/
+void slang_cache_set_dir(const char *dir);
+
+void slang_cache_get_stats(struct slang_cache_stats *stats);
+
+/**
+ * slang_cache_deinit:
+ *
+ * Logs the cache statistics and disables the cache.
+ **/
+void slang_cache_deinit(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,50 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLANG_CACHE_HPP_
+#define SLANG_CACHE_HPP_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "slang_cache.h"
+#include "slang_reflection.h"
+#include "slang_reflection.hpp"
+
+/* Content addressed cache of what loading a slang shader computes.
+ *
+ * SPIR-V is keyed by the stage source (with its #includes
+ * expanded), the stage and the compiler version, so that editing
+ * a shader or any file it includes misses, and the entry it
+ * replaces is simply never looked up again.
+ *
+ * Reflection is keyed by the SPIR-V of both stages, the pass
+ * number and the semantic maps the reflection is made against,
+ * as aliases and parameters of other passes change the result. */
+
+bool slang_cache_load_spirv(const std::string &source, unsigned stage,
+      const std::string &compiler, std::vector<uint32_t> *spirv);
+
+void slang_cache_store_spirv(const std::string &source, unsigned stage,
+      const std::string &compiler, const std::vector<uint32_t> &spirv);
+
+bool slang_cache_load_reflection(const std::vector<uint32_t> &vertex,
+      const std::vector<uint32_t> &fragment, slang_reflection *reflection);
+
+void slang_cache_store_reflection(const std::vector<uint32_t> &vertex,
+      const std::vector<uint32_t> &fragment,
+      const slang_reflection &reflection);
+
+#endif
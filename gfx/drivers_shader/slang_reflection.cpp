@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <compat/strl.h>
 #include "glslang_util.h"
+#include "slang_cache.hpp"
 #include "../../verbosity.h"
 
 using namespace std;
@@ -725,6 +726,9 @@ bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
       const std::vector<uint32_t> &fragment,
       slang_reflection *reflection)
 {
+   if (slang_cache_load_reflection(vertex, fragment, reflection))
+      return true;
+
    try
    {
       Compiler vertex_compiler(vertex);
@@ -743,6 +747,7 @@ bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
          return false;
       }
 
+      slang_cache_store_reflection(vertex, fragment, *reflection);
       return true;
    }
    catch (const std::exception &e)
@@ -26,6 +26,7 @@
 
 /* TODO/FIXME - global */
 static void *video_font_driver = NULL;
+static bool font_driver_prewarm = false;
 
 int font_renderer_create_default(
       const font_renderer_driver_t **drv,
@@ -947,3 +948,13 @@ void font_driver_free_osd(void)
 
    video_font_driver = NULL;
 }
+
+void font_driver_set_prewarm(bool prewarm)
+{
+   font_driver_prewarm = prewarm;
+}
+
+bool font_driver_get_prewarm(void)
+{
+   return font_driver_prewarm;
+}
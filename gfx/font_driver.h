@@ -135,6 +135,14 @@ void font_driver_init_osd(
 
 void font_driver_free_osd(void);
 
+/* While set, renderers rasterize the glyphs the menu
+ * strings of the current language use the most when
+ * a font is created. Menu drivers set it around the
+ * creation of the font of their entry list only. */
+void font_driver_set_prewarm(bool prewarm);
+
+bool font_driver_get_prewarm(void);
+
 int font_driver_get_line_height(font_data_t *font, float scale);
 int font_driver_get_line_ascender(font_data_t *font, float scale);
 int font_driver_get_line_descender(font_data_t *font, float scale);
@@ -24,6 +24,8 @@
 #include <string.h>
 #include <ctype.h>
 
+#include <array/rbuf.h>
+#include <array/rhmap.h>
 #include <features/features_cpu.h>
 #include <file/file_path.h>
 #include <string/stdstring.h>
@@ -38,6 +40,17 @@
 #define DEFAULT_GFX_THUMBNAIL_STREAM_DELAY  83.333333f
 #define DEFAULT_GFX_THUMBNAIL_FADE_DURATION 166.66667f
 
+/* Maximum number of prefetch loads queued at once */
+#define GFX_THUMBNAIL_PREFETCH_MAX_PENDING  16
+
+enum gfx_thumbnail_cache_flags
+{
+   GFX_THUMB_CACHE_FLAG_PENDING  = (1 << 0),
+   GFX_THUMB_CACHE_FLAG_PREFETCH = (1 << 1),
+   /* In the least recently used list */
+   GFX_THUMB_CACHE_FLAG_IDLE     = (1 << 2)
+};
+
 /* Utility structure, sent as userdata when pushing
  * an image load */
 typedef struct
@@ -46,6 +59,30 @@ typedef struct
    gfx_thumbnail_t *thumbnail;
 } gfx_thumbnail_tag_t;
 
+/* Sent as userdata when pushing an image load
+ * for the texture cache */
+typedef struct
+{
+   uint64_t load_id;
+   char *key;
+} gfx_thumbnail_cache_tag_t;
+
+struct gfx_thumbnail_cache_entry
+{
+   uintptr_t texture;
+   uint64_t load_id;
+   char *key;
+   /* Thumbnails waiting for a pending load */
+   gfx_thumbnail_tag_t *waiters; /* RBUF */
+   struct gfx_thumbnail_cache_entry *lru_prev;
+   struct gfx_thumbnail_cache_entry *lru_next;
+   size_t size;
+   unsigned width;
+   unsigned height;
+   unsigned refs;                /* Thumbnails using the texture */
+   uint8_t flags;
+};
+
 static gfx_thumbnail_state_t gfx_thumb_st = {0}; /* uint64_t alignment */
 
 gfx_thumbnail_state_t *gfx_thumb_get_ptr(void)
@@ -213,6 +250,380 @@ end:
    }
 }
 
+/* Texture cache */
+
+/* Returns the texture cache budget in bytes
+ * (0 when the cache is disabled) */
+static size_t gfx_thumbnail_cache_budget(void)
+{
+#ifdef HAVE_MENU
+   settings_t *settings = config_get_ptr();
+   return (size_t)settings->uints.menu_thumbnail_cache_size << 20;
+#else
+   return 0;
+#endif
+}
+
+static void gfx_thumbnail_cache_get_key(char *s, size_t len,
+      const char *path, unsigned gfx_thumbnail_upscale_threshold)
+{
+   snprintf(s, len, "%u|%s", gfx_thumbnail_upscale_threshold, path);
+}
+
+/* Appends 'entry', which no thumbnail uses any more,
+ * to the least recently used list */
+static void gfx_thumbnail_cache_lru_push(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      struct gfx_thumbnail_cache_entry *entry)
+{
+   entry->lru_prev  = p_gfx_thumb->cache_lru_tail;
+   entry->lru_next  = NULL;
+   entry->flags    |= GFX_THUMB_CACHE_FLAG_IDLE;
+
+   if (p_gfx_thumb->cache_lru_tail)
+      p_gfx_thumb->cache_lru_tail->lru_next = entry;
+   else
+      p_gfx_thumb->cache_lru_head           = entry;
+   p_gfx_thumb->cache_lru_tail              = entry;
+}
+
+static void gfx_thumbnail_cache_lru_remove(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      struct gfx_thumbnail_cache_entry *entry)
+{
+   if (entry->lru_prev)
+      entry->lru_prev->lru_next   = entry->lru_next;
+   else
+      p_gfx_thumb->cache_lru_head = entry->lru_next;
+
+   if (entry->lru_next)
+      entry->lru_next->lru_prev   = entry->lru_prev;
+   else
+      p_gfx_thumb->cache_lru_tail = entry->lru_prev;
+
+   entry->lru_prev  = NULL;
+   entry->lru_next  = NULL;
+   entry->flags    &= ~GFX_THUMB_CACHE_FLAG_IDLE;
+}
+
+/* Unloads the texture of 'entry' and frees it; the
+ * entry must already be removed from the cache */
+static void gfx_thumbnail_cache_free_entry(
+      struct gfx_thumbnail_cache_entry *entry)
+{
+   /* Loads still pending are ignored on completion */
+   if (entry->texture)
+      video_driver_texture_unload(&entry->texture);
+   RBUF_FREE(entry->waiters);
+   free(entry->key);
+   free(entry);
+}
+
+/* Unloads least recently used textures that no
+ * thumbnail uses until the cache fits in 'budget' */
+static void gfx_thumbnail_cache_evict(
+      gfx_thumbnail_state_t *p_gfx_thumb, size_t budget)
+{
+   /* Stops when all remaining textures are in use */
+   while (     (p_gfx_thumb->cache_size > budget)
+            &&  p_gfx_thumb->cache_lru_head)
+   {
+      struct gfx_thumbnail_cache_entry *lru = p_gfx_thumb->cache_lru_head;
+
+      gfx_thumbnail_cache_lru_remove(p_gfx_thumb, lru);
+      p_gfx_thumb->cache_size -= lru->size;
+      (void)RHMAP_DEL_STR(p_gfx_thumb->cache, lru->key);
+      gfx_thumbnail_cache_free_entry(lru);
+   }
+}
+
+/* Hands the texture of a loaded cache entry over
+ * to 'thumbnail' */
+static void gfx_thumbnail_cache_acquire(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      struct gfx_thumbnail_cache_entry *entry,
+      gfx_thumbnail_t *thumbnail)
+{
+   if (entry->flags & GFX_THUMB_CACHE_FLAG_IDLE)
+      gfx_thumbnail_cache_lru_remove(p_gfx_thumb, entry);
+
+   thumbnail->texture     = entry->texture;
+   thumbnail->cache_entry = entry;
+   thumbnail->width       = entry->width;
+   thumbnail->height      = entry->height;
+   thumbnail->status      = GFX_THUMBNAIL_STATUS_AVAILABLE;
+   entry->refs++;
+}
+
+/* Called when a thumbnail stops using a cached texture
+ * > The texture stays in the cache, and is unloaded by
+ *   the next eviction once it is the least recently used */
+static void gfx_thumbnail_cache_release(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      struct gfx_thumbnail_cache_entry *entry)
+{
+   if (entry->refs > 0 && --entry->refs == 0)
+      gfx_thumbnail_cache_lru_push(p_gfx_thumb, entry);
+}
+
+/* Sets 'thumbnail' from the cache entry for 'key', if any:
+ * available when the texture is loaded, pending (until
+ * the load completes) when it is being loaded
+ * Returns false if the cache has no entry for 'key' */
+static bool gfx_thumbnail_cache_get(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      const char *key, gfx_thumbnail_t *thumbnail)
+{
+   struct gfx_thumbnail_cache_entry *entry = NULL;
+   ptrdiff_t idx                           = RHMAP_IDX_STR(p_gfx_thumb->cache, key);
+
+   if (idx < 0)
+      return false;
+
+   entry = p_gfx_thumb->cache[idx];
+
+   if (entry->flags & GFX_THUMB_CACHE_FLAG_PENDING)
+   {
+      gfx_thumbnail_tag_t waiter;
+
+      waiter.list_id   = p_gfx_thumb->list_id;
+      waiter.thumbnail = thumbnail;
+      RBUF_PUSH(entry->waiters, waiter);
+
+      thumbnail->status = GFX_THUMBNAIL_STATUS_PENDING;
+   }
+   else
+      gfx_thumbnail_cache_acquire(p_gfx_thumb, entry, thumbnail);
+
+   return true;
+}
+
+/* Used to process thumbnail data following completion
+ * of an image load task pushed for the texture cache */
+static void gfx_thumbnail_cache_handle_upload(
+      retro_task_t *task, void *task_data, void *user_data, const char *err)
+{
+   size_t i;
+   gfx_thumbnail_state_t *p_gfx_thumb       = &gfx_thumb_st;
+   struct texture_image *img                = (struct texture_image*)task_data;
+   gfx_thumbnail_cache_tag_t *cache_tag     = (gfx_thumbnail_cache_tag_t*)user_data;
+   struct gfx_thumbnail_cache_entry *entry  = NULL;
+   gfx_thumbnail_tag_t *waiters             = NULL;
+   ptrdiff_t idx                            = -1;
+   bool loaded                              = false;
+
+   if (!cache_tag)
+      goto end;
+
+   /* Ensure that the entry is still waiting for this
+    * load (cache may have been flushed meanwhile) */
+   if ((idx = RHMAP_IDX_STR(p_gfx_thumb->cache, cache_tag->key)) < 0)
+      goto end;
+
+   entry = p_gfx_thumb->cache[idx];
+
+   if (     !(entry->flags & GFX_THUMB_CACHE_FLAG_PENDING)
+         || (entry->load_id != cache_tag->load_id))
+      goto end;
+
+   if (entry->flags & GFX_THUMB_CACHE_FLAG_PREFETCH)
+      p_gfx_thumb->prefetch_pending--;
+
+   waiters         = entry->waiters;
+   entry->waiters  = NULL;
+   entry->flags   &= ~(GFX_THUMB_CACHE_FLAG_PENDING
+                     | GFX_THUMB_CACHE_FLAG_PREFETCH);
+
+   /* Upload texture to GPU */
+   if (      img
+         && (img->width  > 0)
+         && (img->height > 0)
+         && video_driver_texture_load(
+            img, TEXTURE_FILTER_MIPMAP_LINEAR, &entry->texture))
+   {
+      entry->width             = img->width;
+      entry->height            = img->height;
+      entry->size              = (size_t)img->width * img->height
+                               * sizeof(uint32_t);
+      p_gfx_thumb->cache_size += entry->size;
+      loaded                   = true;
+   }
+   else
+   {
+      (void)RHMAP_DEL_STR(p_gfx_thumb->cache, cache_tag->key);
+      gfx_thumbnail_cache_free_entry(entry);
+      entry = NULL;
+   }
+
+   /* Hand texture over to all thumbnails still
+    * waiting for it */
+   for (i = 0; i < RBUF_LEN(waiters); i++)
+   {
+      gfx_thumbnail_t *thumbnail = waiters[i].thumbnail;
+
+      if (     (waiters[i].list_id != p_gfx_thumb->list_id)
+            || (thumbnail->status  != GFX_THUMBNAIL_STATUS_PENDING))
+         continue;
+
+      /* Sanity check: see gfx_thumbnail_handle_upload() */
+      if (thumbnail->texture)
+         gfx_thumbnail_reset(thumbnail);
+
+      thumbnail->status = GFX_THUMBNAIL_STATUS_MISSING;
+
+      if (loaded)
+         gfx_thumbnail_cache_acquire(p_gfx_thumb, entry, thumbnail);
+
+      gfx_thumbnail_init_fade(p_gfx_thumb, thumbnail);
+   }
+
+   RBUF_FREE(waiters);
+
+   if (loaded)
+   {
+      /* Prefetched, or all waiters have moved on */
+      if (entry->refs == 0)
+         gfx_thumbnail_cache_lru_push(p_gfx_thumb, entry);
+      gfx_thumbnail_cache_evict(p_gfx_thumb,
+            gfx_thumbnail_cache_budget());
+   }
+
+end:
+   /* Clean up */
+   if (img)
+   {
+      image_texture_free(img);
+      free(img);
+   }
+
+   if (cache_tag)
+   {
+      free(cache_tag->key);
+      free(cache_tag);
+   }
+}
+
+/* Pushes an image load for the texture cache entry
+ * 'key'; 'thumbnail' (if not NULL) is set once the
+ * load completes
+ * > Prefetch loads run as background tasks
+ * Returns false if the load could not be pushed */
+static bool gfx_thumbnail_cache_load(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      const char *key, const char *path,
+      gfx_thumbnail_t *thumbnail,
+      unsigned gfx_thumbnail_upscale_threshold,
+      bool prefetch)
+{
+   struct gfx_thumbnail_cache_entry *entry = NULL;
+   gfx_thumbnail_cache_tag_t *cache_tag    = (gfx_thumbnail_cache_tag_t*)
+      malloc(sizeof(gfx_thumbnail_cache_tag_t));
+   bool pushed                             = false;
+
+   if (!cache_tag)
+      return false;
+
+   if (!(cache_tag->key = strdup(key)))
+   {
+      free(cache_tag);
+      return false;
+   }
+
+   if (!(entry = (struct gfx_thumbnail_cache_entry*)
+         calloc(1, sizeof(*entry))))
+   {
+      free(cache_tag->key);
+      free(cache_tag);
+      return false;
+   }
+
+   if (!(entry->key = strdup(key)))
+   {
+      free(entry);
+      free(cache_tag->key);
+      free(cache_tag);
+      return false;
+   }
+
+   entry->load_id     = ++p_gfx_thumb->cache_load_id;
+   entry->flags       = GFX_THUMB_CACHE_FLAG_PENDING;
+   cache_tag->load_id = entry->load_id;
+
+   if (prefetch)
+      entry->flags   |= GFX_THUMB_CACHE_FLAG_PREFETCH;
+
+   if (thumbnail)
+   {
+      gfx_thumbnail_tag_t waiter;
+
+      waiter.list_id   = p_gfx_thumb->list_id;
+      waiter.thumbnail = thumbnail;
+      RBUF_PUSH(entry->waiters, waiter);
+   }
+
+   /* Image load callbacks only run on the main
+    * thread, so the entry can be added afterwards */
+   if (prefetch)
+      pushed = task_push_image_load_background(
+            path, video_driver_supports_rgba(),
+            gfx_thumbnail_upscale_threshold,
+            gfx_thumbnail_cache_handle_upload, cache_tag);
+   else
+      pushed = task_push_image_load(
+            path, video_driver_supports_rgba(),
+            gfx_thumbnail_upscale_threshold,
+            gfx_thumbnail_cache_handle_upload, cache_tag);
+
+   if (!pushed)
+   {
+      gfx_thumbnail_cache_free_entry(entry);
+      free(cache_tag->key);
+      free(cache_tag);
+      return false;
+   }
+
+   RHMAP_SET_STR(p_gfx_thumb->cache, key, entry);
+
+   if (prefetch)
+      p_gfx_thumb->prefetch_pending++;
+   if (thumbnail)
+      thumbnail->status = GFX_THUMBNAIL_STATUS_PENDING;
+
+   return true;
+}
+
+/* When a streamed thumbnail first comes on screen, sets
+ * it straight from the texture cache (skipping the stream
+ * delay) if its texture is cached or being loaded
+ * Returns true if 'thumbnail' has been set */
+static bool gfx_thumbnail_cache_get_stream(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_path_data_t *path_data,
+      enum gfx_thumbnail_id thumbnail_id,
+      gfx_thumbnail_t *thumbnail,
+      unsigned gfx_thumbnail_upscale_threshold)
+{
+   char key[PATH_MAX_LENGTH + 16];
+   const char *thumbnail_path = NULL;
+
+   if (     !path_data
+         || !gfx_thumbnail_is_enabled(path_data, thumbnail_id)
+         || !gfx_thumbnail_update_path(path_data, thumbnail_id)
+         || !gfx_thumbnail_get_path(path_data, thumbnail_id, &thumbnail_path))
+      return false;
+
+   gfx_thumbnail_cache_get_key(key, sizeof(key), thumbnail_path,
+         gfx_thumbnail_upscale_threshold);
+
+   if (!gfx_thumbnail_cache_get(p_gfx_thumb, key, thumbnail))
+      return false;
+
+   if (thumbnail->status != GFX_THUMBNAIL_STATUS_PENDING)
+      gfx_thumbnail_init_fade(p_gfx_thumb, thumbnail);
+
+   return true;
+}
+
 /* Core interface */
 
 /* When called, prevents the handling of any pending
@@ -247,6 +658,7 @@ void gfx_thumbnail_request(
       bool network_on_demand_thumbnails)
 {
    gfx_thumbnail_state_t *p_gfx_thumb = &gfx_thumb_st;
+   size_t cache_budget                = gfx_thumbnail_cache_budget();
 
    if (!path_data || !thumbnail)
       return;
@@ -256,6 +668,10 @@ void gfx_thumbnail_request(
    gfx_thumbnail_reset(thumbnail);
    thumbnail->status = GFX_THUMBNAIL_STATUS_MISSING;
 
+   /* Keep texture cache within budget (which
+    * may have changed since the last request) */
+   gfx_thumbnail_cache_evict(p_gfx_thumb, cache_budget);
+
    /* Update/extract thumbnail path */
    if (gfx_thumbnail_is_enabled(path_data, thumbnail_id))
    {
@@ -264,10 +680,29 @@ void gfx_thumbnail_request(
          const char *thumbnail_path = NULL;
          if (gfx_thumbnail_get_path(path_data, thumbnail_id, &thumbnail_path))
          {
+            char key[PATH_MAX_LENGTH + 16];
+
+            gfx_thumbnail_cache_get_key(key, sizeof(key), thumbnail_path,
+                  gfx_thumbnail_upscale_threshold);
+
+            /* Use cached texture, if available */
+            if (gfx_thumbnail_cache_get(p_gfx_thumb, key, thumbnail))
+               goto end;
+
             /* Load thumbnail, if required */
             if (path_is_valid(thumbnail_path))
             {
-               gfx_thumbnail_tag_t *thumbnail_tag =
+               gfx_thumbnail_tag_t *thumbnail_tag = NULL;
+
+               if (cache_budget > 0)
+               {
+                  gfx_thumbnail_cache_load(p_gfx_thumb, key,
+                        thumbnail_path, thumbnail,
+                        gfx_thumbnail_upscale_threshold, false);
+                  goto end;
+               }
+
+               thumbnail_tag =
                   (gfx_thumbnail_tag_t*)malloc(sizeof(gfx_thumbnail_tag_t));
 
                if (!thumbnail_tag)
@@ -404,9 +839,14 @@ void gfx_thumbnail_reset(gfx_thumbnail_t *thumbnail)
    if (!thumbnail)
       return;
 
-   /* Unload texture */
+   /* Unload texture, unless it belongs to the cache */
    if (thumbnail->texture)
-      video_driver_texture_unload(&thumbnail->texture);
+   {
+      if (thumbnail->cache_entry)
+         gfx_thumbnail_cache_release(&gfx_thumb_st, thumbnail->cache_entry);
+      else
+         video_driver_texture_unload(&thumbnail->texture);
+   }
 
    /* Ensure any 'fade in' animation is killed */
    if (thumbnail->flags & GFX_THUMB_FLAG_FADE_ACTIVE)
@@ -418,6 +858,7 @@ void gfx_thumbnail_reset(gfx_thumbnail_t *thumbnail)
    /* Reset all parameters */
    thumbnail->status      = GFX_THUMBNAIL_STATUS_UNKNOWN;
    thumbnail->texture     = 0;
+   thumbnail->cache_entry = NULL;
    thumbnail->width       = 0;
    thumbnail->height      = 0;
    thumbnail->alpha       = 0.0f;
@@ -466,6 +907,13 @@ void gfx_thumbnail_request_stream(
        || (thumbnail->status != GFX_THUMBNAIL_STATUS_UNKNOWN))
       return;
 
+   /* Cached textures are shown straight away */
+   if (      (thumbnail->delay_timer == 0.0f)
+         &&  (RHMAP_LEN(p_gfx_thumb->cache) > 0)
+         &&  gfx_thumbnail_cache_get_stream(p_gfx_thumb, path_data,
+               thumbnail_id, thumbnail, gfx_thumbnail_upscale_threshold))
+      return;
+
    /* Check if stream delay timer has elapsed */
    thumbnail->delay_timer += p_anim->delta_time;
 
@@ -532,6 +980,20 @@ void gfx_thumbnail_request_streams(
    process_right = (right_thumbnail->status == GFX_THUMBNAIL_STATUS_UNKNOWN);
    process_left  = (left_thumbnail->status  == GFX_THUMBNAIL_STATUS_UNKNOWN);
 
+   /* Cached textures are shown straight away */
+   if (RHMAP_LEN(gfx_thumb_st.cache) > 0)
+   {
+      if (process_right && (right_thumbnail->delay_timer == 0.0f))
+         process_right = !gfx_thumbnail_cache_get_stream(&gfx_thumb_st,
+               path_data, GFX_THUMBNAIL_RIGHT, right_thumbnail,
+               gfx_thumbnail_upscale_threshold);
+
+      if (process_left  && (left_thumbnail->delay_timer  == 0.0f))
+         process_left  = !gfx_thumbnail_cache_get_stream(&gfx_thumb_st,
+               path_data, GFX_THUMBNAIL_LEFT, left_thumbnail,
+               gfx_thumbnail_upscale_threshold);
+   }
+
    if (process_right || process_left)
    {
       /* Check if stream delay timer has elapsed */
@@ -630,6 +1092,16 @@ void gfx_thumbnail_process_stream(
       {
          gfx_thumbnail_state_t *p_gfx_thumb = &gfx_thumb_st;
 
+         /* Cached textures are shown straight away */
+         if (      (thumbnail->delay_timer == 0.0f)
+               &&  (RHMAP_LEN(p_gfx_thumb->cache) > 0)
+               &&  path_data
+               &&  playlist
+               &&  gfx_thumbnail_set_content_playlist(path_data, playlist, idx)
+               &&  gfx_thumbnail_cache_get_stream(p_gfx_thumb, path_data,
+                     thumbnail_id, thumbnail, gfx_thumbnail_upscale_threshold))
+            return;
+
          /* Check if stream delay timer has elapsed */
          thumbnail->delay_timer += p_anim->delta_time;
 
@@ -703,6 +1175,25 @@ void gfx_thumbnail_process_streams(
       bool process_right = (right_thumbnail->status == GFX_THUMBNAIL_STATUS_UNKNOWN);
       bool process_left  = (left_thumbnail->status  == GFX_THUMBNAIL_STATUS_UNKNOWN);
 
+      /* Cached textures are shown straight away */
+      if (     (RHMAP_LEN(gfx_thumb_st.cache) > 0)
+            && (   (process_right && (right_thumbnail->delay_timer == 0.0f))
+                || (process_left  && (left_thumbnail->delay_timer  == 0.0f)))
+            && path_data
+            && playlist
+            && gfx_thumbnail_set_content_playlist(path_data, playlist, idx))
+      {
+         if (process_right && (right_thumbnail->delay_timer == 0.0f))
+            process_right = !gfx_thumbnail_cache_get_stream(&gfx_thumb_st,
+                  path_data, GFX_THUMBNAIL_RIGHT, right_thumbnail,
+                  gfx_thumbnail_upscale_threshold);
+
+         if (process_left  && (left_thumbnail->delay_timer  == 0.0f))
+            process_left  = !gfx_thumbnail_cache_get_stream(&gfx_thumb_st,
+                  path_data, GFX_THUMBNAIL_LEFT, left_thumbnail,
+                  gfx_thumbnail_upscale_threshold);
+      }
+
       if (process_right || process_left)
       {
          /* Check if stream delay timer has elapsed */
@@ -786,6 +1277,189 @@ void gfx_thumbnail_process_streams(
    }
 }
 
+/* Prefetching */
+
+/* Loads the thumbnails of up to 'count' playlist entries
+ * following the on-screen ones (from 'first_idx' to
+ * 'last_idx') into the texture cache, in the direction
+ * of the last change of the on-screen entries
+ * - Should be called each frame; does nothing until
+ *   the on-screen entries change
+ * - Left thumbnails are only loaded if 'left_thumbnail'
+ *   is true
+ * - Does nothing if the texture cache is disabled,
+ *   or if the task queue is not threaded
+ * NOTE: Must be called *after* gfx_thumbnail_set_system() */
+void gfx_thumbnail_prefetch(
+      gfx_thumbnail_path_data_t *path_data,
+      playlist_t *playlist,
+      size_t first_idx, size_t last_idx, size_t count,
+      bool left_thumbnail,
+      unsigned gfx_thumbnail_upscale_threshold)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = &gfx_thumb_st;
+   size_t playlist_len                = 0;
+   size_t idx, end;
+
+   /* Without task threads, prefetch loads would
+    * just take time away from drawing frames */
+   if (     !path_data
+         || !playlist
+         || (count < 1)
+         || (first_idx > last_idx)
+         || (gfx_thumbnail_cache_budget() == 0)
+         || !task_queue_is_threaded())
+      return;
+
+   playlist_len = playlist_size(playlist);
+   if (last_idx >= playlist_len)
+      return;
+
+   /* A new list starts prefetching downwards */
+   if (     (p_gfx_thumb->prefetch_list_id  != p_gfx_thumb->list_id)
+         || (p_gfx_thumb->prefetch_playlist != playlist))
+   {
+      p_gfx_thumb->prefetch_list_id   = p_gfx_thumb->list_id;
+      p_gfx_thumb->prefetch_playlist  = playlist;
+      p_gfx_thumb->prefetch_direction = 1;
+      p_gfx_thumb->prefetch_next      = last_idx + 1;
+   }
+   else
+   {
+      int direction = p_gfx_thumb->prefetch_direction;
+
+      /* Nothing to do until on-screen entries change
+       * or pending prefetch loads complete */
+      if (     (first_idx == p_gfx_thumb->prefetch_first)
+            && (last_idx  == p_gfx_thumb->prefetch_last)
+            && (p_gfx_thumb->prefetch_pending
+                  >= GFX_THUMBNAIL_PREFETCH_MAX_PENDING))
+         return;
+
+      if (last_idx > p_gfx_thumb->prefetch_last)
+         direction = 1;
+      else if (first_idx < p_gfx_thumb->prefetch_first)
+         direction = -1;
+
+      /* Direction changed: restart from the edge
+       * of the on-screen entries */
+      if (direction != p_gfx_thumb->prefetch_direction)
+      {
+         p_gfx_thumb->prefetch_direction = direction;
+         p_gfx_thumb->prefetch_next      = (direction > 0)
+               ? last_idx + 1 : first_idx - 1;
+      }
+   }
+
+   p_gfx_thumb->prefetch_first = first_idx;
+   p_gfx_thumb->prefetch_last  = last_idx;
+
+   if (p_gfx_thumb->prefetch_direction > 0)
+   {
+      end = last_idx + count;
+      if (end >= playlist_len)
+         end = playlist_len - 1;
+      /* Entries up to 'prefetch_next' have already
+       * been handled, unless the list jumped ahead */
+      if (p_gfx_thumb->prefetch_next <= last_idx)
+         p_gfx_thumb->prefetch_next = last_idx + 1;
+      if (p_gfx_thumb->prefetch_next > end)
+         return;
+   }
+   else
+   {
+      if (first_idx == 0)
+         return;
+      end = (first_idx > count) ? first_idx - count : 0;
+      /* 'prefetch_next' wraps around to SIZE_MAX
+       * once the first entry has been handled */
+      if (     (p_gfx_thumb->prefetch_next >= first_idx)
+            && (p_gfx_thumb->prefetch_next != (size_t)-1))
+         p_gfx_thumb->prefetch_next = first_idx - 1;
+      if (     (p_gfx_thumb->prefetch_next <  end)
+            || (p_gfx_thumb->prefetch_next == (size_t)-1))
+         return;
+   }
+
+   /* Prefetch loads use a copy of the path data,
+    * since the menu's own describes the current
+    * selection */
+   if (!p_gfx_thumb->prefetch_path_data)
+      if (!(p_gfx_thumb->prefetch_path_data = gfx_thumbnail_path_init()))
+         return;
+
+   memcpy(p_gfx_thumb->prefetch_path_data, path_data,
+         sizeof(*path_data));
+
+   for (;;)
+   {
+      gfx_thumbnail_path_data_t *prefetch_data =
+         p_gfx_thumb->prefetch_path_data;
+      int i;
+
+      if (p_gfx_thumb->prefetch_pending >= GFX_THUMBNAIL_PREFETCH_MAX_PENDING)
+         break;
+
+      idx = p_gfx_thumb->prefetch_next;
+
+      if (gfx_thumbnail_set_content_playlist(prefetch_data, playlist, idx))
+      {
+         for (i = GFX_THUMBNAIL_RIGHT; i <= GFX_THUMBNAIL_LEFT; i++)
+         {
+            char key[PATH_MAX_LENGTH + 16];
+            enum gfx_thumbnail_id thumbnail_id = (enum gfx_thumbnail_id)i;
+            const char *thumbnail_path         = NULL;
+
+            if (     ((thumbnail_id == GFX_THUMBNAIL_LEFT) && !left_thumbnail)
+                  || !gfx_thumbnail_is_enabled(prefetch_data, thumbnail_id)
+                  || !gfx_thumbnail_update_path(prefetch_data, thumbnail_id)
+                  || !gfx_thumbnail_get_path(prefetch_data, thumbnail_id,
+                     &thumbnail_path))
+               continue;
+
+            gfx_thumbnail_cache_get_key(key, sizeof(key), thumbnail_path,
+                  gfx_thumbnail_upscale_threshold);
+
+            if (     !RHMAP_HAS_STR(p_gfx_thumb->cache, key)
+                  && path_is_valid(thumbnail_path))
+               gfx_thumbnail_cache_load(p_gfx_thumb, key, thumbnail_path,
+                     NULL, gfx_thumbnail_upscale_threshold, true);
+         }
+      }
+
+      p_gfx_thumb->prefetch_next = idx + p_gfx_thumb->prefetch_direction;
+
+      if (idx == end)
+         break;
+   }
+}
+
+/* Unloads all textures of the texture cache
+ * > Must be called when the menu context is
+ *   destroyed, *after* all thumbnails have been
+ *   reset */
+void gfx_thumbnail_flush_cache(void)
+{
+   size_t i;
+   gfx_thumbnail_state_t *p_gfx_thumb = &gfx_thumb_st;
+   size_t cap                         = RHMAP_CAP(p_gfx_thumb->cache);
+
+   for (i = 0; i < cap; i++)
+      if (RHMAP_KEY(p_gfx_thumb->cache, i))
+         gfx_thumbnail_cache_free_entry(p_gfx_thumb->cache[i]);
+
+   RHMAP_FREE(p_gfx_thumb->cache);
+   p_gfx_thumb->cache_lru_head   = NULL;
+   p_gfx_thumb->cache_lru_tail   = NULL;
+   p_gfx_thumb->cache_size       = 0;
+   p_gfx_thumb->prefetch_pending = 0;
+   p_gfx_thumb->prefetch_list_id = p_gfx_thumb->list_id - 1;
+
+   if (p_gfx_thumb->prefetch_path_data)
+      free(p_gfx_thumb->prefetch_path_data);
+   p_gfx_thumb->prefetch_path_data = NULL;
+}
+
 /* Thumbnail rendering */
 
 /* Determines the actual screen dimensions of a
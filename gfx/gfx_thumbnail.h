@@ -33,6 +33,11 @@
 
 RETRO_BEGIN_DECLS
 
+/* Number of entries ahead of the selection for which
+ * thumbnails are prefetched by menus that only show
+ * thumbnails of the selected entry */
+#define GFX_THUMBNAIL_PREFETCH_ENTRIES 8
+
 /* Defines the current status of an entry
  * thumbnail texture */
 enum gfx_thumbnail_status
@@ -69,11 +74,16 @@ enum gfx_thumbnail_flags
    GFX_THUMB_FLAG_CORE_ASPECT = (1 << 1)
 };
 
+struct gfx_thumbnail_cache_entry;
+
 /* Holds all runtime parameters associated with
  * an entry thumbnail */
 typedef struct
 {
    uintptr_t texture;
+   /* Texture cache entry the texture belongs to,
+    * NULL if the thumbnail owns the texture */
+   struct gfx_thumbnail_cache_entry *cache_entry;
    unsigned width;
    unsigned height;
    float alpha;
@@ -115,6 +125,32 @@ struct gfx_thumbnail_state
     * at the time when the load completes */
    uint64_t list_id;
 
+   /* Uploaded thumbnail textures, keyed by image
+    * path and upscale threshold, so that entries
+    * scrolled back to don't have to be loaded again.
+    * Textures no thumbnail uses are kept up to the
+    * 'menu_thumbnail_cache_size' budget, after which
+    * the least recently used ones are unloaded */
+   struct gfx_thumbnail_cache_entry **cache; /* RHMAP */
+   /* Textures no thumbnail uses, least recently
+    * used first */
+   struct gfx_thumbnail_cache_entry *cache_lru_head;
+   struct gfx_thumbnail_cache_entry *cache_lru_tail;
+   uint64_t cache_load_id;
+   size_t cache_size;
+
+   /* Prefetching loads the thumbnails of the entries
+    * following the on-screen ones, in the direction
+    * the list is being scrolled, as background tasks */
+   gfx_thumbnail_path_data_t *prefetch_path_data;
+   playlist_t *prefetch_playlist;
+   uint64_t prefetch_list_id;
+   size_t prefetch_first;
+   size_t prefetch_last;
+   size_t prefetch_next;
+   unsigned prefetch_pending;
+   int prefetch_direction;
+
    /* When streaming thumbnails, to minimise the processing
     * of unnecessary images (i.e. when scrolling rapidly through
     * playlists), we delay loading until an entry has been on screen
@@ -301,6 +337,32 @@ void gfx_thumbnail_process_streams(
       unsigned gfx_thumbnail_upscale_threshold,
       bool network_on_demand_thumbnails);
 
+/* Prefetching */
+
+/* Loads the thumbnails of up to 'count' playlist entries
+ * following the on-screen ones (from 'first_idx' to
+ * 'last_idx') into the texture cache, in the direction
+ * of the last change of the on-screen entries
+ * - Should be called each frame; does nothing until
+ *   the on-screen entries change
+ * - Left thumbnails are only loaded if 'left_thumbnail'
+ *   is true
+ * - Does nothing if the texture cache is disabled,
+ *   or if the task queue is not threaded
+ * NOTE: Must be called *after* gfx_thumbnail_set_system() */
+void gfx_thumbnail_prefetch(
+      gfx_thumbnail_path_data_t *path_data,
+      playlist_t *playlist,
+      size_t first_idx, size_t last_idx, size_t count,
+      bool left_thumbnail,
+      unsigned gfx_thumbnail_upscale_threshold);
+
+/* Unloads all textures of the texture cache
+ * > Must be called when the menu context is
+ *   destroyed, *after* all thumbnails have been
+ *   reset */
+void gfx_thumbnail_flush_cache(void);
+
 /* Thumbnail rendering */
 
 /* Determines the actual screen dimensions of a
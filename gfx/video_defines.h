@@ -284,6 +284,13 @@ struct font_atlas
    uint8_t *buffer; /* Alpha channel. */
    unsigned width;
    unsigned height;
+   /* Region changed since the last upload, when
+    * 'dirty' is set. A zero size means the whole
+    * atlas, so drivers may ignore it. */
+   unsigned dirty_x;
+   unsigned dirty_y;
+   unsigned dirty_width;
+   unsigned dirty_height;
    bool dirty;
 };
 
@@ -18,6 +18,7 @@
 #include <math.h>
 
 #include <retro_inline.h>
+#include <memalign.h>
 #include <string/stdstring.h>
 #include <retro_math.h>
 #include <retro_timers.h>
@@ -995,6 +996,7 @@ void video_driver_gpu_record_deinit(void)
    if (video_st->record_gpu_buffer)
       free(video_st->record_gpu_buffer);
    video_st->record_gpu_buffer = NULL;
+   recording_state_get_ptr()->gpu_readback_ring = false;
 }
 
 void recording_dump_frame(
@@ -1011,7 +1013,8 @@ void recording_dump_frame(
    ffemu_data.pitch    = (int)pitch;
    ffemu_data.is_dupe  = false;
 
-   if (video_st->record_gpu_buffer)
+   if (     video_st->record_gpu_buffer
+         || record_st->gpu_readback_ring)
    {
       struct video_viewport vp;
 
@@ -1050,6 +1053,27 @@ void recording_dump_frame(
          return;
       }
 
+      if (record_st->gpu_readback_ring)
+      {
+         struct video_readback_frame frame;
+
+         /* Nothing is read back until the ring has filled up. */
+         if (!(      video_st->poke
+                  && video_st->poke->read_viewport_ring
+                  && video_st->poke->read_viewport_ring(
+                     video_st->data, &frame)))
+            return;
+
+         ffemu_data.data    = frame.data;
+         ffemu_data.width   = frame.width;
+         ffemu_data.height  = frame.height;
+         ffemu_data.pitch   = frame.pitch;
+         ffemu_data.is_dupe = frame.is_dupe;
+
+         record_st->driver->push_video(record_st->data, &ffemu_data);
+         return;
+      }
+
       /* Big bottleneck.
        * Since we might need to do read-backs asynchronously,
        * it might take 3-4 times before this returns true. */
@@ -1463,7 +1487,7 @@ void video_driver_filter_free(void)
 #ifdef _3DS
       linearFree(video_st->state_buffer);
 #else
-      free(video_st->state_buffer);
+      memalign_free(video_st->state_buffer);
 #endif
    }
    video_st->state_buffer    = NULL;
@@ -1533,12 +1557,15 @@ void video_driver_init_filter(enum retro_pixel_format colfmt_int,
    video_st->state_out_bpp   = (video_st->flags & VIDEO_FLAG_STATE_OUT_RGB32)
       ? sizeof(uint32_t) : sizeof(uint16_t);
 
-   /* TODO: Aligned output. */
+   /* Cache line aligned, so that SIMD filter kernels start out
+    * on an aligned row and row bands filtered by different
+    * threads do not share cache lines (as long as the pitch
+    * is a multiple of 64, which it is for most filters) */
 #ifdef _3DS
    buf = linearMemAlign(
          width * height * video_st->state_out_bpp, 0x80);
 #else
-   buf = malloc(
+   buf = memalign_alloc(64,
          width * height * video_st->state_out_bpp);
 #endif
    if (!buf)
@@ -1937,6 +1964,15 @@ bool video_driver_supports_rgba(void)
    return tmp;
 }
 
+unsigned video_driver_get_max_texture_size(void)
+{
+   video_driver_state_t *video_st       = &video_driver_st;
+   if (     !video_st->poke
+         || !video_st->poke->get_max_texture_size)
+      return 0;
+   return video_st->poke->get_max_texture_size(video_st->data);
+}
+
 void video_driver_set_hdr_support(void)
 {
    video_driver_state_t *video_st  = &video_driver_st;
@@ -3668,6 +3704,7 @@ void video_driver_frame(const void *data, unsigned width,
              !video_info.post_filter_record
           || !data
           || video_st->record_gpu_buffer
+          || recording_st->gpu_readback_ring
          ) && recording_st->data
            && recording_st->driver
            && recording_st->driver->push_video)
@@ -3764,8 +3801,10 @@ void video_driver_frame(const void *data, unsigned width,
    if (render_frame && video_info.statistics_show)
    {
       audio_statistics_t audio_stats;
+      struct record_stats record_stats;
       char throttle_stats[128];
       char latency_stats[128];
+      char recording_stats[128];
       char tmp[128];
       size_t len;
       double stddev                          = 0.0;
@@ -3812,9 +3851,10 @@ void video_driver_frame(const void *data, unsigned width,
 
       audio_compute_buffer_statistics(&audio_stats);
 
-      throttle_stats[0] = '\0';
-      latency_stats[0]  = '\0';
-      tmp[0]            = '\0';
+      throttle_stats[0]  = '\0';
+      latency_stats[0]   = '\0';
+      recording_stats[0] = '\0';
+      tmp[0]             = '\0';
       len               = 0;
 
       if (video_info.frame_rest)
@@ -3865,6 +3905,20 @@ void video_driver_frame(const void *data, unsigned width,
          strlcpy(latency_stats + _len, tmp, sizeof(latency_stats) - _len);
       }
 
+      /* TODO/FIXME - localize */
+      if (recording_get_stats(&record_stats))
+         snprintf(recording_stats, sizeof(recording_stats),
+               "RECORDING\n"
+               " Queue:       %2u / %2u\n"
+               " Encoder Lag: %5.2f ms\n"
+               " - Max:       %5.2f ms\n"
+               " Dropped:     %5" PRIu64"\n",
+               record_stats.video_queue_depth,
+               record_stats.video_queue_size,
+               record_stats.encoder_lag / 1000.0f,
+               record_stats.encoder_lag_max / 1000.0f,
+               record_stats.video_frames_dropped);
+
       /* TODO/FIXME - localize */
       snprintf(video_info.stat_text,
             sizeof(video_info.stat_text),
@@ -3888,6 +3942,7 @@ void video_driver_frame(const void *data, unsigned width,
             " Blocking:    %5.2f %%\n"
             " Samples:     %5d\n"
             "%s"
+            "%s"
             "%s",
             av_info->geometry.base_width,
             av_info->geometry.base_height,
@@ -3911,7 +3966,8 @@ void video_driver_frame(const void *data, unsigned width,
             audio_stats.close_to_blocking,
             audio_stats.samples,
             throttle_stats,
-            latency_stats);
+            latency_stats,
+            recording_stats);
 
       /* TODO/FIXME - add OSD chat text here */
    }
@@ -626,6 +626,22 @@ typedef struct gfx_ctx_ident
    const char *ident;
 } gfx_ctx_ident_t;
 
+/* A completed frame in the driver's asynchronous readback ring.
+ * data points straight into mapped GPU memory in ARGB8888
+ * (BGRA byte order) and stays valid until the next frame is
+ * submitted to the driver. pitch is negative when the rows
+ * are stored bottom-up. */
+struct video_readback_frame
+{
+   const void *data;
+   unsigned width;
+   unsigned height;
+   int pitch;
+   /* The oldest readback in the ring is not done on the GPU yet;
+    * repeat the previous frame instead of waiting for it. */
+   bool is_dupe;
+};
+
 /* Optionally implemented interface to poke more
  * deeply into video driver. */
 
@@ -676,6 +692,17 @@ typedef struct video_poke_interface
    void (*set_hdr_paper_white_nits)(void *data, float paper_white_nits);
    void (*set_hdr_contrast)(void *data, float contrast);
    void (*set_hdr_expand_gamut)(void *data, bool expand_gamut);
+
+   /* Optional. Takes the oldest frame from the readback ring
+    * used for GPU recording without converting or copying it.
+    * Returns false if no frame is available yet.
+    * With a NULL frame, returns whether the ring is active. */
+   bool (*read_viewport_ring)(void *data,
+         struct video_readback_frame *frame);
+
+   /* Optional. Largest width or height of a texture
+    * the driver can create. */
+   unsigned (*get_max_texture_size)(void *data);
 } video_poke_interface_t;
 
 /* msg is for showing a message on the screen
@@ -916,6 +943,9 @@ void video_driver_unset_rgba(void);
 
 bool video_driver_supports_rgba(void);
 
+/* Returns 0 if the driver doesn't tell */
+unsigned video_driver_get_max_texture_size(void);
+
 void video_driver_set_hdr_support(void);
 
 void video_driver_unset_hdr_support(void);
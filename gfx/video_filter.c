@@ -36,6 +36,18 @@
 #include "video_filter.h"
 #include "video_filters/softfilter.h"
 
+#ifdef HAVE_THREADS
+#include <rthreads/tpool.h>
+#include <retro_atomic.h>
+
+/* Every worker gets several row bands to chew through, so a
+ * worker that is descheduled for a moment only delays its
+ * current band while the others pick up the remaining ones. */
+#define SOFTFILTER_BANDS_PER_WORKER 4
+/* Below this, scheduling a band costs more than filtering it */
+#define SOFTFILTER_MIN_BAND_ROWS    8
+#endif
+
 struct rarch_soft_plug
 {
 #ifdef HAVE_DYLIB
@@ -57,51 +69,35 @@ struct rarch_softfilter
    unsigned max_width, max_height;
    enum retro_pixel_format pix_fmt, out_pix_fmt;
 
+   /* One work packet per row band */
    struct softfilter_work_packet *packets;
    unsigned threads;
 
 #ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
+   tpool_t *pool;
+   unsigned workers;
+   retro_atomic_long_t next_band;
 #endif
 };
 
 #ifdef HAVE_THREADS
-#include <rthreads/rthreads.h>
-
-struct filter_thread_data
-{
-   sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
-   slock_t *lock;
-   void *userdata;
-   bool die;
-   bool done;
-};
-
-static void filter_thread_loop(void *data)
+/* Runs on the pool and on the calling thread alike: keeps
+ * claiming the next unprocessed row band until none are left. */
+static void softfilter_band_worker(void *data)
 {
-   struct filter_thread_data *thr = (struct filter_thread_data*)data;
+   rarch_softfilter_t *filt = (rarch_softfilter_t*)data;
 
    for (;;)
    {
-      bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
-
-      if (die)
-         break;
+      const struct softfilter_work_packet *packet = NULL;
+      long band = retro_atomic_fetch_add(&filt->next_band, 1);
 
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
+      if (band >= (long)filt->threads)
+         break;
 
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
+      packet = &filt->packets[band];
+      if (packet->work)
+         packet->work(filt->impl_data, packet->thread_data);
    }
 }
 #endif
@@ -136,7 +132,7 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts;
+   unsigned input_fmts, input_fmt, output_fmts, bands;
    struct config_file_userdata userdata;
    char key[64], name[64];
    name[0] = '\0';
@@ -204,29 +200,45 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    filt->max_width = max_width;
    filt->max_height = max_height;
 
+   if (threads == RARCH_SOFTFILTER_THREADS_AUTO)
+      threads = cpu_features_get_core_amount();
+   if (!threads)
+      threads = 1;
+
+   /* Filters split the frame into as many row bands as they
+    * are given 'threads'; ask for more bands than there are
+    * workers so the pool can balance them dynamically. */
+   bands = threads;
+#ifdef HAVE_THREADS
+   if (threads > 1)
+   {
+      unsigned max_bands = max_height / SOFTFILTER_MIN_BAND_ROWS;
+      bands              = threads * SOFTFILTER_BANDS_PER_WORKER;
+      if (bands > max_bands)
+         bands           = MAX(max_bands, 1);
+   }
+#endif
+
    filt->impl_data = filt->impl->create(
          &softfilter_config, input_fmt, input_fmt, max_width, max_height,
-         threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads :
-         cpu_features_get_core_amount(), cpu_features,
-         &userdata);
+         bands, cpu_features, &userdata);
    if (!filt->impl_data)
    {
       RARCH_ERR("Failed to create softfilter state.\n");
       return false;
    }
 
-   threads = filt->impl->query_num_threads(filt->impl_data);
-   if (!threads)
+   bands = filt->impl->query_num_threads(filt->impl_data);
+   if (!bands)
    {
       RARCH_ERR("Invalid number of threads.\n");
       return false;
    }
 
-   filt->threads = threads;
-   RARCH_LOG("Using %u threads for softfilter.\n", threads);
+   filt->threads = bands;
 
    filt->packets = (struct softfilter_work_packet*)
-      calloc(threads, sizeof(*filt->packets));
+      calloc(bands, sizeof(*filt->packets));
    if (!filt->packets)
    {
       RARCH_ERR("Failed to allocate softfilter packets.\n");
@@ -234,30 +246,19 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    }
 
 #ifdef HAVE_THREADS
-   if (filt->threads > 1)
+   /* The thread calling rarch_softfilter_process() works
+    * through bands too, so the pool needs one thread less */
+   filt->workers = MIN(threads, bands);
+   if (filt->workers > 1)
    {
-      unsigned i;
-      if (!(filt->thread_data = (struct filter_thread_data*)
-         calloc(threads, sizeof(*filt->thread_data))))
+      if (!(filt->pool = tpool_create(filt->workers - 1)))
          return false;
-
-      for (i = 0; i < threads; i++)
-      {
-         filt->thread_data[i].userdata = filt->impl_data;
-         filt->thread_data[i].done     = true;
-
-         filt->thread_data[i].lock     = slock_new();
-         if (!filt->thread_data[i].lock)
-            return false;
-         filt->thread_data[i].cond     = scond_new();
-         if (!filt->thread_data[i].cond)
-            return false;
-         filt->thread_data[i].thread   = sthread_create(
-               filter_thread_loop, &filt->thread_data[i]);
-         if (!filt->thread_data[i].thread)
-            return false;
-      }
    }
+
+   RARCH_LOG("[SoftFilter]: Using %u row band(s) on %u thread(s).\n",
+         bands, MAX(filt->workers, 1));
+#else
+   RARCH_LOG("[SoftFilter]: Using %u row band(s).\n", bands);
 #endif
 
    return true;
@@ -483,6 +484,11 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    if (!filt)
       return;
 
+#ifdef HAVE_THREADS
+   if (filt->pool)
+      tpool_destroy(filt->pool);
+#endif
+
    free(filt->packets);
    if (filt->impl && filt->impl_data)
       filt->impl->destroy(filt->impl_data);
@@ -496,25 +502,6 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    free(filt->plugs);
 #endif
 
-#ifdef HAVE_THREADS
-   if (filt->threads > 1)
-   {
-      for (i = 0; i < filt->threads; i++)
-      {
-         if (!filt->thread_data[i].thread)
-            continue;
-         slock_lock(filt->thread_data[i].lock);
-         filt->thread_data[i].die = true;
-         scond_signal(filt->thread_data[i].cond);
-         slock_unlock(filt->thread_data[i].lock);
-         sthread_join(filt->thread_data[i].thread);
-         slock_free(filt->thread_data[i].lock);
-         scond_free(filt->thread_data[i].cond);
-      }
-      free(filt->thread_data);
-   }
-#endif
-
    if (filt->conf)
       config_file_free(filt->conf);
 
@@ -558,32 +545,17 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
             output, output_stride, input, width, height, input_stride);
 
 #ifdef HAVE_THREADS
-   if (filt->threads > 1)
+   if (filt->pool)
    {
-      /* Fire off workers */
-      for (i = 0; i < filt->threads; i++)
-      {
-#if 0
-         RARCH_LOG("Firing off filter thread %u ...\n", i);
-#endif
-         filt->thread_data[i].packet = &filt->packets[i];
-         slock_lock(filt->thread_data[i].lock);
-         filt->thread_data[i].done = false;
-         scond_signal(filt->thread_data[i].cond);
-         slock_unlock(filt->thread_data[i].lock);
-      }
+      retro_atomic_store_release(&filt->next_band, 0);
 
-      /* Wait for workers */
-      for (i = 0; i < filt->threads; i++)
-      {
-#if 0
-         RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-         slock_lock(filt->thread_data[i].lock);
-         while (!filt->thread_data[i].done)
-            scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-         slock_unlock(filt->thread_data[i].lock);
-      }
+      /* Bands are claimed in order, each pool thread keeps
+       * going until all of them are taken */
+      for (i = 1; i < filt->workers; i++)
+         tpool_add_work(filt->pool, softfilter_band_worker, filt);
+
+      softfilter_band_worker(filt);
+      tpool_wait(filt->pool);
       return;
    }
 #endif
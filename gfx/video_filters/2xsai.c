@@ -37,6 +37,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   unsigned rows_below;
 };
 
 struct filter_data
@@ -76,9 +77,7 @@ static void *twoxsai_generic_create(const struct softfilter_config *config,
       free(filt);
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    return filt;
 }
@@ -115,12 +114,12 @@ static void twoxsai_generic_destroy(void *data)
 
 #define twoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define twoxsai_declare_variables(typename_t, in, nextline) \
+#define twoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product, product1, product2; \
-         typename_t colorI = *(in - nextline - 1); \
-         typename_t colorE = *(in - nextline + 0); \
-         typename_t colorF = *(in - nextline + 1); \
-         typename_t colorJ = *(in - nextline + 2); \
+         typename_t colorI = *(in - prevline - 1); \
+         typename_t colorE = *(in - prevline + 0); \
+         typename_t colorF = *(in - prevline + 1); \
+         typename_t colorJ = *(in - prevline + 2); \
          typename_t colorG = *(in - 1); \
          typename_t colorA = *(in + 0); \
          typename_t colorB = *(in + 1); \
@@ -129,9 +128,9 @@ static void twoxsai_generic_destroy(void *data)
          typename_t colorC = *(in + nextline + 0); \
          typename_t colorD = *(in + nextline + 1); \
          typename_t colorL = *(in + nextline + 2); \
-         typename_t colorM = *(in + nextline + nextline - 1); \
-         typename_t colorN = *(in + nextline + nextline + 0); \
-         typename_t colorO = *(in + nextline + nextline + 1);
+         typename_t colorM = *(in + nextline2 - 1); \
+         typename_t colorN = *(in + nextline2 + 0); \
+         typename_t colorO = *(in + nextline2 + 1);
 
 #ifndef twoxsai_function
 #define twoxsai_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -208,20 +207,24 @@ static void twoxsai_generic_destroy(void *data)
 #endif
 
 static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
-      int first, int last, uint32_t *src,
+      unsigned above, unsigned below, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
-      uint32_t *in  = (uint32_t*)src;
-      uint32_t *out = (uint32_t*)dst;
+      /* Neighbouring lines, clamped at the edges of the frame */
+      unsigned rows_below = height - 1 - y + below;
+      unsigned prevline   = (above + y) ? src_stride : 0;
+      unsigned nextline   = rows_below ? src_stride : 0;
+      unsigned nextline2  = (rows_below > 1) ? 2 * src_stride : nextline;
+      uint32_t *in        = (uint32_t*)src;
+      uint32_t *out       = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint32_t, in, nextline);
+         twoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -240,20 +243,24 @@ static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
 }
 
 static void twoxsai_generic_rgb565(unsigned width, unsigned height,
-      int first, int last, uint16_t *src,
+      unsigned above, unsigned below, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
-      uint16_t *in  = (uint16_t*)src;
-      uint16_t *out = (uint16_t*)dst;
+      /* Neighbouring lines, clamped at the edges of the frame */
+      unsigned rows_below = height - 1 - y + below;
+      unsigned prevline   = (above + y) ? src_stride : 0;
+      unsigned nextline   = rows_below ? src_stride : 0;
+      unsigned nextline2  = (rows_below > 1) ? 2 * src_stride : nextline;
+      uint16_t *in        = (uint16_t*)src;
+      uint16_t *out       = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint16_t, in, nextline);
+         twoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -280,7 +287,7 @@ static void twoxsai_work_cb_rgb565(void *data, void *thread_data)
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
    twoxsai_generic_rgb565(width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->rows_below, input,
          (unsigned)(thr->in_pitch / SOFTFILTER_BPP_RGB565),
          output,
          (unsigned)(thr->out_pitch / SOFTFILTER_BPP_RGB565));
@@ -295,7 +302,7 @@ static void twoxsai_work_cb_xrgb8888(void *data, void *thread_data)
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
    twoxsai_generic_xrgb8888(width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->rows_below, input,
          (unsigned)(thr->in_pitch / SOFTFILTER_BPP_XRGB8888),
          output,
          (unsigned)(thr->out_pitch / SOFTFILTER_BPP_XRGB8888));
@@ -331,6 +338,7 @@ static void twoxsai_generic_packets(void *data,
        */
       thr->first             = y_start;
       thr->last              = y_end == height;
+      thr->rows_below        = height - y_end;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work     = twoxsai_work_cb_rgb565;
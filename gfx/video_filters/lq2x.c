@@ -75,9 +75,7 @@ static void *lq2x_generic_create(const struct softfilter_config *config,
       free(filt);
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    return filt;
 }
@@ -111,8 +109,10 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
 
    for (y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      /* Neighbouring lines, clamped at the edges of the
+       * frame but not at the edges of this band */
+      int prevline = (y == 0 && !first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for (x = 0; x < width; x++)
       {
@@ -155,8 +155,10 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
 
    for (y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      /* Neighbouring lines, clamped at the edges of the
+       * frame but not at the edges of this band */
+      int prevline = (y == 0 && !first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for (x = 0; x < width; x++)
       {
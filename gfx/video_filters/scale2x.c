@@ -20,6 +20,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation scale2x_get_implementation
 #define softfilter_thread_data scale2x_softfilter_thread_data
@@ -39,13 +45,152 @@ struct softfilter_thread_data
    int last;
 };
 
+/* Vector row kernels process the interior of a row and
+ * return the first column they did not handle */
+typedef unsigned (*scale2x_row_xrgb8888_t)(const uint32_t *prev,
+      const uint32_t *cur, const uint32_t *next,
+      uint32_t *out0, uint32_t *out1, unsigned width);
+typedef unsigned (*scale2x_row_rgb565_t)(const uint16_t *prev,
+      const uint16_t *cur, const uint16_t *next,
+      uint16_t *out0, uint16_t *out1, unsigned width);
+
 struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
    unsigned in_fmt;
+   scale2x_row_xrgb8888_t row_xrgb8888;
+   scale2x_row_rgb565_t row_rgb565;
 };
 
+#if defined(__SSE2__)
+/* Four (XRGB8888) or eight (RGB565) pixels at a time; the
+ * first and last column clamp their neighbours and are left
+ * to the scalar path. */
+static unsigned scale2x_row_xrgb8888_sse2(const uint32_t *prev,
+      const uint32_t *cur, const uint32_t *next,
+      uint32_t *out0, uint32_t *out1, unsigned width)
+{
+   unsigned x;
+
+   for (x = 1; x + 4 < width; x += 4)
+   {
+      __m128i A    = _mm_loadu_si128((const __m128i*)(prev + x));
+      __m128i B    = _mm_loadu_si128((const __m128i*)(cur  + x - 1));
+      __m128i C    = _mm_loadu_si128((const __m128i*)(cur  + x));
+      __m128i D    = _mm_loadu_si128((const __m128i*)(cur  + x + 1));
+      __m128i E    = _mm_loadu_si128((const __m128i*)(next + x));
+      /* All lanes set where the expansion must not happen */
+      __m128i keep = _mm_or_si128(_mm_cmpeq_epi32(A, E),
+            _mm_cmpeq_epi32(B, D));
+      __m128i m00  = _mm_andnot_si128(keep, _mm_cmpeq_epi32(A, B));
+      __m128i m01  = _mm_andnot_si128(keep, _mm_cmpeq_epi32(A, D));
+      __m128i m10  = _mm_andnot_si128(keep, _mm_cmpeq_epi32(E, B));
+      __m128i m11  = _mm_andnot_si128(keep, _mm_cmpeq_epi32(E, D));
+      __m128i p00  = _mm_or_si128(_mm_and_si128(m00, A), _mm_andnot_si128(m00, C));
+      __m128i p01  = _mm_or_si128(_mm_and_si128(m01, A), _mm_andnot_si128(m01, C));
+      __m128i p10  = _mm_or_si128(_mm_and_si128(m10, E), _mm_andnot_si128(m10, C));
+      __m128i p11  = _mm_or_si128(_mm_and_si128(m11, E), _mm_andnot_si128(m11, C));
+
+      _mm_storeu_si128((__m128i*)(out0 + 2 * x),     _mm_unpacklo_epi32(p00, p01));
+      _mm_storeu_si128((__m128i*)(out0 + 2 * x + 4), _mm_unpackhi_epi32(p00, p01));
+      _mm_storeu_si128((__m128i*)(out1 + 2 * x),     _mm_unpacklo_epi32(p10, p11));
+      _mm_storeu_si128((__m128i*)(out1 + 2 * x + 4), _mm_unpackhi_epi32(p10, p11));
+   }
+
+   return x;
+}
+
+static unsigned scale2x_row_rgb565_sse2(const uint16_t *prev,
+      const uint16_t *cur, const uint16_t *next,
+      uint16_t *out0, uint16_t *out1, unsigned width)
+{
+   unsigned x;
+
+   for (x = 1; x + 8 < width; x += 8)
+   {
+      __m128i A    = _mm_loadu_si128((const __m128i*)(prev + x));
+      __m128i B    = _mm_loadu_si128((const __m128i*)(cur  + x - 1));
+      __m128i C    = _mm_loadu_si128((const __m128i*)(cur  + x));
+      __m128i D    = _mm_loadu_si128((const __m128i*)(cur  + x + 1));
+      __m128i E    = _mm_loadu_si128((const __m128i*)(next + x));
+      __m128i keep = _mm_or_si128(_mm_cmpeq_epi16(A, E),
+            _mm_cmpeq_epi16(B, D));
+      __m128i m00  = _mm_andnot_si128(keep, _mm_cmpeq_epi16(A, B));
+      __m128i m01  = _mm_andnot_si128(keep, _mm_cmpeq_epi16(A, D));
+      __m128i m10  = _mm_andnot_si128(keep, _mm_cmpeq_epi16(E, B));
+      __m128i m11  = _mm_andnot_si128(keep, _mm_cmpeq_epi16(E, D));
+      __m128i p00  = _mm_or_si128(_mm_and_si128(m00, A), _mm_andnot_si128(m00, C));
+      __m128i p01  = _mm_or_si128(_mm_and_si128(m01, A), _mm_andnot_si128(m01, C));
+      __m128i p10  = _mm_or_si128(_mm_and_si128(m10, E), _mm_andnot_si128(m10, C));
+      __m128i p11  = _mm_or_si128(_mm_and_si128(m11, E), _mm_andnot_si128(m11, C));
+
+      _mm_storeu_si128((__m128i*)(out0 + 2 * x),     _mm_unpacklo_epi16(p00, p01));
+      _mm_storeu_si128((__m128i*)(out0 + 2 * x + 8), _mm_unpackhi_epi16(p00, p01));
+      _mm_storeu_si128((__m128i*)(out1 + 2 * x),     _mm_unpacklo_epi16(p10, p11));
+      _mm_storeu_si128((__m128i*)(out1 + 2 * x + 8), _mm_unpackhi_epi16(p10, p11));
+   }
+
+   return x;
+}
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static unsigned scale2x_row_xrgb8888_neon(const uint32_t *prev,
+      const uint32_t *cur, const uint32_t *next,
+      uint32_t *out0, uint32_t *out1, unsigned width)
+{
+   unsigned x;
+
+   for (x = 1; x + 4 < width; x += 4)
+   {
+      uint32x4x2_t row0, row1;
+      uint32x4_t A    = vld1q_u32(prev + x);
+      uint32x4_t B    = vld1q_u32(cur  + x - 1);
+      uint32x4_t C    = vld1q_u32(cur  + x);
+      uint32x4_t D    = vld1q_u32(cur  + x + 1);
+      uint32x4_t E    = vld1q_u32(next + x);
+      uint32x4_t keep = vorrq_u32(vceqq_u32(A, E), vceqq_u32(B, D));
+
+      row0.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(A, B), keep), A, C);
+      row0.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(A, D), keep), A, C);
+      row1.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(E, B), keep), E, C);
+      row1.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(E, D), keep), E, C);
+
+      vst2q_u32(out0 + 2 * x, row0);
+      vst2q_u32(out1 + 2 * x, row1);
+   }
+
+   return x;
+}
+
+static unsigned scale2x_row_rgb565_neon(const uint16_t *prev,
+      const uint16_t *cur, const uint16_t *next,
+      uint16_t *out0, uint16_t *out1, unsigned width)
+{
+   unsigned x;
+
+   for (x = 1; x + 8 < width; x += 8)
+   {
+      uint16x8x2_t row0, row1;
+      uint16x8_t A    = vld1q_u16(prev + x);
+      uint16x8_t B    = vld1q_u16(cur  + x - 1);
+      uint16x8_t C    = vld1q_u16(cur  + x);
+      uint16x8_t D    = vld1q_u16(cur  + x + 1);
+      uint16x8_t E    = vld1q_u16(next + x);
+      uint16x8_t keep = vorrq_u16(vceqq_u16(A, E), vceqq_u16(B, D));
+
+      row0.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(A, B), keep), A, C);
+      row0.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(A, D), keep), A, C);
+      row1.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(E, B), keep), E, C);
+      row1.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(E, D), keep), E, C);
+
+      vst2q_u16(out0 + 2 * x, row0);
+      vst2q_u16(out1 + 2 * x, row1);
+   }
+
+   return x;
+}
+#endif
+
 static unsigned scale2x_generic_input_fmts(void)
 {
    return SOFTFILTER_FMT_XRGB8888 | SOFTFILTER_FMT_RGB565;
@@ -70,15 +215,30 @@ static void *scale2x_generic_create(const struct softfilter_config *config,
    struct filter_data *filt = (struct filter_data*)calloc(1, sizeof(*filt));
    if (!filt)
       return NULL;
-   if (!(filt->workers = (struct softfilter_thread_data*)calloc(1, sizeof(struct softfilter_thread_data))))
+   if (!threads)
+      threads = 1;
+   if (!(filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data))))
    {
       free(filt);
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
+
+#if defined(__SSE2__)
+   if (simd & SOFTFILTER_SIMD_SSE2)
+   {
+      filt->row_xrgb8888 = scale2x_row_xrgb8888_sse2;
+      filt->row_rgb565   = scale2x_row_rgb565_sse2;
+   }
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   if (simd & SOFTFILTER_SIMD_NEON)
+   {
+      filt->row_xrgb8888 = scale2x_row_xrgb8888_neon;
+      filt->row_rgb565   = scale2x_row_rgb565_neon;
+   }
+#endif
+
    return filt;
 }
 
@@ -99,99 +259,100 @@ static void scale2x_generic_destroy(void *data)
    free(filt);
 }
 
+#define SCALE2X_PIXELS(typename_t, prev, cur, next, out0, out1, x, end, width) \
+   for (; x < end; x++) \
+   { \
+      /* Get sample points */ \
+      typename_t A = prev[x]; \
+      typename_t B = cur[(x > 0) ? x - 1 : x]; \
+      typename_t C = cur[x]; \
+      typename_t D = cur[(x < width - 1) ? x + 1 : x]; \
+      typename_t E = next[x]; \
+      \
+      /* Apply pixel expansion algorithm */ \
+      if (A != E && B != D) \
+      { \
+         out0[2 * x]     = (A == B ? A : C); \
+         out0[2 * x + 1] = (A == D ? A : C); \
+         out1[2 * x]     = (E == B ? E : C); \
+         out1[2 * x + 1] = (E == D ? E : C); \
+      } \
+      else \
+      { \
+         out0[2 * x]     = C; \
+         out0[2 * x + 1] = C; \
+         out1[2 * x]     = C; \
+         out1[2 * x + 1] = C; \
+      } \
+   }
+
 static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
 {
+   struct filter_data *filt           = (struct filter_data*)data;
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
    uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
    uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
    const uint32_t *input              = (const uint32_t*)thr->in_data;
-   uint32_t *output0                  = (uint32_t*)thr->out_data;
-   uint32_t *output1                  = (uint32_t*)thr->out_data + out_stride;
-   uint16_t x, y;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned y;
 
    for (y = 0; y < thr->height; y++)
    {
-      /* Determine offsets of previous/next source lines */
-      uint32_t line_prev = (y == 0)               ? 0 : in_stride;
-      uint32_t line_next = (y == thr->height - 1) ? 0 : in_stride;
+      /* Previous/next source lines, clamped at the frame
+       * edges but not at the edges of this band */
+      const uint32_t *prev = (y == 0 && !thr->first)
+         ? input : input - in_stride;
+      const uint32_t *next = (y == thr->height - 1 && thr->last)
+         ? input : input + in_stride;
+      uint32_t *output0    = output;
+      uint32_t *output1    = output + out_stride;
+      unsigned x           = 0;
 
-      for (x = 0; x < thr->width; x++)
+      if (filt->row_xrgb8888 && width > 1)
       {
-         /* Get sample points */
-         uint32_t A = *(input - line_prev);
-         uint32_t B = (x > 0) ? *(input - 1) : *input;
-         uint32_t C = *input;
-         uint32_t D = (x < thr->width - 1) ? *(input + 1) : *input;
-         uint32_t E = *(input++ + line_next);
-
-         /* Apply pixel expansion algorithm */
-         if (A != E && B != D)
-         {
-            *output0++ = (A == B ? A : C);
-            *output0++ = (A == D ? A : C);
-            *output1++ = (E == B ? E : C);
-            *output1++ = (E == D ? E : C);
-         }
-         else
-         {
-            *output0++ = C;
-            *output0++ = C;
-            *output1++ = C;
-            *output1++ = C;
-         }
+         SCALE2X_PIXELS(uint32_t, prev, input, next, output0, output1, x, 1, width);
+         x = filt->row_xrgb8888(prev, input, next, output0, output1, width);
       }
+      SCALE2X_PIXELS(uint32_t, prev, input, next, output0, output1, x, width, width);
 
-      input   += in_stride - thr->width;
-      output0 += (out_stride << 1) - (thr->width << 1);
-      output1 += (out_stride << 1) - (thr->width << 1);
+      input  += in_stride;
+      output += out_stride << 1;
    }
 }
 
 static void scale2x_work_cb_rgb565(void *data, void *thread_data)
 {
+   struct filter_data *filt           = (struct filter_data*)data;
    struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
    uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
    uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
    const uint16_t *input              = (const uint16_t*)thr->in_data;
-   uint16_t *output0                  = (uint16_t*)thr->out_data;
-   uint16_t *output1                  = (uint16_t*)thr->out_data + out_stride;
-   uint16_t x, y;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned y;
 
    for (y = 0; y < thr->height; y++)
    {
-      /* Determine offsets of previous/next source lines */
-      uint32_t line_prev = (y == 0)               ? 0 : in_stride;
-      uint32_t line_next = (y == thr->height - 1) ? 0 : in_stride;
+      /* Previous/next source lines, clamped at the frame
+       * edges but not at the edges of this band */
+      const uint16_t *prev = (y == 0 && !thr->first)
+         ? input : input - in_stride;
+      const uint16_t *next = (y == thr->height - 1 && thr->last)
+         ? input : input + in_stride;
+      uint16_t *output0    = output;
+      uint16_t *output1    = output + out_stride;
+      unsigned x           = 0;
 
-      for (x = 0; x < thr->width; x++)
+      if (filt->row_rgb565 && width > 1)
       {
-         /* Get sample points */
-         uint16_t A = *(input - line_prev);
-         uint16_t B = (x > 0) ? *(input - 1) : *input;
-         uint16_t C = *input;
-         uint16_t D = (x < thr->width - 1) ? *(input + 1) : *input;
-         uint16_t E = *(input++ + line_next);
-
-         /* Apply pixel expansion algorithm */
-         if (A != E && B != D)
-         {
-            *output0++ = (A == B ? A : C);
-            *output0++ = (A == D ? A : C);
-            *output1++ = (E == B ? E : C);
-            *output1++ = (E == D ? E : C);
-         }
-         else
-         {
-            *output0++ = C;
-            *output0++ = C;
-            *output1++ = C;
-            *output1++ = C;
-         }
+         SCALE2X_PIXELS(uint16_t, prev, input, next, output0, output1, x, 1, width);
+         x = filt->row_rgb565(prev, input, next, output0, output1, width);
       }
+      SCALE2X_PIXELS(uint16_t, prev, input, next, output0, output1, x, width, width);
 
-      input   += in_stride - thr->width;
-      output0 += (out_stride << 1) - (thr->width << 1);
-      output1 += (out_stride << 1) - (thr->width << 1);
+      input  += in_stride;
+      output += out_stride << 1;
    }
 }
 
@@ -200,26 +361,35 @@ static void scale2x_generic_packets(void *data,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride)
 {
-   /* We are guaranteed single threaded operation
-    * (filt->threads = 1) so we don't need to loop
-    * over threads and can cull some code. This only
-    * makes the tiniest performance difference, but
-    * every little helps when running on an o3DS... */
-   struct filter_data *filt           = (struct filter_data*)data;
-   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[0];
-
-   thr->out_data                      = (uint8_t*)output;
-   thr->in_data                       = (const uint8_t*)input;
-   thr->out_pitch                     = output_stride;
-   thr->in_pitch                      = input_stride;
-   thr->width                         = width;
-   thr->height                        = height;
-
-   if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
-      packets[0].work                 = scale2x_work_cb_xrgb8888;
-   else if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
-      packets[0].work                 = scale2x_work_cb_rgb565;
-   packets[0].thread_data             = thr;
+   unsigned i;
+   struct filter_data *filt = (struct filter_data*)data;
+
+   for (i = 0; i < filt->threads; i++)
+   {
+      struct softfilter_thread_data *thr =
+         (struct softfilter_thread_data*)&filt->workers[i];
+
+      unsigned y_start       = (height * i) / filt->threads;
+      unsigned y_end         = (height * (i + 1)) / filt->threads;
+
+      thr->out_data          = (uint8_t*)output + y_start * 2 * output_stride;
+      thr->in_data           = (const uint8_t*)input + y_start * input_stride;
+      thr->out_pitch         = output_stride;
+      thr->in_pitch          = input_stride;
+      thr->width             = width;
+      thr->height            = y_end - y_start;
+
+      /* Workers need to know if they can access pixels
+       * outside their given buffer. */
+      thr->first             = y_start;
+      thr->last              = y_end == height;
+
+      if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
+         packets[i].work     = scale2x_work_cb_xrgb8888;
+      else if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
+         packets[i].work     = scale2x_work_cb_rgb565;
+      packets[i].thread_data = thr;
+   }
 }
 
 static const struct softfilter_implementation scale2x_generic = {
@@ -249,3 +419,5 @@ const struct softfilter_implementation *softfilter_get_implementation(
 #undef softfilter_thread_data
 #undef filter_data
 #endif
+
+#undef SCALE2X_PIXELS
@@ -38,6 +38,7 @@ struct softfilter_thread_data
    unsigned height;
    int first;
    int last;
+   unsigned rows_below;
 };
 
 struct filter_data
@@ -77,9 +78,7 @@ static void *supertwoxsai_generic_create(const struct softfilter_config *config,
       free(filt);
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
 
    return filt;
@@ -114,12 +113,12 @@ static void supertwoxsai_generic_destroy(void *data)
 #define supertwoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)))
 
 #ifndef supertwoxsai_declare_variables
-#define supertwoxsai_declare_variables(typename_t, in, nextline) \
+#define supertwoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product1a, product1b, product2a, product2b; \
-         const typename_t colorB0 = *(in - nextline - 1); \
-         const typename_t colorB1 = *(in - nextline + 0); \
-         const typename_t colorB2 = *(in - nextline + 1); \
-         const typename_t colorB3 = *(in - nextline + 2); \
+         const typename_t colorB0 = *(in - prevline - 1); \
+         const typename_t colorB1 = *(in - prevline + 0); \
+         const typename_t colorB2 = *(in - prevline + 1); \
+         const typename_t colorB3 = *(in - prevline + 2); \
          const typename_t color4  = *(in - 1); \
          const typename_t color5  = *(in + 0); \
          const typename_t color6  = *(in + 1); \
@@ -128,10 +127,10 @@ static void supertwoxsai_generic_destroy(void *data)
          const typename_t color2  = *(in + nextline + 0); \
          const typename_t color3  = *(in + nextline + 1); \
          const typename_t colorS1 = *(in + nextline + 2); \
-         const typename_t colorA0 = *(in + nextline + nextline - 1); \
-         const typename_t colorA1 = *(in + nextline + nextline + 0); \
-         const typename_t colorA2 = *(in + nextline + nextline + 1); \
-         const typename_t colorA3 = *(in + nextline + nextline + 2)
+         const typename_t colorA0 = *(in + nextline2 - 1); \
+         const typename_t colorA1 = *(in + nextline2 + 0); \
+         const typename_t colorA2 = *(in + nextline2 + 1); \
+         const typename_t colorA3 = *(in + nextline2 + 2)
 #endif
 
 #ifndef supertwoxsai_function
@@ -198,20 +197,24 @@ static void supertwoxsai_generic_destroy(void *data)
 #endif
 
 static void supertwoxsai_generic_xrgb8888(unsigned width, unsigned height,
-      int first, int last, uint32_t *src,
+      unsigned above, unsigned below, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
-      uint32_t *in  = (uint32_t*)src;
-      uint32_t *out = (uint32_t*)dst;
+      /* Neighbouring lines, clamped at the edges of the frame */
+      unsigned rows_below = height - 1 - y + below;
+      unsigned prevline   = (above + y) ? src_stride : 0;
+      unsigned nextline   = rows_below ? src_stride : 0;
+      unsigned nextline2  = (rows_below > 1) ? 2 * src_stride : nextline;
+      uint32_t *in        = (uint32_t*)src;
+      uint32_t *out       = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint32_t, in, nextline);
+         supertwoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          /*---------------------------    B1 B2
           *                             4  5  6 S2
@@ -229,20 +232,24 @@ static void supertwoxsai_generic_xrgb8888(unsigned width, unsigned height,
 }
 
 static void supertwoxsai_generic_rgb565(unsigned width, unsigned height,
-      int first, int last, uint16_t *src,
+      unsigned above, unsigned below, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
-      uint16_t *in  = (uint16_t*)src;
-      uint16_t *out = (uint16_t*)dst;
+      /* Neighbouring lines, clamped at the edges of the frame */
+      unsigned rows_below = height - 1 - y + below;
+      unsigned prevline   = (above + y) ? src_stride : 0;
+      unsigned nextline   = rows_below ? src_stride : 0;
+      unsigned nextline2  = (rows_below > 1) ? 2 * src_stride : nextline;
+      uint16_t *in        = (uint16_t*)src;
+      uint16_t *out       = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint16_t, in, nextline);
+         supertwoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          /*---------------------------    B1 B2
           *                             4  5  6 S2
@@ -267,7 +274,7 @@ static void supertwoxsai_work_cb_rgb565(void *data, void *thread_data)
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
    supertwoxsai_generic_rgb565(width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->rows_below, input,
         (unsigned)(thr->in_pitch / SOFTFILTER_BPP_RGB565),
         output,
         (unsigned)(thr->out_pitch / SOFTFILTER_BPP_RGB565));
@@ -281,7 +288,7 @@ static void supertwoxsai_work_cb_xrgb8888(void *data, void *thread_data)
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
    supertwoxsai_generic_xrgb8888(width, height,
-         thr->first, thr->last, input,
+         thr->first, thr->rows_below, input,
 	 (unsigned)(thr->in_pitch / SOFTFILTER_BPP_XRGB8888),
 	 output,
 	 (unsigned)(thr->out_pitch / SOFTFILTER_BPP_XRGB8888));
@@ -312,6 +319,7 @@ static void supertwoxsai_generic_packets(void *data,
        * outside their given buffer. */
       thr->first             = y_start;
       thr->last              = y_end == height;
+      thr->rows_below        = height - y_end;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
          packets[i].work     = supertwoxsai_work_cb_rgb565;
@@ -56,6 +56,10 @@
 #include "drivers_shader/slang_process.h"
 #endif
 
+#ifdef HAVE_SLANG
+#include "drivers_shader/slang_cache.h"
+#endif
+
 /* Maximum depth of chain of referenced shader presets.
  * 16 seems to be a very large number of references at the moment. */
 #define SHADER_MAX_REFERENCE_DEPTH 16
@@ -2200,6 +2204,11 @@ bool video_shader_load_preset_into_shader(const char *path,
    struct path_linked_list* path_list_tmp            = NULL;
    config_file_t *root_conf                          = video_shader_get_root_preset_config(path);
 
+#ifdef HAVE_SLANG
+   /* Passes are compiled once the preset is loaded */
+   slang_cache_set_dir(config_get_ptr()->paths.directory_cache);
+#endif
+
    if (!root_conf)
    {
       RARCH_LOG("\n");
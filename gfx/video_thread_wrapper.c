@@ -418,10 +418,13 @@ static void video_thread_loop(void *data)
    for (;;)
    {
       slock_lock(thr->lock);
-      while (thr->send_cmd == CMD_VIDEO_NONE && !thr->frame.updated)
+      while (   thr->send_cmd == CMD_VIDEO_NONE
+             && !(retro_atomic_load_acquire(&thr->frame.ready)
+                & THREAD_FRAME_FRESH))
          scond_wait(thr->cond_thread, thr->lock);
 
-      updated = thr->frame.updated;
+      updated = (retro_atomic_load_acquire(&thr->frame.ready)
+            & THREAD_FRAME_FRESH) != 0;
 
       /* To avoid race condition where send_cmd is updated
        * right after the switch is checked. */
@@ -435,9 +438,10 @@ static void video_thread_loop(void *data)
       if (updated)
       {
          struct video_viewport vp;
-         bool               alive = false;
-         bool               focus = false;
-         bool        has_windowed = false;
+         thread_frame_slot_t *slot = NULL;
+         bool               alive  = false;
+         bool               focus  = false;
+         bool        has_windowed  = false;
 
          vp.x                     = 0;
          vp.y                     = 0;
@@ -446,6 +450,13 @@ static void video_thread_loop(void *data)
          vp.full_width            = 0;
          vp.full_height           = 0;
 
+         /* Take the newest frame and hand our previous
+          * slot back to the core thread */
+         thr->frame.read_slot     = (unsigned)retro_atomic_exchange(
+               &thr->frame.ready, (long)thr->frame.read_slot)
+            & (THREAD_FRAME_FRESH - 1);
+         slot                     = &thr->frame.slots[thr->frame.read_slot];
+
          slock_lock(thr->frame.lock);
 
          thread_update_driver_state(thr);
@@ -462,9 +473,10 @@ static void video_thread_loop(void *data)
                video_driver_build_info(&video_info);
 
                ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count, thr->frame.pitch,
-                  *thr->frame.msg ? thr->frame.msg : NULL,
+                  slot->dupe ? NULL : slot->buffer,
+                  slot->width, slot->height,
+                  slot->count, slot->pitch,
+                  *slot->msg ? slot->msg : NULL,
                   &video_info);
 
                slock_unlock(thr->frame.lock);
@@ -493,7 +505,6 @@ static void video_thread_loop(void *data)
          thr->focus         = focus;
          thr->has_windowed  = has_windowed;
          thr->vp            = vp;
-         thr->frame.updated = false;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -595,16 +606,23 @@ static bool video_thread_frame(void *data, const void *frame_,
       return false;
    }
 
-   slock_lock(thr->lock);
-
    if (!thr->nonblock)
    {
       retro_time_t target_frame_time =
          (retro_time_t)roundf(1000000 / video_info->refresh_rate);
       retro_time_t target            = thr->last_time + target_frame_time;
+      retro_time_t wait_start        = cpu_features_get_time_usec();
+
+      slock_lock(thr->lock);
 
-      /* Ideally, use absolute time, but that is only a good idea on POSIX. */
-      while (thr->frame.updated)
+      /* Pace the core to the display: while the previous frame
+       * has not been picked up yet, wait until the frame time
+       * has elapsed. There is always a free slot to write into,
+       * so this never waits for a buffer.
+       *
+       * Ideally, use absolute time, but that is only a good idea on POSIX. */
+      while (retro_atomic_load_acquire(&thr->frame.ready)
+            & THREAD_FRAME_FRESH)
       {
          retro_time_t current = cpu_features_get_time_usec();
          retro_time_t delta   = target - current;
@@ -615,52 +633,78 @@ static bool video_thread_frame(void *data, const void *frame_,
          if (!scond_wait_timeout(thr->cond_cmd, thr->lock, delta))
             break;
       }
+
+      slock_unlock(thr->lock);
+
+      thr->frame.stall_time += cpu_features_get_time_usec() - wait_start;
    }
 
-   /* Drop frame if updated flag is still set, as thread is
-    * still working on last frame. */
-   if (!thr->frame.updated)
    {
-      const uint8_t *src   = (const uint8_t*)frame_;
-      uint8_t       *dst   = thr->frame.buffer;
-      unsigned copy_stride = width *
+      long prev;
+      thread_frame_slot_t *slot = &thr->frame.slots[thr->frame.write_slot];
+      const uint8_t *src        = (const uint8_t*)frame_;
+      unsigned copy_stride      = width *
          (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
 
-      if (src)
+      /* Nothing to copy if the core rendered straight into
+       * the slot (see thread_get_current_software_framebuffer) */
+      if (src == slot->buffer)
+         thr->zero_copy_count++;
+      else if (src)
       {
-         int i; /* TODO/FIXME - increment counter never meaningfully used */
-         for (i = 0; i < (int)height; i++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
+         if (pitch == copy_stride)
+            memcpy(slot->buffer, src, copy_stride * height);
+         else
+         {
+            unsigned i;
+            uint8_t *dst = slot->buffer;
+            for (i = 0; i < height; i++, src += pitch, dst += copy_stride)
+               memcpy(dst, src, copy_stride);
+         }
       }
 
-      thr->frame.updated = true;
-      thr->frame.width   = width;
-      thr->frame.height  = height;
-      thr->frame.count   = frame_count;
-      thr->frame.pitch   = copy_stride;
+      slot->dupe   = (src == NULL);
+      slot->width  = width;
+      slot->height = height;
+      slot->count  = frame_count;
+      slot->pitch  = copy_stride;
 
       if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
+         strlcpy(slot->msg, msg, sizeof(slot->msg));
       else
-         *thr->frame.msg = '\0';
+         *slot->msg = '\0';
+
+      /* Publish the frame. If the slot we get back still
+       * holds an unseen frame, that frame was dropped in
+       * favour of this newer one. */
+      prev                  = retro_atomic_exchange(&thr->frame.ready,
+            (long)(thr->frame.write_slot | THREAD_FRAME_FRESH));
+      thr->frame.write_slot = (unsigned)prev & (THREAD_FRAME_FRESH - 1);
+
+      thr->hit_count++;
+      if (prev & THREAD_FRAME_FRESH)
+         thr->miss_count++;
+   }
 
+   {
+      retro_time_t wait_start = cpu_features_get_time_usec();
+
+      slock_lock(thr->lock);
       scond_signal(thr->cond_thread);
 
 #ifdef HAVE_MENU
       if (thr->texture.enable)
       {
-         do
-         {
+         while (retro_atomic_load_acquire(&thr->frame.ready)
+               & THREAD_FRAME_FRESH)
             scond_wait(thr->cond_cmd, thr->lock);
-         } while (thr->frame.updated);
       }
 #endif
-      thr->hit_count++;
-   }
-   else
-      thr->miss_count++;
 
-   slock_unlock(thr->lock);
+      slock_unlock(thr->lock);
+
+      thr->frame.stall_time += cpu_features_get_time_usec() - wait_start;
+   }
 
    thr->last_time = cpu_features_get_time_usec();
 
@@ -695,20 +739,33 @@ static bool video_thread_init(thread_video_t *thr,
       return false;
 
    {
+      unsigned i;
       size_t max_size        = info.input_scale * RARCH_SCALE_BASE;
       max_size              *= max_size;
       max_size              *= info.rgb32 ?
          sizeof(uint32_t) : sizeof(uint16_t);
 
+      for (i = 0; i < THREAD_FRAME_SLOTS; i++)
+      {
+         thread_frame_slot_t *slot = &thr->frame.slots[i];
 #ifdef _3DS
-      thr->frame.buffer      = linearMemAlign(max_size, 0x80);
+         slot->buffer           = (uint8_t*)linearMemAlign(max_size, 0x80);
 #else
-      thr->frame.buffer      = (uint8_t*)malloc(max_size);
+         slot->buffer           = (uint8_t*)malloc(max_size);
 #endif
-      if (!thr->frame.buffer)
-         return false;
+         if (!slot->buffer)
+            return false;
+
+         memset(slot->buffer, 0x80, max_size);
+      }
 
-      memset(thr->frame.buffer, 0x80, max_size);
+      thr->frame.slot_size   = max_size;
+
+      /* Core thread writes into slot 0, video thread
+       * holds slot 1, slot 2 is waiting to be swapped in */
+      thr->frame.write_slot  = 0;
+      thr->frame.read_slot   = 1;
+      thr->frame.ready       = 2;
    }
 
    thr->input                = input;
@@ -818,6 +875,7 @@ static bool video_thread_read_viewport(void *data,
 
 static void video_thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
 
    if (thr)
@@ -840,11 +898,14 @@ static void video_thread_free(void *data)
       }
 
       free(thr->texture.frame);
+      for (i = 0; i < THREAD_FRAME_SLOTS; i++)
+      {
 #ifdef _3DS
-      linearFree(thr->frame.buffer);
+         linearFree(thr->frame.slots[i].buffer);
 #else
-      free(thr->frame.buffer);
+         free(thr->frame.slots[i].buffer);
 #endif
+      }
       free(thr->alpha_mod);
 
       slock_free(thr->frame.lock);
@@ -854,8 +915,11 @@ static void video_thread_free(void *data)
       scond_free(thr->cond_thread);
 
       RARCH_LOG(
-         "Threaded video stats: Frames pushed: %u, Frames dropped: %u.\n",
-         thr->hit_count, thr->miss_count);
+         "Threaded video stats: Frames pushed: %u, Frames dropped: %u, "
+         "Zero-copy frames: %u, Average core thread stall: %.3f ms.\n",
+         thr->hit_count, thr->miss_count, thr->zero_copy_count,
+         thr->hit_count ? (thr->frame.stall_time / 1000.0)
+            / thr->hit_count : 0.0);
 
       free(thr);
    }
@@ -1248,6 +1312,51 @@ static struct video_shader *thread_get_current_shader(void *data)
    return NULL;
 }
 
+/* Lets the core render straight into the slot the next
+ * frame will be published from, so video_thread_frame()
+ * only has to flip ownership instead of copying.
+ *
+ * Only called from the core thread. */
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   video_driver_state_t *video_st = video_state_get_ptr();
+   thread_video_t            *thr = (thread_video_t*)data;
+   enum retro_pixel_format format = RETRO_PIXEL_FORMAT_RGB565;
+   size_t                     bpp = sizeof(uint16_t);
+
+   if (!thr || !framebuffer)
+      return false;
+
+   if (thr->info.rgb32)
+   {
+      format = RETRO_PIXEL_FORMAT_XRGB8888;
+      bpp    = sizeof(uint32_t);
+   }
+
+   /* The core's frame has to reach video_thread_frame()
+    * untouched - no 0RGB1555 conversion, no softfilter */
+   if (video_st->pix_fmt != format)
+      return false;
+#ifdef HAVE_VIDEO_FILTER
+   if (video_st->state_filter)
+      return false;
+#endif
+
+   if (    !framebuffer->width
+         || !framebuffer->height
+         || (size_t)framebuffer->width * framebuffer->height * bpp
+            > thr->frame.slot_size)
+      return false;
+
+   framebuffer->data         = thr->frame.slots[thr->frame.write_slot].buffer;
+   framebuffer->pitch        = framebuffer->width * bpp;
+   framebuffer->format       = format;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+
+   return true;
+}
+
 static uint32_t thread_get_flags(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
@@ -1258,6 +1367,17 @@ static uint32_t thread_get_flags(void *data)
    return 0;
 }
 
+static unsigned thread_get_max_texture_size(void *data)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+
+   if (     thr && thr->driver_data && thr->poke
+         && thr->poke->get_max_texture_size)
+      return thr->poke->get_max_texture_size(thr->driver_data);
+
+   return 0;
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_get_flags,
    thread_load_texture,
@@ -1278,12 +1398,14 @@ static const video_poke_interface_t thread_poke = {
    thread_show_mouse,
    thread_grab_mouse_toggle,
    thread_get_current_shader,
-   NULL, /* get_current_software_framebuffer */
+   thread_get_current_software_framebuffer,
    NULL, /* get_hw_render_interface */
    thread_set_hdr_max_nits,
    thread_set_hdr_paper_white_nits,
    thread_set_hdr_contrast,
-   thread_set_hdr_expand_gamut
+   thread_set_hdr_expand_gamut,
+   NULL, /* read_viewport_ring */
+   thread_get_max_texture_size
 };
 
 static void video_thread_get_poke_interface(void *data,
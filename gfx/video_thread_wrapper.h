@@ -23,6 +23,7 @@
 #include <retro_common_api.h>
 #include <rthreads/rthreads.h>
 #include <retro_miscellaneous.h>
+#include <retro_atomic.h>
 
 #include "font_driver.h"
 
@@ -166,6 +167,23 @@ typedef struct thread_packet
    enum thread_cmd type;
 } thread_packet_t;
 
+#define THREAD_FRAME_SLOTS 3
+/* Set in thread_video_t::frame.ready while the slot it
+ * points to holds a frame the video thread has not
+ * picked up yet */
+#define THREAD_FRAME_FRESH 0x4
+
+typedef struct thread_frame_slot
+{
+   uint64_t count;
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   char msg[NAME_MAX_LENGTH];
+   bool dupe; /* core asked to show the previous frame again */
+} thread_frame_slot_t;
+
 typedef struct thread_video
 {
    retro_time_t last_time;
@@ -203,8 +221,9 @@ typedef struct thread_video
       bool full_screen;
    } texture;
 
-   unsigned hit_count;
-   unsigned miss_count;
+   unsigned hit_count;  /* frames published by the core thread */
+   unsigned miss_count; /* frames replaced before the video thread saw them */
+   unsigned zero_copy_count; /* frames the core rendered straight into a slot */
    unsigned alpha_mods;
 
    struct video_viewport vp;
@@ -220,14 +239,16 @@ typedef struct thread_video
 
    struct
    {
-      uint64_t count;
+      /* Triple buffer shared between the core thread (producer)
+       * and the video thread (consumer). Each side owns one slot,
+       * the third one is handed over through 'ready'. */
+      thread_frame_slot_t slots[THREAD_FRAME_SLOTS];
+      retro_atomic_long_t ready; /* slot index | THREAD_FRAME_FRESH */
+      retro_time_t stall_time;   /* time the core thread spent waiting */
+      size_t slot_size;          /* size of each slot buffer in bytes */
+      unsigned write_slot;       /* owned by the core thread */
+      unsigned read_slot;        /* owned by the video thread */
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      char msg[NAME_MAX_LENGTH];
-      bool updated;
       bool within_thread;
    } frame;
 
@@ -1220,6 +1220,7 @@ THREAD
 #endif
 
 #include "../libretro-common/rthreads/rthreads.c"
+#include "../libretro-common/rthreads/tpool.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
 #endif
@@ -1279,6 +1280,7 @@ DATA RUNLOOP
 #include "../tasks/task_save.c"
 #include "../tasks/task_movie.c"
 #include "../tasks/task_image.c"
+#include "../tasks/task_image_cache.c"
 #include "../tasks/task_file_transfer.c"
 #include "../tasks/task_playlist_manager.c"
 #include "../tasks/task_manual_content_scan.c"
@@ -1292,6 +1294,7 @@ DATA RUNLOOP
 #ifdef HAVE_LIBRETRODB
 #include "../tasks/task_database.c"
 #include "../tasks/task_database_cue.c"
+#include "../tasks/task_database_hash.c"
 #endif
 #if defined(HAVE_NETWORKING) && defined(HAVE_MENU)
 #include "../tasks/task_core_updater.c"
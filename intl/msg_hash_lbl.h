@@ -3349,6 +3349,30 @@ MSG_HASH(
    MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP,
    "rewind_buffer_size_step"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_THREADED,
+   "rewind_threaded"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_COLD_BUFFER_SIZE,
+   "rewind_cold_buffer_size"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_SPILL_SIZE,
+   "rewind_spill_size"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_TIER_HOT,
+   "rewind_tier_hot"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_TIER_COLD,
+   "rewind_tier_cold"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_TIER_SPILL,
+   "rewind_tier_spill"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_REWIND_SETTINGS,
    "rewind_settings"
@@ -3796,6 +3820,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE,
    "threaded_data_runloop_enable"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS,
+   "threaded_data_runloop_workers"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_THUMBNAILS,
    "thumbnails"
@@ -3832,6 +3860,14 @@ MSG_HASH(
    MENU_ENUM_LABEL_MENU_THUMBNAIL_UPSCALE_THRESHOLD,
    "menu_thumbnail_upscale_threshold"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_IMAGE_CACHE_SIZE,
+   "image_cache_size"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_MENU_THUMBNAIL_CACHE_SIZE,
+   "menu_thumbnail_cache_size"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_MENU_RGUI_THUMBNAIL_DOWNSCALER,
    "rgui_thumbnail_downscaler"
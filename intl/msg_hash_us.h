@@ -4971,6 +4971,42 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE_STEP,
    "Each time the rewind buffer size value is increased or decreased, it will change by this amount."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_THREADED,
+   "Threaded Rewind Compression"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_COLD_BUFFER_SIZE,
+   "Compressed Rewind Buffer Size (MB)"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_COLD_BUFFER_SIZE,
+   "The amount of memory (in MB) for older rewind history that no longer fits in the rewind buffer, kept compressed. Set to 0 to discard it instead."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_SPILL_SIZE,
+   "Rewind Disk Spill Size (MB)"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_SPILL_SIZE,
+   "The size (in MB) of a file in the cache directory that the oldest compressed rewind history moves to once the compressed rewind buffer is full."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_TIER_HOT,
+   "Rewind Buffer"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_TIER_COLD,
+   "Compressed Rewind Buffer"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_TIER_SPILL,
+   "Rewind Disk Spill"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_THREADED,
+   "Compress rewind states on a separate thread while the next frame runs. Reduces the performance hit of rewind on multi-core systems at the cost of an extra state sized buffer."
+   )
 
 /* Settings > Frame Throttle > Frame Time Counter */
 
@@ -5948,6 +5984,18 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_THREADED_DATA_RUNLOOP_ENABLE,
    "Perform tasks on a separate thread."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_WORKERS,
+   "Threaded Task Workers"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_THREADED_DATA_RUNLOOP_WORKERS,
+   "Number of threads used to perform tasks. More workers let scans and downloads run without delaying image loads and saves."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_WORKERS_AUTO,
+   "Automatic"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_PAUSE_NONACTIVE,
    "Pause Content When Not Active"
@@ -6775,6 +6823,22 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_MENU_THUMBNAIL_UPSCALE_THRESHOLD,
    "Automatically upscale thumbnail images with a width/height smaller than the specified value. Improves picture quality. Has a moderate performance impact."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_IMAGE_CACHE_SIZE,
+   "Decoded Image Cache Size"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_IMAGE_CACHE_SIZE,
+   "Maximum size (in MB) of the thumbnails and other images kept decoded in the cache directory, so that they load faster the next time they are shown. Least recently used images are deleted first. Set to 0 to disable the cache."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_MENU_THUMBNAIL_CACHE_SIZE,
+   "Thumbnail Memory Cache Size"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_MENU_THUMBNAIL_CACHE_SIZE,
+   "Video memory (in MB) used to keep thumbnails loaded after they scroll off screen, and to load thumbnails of upcoming playlist entries ahead of time. Reduces thumbnail pop-in when scrolling. Set to 0 to disable."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_MENU_TICKER_TYPE,
    "Ticker Text Animation"
@@ -14697,6 +14761,10 @@ MSG_HASH(
    MSG_REWIND_INIT_FAILED,
    "Failed to initialize rewind buffer. Rewinding will be disabled."
    )
+MSG_HASH(
+   MSG_REWIND_TIER_STATS,
+   "%.1f MB, %u states"
+   )
 MSG_HASH(
    MSG_REWIND_INIT_FAILED_THREADED_AUDIO,
    "Implementation uses threaded audio. Cannot use rewind."
@@ -15241,6 +15309,10 @@ MSG_HASH(
    MSG_RESAMPLER_QUALITY_HIGHEST,
    "Highest"
    )
+MSG_HASH(
+   MSG_RESAMPLER_QUALITY_POLYPHASE,
+   "Polyphase"
+   )
 MSG_HASH(
    MSG_MISSING_ASSETS,
    "Warning: Missing assets, use the Online Updater if available"
@@ -30,10 +30,36 @@
 #include <emmintrin.h>
 #elif defined(__ALTIVEC__)
 #include <altivec.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 #include <retro_miscellaneous.h>
 #include <audio/audio_mix.h>
+
+#ifdef AUDIO_MIX_AVX2
+#include <immintrin.h>
+#include <features/features_cpu.h>
+
+#ifdef __AVX2__
+#define AUDIO_MIX_AVX2_TARGET
+#else
+#define AUDIO_MIX_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+/* 0 = not checked yet, 1 = AVX2, -1 = no AVX2.
+ * Every thread detects the same thing, racing here is harmless */
+static int audio_mix_avx2 = 0;
+
+static bool audio_mix_has_avx2(void)
+{
+   if (!audio_mix_avx2)
+      audio_mix_avx2 = ((cpu_features_get()
+               & (RETRO_SIMD_AVX | RETRO_SIMD_AVX2))
+            == (RETRO_SIMD_AVX | RETRO_SIMD_AVX2)) ? 1 : -1;
+   return audio_mix_avx2 > 0;
+}
+#endif
 #include <streams/file_stream.h>
 #include <audio/conversion/float_to_s16.h>
 #include <audio/conversion/s16_to_float.h>
@@ -78,6 +104,105 @@ void audio_mix_volume_SSE2(float *out, const float *in, float vol, size_t sample
 }
 #endif
 
+#ifdef AUDIO_MIX_AVX2
+AUDIO_MIX_AVX2_TARGET
+void audio_mix_volume_AVX2(float *out, const float *in, float vol, size_t samples)
+{
+   size_t i, remaining_samples;
+   __m256 volume = _mm256_set1_ps(vol);
+
+   for (i = 0; i + 32 <= samples; i += 32, out += 32, in += 32)
+   {
+      unsigned j;
+      for (j = 0; j < 4; j++)
+         _mm256_storeu_ps(out + 8 * j, _mm256_add_ps(
+                  _mm256_loadu_ps(out + 8 * j),
+                  _mm256_mul_ps(volume, _mm256_loadu_ps(in + 8 * j))));
+   }
+
+   remaining_samples = samples - i;
+
+   for (i = 0; i < remaining_samples; i++)
+      out[i] += in[i] * vol;
+}
+
+#ifndef __AVX2__
+void audio_mix_volume(float *out, const float *in, float vol, size_t samples)
+{
+   if (audio_mix_has_avx2())
+      audio_mix_volume_AVX2(out, in, vol, samples);
+   else
+      audio_mix_volume_SSE2(out, in, vol, samples);
+}
+#endif
+
+AUDIO_MIX_AVX2_TARGET
+static size_t audio_mix_clamp_AVX2(float *buf, size_t samples)
+{
+   size_t i   = 0;
+   __m256 lo  = _mm256_set1_ps(-1.0f);
+   __m256 hi  = _mm256_set1_ps( 1.0f);
+
+   for (; i + 8 <= samples; i += 8)
+      _mm256_storeu_ps(buf + i, _mm256_min_ps(hi,
+               _mm256_max_ps(lo, _mm256_loadu_ps(buf + i))));
+
+   return i;
+}
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+void audio_mix_volume_NEON(float *out, const float *in, float vol, size_t samples)
+{
+   size_t i, remaining_samples;
+
+   for (i = 0; i + 16 <= samples; i += 16, out += 16, in += 16)
+   {
+      unsigned j;
+      for (j = 0; j < 4; j++)
+         vst1q_f32(out + 4 * j, vmlaq_n_f32(
+                  vld1q_f32(out + 4 * j), vld1q_f32(in + 4 * j), vol));
+   }
+
+   remaining_samples = samples - i;
+
+   for (i = 0; i < remaining_samples; i++)
+      out[i] += in[i] * vol;
+}
+#endif
+
+void audio_mix_clamp(float *buf, size_t samples)
+{
+   size_t i = 0;
+#if defined(__SSE2__)
+   __m128 lo     = _mm_set1_ps(-1.0f);
+   __m128 hi     = _mm_set1_ps( 1.0f);
+
+#ifdef AUDIO_MIX_AVX2
+   if (audio_mix_has_avx2())
+      i = audio_mix_clamp_AVX2(buf, samples);
+#endif
+
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(buf + i, _mm_min_ps(hi,
+               _mm_max_ps(lo, _mm_loadu_ps(buf + i))));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   float32x4_t lo = vdupq_n_f32(-1.0f);
+   float32x4_t hi = vdupq_n_f32( 1.0f);
+
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(buf + i, vminq_f32(hi, vmaxq_f32(lo, vld1q_f32(buf + i))));
+#endif
+
+   for (; i < samples; i++)
+   {
+      if (buf[i] < -1.0f)
+         buf[i] = -1.0f;
+      else if (buf[i] > 1.0f)
+         buf[i] = 1.0f;
+   }
+}
+
 void audio_mix_free_chunk(audio_chunk_t *chunk)
 {
    if (!chunk)
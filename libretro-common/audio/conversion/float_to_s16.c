@@ -22,7 +22,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #elif defined(__ALTIVEC__)
 #include <altivec.h>
@@ -98,6 +100,25 @@ void convert_float_to_s16(int16_t *out,
 #if defined(__SSE2__)
    __m128 factor     = _mm_set1_ps((float)0x8000);
    /* Initialize a 4D vector with 32768.0 for its elements */
+#if defined(__AVX2__)
+   __m256 factor_avx = _mm256_set1_ps((float)0x8000);
+
+   for (i = 0; i + 16 <= samples; i += 16, in += 16, out += 16)
+   {
+      __m256i ints_a = _mm256_cvtps_epi32(
+            _mm256_mul_ps(_mm256_loadu_ps(in + 0), factor_avx));
+      __m256i ints_b = _mm256_cvtps_epi32(
+            _mm256_mul_ps(_mm256_loadu_ps(in + 8), factor_avx));
+      /* Packing works within 128-bit lanes, put the
+       * four 64-bit quarters back in order afterwards */
+      __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(ints_a, ints_b), _MM_SHUFFLE(3, 1, 2, 0));
+
+      _mm256_storeu_si256((__m256i *)out, packed);
+   }
+
+   samples           = samples - i;
+#endif
 
    for (i = 0; i + 8 <= samples; i += 8, in += 8, out += 8)
    { /* Skip forward 8 samples at a time... */
@@ -19,7 +19,9 @@
  * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #elif defined(__ALTIVEC__)
 #include <altivec.h>
@@ -98,6 +100,24 @@ void convert_s16_to_float(float *out,
 #if defined(__SSE2__)
    float fgain   = gain / UINT32_C(0x80000000);
    __m128 factor = _mm_set1_ps(fgain);
+#if defined(__AVX2__)
+   __m256 factor_avx = _mm256_set1_ps(gain / 0x8000);
+
+   for (i = 0; i + 16 <= samples; i += 16, in += 16, out += 16)
+   {
+      __m256i regs_l   = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)in));
+      __m256i regs_r   = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)(in + 8)));
+
+      _mm256_storeu_ps(out + 0, _mm256_mul_ps(
+               _mm256_cvtepi32_ps(regs_l), factor_avx));
+      _mm256_storeu_ps(out + 8, _mm256_mul_ps(
+               _mm256_cvtepi32_ps(regs_r), factor_avx));
+   }
+
+   samples = samples - i;
+#endif
 
    for (i = 0; i + 8 <= samples; i += 8, in += 8, out += 8)
    {
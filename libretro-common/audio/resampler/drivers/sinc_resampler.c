@@ -66,13 +66,27 @@ enum sinc_window
  * of sinc taps, the AVX code is clearly faster than SSE1.
  */
 
+/* Polyphase quality: smallest table that keeps the interpolated
+ * fallback (used while rate control drifts the ratio) close to
+ * the HIGHER level, and the largest rational grid we accept. */
+#define SINC_POLYPHASE_MIN_PHASES 512
+#define SINC_POLYPHASE_MAX_PHASES 1024
+
 typedef struct rarch_sinc_resampler
 {
+   resampler_process_t process;
+   /* Polyphase only: kernels for outputs on the rational
+    * grid (one coefficient row per phase), and for a drifting
+    * ratio (coefficients interpolated between phases). */
+   resampler_process_t process_exact;
+   resampler_process_t process_drift;
    /* A buffer for phase_table, buffer_l and buffer_r
     * are created in a single calloc().
     * Ensure that we get as good cache locality as we can hope for. */
    float *main_buffer;
    float *phase_table;
+   float *drift_table;
+   float *exact_table;
    float *buffer_l;
    float *buffer_r;
    unsigned phase_bits;
@@ -80,11 +94,32 @@ typedef struct rarch_sinc_resampler
    unsigned subphase_mask;
    unsigned taps;
    unsigned ptr;
+   uint32_t phases;    /* Time units per input frame */
+   uint32_t poly_step; /* Time units per output frame on the grid, or 0 */
    uint32_t time;
    float subphase_mod;
    float kaiser_beta;
 } rarch_sinc_resampler_t;
 
+/* On a polyphase table, any ratio within rounding of the
+ * nominal one keeps outputs exactly on the rational grid.
+ *
+ * Dynamic rate control moves the ratio much further than that
+ * (audio_rate_control_delta is 0.5% by default), which takes the
+ * interpolated drift kernel, so the exact grid only pays off with
+ * rate control disabled. Running the exact table at the drifted
+ * ratio instead would round every output to one of 512-1024
+ * phases, adding jitter around -60 dB at high frequencies, well
+ * below what the HIGHER filter it shares is built for. */
+static INLINE uint32_t resampler_sinc_step(
+      const rarch_sinc_resampler_t *resamp, double ratio)
+{
+   double step = resamp->phases / ratio;
+   if (resamp->poly_step && fabs(step - resamp->poly_step) < 0.5)
+      return resamp->poly_step;
+   return (uint32_t)step;
+}
+
 #if (defined(__ARM_NEON__) || defined(HAVE_NEON))
 
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
@@ -99,8 +134,8 @@ void process_sinc_neon_asm(float *out, const float *left,
 static void resampler_sinc_process_neon_kaiser(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t phases                = resamp->phases;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -172,8 +207,8 @@ static void resampler_sinc_process_neon_kaiser(void *re_, struct resampler_data
 static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t phases                = resamp->phases;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -244,9 +279,9 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 static void resampler_sinc_process_avx_kaiser(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -329,9 +364,9 @@ static void resampler_sinc_process_avx_kaiser(void *re_, struct resampler_data *
 static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -411,9 +446,9 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 static void resampler_sinc_process_sse_kaiser(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -506,9 +541,9 @@ static void resampler_sinc_process_sse_kaiser(void *re_, struct resampler_data *
 static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -597,9 +632,9 @@ static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
 static void resampler_sinc_process_c_kaiser(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -666,9 +701,9 @@ static void resampler_sinc_process_c_kaiser(void *re_, struct resampler_data *da
 static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   uint32_t phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -729,6 +764,33 @@ static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
    data->output_frames = out_frames;
 }
 
+static void resampler_sinc_process(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   resamp->process(resamp, data);
+}
+
+static void resampler_sinc_process_polyphase(void *re_,
+      struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+
+   if (resampler_sinc_step(resamp, data->ratio) == resamp->poly_step)
+   {
+      /* Back on the nominal ratio after a drift: snap to the
+       * closest phase, a shift of at most half a phase. */
+      resamp->time        = (resamp->time + (resamp->subphase_mask >> 1))
+         & ~resamp->subphase_mask;
+      resamp->phase_table = resamp->exact_table;
+      resamp->process_exact(resamp, data);
+   }
+   else
+   {
+      resamp->phase_table = resamp->drift_table;
+      resamp->process_drift(resamp, data);
+   }
+}
+
 static void resampler_sinc_free(void *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)data;
@@ -858,15 +920,88 @@ static void sinc_init_table_lanczos(
    }
 }
 
+/* Finds the number of phases L and the step M (in phases) such
+ * that ratio == L / M, e.g. 44.1 to 48 kHz is 160 phases with a
+ * step of 147. L is then scaled up to at least
+ * SINC_POLYPHASE_MIN_PHASES for the interpolated fallback.
+ * Returns 0 if the ratio isn't a small enough fraction. */
+static unsigned sinc_polyphase_phases(double ratio, unsigned *step)
+{
+   unsigned l;
+
+   if (ratio <= 0.0)
+      return 0;
+
+   for (l = 1; l <= SINC_POLYPHASE_MAX_PHASES; l++)
+   {
+      double m       = l / ratio;
+      double m_round = floor(m + 0.5);
+
+      if (m_round >= 1.0 && fabs(m - m_round) < m * 1e-9)
+      {
+         unsigned scale = (SINC_POLYPHASE_MIN_PHASES + l - 1) / l;
+         *step          = (unsigned)m_round * scale;
+         return l * scale;
+      }
+   }
+
+   return 0;
+}
+
+static resampler_process_t resampler_sinc_get_process(
+      resampler_simd_mask_t mask, bool enable_avx, bool kaiser)
+{
+   resampler_process_t process = resampler_sinc_process_c;
+   if (kaiser)
+      process = resampler_sinc_process_c_kaiser;
+
+   if (mask & RESAMPLER_SIMD_AVX && enable_avx)
+   {
+#if defined(__AVX__)
+      process    = resampler_sinc_process_avx;
+      if (kaiser)
+         process = resampler_sinc_process_avx_kaiser;
+#endif
+   }
+   else if (mask & RESAMPLER_SIMD_SSE)
+   {
+#if defined(__SSE__)
+      process    = resampler_sinc_process_sse;
+      if (kaiser)
+         process = resampler_sinc_process_sse_kaiser;
+#endif
+   }
+   else if (mask & RESAMPLER_SIMD_NEON)
+   {
+#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
+#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
+      if (!kaiser)
+         process = resampler_sinc_process_neon;
+#else
+      process    = resampler_sinc_process_neon;
+      if (kaiser)
+         process = resampler_sinc_process_neon_kaiser;
+#endif
+#endif
+   }
+
+   return process;
+}
+
 static void *resampler_sinc_new(const struct resampler_config *config,
       double bandwidth_mod, enum resampler_quality quality,
       resampler_simd_mask_t mask)
 {
    double cutoff                  = 0.0;
    size_t phase_elems             = 0;
+   size_t exact_elems             = 0;
    size_t elems                   = 0;
    unsigned enable_avx            = 0;
    unsigned sidelobes             = 0;
+   unsigned table_phases          = 0;
+   unsigned poly_phases           = 0;
+   unsigned poly_step             = 0;
+   bool polyphase                 = false;
    enum sinc_window window_type   = SINC_WINDOW_NONE;
    rarch_sinc_resampler_t *re     = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
@@ -908,6 +1043,21 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->kaiser_beta   = 14.5;
          enable_avx        = 1;
          break;
+      case RESAMPLER_QUALITY_POLYPHASE:
+         /* Same filter as HIGHER, on a table of phases matching
+          * the nominal ratio. If the ratio isn't a small fraction
+          * this is HIGHER with finer subphases. Only faster than
+          * HIGHER with dynamic rate control off, see
+          * resampler_sinc_step(). */
+         cutoff            = 0.90;
+         sidelobes         = 32;
+         re->phase_bits    = 10;
+         re->subphase_bits = 16;
+         window_type       = SINC_WINDOW_KAISER;
+         re->kaiser_beta   = 10.5;
+         enable_avx        = 1;
+         polyphase         = true;
+         break;
       case RESAMPLER_QUALITY_NORMAL:
       case RESAMPLER_QUALITY_DONTCARE:
          cutoff            = 0.825;
@@ -923,6 +1073,18 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    re->subphase_mod  = 1.0f / (1 << re->subphase_bits);
    re->taps          = sidelobes * 2;
 
+   if (polyphase)
+      poly_phases    = sinc_polyphase_phases(bandwidth_mod, &poly_step);
+
+   if (poly_phases)
+   {
+      table_phases   = poly_phases;
+      re->poly_step  = poly_step << re->subphase_bits;
+   }
+   else
+      table_phases   = 1 << re->phase_bits;
+   re->phases        = table_phases << re->subphase_bits;
+
    /* Downsampling, must lower cutoff, and extend number of
     * taps accordingly to keep same stopband attenuation. */
    if (bandwidth_mod < 1.0)
@@ -945,10 +1107,12 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #endif
    }
 
-   phase_elems     = ((1 << re->phase_bits) * re->taps);
+   phase_elems     = table_phases * re->taps;
    if (window_type == SINC_WINDOW_KAISER)
       phase_elems  = phase_elems * 2;
-   elems           = phase_elems + 4 * re->taps;
+   if (poly_phases)
+      exact_elems  = poly_phases * re->taps;
+   elems           = phase_elems + exact_elems + 4 * re->taps;
 
    re->main_buffer = (float*)memalign_alloc(128, sizeof(float) * elems);
    if (!re->main_buffer)
@@ -957,55 +1121,42 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    memset(re->main_buffer, 0, sizeof(float) * elems);
 
    re->phase_table = re->main_buffer;
-   re->buffer_l    = re->main_buffer + phase_elems;
+   re->drift_table = re->phase_table;
+   re->exact_table = re->phase_table + phase_elems;
+   re->buffer_l    = re->exact_table + exact_elems;
    re->buffer_r    = re->buffer_l + 2 * re->taps;
 
    switch (window_type)
    {
       case SINC_WINDOW_LANCZOS:
          sinc_init_table_lanczos(re, cutoff, re->phase_table,
-               1 << re->phase_bits, re->taps, false);
+               table_phases, re->taps, false);
          break;
       case SINC_WINDOW_KAISER:
          sinc_init_table_kaiser(re, cutoff, re->phase_table,
-               1 << re->phase_bits, re->taps, true);
+               table_phases, re->taps, true);
          break;
       case SINC_WINDOW_NONE:
          goto error;
    }
 
-   sinc_resampler.process = resampler_sinc_process_c;
-   if (window_type == SINC_WINDOW_KAISER)
-      sinc_resampler.process    = resampler_sinc_process_c_kaiser;
+   re->process = resampler_sinc_get_process(mask, enable_avx,
+         window_type == SINC_WINDOW_KAISER);
 
-   if (mask & RESAMPLER_SIMD_AVX && enable_avx)
-   {
-#if defined(__AVX__)
-      sinc_resampler.process    = resampler_sinc_process_avx;
-      if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_avx_kaiser;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_SSE)
+   if (poly_phases)
    {
-#if defined(__SSE__)
-      sinc_resampler.process = resampler_sinc_process_sse;
-      if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_sse_kaiser;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_NEON)
-   {
-#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
-#ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
-      if (window_type != SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_neon;
-#else
-      sinc_resampler.process = resampler_sinc_process_neon;
-      if (window_type == SINC_WINDOW_KAISER)
-         sinc_resampler.process = resampler_sinc_process_neon_kaiser;
-#endif
-#endif
+      unsigned p;
+
+      /* The grid only ever hits whole phases: same coefficients
+       * without the deltas, half the memory traffic per tap */
+      for (p = 0; p < poly_phases; p++)
+         memcpy(re->exact_table + p * re->taps,
+               re->drift_table + p * 2 * re->taps,
+               re->taps * sizeof(float));
+
+      re->process_exact = resampler_sinc_get_process(mask, enable_avx, false);
+      re->process_drift = re->process;
+      re->process       = resampler_sinc_process_polyphase;
    }
 
    return re;
@@ -1017,7 +1168,7 @@ error:
 
 retro_resampler_t sinc_resampler = {
    resampler_sinc_new,
-   resampler_sinc_process_c,
+   resampler_sinc_process,
    resampler_sinc_free,
    RESAMPLER_API_VERSION,
    "sinc",
@@ -25,6 +25,14 @@
 #include <encodings/crc32.h>
 #include <stdlib.h>
 
+/* ARMv8 CRC builds use the crc32 instructions, anything
+ * else the slice-by-16 tables */
+#if !__ARM_FEATURE_CRC32
+#define CRC32_SLICE16
+#endif
+
+#include "encoding_crc32_tables.h"
+
 #if __ARM_FEATURE_CRC32
 
 #ifdef _M_ARM64
@@ -64,69 +72,331 @@ uint32_t encoding_crc32(uint32_t crc, const uint8_t *data, size_t len)
 
 #else
 
-static const uint32_t crc32_table[256] = {
-  0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L,
-  0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0x0edb8832L, 0x79dcb8a4L,
-  0xe0d5e91eL, 0x97d2d988L, 0x09b64c2bL, 0x7eb17cbdL, 0xe7b82d07L,
-  0x90bf1d91L, 0x1db71064L, 0x6ab020f2L, 0xf3b97148L, 0x84be41deL,
-  0x1adad47dL, 0x6ddde4ebL, 0xf4d4b551L, 0x83d385c7L, 0x136c9856L,
-  0x646ba8c0L, 0xfd62f97aL, 0x8a65c9ecL, 0x14015c4fL, 0x63066cd9L,
-  0xfa0f3d63L, 0x8d080df5L, 0x3b6e20c8L, 0x4c69105eL, 0xd56041e4L,
-  0xa2677172L, 0x3c03e4d1L, 0x4b04d447L, 0xd20d85fdL, 0xa50ab56bL,
-  0x35b5a8faL, 0x42b2986cL, 0xdbbbc9d6L, 0xacbcf940L, 0x32d86ce3L,
-  0x45df5c75L, 0xdcd60dcfL, 0xabd13d59L, 0x26d930acL, 0x51de003aL,
-  0xc8d75180L, 0xbfd06116L, 0x21b4f4b5L, 0x56b3c423L, 0xcfba9599L,
-  0xb8bda50fL, 0x2802b89eL, 0x5f058808L, 0xc60cd9b2L, 0xb10be924L,
-  0x2f6f7c87L, 0x58684c11L, 0xc1611dabL, 0xb6662d3dL, 0x76dc4190L,
-  0x01db7106L, 0x98d220bcL, 0xefd5102aL, 0x71b18589L, 0x06b6b51fL,
-  0x9fbfe4a5L, 0xe8b8d433L, 0x7807c9a2L, 0x0f00f934L, 0x9609a88eL,
-  0xe10e9818L, 0x7f6a0dbbL, 0x086d3d2dL, 0x91646c97L, 0xe6635c01L,
-  0x6b6b51f4L, 0x1c6c6162L, 0x856530d8L, 0xf262004eL, 0x6c0695edL,
-  0x1b01a57bL, 0x8208f4c1L, 0xf50fc457L, 0x65b0d9c6L, 0x12b7e950L,
-  0x8bbeb8eaL, 0xfcb9887cL, 0x62dd1ddfL, 0x15da2d49L, 0x8cd37cf3L,
-  0xfbd44c65L, 0x4db26158L, 0x3ab551ceL, 0xa3bc0074L, 0xd4bb30e2L,
-  0x4adfa541L, 0x3dd895d7L, 0xa4d1c46dL, 0xd3d6f4fbL, 0x4369e96aL,
-  0x346ed9fcL, 0xad678846L, 0xda60b8d0L, 0x44042d73L, 0x33031de5L,
-  0xaa0a4c5fL, 0xdd0d7cc9L, 0x5005713cL, 0x270241aaL, 0xbe0b1010L,
-  0xc90c2086L, 0x5768b525L, 0x206f85b3L, 0xb966d409L, 0xce61e49fL,
-  0x5edef90eL, 0x29d9c998L, 0xb0d09822L, 0xc7d7a8b4L, 0x59b33d17L,
-  0x2eb40d81L, 0xb7bd5c3bL, 0xc0ba6cadL, 0xedb88320L, 0x9abfb3b6L,
-  0x03b6e20cL, 0x74b1d29aL, 0xead54739L, 0x9dd277afL, 0x04db2615L,
-  0x73dc1683L, 0xe3630b12L, 0x94643b84L, 0x0d6d6a3eL, 0x7a6a5aa8L,
-  0xe40ecf0bL, 0x9309ff9dL, 0x0a00ae27L, 0x7d079eb1L, 0xf00f9344L,
-  0x8708a3d2L, 0x1e01f268L, 0x6906c2feL, 0xf762575dL, 0x806567cbL,
-  0x196c3671L, 0x6e6b06e7L, 0xfed41b76L, 0x89d32be0L, 0x10da7a5aL,
-  0x67dd4accL, 0xf9b9df6fL, 0x8ebeeff9L, 0x17b7be43L, 0x60b08ed5L,
-  0xd6d6a3e8L, 0xa1d1937eL, 0x38d8c2c4L, 0x4fdff252L, 0xd1bb67f1L,
-  0xa6bc5767L, 0x3fb506ddL, 0x48b2364bL, 0xd80d2bdaL, 0xaf0a1b4cL,
-  0x36034af6L, 0x41047a60L, 0xdf60efc3L, 0xa867df55L, 0x316e8eefL,
-  0x4669be79L, 0xcb61b38cL, 0xbc66831aL, 0x256fd2a0L, 0x5268e236L,
-  0xcc0c7795L, 0xbb0b4703L, 0x220216b9L, 0x5505262fL, 0xc5ba3bbeL,
-  0xb2bd0b28L, 0x2bb45a92L, 0x5cb36a04L, 0xc2d7ffa7L, 0xb5d0cf31L,
-  0x2cd99e8bL, 0x5bdeae1dL, 0x9b64c2b0L, 0xec63f226L, 0x756aa39cL,
-  0x026d930aL, 0x9c0906a9L, 0xeb0e363fL, 0x72076785L, 0x05005713L,
-  0x95bf4a82L, 0xe2b87a14L, 0x7bb12baeL, 0x0cb61b38L, 0x92d28e9bL,
-  0xe5d5be0dL, 0x7cdcefb7L, 0x0bdbdf21L, 0x86d3d2d4L, 0xf1d4e242L,
-  0x68ddb3f8L, 0x1fda836eL, 0x81be16cdL, 0xf6b9265bL, 0x6fb077e1L,
-  0x18b74777L, 0x88085ae6L, 0xff0f6a70L, 0x66063bcaL, 0x11010b5cL,
-  0x8f659effL, 0xf862ae69L, 0x616bffd3L, 0x166ccf45L, 0xa00ae278L,
-  0xd70dd2eeL, 0x4e048354L, 0x3903b3c2L, 0xa7672661L, 0xd06016f7L,
-  0x4969474dL, 0x3e6e77dbL, 0xaed16a4aL, 0xd9d65adcL, 0x40df0b66L,
-  0x37d83bf0L, 0xa9bcae53L, 0xdebb9ec5L, 0x47b2cf7fL, 0x30b5ffe9L,
-  0xbdbdf21cL, 0xcabac28aL, 0x53b39330L, 0x24b4a3a6L, 0xbad03605L,
-  0xcdd70693L, 0x54de5729L, 0x23d967bfL, 0xb3667a2eL, 0xc4614ab8L,
-  0x5d681b02L, 0x2a6f2b94L, 0xb40bbe37L, 0xc30c8ea1L, 0x5a05df1bL,
-  0x2d02ef8dL
+/* Carry-less multiply folding (Intel, "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction"), built with
+ * function target attributes and picked at runtime, so that
+ * generic x86 builds get it too */
+#if (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define CRC32_PCLMUL
+#define CRC32_PCLMUL_TARGET __attribute__((target("sse2,pclmul")))
+#if (defined(__clang__) && __clang_major__ >= 6) \
+      || (!defined(__clang__) && __GNUC__ >= 8)
+#define CRC32_VPCLMUL
+#define CRC32_VPCLMUL_TARGET __attribute__((target("avx2,pclmul,vpclmulqdq")))
+#endif
+#include <cpuid.h>
+#include <immintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && _MSC_VER >= 1900
+#define CRC32_PCLMUL
+#define CRC32_PCLMUL_TARGET
+#include <intrin.h>
+#include <wmmintrin.h>
+#endif
+
+#define CRC32_PCLMUL_MIN_LEN  64
+#define CRC32_VPCLMUL_MIN_LEN 256
+
+enum crc32_kernel
+{
+   CRC32_KERNEL_UNKNOWN = 0,
+   CRC32_KERNEL_SLICE16,
+   CRC32_KERNEL_PCLMUL,
+   CRC32_KERNEL_VPCLMUL
 };
 
+static uint32_t crc32_slice16(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   /* Byte loads, the compiler merges them on little endian targets */
+   while (len >= 16)
+   {
+      uint32_t a = crc ^ ((uint32_t)buf[0]
+            | ((uint32_t)buf[1] << 8)
+            | ((uint32_t)buf[2] << 16)
+            | ((uint32_t)buf[3] << 24));
+
+      crc = crc32_table[15][ a        & 0xff]
+          ^ crc32_table[14][(a >>  8) & 0xff]
+          ^ crc32_table[13][(a >> 16) & 0xff]
+          ^ crc32_table[12][ a >> 24        ]
+          ^ crc32_table[11][buf[4]]
+          ^ crc32_table[10][buf[5]]
+          ^ crc32_table[ 9][buf[6]]
+          ^ crc32_table[ 8][buf[7]]
+          ^ crc32_table[ 7][buf[8]]
+          ^ crc32_table[ 6][buf[9]]
+          ^ crc32_table[ 5][buf[10]]
+          ^ crc32_table[ 4][buf[11]]
+          ^ crc32_table[ 3][buf[12]]
+          ^ crc32_table[ 2][buf[13]]
+          ^ crc32_table[ 1][buf[14]]
+          ^ crc32_table[ 0][buf[15]];
+
+      buf += 16;
+      len -= 16;
+   }
+
+   while (len--)
+      crc = crc32_table[0][(crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+
+   return crc;
+}
+
+#ifdef CRC32_PCLMUL
+/* Folding constants: x^(D+32) and x^(D-32) mod P, bit reflected
+ * and shifted left by one, for a fold distance of D bits */
+static const uint64_t crc32_k_512[2]  = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+static const uint64_t crc32_k_128[2]  = { 0x01751997d0ULL, 0x00ccaa009eULL };
+static const uint64_t crc32_k_64[2]   = { 0x0163cd6124ULL, 0x0000000000ULL };
+/* Barrett reduction: P' and mu' */
+static const uint64_t crc32_k_poly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+static CRC32_PCLMUL_TARGET __m128i crc32_pclmul_load(const uint64_t *k)
+{
+   return _mm_set_epi64x((long long)k[1], (long long)k[0]);
+}
+
+/* Folds the 128 bit remainder x into the next 16 bytes of data */
+static CRC32_PCLMUL_TARGET __m128i crc32_pclmul_fold(__m128i x,
+      __m128i data, __m128i k)
+{
+   __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+   __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+   return _mm_xor_si128(_mm_xor_si128(hi, lo), data);
+}
+
+/* Folds in the remaining 16 byte blocks and reduces to 32 bits */
+static CRC32_PCLMUL_TARGET uint32_t crc32_pclmul_finish(__m128i x1,
+      const uint8_t *buf, size_t len)
+{
+   __m128i x2, x3;
+   __m128i k   = crc32_pclmul_load(crc32_k_128);
+   __m128i low = _mm_setr_epi32(~0, 0, ~0, 0);
+
+   for (; len >= 16; buf += 16, len -= 16)
+      x1 = crc32_pclmul_fold(x1, _mm_loadu_si128((const __m128i*)buf), k);
+
+   /* 128 to 64 bits */
+   x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+   x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+   k  = crc32_pclmul_load(crc32_k_64);
+   x2 = _mm_srli_si128(x1, 4);
+   x1 = _mm_and_si128(x1, low);
+   x1 = _mm_clmulepi64_si128(x1, k, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   /* Barrett reduction to 32 bits */
+   k  = crc32_pclmul_load(crc32_k_poly);
+   x2 = _mm_and_si128(x1, low);
+   x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+   x2 = _mm_and_si128(x2, low);
+   x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+   x1 = _mm_xor_si128(x1, x2);
+
+   x3 = _mm_srli_si128(x1, 4);
+   return (uint32_t)_mm_cvtsi128_si32(x3);
+}
+
+/* len must be at least 64, only len & ~15 bytes are consumed */
+static CRC32_PCLMUL_TARGET uint32_t crc32_pclmul(uint32_t crc,
+      const uint8_t *buf, size_t len)
+{
+   __m128i k  = crc32_pclmul_load(crc32_k_512);
+   __m128i x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+   __m128i x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+   __m128i x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+   __m128i x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+
+   x1         = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+
+   for (buf += 64, len -= 64; len >= 64; buf += 64, len -= 64)
+   {
+      x1 = crc32_pclmul_fold(x1,
+            _mm_loadu_si128((const __m128i*)(buf + 0x00)), k);
+      x2 = crc32_pclmul_fold(x2,
+            _mm_loadu_si128((const __m128i*)(buf + 0x10)), k);
+      x3 = crc32_pclmul_fold(x3,
+            _mm_loadu_si128((const __m128i*)(buf + 0x20)), k);
+      x4 = crc32_pclmul_fold(x4,
+            _mm_loadu_si128((const __m128i*)(buf + 0x30)), k);
+   }
+
+   /* Four lanes into one */
+   k  = crc32_pclmul_load(crc32_k_128);
+   x1 = crc32_pclmul_fold(x1, x2, k);
+   x1 = crc32_pclmul_fold(x1, x3, k);
+   x1 = crc32_pclmul_fold(x1, x4, k);
+
+   return crc32_pclmul_finish(x1, buf, len);
+}
+
+#ifdef CRC32_VPCLMUL
+static const uint64_t crc32_k_1024[2] = { 0x01e88ef372ULL, 0x014a7fe880ULL };
+
+static CRC32_VPCLMUL_TARGET __m256i crc32_vpclmul_fold(__m256i x,
+      __m256i data, __m256i k)
+{
+   __m256i lo = _mm256_clmulepi64_epi128(x, k, 0x00);
+   __m256i hi = _mm256_clmulepi64_epi128(x, k, 0x11);
+   return _mm256_xor_si256(_mm256_xor_si256(hi, lo), data);
+}
+
+/* Same as crc32_pclmul() on 128 bytes per iteration, two 128 bit
+ * lanes per register; len must be at least 128 */
+static CRC32_VPCLMUL_TARGET uint32_t crc32_vpclmul(uint32_t crc,
+      const uint8_t *buf, size_t len)
+{
+   unsigned i;
+   __m128i x, lanes[8];
+   __m128i k128 = crc32_pclmul_load(crc32_k_128);
+   __m256i k    = _mm256_broadcastsi128_si256(
+         crc32_pclmul_load(crc32_k_1024));
+   __m256i y1   = _mm256_loadu_si256((const __m256i*)(buf + 0x00));
+   __m256i y2   = _mm256_loadu_si256((const __m256i*)(buf + 0x20));
+   __m256i y3   = _mm256_loadu_si256((const __m256i*)(buf + 0x40));
+   __m256i y4   = _mm256_loadu_si256((const __m256i*)(buf + 0x60));
+
+   y1           = _mm256_xor_si256(y1,
+         _mm256_castsi128_si256(_mm_cvtsi32_si128((int)crc)));
+
+   for (buf += 128, len -= 128; len >= 128; buf += 128, len -= 128)
+   {
+      y1 = crc32_vpclmul_fold(y1,
+            _mm256_loadu_si256((const __m256i*)(buf + 0x00)), k);
+      y2 = crc32_vpclmul_fold(y2,
+            _mm256_loadu_si256((const __m256i*)(buf + 0x20)), k);
+      y3 = crc32_vpclmul_fold(y3,
+            _mm256_loadu_si256((const __m256i*)(buf + 0x40)), k);
+      y4 = crc32_vpclmul_fold(y4,
+            _mm256_loadu_si256((const __m256i*)(buf + 0x60)), k);
+   }
+
+   /* Eight 128 bit lanes, in data order, into one */
+   lanes[0] = _mm256_castsi256_si128(y1);
+   lanes[1] = _mm256_extracti128_si256(y1, 1);
+   lanes[2] = _mm256_castsi256_si128(y2);
+   lanes[3] = _mm256_extracti128_si256(y2, 1);
+   lanes[4] = _mm256_castsi256_si128(y3);
+   lanes[5] = _mm256_extracti128_si256(y3, 1);
+   lanes[6] = _mm256_castsi256_si128(y4);
+   lanes[7] = _mm256_extracti128_si256(y4, 1);
+
+   x = lanes[0];
+   for (i = 1; i < 8; i++)
+      x = crc32_pclmul_fold(x, lanes[i], k128);
+
+   return crc32_pclmul_finish(x, buf, len);
+}
+#endif
+
+static enum crc32_kernel crc32_detect_kernel(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   int regs[4];
+
+   __cpuid(regs, 1);
+   if (regs[2] & (1 << 1))
+      return CRC32_KERNEL_PCLMUL;
+#else
+   unsigned eax, ebx, ecx, edx;
+
+   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1 << 1)))
+      return CRC32_KERNEL_SLICE16;
+
+#ifdef CRC32_VPCLMUL
+   /* AVX, and the OS saving the YMM registers */
+   if (     (ecx & (1 << 27))
+         && (ecx & (1 << 28))
+         && __get_cpuid_max(0, NULL) >= 7)
+   {
+      unsigned xcr0_lo, xcr0_hi;
+      __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" /* xgetbv */
+            : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+
+      if ((xcr0_lo & 6) == 6)
+      {
+         __cpuid_count(7, 0, eax, ebx, ecx, edx);
+         /* AVX2 and VPCLMULQDQ */
+         if ((ebx & (1 << 5)) && (ecx & (1 << 10)))
+            return CRC32_KERNEL_VPCLMUL;
+      }
+   }
+#endif
+
+   return CRC32_KERNEL_PCLMUL;
+#endif
+
+   return CRC32_KERNEL_SLICE16;
+}
+
+static enum crc32_kernel crc32_kernel = CRC32_KERNEL_UNKNOWN;
+#endif
+
 uint32_t encoding_crc32(uint32_t crc, const uint8_t *buf, size_t len)
 {
    crc = ~crc;
 
-   while (len--)
-      crc = crc32_table[(crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+#ifdef CRC32_PCLMUL
+   if (len >= CRC32_PCLMUL_MIN_LEN)
+   {
+      size_t bulk = len & ~(size_t)15;
 
-   return ~crc;
+      /* Every thread detects the same kernel, racing here is harmless */
+      if (crc32_kernel == CRC32_KERNEL_UNKNOWN)
+         crc32_kernel = crc32_detect_kernel();
+
+#ifdef CRC32_VPCLMUL
+      if (crc32_kernel == CRC32_KERNEL_VPCLMUL
+            && len >= CRC32_VPCLMUL_MIN_LEN)
+         crc = crc32_vpclmul(crc, buf, bulk);
+      else
+#endif
+      if (crc32_kernel >= CRC32_KERNEL_PCLMUL)
+         crc = crc32_pclmul(crc, buf, bulk);
+      else
+         bulk = 0;
+
+      buf += bulk;
+      len -= bulk;
+   }
+#endif
+
+   return ~crc32_slice16(crc, buf, len);
 }
 
 #endif
+
+/* Polynomial product a.b modulo the CRC polynomial (zlib) */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b)
+{
+   uint32_t m = (uint32_t)1 << 31;
+   uint32_t p = 0;
+
+   for (;;)
+   {
+      if (a & m)
+      {
+         p ^= b;
+         if (!(a & (m - 1)))
+            break;
+      }
+      m >>= 1;
+      b   = (b & 1) ? (b >> 1) ^ 0xedb88320 : b >> 1;
+   }
+
+   return p;
+}
+
+uint32_t encoding_crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+   /* crc1 times x^(8.len2) */
+   unsigned k = 3;
+   uint32_t p = (uint32_t)1 << 31;
+
+   for (; len2; len2 >>= 1, k++)
+      if (len2 & 1)
+         p = crc32_multmodp(crc32_x2n_table[k & 31], p);
+
+   return crc32_multmodp(p, crc1) ^ crc2;
+}
@@ -38,6 +38,7 @@
 
 #ifdef _WIN32
 #include <direct.h>
+#include <encodings/utf.h>
 #else
 #include <unistd.h> /* stat() is defined here */
 #endif
@@ -98,6 +99,27 @@ int32_t path_get_size(const char *path)
    return -1;
 }
 
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime)
+{
+#ifdef _WIN32
+   struct _stat64 st;
+   wchar_t *path_w = utf8_to_utf16_string_alloc(path);
+   int ret         = path_w ? _wstat64(path_w, &st) : -1;
+
+   free(path_w);
+   if (ret != 0)
+      return false;
+#else
+   struct stat st;
+
+   if (stat(path, &st) != 0)
+      return false;
+#endif
+   *size  = (int64_t)st.st_size;
+   *mtime = (int64_t)st.st_mtime;
+   return true;
+}
+
 /**
  * path_mkdir:
  * @dir                : directory
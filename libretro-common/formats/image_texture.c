@@ -30,6 +30,13 @@
 #include <file/nbio.h>
 #include <string/stdstring.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && !defined(__ARMEB__) && !defined(__AARCH64EB__)
+#define IMAGE_TEXTURE_NEON
+#include <arm_neon.h>
+#endif
+
 enum image_type_enum image_texture_get_type(const char *path)
 {
    /* We are comparing against a fixed list of file
@@ -104,11 +111,41 @@ bool image_texture_color_convert(unsigned r_shift,
    /* This is quite uncommon. */
    if (a_shift != 24 || r_shift != 16 || g_shift != 8 || b_shift != 0)
    {
-      uint32_t i;
+      uint32_t i          = 0;
       uint32_t num_pixels = out_img->width * out_img->height;
       uint32_t *pixels    = (uint32_t*)out_img->pixels;
 
-      for (i = 0; i < num_pixels; i++)
+      /* Swapping red and blue is what drivers taking RGBA
+       * textures ask for */
+      if (a_shift == 24 && r_shift == 0 && g_shift == 8 && b_shift == 16)
+      {
+#if defined(__SSE2__)
+         const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+
+         for (; i + 4 <= num_pixels; i += 4)
+         {
+            __m128i px = _mm_loadu_si128((const __m128i*)(pixels + i));
+            __m128i rb = _mm_and_si128(px, rb_mask);
+
+            rb         = _mm_or_si128(_mm_slli_epi32(rb, 16),
+                  _mm_srli_epi32(rb, 16));
+            _mm_storeu_si128((__m128i*)(pixels + i),
+                  _mm_or_si128(_mm_andnot_si128(rb_mask, px), rb));
+         }
+#elif defined(IMAGE_TEXTURE_NEON)
+         for (; i + 16 <= num_pixels; i += 16)
+         {
+            uint8x16x4_t px = vld4q_u8((const uint8_t*)(pixels + i));
+            uint8x16_t b    = px.val[0];
+
+            px.val[0]       = px.val[2];
+            px.val[2]       = b;
+            vst4q_u8((uint8_t*)(pixels + i), px);
+         }
+#endif
+      }
+
+      for (; i < num_pixels; i++)
       {
          uint32_t col = pixels[i];
          uint8_t a    = (uint8_t)(col >> 24);
@@ -39,6 +39,15 @@
 
 #include "rpng_internal.h"
 
+#if defined(RPNG_NO_SIMD)
+#elif defined(__SSE2__)
+#define RPNG_SIMD_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && !defined(__ARMEB__) && !defined(__AARCH64EB__)
+#define RPNG_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 enum png_ihdr_color_type
 {
    PNG_IHDR_COLOR_GRAY       = 0,
@@ -230,14 +239,62 @@ static bool rpng_process_ihdr(struct png_ihdr *ihdr)
 }
 #endif
 
+#if defined(RPNG_SIMD_SSE2)
+/* Turns four RGBA pixels (as read from memory) into ARGB words,
+ * with the alpha of the pixels or'ed with @alpha */
+static INLINE __m128i rpng_rgba_to_argb_sse2(__m128i px, __m128i alpha)
+{
+   const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+   __m128i rb            = _mm_and_si128(px, rb_mask);
+
+   rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+   return _mm_or_si128(_mm_or_si128(_mm_andnot_si128(rb_mask, px), rb),
+         alpha);
+}
+#endif
+
 static void rpng_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   int i;
+   int i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < (int)width; i++)
+#if defined(RPNG_SIMD_SSE2)
+   if (bpp == 1)
+   {
+      const __m128i alpha = _mm_set1_epi32(0xff000000);
+
+      /* Four pixels at a time, from 16 byte loads */
+      for (; i + 6 <= (int)width; i += 4, decoded += 12)
+      {
+         __m128i in = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i lo = _mm_unpacklo_epi32(in, _mm_srli_si128(in, 3));
+         __m128i hi = _mm_unpacklo_epi32(_mm_srli_si128(in, 6),
+               _mm_srli_si128(in, 9));
+
+         _mm_storeu_si128((__m128i*)(data + i), rpng_rgba_to_argb_sse2(
+                  _mm_unpacklo_epi64(lo, hi), alpha));
+      }
+   }
+#elif defined(RPNG_SIMD_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 8 <= (int)width; i += 8, decoded += 24)
+      {
+         uint8x8x3_t in = vld3_u8(decoded);
+         uint8x8x4_t out;
+
+         out.val[0] = in.val[2];
+         out.val[1] = in.val[1];
+         out.val[2] = in.val[0];
+         out.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(data + i), out);
+      }
+   }
+#endif
+
+   for (; i < (int)width; i++)
    {
       uint32_t r, g, b;
 
@@ -254,11 +311,35 @@ static void rpng_reverse_filter_copy_line_rgb(uint32_t *data,
 static void rpng_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   int i;
+   int i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < (int)width; i++)
+#if defined(RPNG_SIMD_SSE2)
+   if (bpp == 1)
+   {
+      const __m128i alpha = _mm_setzero_si128();
+
+      for (; i + 4 <= (int)width; i += 4, decoded += 16)
+         _mm_storeu_si128((__m128i*)(data + i), rpng_rgba_to_argb_sse2(
+                  _mm_loadu_si128((const __m128i*)decoded), alpha));
+   }
+#elif defined(RPNG_SIMD_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 8 <= (int)width; i += 8, decoded += 32)
+      {
+         uint8x8x4_t px = vld4_u8(decoded);
+         uint8x8_t r    = px.val[0];
+
+         px.val[0]      = px.val[2];
+         px.val[2]      = r;
+         vst4_u8((uint8_t*)(data + i), px);
+      }
+   }
+#endif
+
+   for (; i < (int)width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -562,52 +643,328 @@ error:
    return -1;
 }
 
-static int rpng_reverse_filter_copy_line(uint32_t *data,
-      const struct png_ihdr *ihdr,
-      struct rpng_process *pngp, unsigned filter)
+/* Reverse filters for 8-bit RGB and RGBA scanlines (3 and 4 bytes
+ * per pixel), which is what nearly every thumbnail and background
+ * is. 'Sub', 'average' and 'paeth' depend on the pixel to their
+ * left, so they go one pixel per vector; 'up' goes 16 bytes at a
+ * time. The other pixel sizes use the scalar loops. */
+#if defined(RPNG_SIMD_SSE2) || defined(RPNG_SIMD_NEON)
+/* Pixels are moved 4 bytes at a time, the extra byte after a
+ * 3 byte pixel being rewritten with the next pixel; only the last
+ * pixel of a scanline (@len being 3) is moved byte by byte */
+static INLINE uint32_t rpng_load_pixel_u32(const uint8_t *p, unsigned len)
+{
+   uint32_t px;
+   if (len == 4)
+      memcpy(&px, p, 4);
+   else
+      px = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+   return px;
+}
+
+static INLINE void rpng_store_pixel_u32(uint8_t *p, uint32_t px, unsigned len)
+{
+   if (len == 4)
+      memcpy(p, &px, 4);
+   else
+   {
+      p[0] = (uint8_t)px;
+      p[1] = (uint8_t)(px >> 8);
+      p[2] = (uint8_t)(px >> 16);
+   }
+}
+#endif
+
+#if defined(RPNG_SIMD_SSE2)
+#define RPNG_SIMD_FILTERS
+
+static INLINE __m128i rpng_load_pixel(const uint8_t *p, unsigned len)
+{
+   return _mm_cvtsi32_si128((int)rpng_load_pixel_u32(p, len));
+}
+
+static INLINE void rpng_store_pixel(uint8_t *p, __m128i v, unsigned len)
+{
+   rpng_store_pixel_u32(p, (uint32_t)_mm_cvtsi128_si32(v), len);
+}
+
+static INLINE __m128i rpng_abs_epi16(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static INLINE __m128i rpng_select(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void rpng_reverse_filter_up_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(in   + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+
+   for (; i < pitch; i++)
+      out[i] = in[i] + prev[i];
+}
+
+static INLINE void rpng_reverse_filter_sub_simd(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned len = (i + 4 <= pitch) ? 4 : 3;
+      a = _mm_add_epi8(a, rpng_load_pixel(in + i, len));
+      rpng_store_pixel(out + i, a, len);
+   }
+}
+
+static INLINE void rpng_reverse_filter_avg_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i one = _mm_set1_epi8(1);
+   __m128i a         = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned len = (i + 4 <= pitch) ? 4 : 3;
+      __m128i b    = rpng_load_pixel(prev + i, len);
+      /* pavgb rounds up, the filter rounds down */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a = _mm_add_epi8(rpng_load_pixel(in + i, len), avg);
+      rpng_store_pixel(out + i, a, len);
+   }
+}
+
+static INLINE void rpng_reverse_filter_paeth_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
 {
    unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   /* Left and upper left pixels, widened to 16 bits */
+   __m128i a          = zero;
+   __m128i c          = zero;
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i pa, pb, pc, smallest, nearest, d;
+      unsigned len = (i + 4 <= pitch) ? 4 : 3;
+      __m128i b    = _mm_unpacklo_epi8(rpng_load_pixel(prev + i, len), zero);
+
+      pa        = _mm_sub_epi16(b, c);
+      pb        = _mm_sub_epi16(a, c);
+      pc        = rpng_abs_epi16(_mm_add_epi16(pa, pb));
+      pa        = rpng_abs_epi16(pa);
+      pb        = rpng_abs_epi16(pb);
+      smallest  = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+      /* Ties go to a, then b, like paeth() */
+      nearest   = rpng_select(_mm_cmpeq_epi16(smallest, pa), a,
+            rpng_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+      d         = _mm_add_epi8(rpng_load_pixel(in + i, len),
+            _mm_packus_epi16(nearest, nearest));
+      rpng_store_pixel(out + i, d, len);
+
+      a         = _mm_unpacklo_epi8(d, zero);
+      c         = b;
+   }
+}
+#elif defined(RPNG_SIMD_NEON)
+#define RPNG_SIMD_FILTERS
+
+static INLINE uint8x8_t rpng_load_pixel(const uint8_t *p, unsigned len)
+{
+   return vreinterpret_u8_u32(vdup_n_u32(rpng_load_pixel_u32(p, len)));
+}
+
+static INLINE void rpng_store_pixel(uint8_t *p, uint8x8_t v, unsigned len)
+{
+   rpng_store_pixel_u32(p, vget_lane_u32(vreinterpret_u32_u8(v), 0), len);
+}
+
+static void rpng_reverse_filter_up_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+
+   for (; i < pitch; i++)
+      out[i] = in[i] + prev[i];
+}
+
+static INLINE void rpng_reverse_filter_sub_simd(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned len = (i + 4 <= pitch) ? 4 : 3;
+      a = vadd_u8(a, rpng_load_pixel(in + i, len));
+      rpng_store_pixel(out + i, a, len);
+   }
+}
+
+static INLINE void rpng_reverse_filter_avg_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned len = (i + 4 <= pitch) ? 4 : 3;
+      a = vadd_u8(rpng_load_pixel(in + i, len),
+            vhadd_u8(a, rpng_load_pixel(prev + i, len)));
+      rpng_store_pixel(out + i, a, len);
+   }
+}
+
+static INLINE void rpng_reverse_filter_paeth_simd(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned len     = (i + 4 <= pitch) ? 4 : 3;
+      uint8x8_t b      = rpng_load_pixel(prev + i, len);
+      uint16x8_t pa    = vabdl_u8(b, c);
+      uint16x8_t pb    = vabdl_u8(a, c);
+      uint16x8_t pc    = vreinterpretq_u16_s16(vabsq_s16(vaddq_s16(
+                  vreinterpretq_s16_u16(vsubl_u8(b, c)),
+                  vreinterpretq_s16_u16(vsubl_u8(a, c)))));
+      /* Ties go to a, then b, like paeth() */
+      uint8x8_t take_a = vmovn_u16(vandq_u16(vcleq_u16(pa, pb),
+               vcleq_u16(pa, pc)));
+      uint8x8_t take_b = vmovn_u16(vcleq_u16(pb, pc));
+      uint8x8_t d      = vadd_u8(rpng_load_pixel(in + i, len),
+            vbsl_u8(take_a, a, vbsl_u8(take_b, b, c)));
+
+      rpng_store_pixel(out + i, d, len);
+
+      a                = d;
+      c                = b;
+   }
+}
+#endif
+
+/**
+ * rpng_reverse_filter_line:
+ * @out    : Unfiltered scanline.
+ * @in     : Filtered scanline, without its filter type byte.
+ * @prev   : Previous unfiltered scanline, zeroes for the first one.
+ * @pitch  : Size of a scanline, in bytes.
+ * @bpp    : Size of a pixel, in bytes (rounded up).
+ * @filter : Filter type of the scanline.
+ *
+ * Returns: false if @filter isn't a valid filter type.
+ **/
+static bool rpng_reverse_filter_line(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp, unsigned filter)
+{
+   unsigned i;
+#ifdef RPNG_SIMD_FILTERS
+   bool simd = (bpp == 3 || bpp == 4);
+#endif
 
    switch (filter)
    {
       case PNG_FILTER_NONE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
+         memcpy(out, in, pitch);
          break;
       case PNG_FILTER_SUB:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] += pngp->decoded_scanline[i - pngp->bpp];
+#ifdef RPNG_SIMD_FILTERS
+         if (simd)
+         {
+            /* With a constant pixel size, whole 4 byte pixels
+             * don't check for the end of the scanline */
+            if (bpp == 4)
+               rpng_reverse_filter_sub_simd(out, in, pitch, 4);
+            else
+               rpng_reverse_filter_sub_simd(out, in, pitch, 3);
+            break;
+         }
+#endif
+         for (i = 0; i < bpp; i++)
+            out[i] = in[i];
+         for (; i < pitch; i++)
+            out[i] = in[i] + out[i - bpp];
          break;
       case PNG_FILTER_UP:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] += pngp->prev_scanline[i];
+#ifdef RPNG_SIMD_FILTERS
+         rpng_reverse_filter_up_simd(out, in, prev, pitch);
+#else
+         for (i = 0; i < pitch; i++)
+            out[i] = in[i] + prev[i];
+#endif
          break;
       case PNG_FILTER_AVERAGE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
-         for (i = 0; i < pngp->bpp; i++)
+#ifdef RPNG_SIMD_FILTERS
+         if (simd)
          {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] += avg;
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] += avg;
+            if (bpp == 4)
+               rpng_reverse_filter_avg_simd(out, in, prev, pitch, 4);
+            else
+               rpng_reverse_filter_avg_simd(out, in, prev, pitch, 3);
+            break;
          }
+#endif
+         for (i = 0; i < bpp; i++)
+            out[i] = in[i] + (prev[i] >> 1);
+         for (; i < pitch; i++)
+            out[i] = in[i] + ((out[i - bpp] + prev[i]) >> 1);
          break;
       case PNG_FILTER_PAETH:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] += pngp->prev_scanline[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] += paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]);
+#ifdef RPNG_SIMD_FILTERS
+         if (simd)
+         {
+            if (bpp == 4)
+               rpng_reverse_filter_paeth_simd(out, in, prev, pitch, 4);
+            else
+               rpng_reverse_filter_paeth_simd(out, in, prev, pitch, 3);
+            break;
+         }
+#endif
+         for (i = 0; i < bpp; i++)
+            out[i] = in[i] + prev[i];
+         for (; i < pitch; i++)
+            out[i] = in[i] + paeth(out[i - bpp], prev[i], prev[i - bpp]);
          break;
       default:
-         return IMAGE_PROCESS_ERROR_END;
+         return false;
    }
 
+   return true;
+}
+
+static int rpng_reverse_filter_copy_line(uint32_t *data,
+      const struct png_ihdr *ihdr,
+      struct rpng_process *pngp, unsigned filter)
+{
+   uint8_t *prev_scanline;
+
+   if (!rpng_reverse_filter_line(pngp->decoded_scanline,
+            pngp->inflate_buf, pngp->prev_scanline,
+            pngp->pitch, pngp->bpp, filter))
+      return IMAGE_PROCESS_ERROR_END;
+
    switch (ihdr->color_type)
    {
       case PNG_IHDR_COLOR_GRAY:
@@ -630,7 +987,10 @@ static int rpng_reverse_filter_copy_line(uint32_t *data,
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
+   /* This scanline is the previous one of the next */
+   prev_scanline          = pngp->prev_scanline;
+   pngp->prev_scanline    = pngp->decoded_scanline;
+   pngp->decoded_scanline = prev_scanline;
 
    return IMAGE_PROCESS_NEXT;
 }
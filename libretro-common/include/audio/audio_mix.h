@@ -55,17 +55,53 @@ typedef struct
    bool resample;
 } audio_chunk_t;
 
-#if defined(__SSE2__)
-#define audio_mix_volume           audio_mix_volume_SSE2
+/* The AVX2 mixer is built with a function target attribute
+ * and picked at runtime, so generic x86 builds get it too */
+#if defined(__AVX2__) || (defined(__SSE2__) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)))
+#define AUDIO_MIX_AVX2
+#endif
 
-void audio_mix_volume_SSE2(float *out,
+#if defined(__AVX2__)
+#define audio_mix_volume           audio_mix_volume_AVX2
+#elif defined(AUDIO_MIX_AVX2)
+/* audio_mix_volume_AVX2 if the CPU supports it,
+ * audio_mix_volume_SSE2 otherwise */
+void audio_mix_volume(float *out,
       const float *in, float vol, size_t samples);
+#elif defined(__SSE2__)
+#define audio_mix_volume           audio_mix_volume_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define audio_mix_volume           audio_mix_volume_NEON
 #else
 #define audio_mix_volume           audio_mix_volume_C
 #endif
 
+#if defined(__SSE2__)
+void audio_mix_volume_SSE2(float *out,
+      const float *in, float vol, size_t samples);
+#endif
+#if defined(AUDIO_MIX_AVX2)
+/* Only call this if the CPU supports AVX2 */
+void audio_mix_volume_AVX2(float *out,
+      const float *in, float vol, size_t samples);
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+void audio_mix_volume_NEON(float *out,
+      const float *in, float vol, size_t samples);
+#endif
+
 void audio_mix_volume_C(float *dst, const float *src, float vol, size_t samples);
 
+/**
+ * audio_mix_clamp:
+ * @buf                : interleaved float samples
+ * @samples            : number of samples in @buf
+ *
+ * Clamps mixed samples to [-1.0, 1.0].
+ **/
+void audio_mix_clamp(float *buf, size_t samples);
+
 void audio_mix_free_chunk(audio_chunk_t *chunk);
 
 audio_chunk_t* audio_mix_load_wav_file(const char *path, int sample_rate,
@@ -54,7 +54,12 @@ enum resampler_quality
    RESAMPLER_QUALITY_LOWER,
    RESAMPLER_QUALITY_NORMAL,
    RESAMPLER_QUALITY_HIGHER,
-   RESAMPLER_QUALITY_HIGHEST
+   RESAMPLER_QUALITY_HIGHEST,
+   /* HIGHER's filter on a precomputed table matching
+    * the resampling ratio (sinc resampler only). Only
+    * faster than HIGHER while the ratio is not adjusted
+    * by dynamic rate control. */
+   RESAMPLER_QUALITY_POLYPHASE
 };
 
 /* A bit-mask of all supported SIMD instruction sets.
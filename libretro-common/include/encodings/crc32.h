@@ -32,6 +32,18 @@ RETRO_BEGIN_DECLS
 
 uint32_t encoding_crc32(uint32_t crc, const uint8_t *buf, size_t len);
 
+/**
+ * encoding_crc32_combine:
+ * @crc1 : CRC32 of a first block of data.
+ * @crc2 : CRC32 of the block following it.
+ * @len2 : Length of the second block.
+ *
+ * Lets a buffer be hashed in chunks, e.g. on several threads.
+ *
+ * Returns: the CRC32 of both blocks, back to back.
+ **/
+uint32_t encoding_crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
 RETRO_END_DECLS
 
 #endif
@@ -675,6 +675,21 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+/**
+ * path_get_size_mtime:
+ * @path               : path
+ * @size               : size of the file in bytes
+ * @mtime              : last modification time, in seconds
+ *                       since the epoch
+ *
+ * Queries the file system directly, bypassing the VFS
+ * interface, so that sizes over 2 GB and modification
+ * times are available. Meant for cache validation.
+ *
+ * @return true if @path exists, otherwise false.
+ **/
+bool path_get_size_mtime(const char *path, int64_t *size, int64_t *mtime);
+
 bool is_path_accessible_using_standard_io(const char *path);
 
 RETRO_END_DECLS
@@ -44,6 +44,22 @@ enum task_type
    TASK_TYPE_BLOCKING
 };
 
+/* Scheduling class of a task. When several tasks are
+ * due at the same time, the threaded task queue runs
+ * the one with the lowest value first. */
+enum task_priority
+{
+   /* Work the user is actively waiting on
+    * (image loads, save writes, decompression...) */
+   TASK_PRIORITY_INTERACTIVE = 0,
+   /* Network transfers */
+   TASK_PRIORITY_NETWORK,
+   /* Long-running bulk work (database/content scans) */
+   TASK_PRIORITY_BACKGROUND,
+
+   TASK_PRIORITY_LAST
+};
+
 typedef struct retro_task retro_task_t;
 typedef void (*retro_task_callback_t)(retro_task_t *task,
       void *task_data,
@@ -115,6 +131,9 @@ struct retro_task
 
    enum task_type type;
 
+   /* scheduling class, defaults to TASK_PRIORITY_INTERACTIVE */
+   enum task_priority priority;
+
    /* if set to true, frontend will
    use an alternative look for the
    task progress display */
@@ -130,6 +149,12 @@ struct retro_task
 
    /* if true no OSD messages will be displayed. */
    bool mute;
+
+   /* if set to true, the threaded task queue may run this
+    * task alongside any other, including tasks with the same
+    * handler. Otherwise it shares a single serial lane with
+    * every other task that doesn't set it. */
+   bool parallel;
 };
 
 typedef struct task_finder_data
@@ -199,6 +224,15 @@ void task_queue_unset_threaded(void);
 
 bool task_queue_is_threaded(void);
 
+/* Sets the number of worker threads used by
+ * the threaded task queue (0 = automatic).
+ * Takes effect on the next task_queue_check(). */
+void task_queue_set_worker_count(unsigned count);
+
+/* Returns the number of worker threads currently
+ * running (0 if the task queue is not threaded). */
+unsigned task_queue_get_worker_count(void);
+
 /**
  * Calls func for every running task
  * until it returns true.
@@ -0,0 +1,74 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (retro_atomic.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_ATOMIC_H
+#define __LIBRETRO_SDK_ATOMIC_H
+
+/* Minimal set of atomic operations on a 'long',
+ * enough to build single-producer/single-consumer
+ * structures without a mutex.
+ *
+ * retro_atomic_load_acquire(ptr)
+ * retro_atomic_store_release(ptr, val)
+ * retro_atomic_exchange(ptr, val)      - returns old value, full barrier
+ * retro_atomic_fetch_add(ptr, val)     - returns old value, full barrier
+ */
+
+typedef volatile long retro_atomic_long_t;
+
+#if defined(_MSC_VER)
+#if defined(_XBOX)
+#include <Xtl.h>
+#else
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+/* Interlocked* are full barriers; plain volatile
+ * accesses have acquire/release semantics on MSVC */
+#define retro_atomic_load_acquire(ptr)       (*(ptr))
+#define retro_atomic_store_release(ptr, val) (*(ptr) = (val))
+#define retro_atomic_exchange(ptr, val)      InterlockedExchange((ptr), (val))
+#define retro_atomic_fetch_add(ptr, val)     InterlockedExchangeAdd((ptr), (val))
+
+#elif defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+
+#define retro_atomic_load_acquire(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define retro_atomic_store_release(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define retro_atomic_exchange(ptr, val)      __atomic_exchange_n((ptr), (val), __ATOMIC_ACQ_REL)
+#define retro_atomic_fetch_add(ptr, val)     __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+
+#elif defined(__GNUC__)
+
+/* Legacy __sync builtins (older console toolchains) */
+#define retro_atomic_load_acquire(ptr)       __sync_fetch_and_add((ptr), 0)
+#define retro_atomic_store_release(ptr, val) do { __sync_synchronize(); *(ptr) = (val); } while (0)
+#define retro_atomic_exchange(ptr, val)      (__sync_synchronize(), __sync_lock_test_and_set((ptr), (val)))
+#define retro_atomic_fetch_add(ptr, val)     __sync_fetch_and_add((ptr), (val))
+
+#else
+#error "retro_atomic.h: no atomic operations available for this compiler"
+#endif
+
+#endif
@@ -110,6 +110,12 @@ uint32_t intfstream_get_first_sector(intfstream_internal_t* intf);
 
 bool intfstream_is_compressed(intfstream_internal_t *intf);
 
+/* Compresses on 'num_threads' threads when the
+ * stream is an RZIP file open for writing.
+ * Must be called before anything is written. */
+bool intfstream_set_compression_threads(intfstream_internal_t *intf,
+      unsigned num_threads);
+
 bool intfstream_get_crc(intfstream_internal_t *intf, uint32_t *crc);
 
 intfstream_t *intfstream_open_file(const char *path,
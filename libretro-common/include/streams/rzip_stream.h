@@ -117,6 +117,17 @@ bool rzipstream_read_file(const char *path, void **buf, int64_t *len);
 
 /* File Write */
 
+/* Compresses chunks on 'num_threads' threads
+ * while writing, and writes them to file in
+ * order as they complete. The resulting file is
+ * identical to one compressed on a single thread.
+ * Must be called before any data is written.
+ * Returns false if threads could not be started
+ * (or HAVE_THREADS is not defined), in which case
+ * the stream keeps compressing on the calling
+ * thread */
+bool rzipstream_set_threads(rzipstream_t *stream, unsigned num_threads);
+
 /* Writes 'len' bytes to an RZIP file.
  * Returns actual number of bytes written, or -1
  * in the event of an error */
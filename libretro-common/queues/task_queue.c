@@ -32,12 +32,26 @@
 #include <rthreads/rthreads.h>
 #endif
 
+/* Upper bound for the threaded worker pool */
+#define TASK_QUEUE_MAX_WORKERS    8
+/* Worker count picked when set to automatic */
+#define TASK_QUEUE_AUTO_WORKERS   4
+/* A worker ignores priority classes once every
+ * this many picks (see task_queue_pick) */
+#define TASK_QUEUE_FAIRNESS_PICKS 8
+
 typedef struct
 {
    retro_task_t *front;
    retro_task_t *back;
 } task_queue_t;
 
+typedef struct
+{
+   task_retriever_data_t *data;
+   task_retriever_info_t *tail;
+} task_retriever_state_t;
+
 struct retro_task_impl
 {
    retro_task_queue_msg_t msg_push;
@@ -60,16 +74,35 @@ static task_queue_t tasks_finished          = {NULL, NULL};
 static struct retro_task_impl *impl_current = NULL;
 static bool task_threaded_enable            = false;
 
+static unsigned task_workers_wanted         = 0;
+static bool task_workers_changed            = false;
+
 #ifdef HAVE_THREADS
+typedef struct
+{
+   /* tasks waiting to run, owned by this worker */
+   task_queue_t queue;
+   /* task whose handler is executing right now */
+   retro_task_t *current;
+   sthread_t *thread;
+   unsigned index;
+   unsigned picks;
+} task_worker_t;
+
+static task_worker_t task_workers[TASK_QUEUE_MAX_WORKERS];
+static unsigned task_workers_count          = 0;
+/* tasks without 'parallel' set, shared by all workers
+ * and run one at a time */
+static task_queue_t task_serial_lane        = {NULL, NULL};
+static bool task_serial_busy                = false;
 static uintptr_t main_thread_id             = 0;
 static slock_t *running_lock                = NULL;
 static slock_t *finished_lock               = NULL;
 static slock_t *property_lock               = NULL;
-static slock_t *queue_lock                  = NULL;
 static scond_t *worker_cond                 = NULL;
-static sthread_t *worker_thread             = NULL;
 static bool worker_continue                 = true;
-/* use running_lock when touching it */
+/* use running_lock when touching task_workers,
+ * the serial lane or worker_continue */
 #endif
 
 static void task_queue_msg_push(retro_task_t *task,
@@ -270,49 +303,54 @@ static bool retro_task_regular_find(retro_task_finder_t func, void *user_data)
    return false;
 }
 
-static void retro_task_regular_retrieve(task_retriever_data_t *data)
+static void task_queue_retrieve_task(task_retriever_data_t *data,
+      retro_task_t *task, task_retriever_info_t **tail)
 {
-   retro_task_t *task          = NULL;
-   task_retriever_info_t *tail = NULL;
+   task_retriever_info_t *info = NULL;
 
-   /* Parse all running tasks and handle matching handlers */
-   for (task = tasks_running.front; task != NULL; task = task->next)
-   {
-      task_retriever_info_t *info = NULL;
-      if (task->handler != data->handler)
-         continue;
+   if (task->handler != data->handler)
+      return;
 
-      /* Create new link */
-      info       = (task_retriever_info_t*)
-         malloc(sizeof(task_retriever_info_t));
-      info->data = malloc(data->element_size);
-      info->next = NULL;
+   /* Create new link */
+   info       = (task_retriever_info_t*)
+      malloc(sizeof(task_retriever_info_t));
+   info->data = malloc(data->element_size);
+   info->next = NULL;
 
-      /* Call retriever function and fill info-specific data */
-      if (!data->func(task, info->data))
-      {
-         free(info->data);
-         free(info);
-         continue;
-      }
+   /* Call retriever function and fill info-specific data */
+   if (!data->func(task, info->data))
+   {
+      free(info->data);
+      free(info);
+      return;
+   }
 
-      /* Add link to list */
-      if (data->list)
+   /* Add link to list */
+   if (data->list)
+   {
+      if (*tail)
       {
-         if (tail)
-         {
-            tail->next = info;
-            tail       = tail->next;
-         }
-         else
-            tail       = info;
+         (*tail)->next = info;
+         *tail         = (*tail)->next;
       }
       else
-      {
-         data->list    = info;
-         tail          = data->list;
-      }
+         *tail         = info;
    }
+   else
+   {
+      data->list       = info;
+      *tail            = data->list;
+   }
+}
+
+static void retro_task_regular_retrieve(task_retriever_data_t *data)
+{
+   retro_task_t *task          = NULL;
+   task_retriever_info_t *tail = NULL;
+
+   /* Parse all running tasks and handle matching handlers */
+   for (task = tasks_running.front; task != NULL; task = task->next)
+      task_queue_retrieve_task(data, task, &tail);
 }
 
 static struct retro_task_impl impl_regular = {
@@ -330,7 +368,7 @@ static struct retro_task_impl impl_regular = {
 
 #ifdef HAVE_THREADS
 
-/* 'queue_lock' must be held for the duration of this function */
+/* 'running_lock' must be held for the duration of this function */
 static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
 {
    retro_task_t     *t = NULL;
@@ -359,10 +397,7 @@ static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
 
          /* When removing the tail of the queue, update the tail pointer */
          if (queue->back == task)
-         {
-            if (queue->back == task)
-               queue->back = t;
-         }
+            queue->back = t;
          break;
       }
 
@@ -371,41 +406,177 @@ static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
    }
 }
 
-static void retro_task_threaded_push_running(retro_task_t *task)
+static unsigned task_queue_length(task_queue_t *queue)
 {
-   slock_lock(running_lock);
-   slock_lock(queue_lock);
-   task_queue_put(&tasks_running, task);
-   scond_signal(worker_cond);
-   slock_unlock(queue_lock);
-   slock_unlock(running_lock);
+   unsigned     len = 0;
+   retro_task_t *t  = queue->front;
+
+   for (; t; t = t->next)
+      len++;
+
+   return len;
 }
 
-static void retro_task_threaded_cancel(void *task)
+/* Returns the task in 'queue' that should run next, or NULL
+ * if none is due yet. 'next_when' is lowered to the earliest
+ * pending schedule time so the caller knows how long to sleep.
+ *
+ * Tasks are picked by priority class, oldest first within a
+ * class; every TASK_QUEUE_FAIRNESS_PICKS picks the oldest due
+ * task wins regardless of class so background work cannot
+ * be starved by a steady stream of interactive tasks.
+ *
+ * 'running_lock' must be held for the duration of this function */
+static retro_task_t *task_queue_pick(task_queue_t *queue,
+      retro_time_t now, retro_time_t *next_when, bool fifo)
+{
+   retro_task_t *task = queue->front;
+   retro_task_t *best = NULL;
+
+   for (; task; task = task->next)
+   {
+      /* allow half a millisecond for context switching */
+      if (task->when && task->when - now - 500 > 0)
+      {
+         if (!*next_when || task->when < *next_when)
+            *next_when = task->when;
+         continue;
+      }
+
+      if (fifo)
+         return task;
+
+      if (!best || task->priority < best->priority)
+         best = task;
+   }
+
+   return best;
+}
+
+/* Calls func for every task owned by a worker, whether it is
+ * currently running or waiting in a queue, until it returns true.
+ *
+ * 'running_lock' must be held for the duration of this function */
+static bool retro_task_threaded_foreach(
+      retro_task_finder_t func, void *user_data)
 {
-   retro_task_t *t;
+   unsigned i;
+   retro_task_t *task = task_serial_lane.front;
+
+   for (; task; task = task->next)
+   {
+      if (func(task, user_data))
+         return true;
+   }
+
+   for (i = 0; i < task_workers_count; i++)
+   {
+      task_worker_t *worker = &task_workers[i];
+      retro_task_t  *task   = worker->queue.front;
+
+      if (worker->current && func(worker->current, user_data))
+         return true;
+
+      for (; task; task = task->next)
+      {
+         if (func(task, user_data))
+            return true;
+      }
+   }
+
+   return false;
+}
+
+static bool retro_task_threaded_push_progress(retro_task_t *task,
+      void *user_data)
+{
+   task_queue_push_progress(task);
+   return false;
+}
+
+static bool retro_task_threaded_cancel_one(retro_task_t *task,
+      void *user_data)
+{
+   if (task != user_data)
+      return false;
+   task->cancelled = true;
+   return true;
+}
+
+static bool retro_task_threaded_cancel_all(retro_task_t *task,
+      void *user_data)
+{
+   task->cancelled = true;
+   return false;
+}
+
+static bool retro_task_threaded_is_unscheduled(retro_task_t *task,
+      void *user_data)
+{
+   return !task->when;
+}
+
+static bool retro_task_threaded_retrieve_one(retro_task_t *task,
+      void *user_data)
+{
+   task_retriever_state_t *state = (task_retriever_state_t*)user_data;
+   task_queue_retrieve_task(state->data, task, &state->tail);
+   return false;
+}
+
+static void retro_task_threaded_push_running(retro_task_t *task)
+{
+   unsigned i;
+   task_worker_t *target = &task_workers[0];
+   unsigned   target_len = 0;
 
    slock_lock(running_lock);
 
-   for (t = tasks_running.front; t; t = t->next)
+   /* Handlers that aren't parallel safe may keep state in
+    * statics (see task_save.c), so those tasks take turns
+    * on a single lane like they did on the one worker thread */
+   if (!task->parallel)
    {
-      if (t == task)
+      task_queue_put(&task_serial_lane, task);
+      scond_signal(worker_cond);
+      slock_unlock(running_lock);
+      return;
+   }
+
+   /* Hand the task to the least loaded worker,
+    * idle workers will steal it if that one is busy */
+   target_len = task_queue_length(&target->queue)
+      + (target->current ? 1 : 0);
+
+   for (i = 1; i < task_workers_count && target_len; i++)
+   {
+      task_worker_t *worker = &task_workers[i];
+      unsigned          len = task_queue_length(&worker->queue)
+         + (worker->current ? 1 : 0);
+
+      if (len < target_len)
       {
-        t->cancelled = true;
-        break;
+         target     = worker;
+         target_len = len;
       }
    }
 
+   task_queue_put(&target->queue, task);
+   scond_signal(worker_cond);
    slock_unlock(running_lock);
 }
 
-static void retro_task_threaded_gather(void)
+static void retro_task_threaded_cancel(void *task)
 {
-   retro_task_t *task = NULL;
+   slock_lock(running_lock);
+   retro_task_threaded_foreach(retro_task_threaded_cancel_one, task);
+   slock_unlock(running_lock);
+}
 
+static void retro_task_threaded_gather(void)
+{
    slock_lock(running_lock);
-   for (task = tasks_running.front; task; task = task->next)
-      task_queue_push_progress(task);
+   retro_task_threaded_foreach(retro_task_threaded_push_progress, NULL);
    slock_unlock(running_lock);
 
    slock_lock(finished_lock);
@@ -422,7 +593,8 @@ static void retro_task_threaded_wait(retro_task_condition_fn_t cond, void* data)
       retro_task_threaded_gather();
 
       slock_lock(running_lock);
-      wait = (tasks_running.front && !tasks_running.front->when);
+      wait = retro_task_threaded_foreach(
+            retro_task_threaded_is_unscheduled, NULL);
       slock_unlock(running_lock);
 
       if (!wait)
@@ -436,29 +608,18 @@ static void retro_task_threaded_wait(retro_task_condition_fn_t cond, void* data)
 
 static void retro_task_threaded_reset(void)
 {
-   retro_task_t *task = NULL;
-
    slock_lock(running_lock);
-   for (task = tasks_running.front; task; task = task->next)
-      task->cancelled = true;
+   retro_task_threaded_foreach(retro_task_threaded_cancel_all, NULL);
    slock_unlock(running_lock);
 }
 
 static bool retro_task_threaded_find(
       retro_task_finder_t func, void *user_data)
 {
-   retro_task_t *task = NULL;
-   bool        result = false;
+   bool result = false;
 
    slock_lock(running_lock);
-   for (task = tasks_running.front; task; task = task->next)
-   {
-      if (func(task, user_data))
-      {
-         result = true;
-         break;
-      }
-   }
+   result      = retro_task_threaded_foreach(func, user_data);
    slock_unlock(running_lock);
 
    return result;
@@ -466,46 +627,70 @@ static bool retro_task_threaded_find(
 
 static void retro_task_threaded_retrieve(task_retriever_data_t *data)
 {
+   task_retriever_state_t state;
+
+   state.data = data;
+   state.tail = NULL;
+
    /* Protect access to running tasks */
    slock_lock(running_lock);
-   /* Call regular retrieve function */
-   retro_task_regular_retrieve(data);
-   /* Release access to running tasks */
+   retro_task_threaded_foreach(retro_task_threaded_retrieve_one, &state);
    slock_unlock(running_lock);
 }
 
 static void threaded_worker(void *userdata)
 {
-   for (;;)
-   {
-      retro_task_t *task  = NULL;
-      bool       finished = false;
+   task_worker_t *worker = (task_worker_t*)userdata;
 
-      if (!worker_continue)
-         break; /* should we keep running until all tasks finished? */
+   slock_lock(running_lock);
 
-      slock_lock(running_lock);
+   while (worker_continue)
+   {
+      unsigned i;
+      bool finished          = false;
+      bool fifo              = (++worker->picks
+            % TASK_QUEUE_FAIRNESS_PICKS) == 0;
+      retro_time_t now       = cpu_features_get_time_usec();
+      retro_time_t next_when = 0;
+      task_queue_t *owner    = &worker->queue;
+      retro_task_t *serial   = NULL;
+      retro_task_t *task     = task_queue_pick(&worker->queue,
+            now, &next_when, fifo);
+
+      /* The serial lane competes with our own queue */
+      if (!task_serial_busy)
+         serial = task_queue_pick(&task_serial_lane,
+               now, &next_when, fifo);
+
+      if (serial && (!task || fifo || serial->priority <= task->priority))
+      {
+         owner = &task_serial_lane;
+         task  = serial;
+      }
 
-      /* Get first task to run */
-      if (!(task = tasks_running.front))
+      /* Nothing due locally - steal from the other workers,
+       * starting with our neighbour so victims are spread out */
+      for (i = 1; !task && i < task_workers_count; i++)
       {
-         scond_wait(worker_cond, running_lock);
-         slock_unlock(running_lock);
-         continue;
+         owner = &task_workers[(worker->index + i)
+            % task_workers_count].queue;
+         task  = task_queue_pick(owner, now, &next_when, fifo);
       }
 
-      if (task->when)
+      if (!task)
       {
-         retro_time_t now   = cpu_features_get_time_usec();
-         retro_time_t delay = task->when - now - 500; /* allow half a millisecond for context switching */
-         if (delay > 0)
-         {
-            scond_wait_timeout(worker_cond, running_lock, delay);
-            slock_unlock(running_lock);
-            continue;
-         }
+         if (next_when)
+            scond_wait_timeout(worker_cond, running_lock,
+                  next_when - now - 500);
+         else
+            scond_wait(worker_cond, running_lock);
+         continue;
       }
 
+      task_queue_remove(owner, task);
+      worker->current = task;
+      if (owner == &task_serial_lane)
+         task_serial_busy = true;
       slock_unlock(running_lock);
 
       task->handler(task);
@@ -514,78 +699,147 @@ static void threaded_worker(void *userdata)
       finished = task->finished;
       slock_unlock(property_lock);
 
-      /* Update queue */
-      if (!finished)
+      if (finished)
       {
-         /* Move the task to the back of the queue */
-         /* mimics retro_task_threaded_push_running,
-          * but also includes a task_queue_remove */
-         slock_lock(running_lock);
-         slock_lock(queue_lock);
+         /* Add task to finished queue */
+         slock_lock(finished_lock);
+         task_queue_put(&tasks_finished, task);
+         slock_unlock(finished_lock);
 
-         /* do nothing if only item in queue */
-         if (task->next)
-         {
-            task_queue_remove(&tasks_running, task);
-            task_queue_put(&tasks_running, task);
-            scond_signal(worker_cond);
-         }
-         slock_unlock(queue_lock);
-         slock_unlock(running_lock);
+         slock_lock(running_lock);
+         worker->current = NULL;
+      }
+      else if (owner == &task_serial_lane)
+      {
+         /* Move the task to the back of the lane so
+          * serial tasks take turns */
+         slock_lock(running_lock);
+         worker->current = NULL;
+         task_queue_put(&task_serial_lane, task);
       }
       else
       {
-         /* Remove task from running queue */
+         /* Move the task to the back of our own queue - a task
+          * keeps running on the worker that last ran it
+          * unless somebody else steals it */
          slock_lock(running_lock);
-         slock_lock(queue_lock);
-         task_queue_remove(&tasks_running, task);
-         slock_unlock(queue_lock);
-         slock_unlock(running_lock);
+         worker->current = NULL;
+         task_queue_put(&worker->queue, task);
 
-         /* Add task to finished queue */
-         slock_lock(finished_lock);
-         task_queue_put(&tasks_finished, task);
-         slock_unlock(finished_lock);
+         /* Wake an idle worker if there is more than
+          * this task left to do */
+         if (worker->queue.front != task)
+            scond_signal(worker_cond);
       }
+
+      /* Hand the lane over to whoever is waiting for it */
+      if (owner == &task_serial_lane)
+      {
+         task_serial_busy = false;
+         scond_signal(worker_cond);
+      }
+   }
+
+   slock_unlock(running_lock);
+}
+
+static unsigned retro_task_threaded_resolve_worker_count(void)
+{
+   unsigned count = task_workers_wanted;
+
+   /* Automatic: leave one core to the main thread */
+   if (count == 0)
+   {
+      count = cpu_features_get_core_amount();
+      count = (count > 1) ? count - 1 : 1;
+      if (count > TASK_QUEUE_AUTO_WORKERS)
+         count = TASK_QUEUE_AUTO_WORKERS;
    }
+
+   if (count > TASK_QUEUE_MAX_WORKERS)
+      count = TASK_QUEUE_MAX_WORKERS;
+
+   return count;
 }
 
 static void retro_task_threaded_init(void)
 {
+   unsigned i;
+   retro_task_t *task = NULL;
+
    running_lock    = slock_new();
    finished_lock   = slock_new();
    property_lock   = slock_new();
-   queue_lock      = slock_new();
    worker_cond     = scond_new();
 
    slock_lock(running_lock);
-   worker_continue = true;
+   worker_continue      = true;
+   task_workers_changed = false;
+   task_serial_busy     = false;
+   task_workers_count   = retro_task_threaded_resolve_worker_count();
+
+   for (i = 0; i < task_workers_count; i++)
+   {
+      task_workers[i].queue.front = NULL;
+      task_workers[i].queue.back  = NULL;
+      task_workers[i].current     = NULL;
+      task_workers[i].index       = i;
+      task_workers[i].picks       = 0;
+   }
+
+   /* Adopt tasks left on hold by a previous implementation */
+   for (i = 0; (task = task_queue_get(&tasks_running)); i++)
+   {
+      if (task->parallel)
+         task_queue_put(&task_workers[i % task_workers_count].queue, task);
+      else
+         task_queue_put(&task_serial_lane, task);
+   }
    slock_unlock(running_lock);
 
-   worker_thread   = sthread_create(threaded_worker, NULL);
+   for (i = 0; i < task_workers_count; i++)
+      task_workers[i].thread = sthread_create(threaded_worker,
+            &task_workers[i]);
 }
 
 static void retro_task_threaded_deinit(void)
 {
+   unsigned i;
+   retro_task_t *task = NULL;
+
    slock_lock(running_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
+   scond_broadcast(worker_cond);
    slock_unlock(running_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < task_workers_count; i++)
+   {
+      sthread_join(task_workers[i].thread);
+      task_workers[i].thread = NULL;
+   }
+
+   /* Keep unfinished tasks on hold so that the
+    * next implementation picks them up */
+   while ((task = task_queue_get(&task_serial_lane)))
+      task_queue_put(&tasks_running, task);
+
+   for (i = 0; i < task_workers_count; i++)
+   {
+      while ((task = task_queue_get(&task_workers[i].queue)))
+         task_queue_put(&tasks_running, task);
+   }
+
+   task_workers_count = 0;
 
    scond_free(worker_cond);
    slock_free(running_lock);
    slock_free(finished_lock);
    slock_free(property_lock);
-   slock_free(queue_lock);
 
-   worker_thread   = NULL;
    worker_cond     = NULL;
    running_lock    = NULL;
    finished_lock   = NULL;
    property_lock   = NULL;
-   queue_lock      = NULL;
 }
 
 static struct retro_task_impl impl_threaded = {
@@ -646,6 +900,22 @@ bool task_queue_is_threaded(void)
    return task_threaded_enable;
 }
 
+void task_queue_set_worker_count(unsigned count)
+{
+   if (count != task_workers_wanted)
+      task_workers_changed = true;
+   task_workers_wanted     = count;
+}
+
+unsigned task_queue_get_worker_count(void)
+{
+#ifdef HAVE_THREADS
+   if (impl_current == &impl_threaded)
+      return task_workers_count;
+#endif
+   return 0;
+}
+
 bool task_queue_find(task_finder_data_t *find_data)
 {
    return impl_current->find(find_data->func, find_data->userdata);
@@ -662,7 +932,9 @@ void task_queue_check(void)
    bool current_threaded = (impl_current == &impl_threaded);
    bool want_threaded    = task_threaded_enable;
 
-   if (want_threaded != current_threaded)
+   /* Restart the worker pool if its size was changed */
+   if (     (want_threaded != current_threaded)
+         || (current_threaded && task_workers_changed))
       task_queue_deinit();
 
    if (!impl_current)
@@ -672,34 +944,18 @@ void task_queue_check(void)
    impl_current->gather();
 }
 
+static bool task_queue_is_blocking(retro_task_t *task, void *user_data)
+{
+   return task->type == TASK_TYPE_BLOCKING;
+}
+
 bool task_queue_push(retro_task_t *task)
 {
    /* Ignore this task if a related one is already running */
    if (task->type == TASK_TYPE_BLOCKING)
    {
-      retro_task_t *running = NULL;
-      bool            found = false;
-
-#ifdef HAVE_THREADS
-      slock_lock(queue_lock);
-#endif
-      running = tasks_running.front;
-
-      for (; running; running = running->next)
-      {
-         if (running->type == TASK_TYPE_BLOCKING)
-         {
-            found = true;
-            break;
-         }
-      }
-
-#ifdef HAVE_THREADS
-      slock_unlock(queue_lock);
-#endif
-
       /* skip this task, user must try again later */
-      if (found)
+      if (impl_current->find(task_queue_is_blocking, NULL))
          return false;
    }
 
@@ -980,9 +1236,11 @@ retro_task_t *task_init(void)
    task->progress_cb       = NULL;
    task->title             = NULL;
    task->type              = TASK_TYPE_NONE;
+   task->priority          = TASK_PRIORITY_INTERACTIVE;
    task->ident             = task_count++;
    task->frontend_userdata = NULL;
    task->alternative_look  = false;
+   task->parallel          = false;
    task->next              = NULL;
    task->when              = 0;
 
@@ -257,8 +257,12 @@ void tpool_wait(tpool_t *tp)
    {
       /* working_cond is dual use. It signals when we're not stopping but the
        * working_cnt is 0 indicating there isn't any work processing. If we
-       * are stopping it will trigger when there aren't any threads running. */
-      if ((!tp->stop && tp->working_cnt != 0) || (tp->stop && tp->thread_cnt != 0))
+       * are stopping it will trigger when there aren't any threads running.
+       *
+       * Work that was queued but not picked up by a thread yet counts as
+       * outstanding too, otherwise tpool_wait() right after tpool_add_work()
+       * could return before anything ran. */
+      if ((!tp->stop && (tp->working_cnt != 0 || tp->work_first)) || (tp->stop && tp->thread_cnt != 0))
          scond_wait(tp->working_cond, tp->work_mutex);
       else
          break;
@@ -641,6 +641,29 @@ bool intfstream_is_compressed(intfstream_internal_t *intf)
    return false;
 }
 
+bool intfstream_set_compression_threads(intfstream_internal_t *intf,
+      unsigned num_threads)
+{
+   if (!intf)
+      return false;
+
+   switch (intf->type)
+   {
+      case INTFSTREAM_FILE:
+      case INTFSTREAM_MEMORY:
+      case INTFSTREAM_CHD:
+         break;
+      case INTFSTREAM_RZIP:
+#if defined(HAVE_ZLIB)
+         return rzipstream_set_threads(intf->rzip.fp, num_threads);
+#else
+         break;
+#endif
+   }
+
+   return false;
+}
+
 bool intfstream_get_crc(intfstream_internal_t *intf, uint32_t *crc)
 {
    int64_t data_read    = 0;
@@ -28,6 +28,10 @@
 
 #include <streams/rzip_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 /* Current RZIP file format version */
 #define RZIP_VERSION 1
 
@@ -44,6 +48,44 @@
 #define RZIP_HEADER_SIZE 20
 #define RZIP_CHUNK_HEADER_SIZE 4
 
+/* Maximum number of compression threads
+ * of a stream */
+#define RZIP_MAX_THREADS 16
+
+#ifdef HAVE_THREADS
+/* Chunk handed over to the compression threads
+ * > Each chunk is compressed as a separate zlib
+ *   stream, so chunks can be compressed in any
+ *   order and written in file order, producing
+ *   the same file as single threaded compression */
+struct rzipstream_block
+{
+   uint8_t *in_buf;
+   uint8_t *out_buf;
+   uint32_t in_size;
+   uint32_t out_size; /* 0 if compression failed */
+   bool done;
+};
+
+struct rzipstream_workers
+{
+   sthread_t *threads[RZIP_MAX_THREADS];
+   slock_t *lock;
+   scond_t *work_cond;  /* Signalled when a chunk is queued */
+   scond_t *done_cond;  /* Signalled when a chunk is compressed */
+   /* Ring buffer of chunks, in file order */
+   struct rzipstream_block *blocks;
+   unsigned num_threads;
+   unsigned num_blocks;
+   unsigned head;       /* Next chunk to write to file */
+   unsigned count;      /* Chunks not yet written to file */
+   unsigned next_job;   /* Next chunk to compress */
+   unsigned pending;    /* Chunks not yet picked by a thread */
+   uint32_t out_buf_size;
+   bool quit;
+};
+#endif
+
 /* Holds all metadata for an RZIP file stream */
 struct rzipstream
 {
@@ -52,6 +94,9 @@ struct rzipstream
     * uncompressed data has been read */
    uint64_t virtual_ptr;
    RFILE* file;
+#ifdef HAVE_THREADS
+   struct rzipstream_workers *workers;
+#endif
    const struct trans_stream_backend *deflate_backend;
    void *deflate_stream;
    const struct trans_stream_backend *inflate_backend;
@@ -186,6 +231,319 @@ static bool rzipstream_write_file_header(rzipstream_t *stream)
          header_bytes, sizeof(header_bytes)) == RZIP_HEADER_SIZE);
 }
 
+/* Chunk Compression */
+
+/* Compresses 'in_size' bytes of 'in_buf' as a
+ * self-contained zlib stream.
+ * Returns compressed size, or 0 in the event
+ * of an error */
+static uint32_t rzipstream_deflate_chunk(
+      const struct trans_stream_backend *deflate_backend,
+      void *deflate_stream,
+      const uint8_t *in_buf, uint32_t in_size,
+      uint8_t *out_buf, uint32_t out_size)
+{
+   uint32_t deflate_read;
+   uint32_t deflate_written;
+
+   deflate_backend->set_in(deflate_stream, in_buf, in_size);
+   deflate_backend->set_out(deflate_stream, out_buf, out_size);
+
+   /* Note: We have to set 'flush == true' here, otherwise we
+    * can't guarantee that the entire chunk will be written
+    * to the output buffer - this is inefficient, but not
+    * much we can do... */
+   if (!deflate_backend->trans(deflate_stream, true,
+         &deflate_read, &deflate_written, NULL))
+      return 0;
+
+   /* Error checking */
+   if (deflate_read != in_size)
+      return 0;
+
+   if (deflate_written > out_size)
+      return 0;
+
+   return deflate_written;
+}
+
+/* Writes a compressed chunk, preceded by its
+ * size, to file */
+static bool rzipstream_write_compressed_chunk(rzipstream_t *stream,
+      const uint8_t *data, uint32_t size)
+{
+   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
+
+   if (size == 0)
+      return false;
+
+   /* Write compressed chunk size to file */
+   chunk_header_bytes[3] = (size >> 24) & 0xFF;
+   chunk_header_bytes[2] = (size >> 16) & 0xFF;
+   chunk_header_bytes[1] = (size >>  8) & 0xFF;
+   chunk_header_bytes[0] =  size        & 0xFF;
+
+   if (filestream_write(
+         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
+         RZIP_CHUNK_HEADER_SIZE)
+      return false;
+
+   /* Write compressed data to file */
+   return (filestream_write(stream->file, data, size) == size);
+}
+
+#ifdef HAVE_THREADS
+/* Compression Threads */
+
+static void rzipstream_worker_thread(void *data)
+{
+   struct rzipstream_workers *workers         = (struct rzipstream_workers*)data;
+   const struct trans_stream_backend *backend = trans_stream_get_zlib_deflate_backend();
+   void *deflate_stream                       = backend->stream_new();
+
+   if (deflate_stream && !backend->define(
+         deflate_stream, "level", RZIP_COMPRESSION_LEVEL))
+   {
+      backend->stream_free(deflate_stream);
+      deflate_stream = NULL;
+   }
+
+   slock_lock(workers->lock);
+
+   for (;;)
+   {
+      struct rzipstream_block *block;
+
+      while (!workers->quit && workers->pending == 0)
+         scond_wait(workers->work_cond, workers->lock);
+
+      if (workers->quit)
+         break;
+
+      block             = &workers->blocks[workers->next_job];
+      workers->next_job = (workers->next_job + 1) % workers->num_blocks;
+      workers->pending--;
+
+      slock_unlock(workers->lock);
+
+      block->out_size   = deflate_stream
+            ? rzipstream_deflate_chunk(backend, deflate_stream,
+                  block->in_buf, block->in_size,
+                  block->out_buf, workers->out_buf_size)
+            : 0;
+
+      slock_lock(workers->lock);
+      block->done       = true;
+      scond_broadcast(workers->done_cond);
+   }
+
+   slock_unlock(workers->lock);
+
+   if (deflate_stream)
+      backend->stream_free(deflate_stream);
+}
+
+/* Stops compression threads, discarding any
+ * chunk that has not been written to file */
+static void rzipstream_free_workers(rzipstream_t *stream)
+{
+   unsigned i;
+   struct rzipstream_workers *workers = stream->workers;
+
+   if (!workers)
+      return;
+
+   if (workers->lock)
+   {
+      slock_lock(workers->lock);
+      workers->quit = true;
+      if (workers->work_cond)
+         scond_broadcast(workers->work_cond);
+      slock_unlock(workers->lock);
+   }
+
+   for (i = 0; i < workers->num_threads; i++)
+      sthread_join(workers->threads[i]);
+
+   if (workers->blocks)
+   {
+      for (i = 0; i < workers->num_blocks; i++)
+      {
+         free(workers->blocks[i].in_buf);
+         free(workers->blocks[i].out_buf);
+      }
+      free(workers->blocks);
+   }
+
+   if (workers->done_cond)
+      scond_free(workers->done_cond);
+   if (workers->work_cond)
+      scond_free(workers->work_cond);
+   if (workers->lock)
+      slock_free(workers->lock);
+
+   free(workers);
+   stream->workers = NULL;
+}
+
+/* Writes compressed chunks to file, in order
+ * > If 'wait' is true, waits for all queued
+ *   chunks to be compressed, otherwise stops at
+ *   the first chunk still being compressed */
+static bool rzipstream_write_blocks(rzipstream_t *stream, bool wait)
+{
+   struct rzipstream_workers *workers = stream->workers;
+
+   slock_lock(workers->lock);
+
+   while (workers->count > 0)
+   {
+      bool ret;
+      struct rzipstream_block *block = &workers->blocks[workers->head];
+
+      if (!block->done)
+      {
+         if (!wait)
+            break;
+         scond_wait(workers->done_cond, workers->lock);
+         continue;
+      }
+
+      /* Chunks which are done are no longer
+       * touched by the threads */
+      slock_unlock(workers->lock);
+      ret = rzipstream_write_compressed_chunk(stream,
+            block->out_buf, block->out_size);
+      slock_lock(workers->lock);
+
+      if (!ret)
+      {
+         slock_unlock(workers->lock);
+         return false;
+      }
+
+      block->done    = false;
+      workers->head  = (workers->head + 1) % workers->num_blocks;
+      workers->count--;
+   }
+
+   slock_unlock(workers->lock);
+   return true;
+}
+
+/* Hands over the data currently cached in the
+ * input buffer to the compression threads */
+static bool rzipstream_queue_chunk(rzipstream_t *stream)
+{
+   uint8_t *in_buf;
+   struct rzipstream_block *block;
+   struct rzipstream_workers *workers = stream->workers;
+
+   /* Write whatever is already compressed, and
+    * wait for the oldest chunk if all are in use */
+   if (!rzipstream_write_blocks(stream, false))
+      return false;
+
+   slock_lock(workers->lock);
+   while (workers->count == workers->num_blocks)
+   {
+      slock_unlock(workers->lock);
+      if (!rzipstream_write_blocks(stream, false))
+         return false;
+      slock_lock(workers->lock);
+      if (     (workers->count == workers->num_blocks)
+            && !workers->blocks[workers->head].done)
+         scond_wait(workers->done_cond, workers->lock);
+   }
+
+   block                = &workers->blocks[
+      (workers->head + workers->count) % workers->num_blocks];
+
+   /* Swap buffers instead of copying the chunk */
+   in_buf               = block->in_buf;
+   block->in_buf        = stream->in_buf;
+   block->in_size       = stream->in_buf_ptr;
+   block->done          = false;
+   stream->in_buf       = in_buf;
+   stream->in_buf_ptr   = 0;
+
+   workers->count++;
+   workers->pending++;
+   scond_signal(workers->work_cond);
+   slock_unlock(workers->lock);
+
+   return true;
+}
+
+/* Compresses chunks on 'num_threads' threads
+ * while writing. Must be called before any data
+ * is written. Returns false if threads could not
+ * be started, in which case the stream keeps
+ * compressing on the calling thread */
+bool rzipstream_set_threads(rzipstream_t *stream, unsigned num_threads)
+{
+   unsigned i;
+   struct rzipstream_workers *workers = NULL;
+
+   if (     !stream
+         || !stream->is_writing
+         ||  stream->workers
+         || (stream->virtual_ptr > 0)
+         || (num_threads < 2))
+      return false;
+
+   if (num_threads > RZIP_MAX_THREADS)
+      num_threads = RZIP_MAX_THREADS;
+
+   if (!(workers = (struct rzipstream_workers*)calloc(1, sizeof(*workers))))
+      return false;
+
+   stream->workers       = workers;
+   /* Two chunks per thread, so that threads can
+    * keep compressing while chunks are queued
+    * and written */
+   workers->num_blocks   = num_threads * 2;
+   workers->out_buf_size = stream->out_buf_size;
+
+   if (!(workers->blocks = (struct rzipstream_block*)calloc(
+         workers->num_blocks, sizeof(*workers->blocks))))
+      goto error;
+
+   for (i = 0; i < workers->num_blocks; i++)
+   {
+      if (!(workers->blocks[i].in_buf  = (uint8_t*)malloc(stream->in_buf_size)))
+         goto error;
+      if (!(workers->blocks[i].out_buf = (uint8_t*)malloc(stream->out_buf_size)))
+         goto error;
+   }
+
+   if (  !(workers->lock      = slock_new())
+       || !(workers->work_cond = scond_new())
+       || !(workers->done_cond = scond_new()))
+      goto error;
+
+   for (i = 0; i < num_threads; i++)
+   {
+      if (!(workers->threads[i] = sthread_create(
+            rzipstream_worker_thread, workers)))
+         break;
+      workers->num_threads++;
+   }
+
+   if (workers->num_threads > 0)
+      return true;
+
+error:
+   rzipstream_free_workers(stream);
+   return false;
+}
+#else
+bool rzipstream_set_threads(rzipstream_t *stream, unsigned num_threads)
+{
+   return false;
+}
+#endif
+
 /* Stream Initialisation/De-initialisation */
 
 /* Initialises all members of an rzipstream_t struct,
@@ -336,6 +694,10 @@ static int rzipstream_free_stream(rzipstream_t *stream)
    if (!stream)
       return -1;
 
+#ifdef HAVE_THREADS
+   rzipstream_free_workers(stream);
+#endif
+
    /* Free transform streams */
    if (stream->deflate_stream && stream->deflate_backend)
       stream->deflate_backend->stream_free(stream->deflate_stream);
@@ -405,6 +767,9 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    stream->chunk_size      = 0;
    stream->virtual_ptr     = 0;
    stream->file            = NULL;
+#ifdef HAVE_THREADS
+   stream->workers         = NULL;
+#endif
    stream->deflate_backend = NULL;
    stream->deflate_stream  = NULL;
    stream->inflate_backend = NULL;
@@ -720,57 +1085,28 @@ error:
  * as the next RZIP file chunk */
 static bool rzipstream_write_chunk(rzipstream_t *stream)
 {
-   unsigned i;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
-   uint32_t deflate_read;
    uint32_t deflate_written;
 
-   if (!stream || !stream->deflate_backend || !stream->deflate_stream)
-      return false;
-
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
-
-   /* Compress data currently held in input buffer */
-   stream->deflate_backend->set_in(
-         stream->deflate_stream,
-         stream->in_buf, stream->in_buf_ptr);
-
-   stream->deflate_backend->set_out(
-         stream->deflate_stream,
-         stream->out_buf, stream->out_buf_size);
-
-   /* Note: We have to set 'flush == true' here, otherwise we
-    * can't guarantee that the entire chunk will be written
-    * to the output buffer - this is inefficient, but not
-    * much we can do... */
-   if (!stream->deflate_backend->trans(
-         stream->deflate_stream, true,
-         &deflate_read, &deflate_written, NULL))
+   if (!stream)
       return false;
 
-   /* Error checking */
-   if (deflate_read != stream->in_buf_ptr)
-      return false;
+#ifdef HAVE_THREADS
+   if (stream->workers)
+      return rzipstream_queue_chunk(stream);
+#endif
 
-   if ((deflate_written == 0) ||
-       (deflate_written > stream->out_buf_size))
+   if (!stream->deflate_backend || !stream->deflate_stream)
       return false;
 
-   /* Write compressed chunk size to file */
-   chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
-   chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
-   chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
-   chunk_header_bytes[0] =  deflate_written        & 0xFF;
-
-   if (filestream_write(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
-         RZIP_CHUNK_HEADER_SIZE)
+   /* Compress data currently held in input buffer */
+   if (!(deflate_written = rzipstream_deflate_chunk(
+         stream->deflate_backend, stream->deflate_stream,
+         stream->in_buf, stream->in_buf_ptr,
+         stream->out_buf, stream->out_buf_size)))
       return false;
 
-   /* Write compressed data to file */
-   if (filestream_write(
-         stream->file, stream->out_buf, deflate_written) != deflate_written)
+   if (!rzipstream_write_compressed_chunk(stream,
+         stream->out_buf, deflate_written))
       return false;
 
    /* Reset input buffer pointer */
@@ -940,6 +1276,13 @@ void rzipstream_rewind(rzipstream_t *stream)
    /* Check whether we are reading or writing */
    if (stream->is_writing)
    {
+#ifdef HAVE_THREADS
+      /* Chunks still being compressed would
+       * otherwise be written after the seek */
+      if (stream->workers && !rzipstream_write_blocks(stream, true))
+         return;
+#endif
+
       /* Reset file position to first chunk location */
       filestream_seek(stream->file, RZIP_HEADER_SIZE, SEEK_SET);
       if (filestream_error(stream->file))
@@ -1054,6 +1397,11 @@ int rzipstream_close(rzipstream_t *stream)
          if (!rzipstream_write_chunk(stream))
             goto error;
 
+#ifdef HAVE_THREADS
+      if (stream->workers && !rzipstream_write_blocks(stream, true))
+         goto error;
+#endif
+
       if (!rzipstream_write_file_header(stream))
          goto error;
    }
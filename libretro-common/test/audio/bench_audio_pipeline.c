@@ -0,0 +1,429 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_audio_pipeline.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Audio pipeline benchmark.
+ *
+ * Feeds 48 kHz stereo through the chain RetroArch runs on every
+ * audio flush: s16 to float with volume, resampler, mixer (one
+ * looping WAV voice) and float back to s16. Every resampler runs
+ * at a few ratios, twice:
+ *  - staged:  each stage walks the whole flush, reported in ns
+ *             per frame for every stage;
+ *  - blocked: all stages run on one small block at a time, as
+ *             audio_driver_flush() does, with the resampler
+ *             skipped when the ratio is exactly 1.0.
+ * Both runs must produce the same samples.
+ *
+ * Usage: bench_audio_pipeline [seconds] [flush_frames] [block_frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <audio/audio_mixer.h>
+#include <audio/audio_resampler.h>
+#include <audio/conversion/float_to_s16.h>
+#include <audio/conversion/s16_to_float.h>
+#include <features/features_cpu.h>
+#include <memalign.h>
+#include <retro_miscellaneous.h>
+
+#define BENCH_RATE   48000
+#define BENCH_STAGES 4
+
+typedef struct
+{
+   const char *name;
+   const retro_resampler_t *backend;
+   enum resampler_quality quality;
+} bench_resampler_t;
+
+static const char *bench_stage_names[BENCH_STAGES] = {
+   "s16->float", "resample", "mix", "float->s16"
+};
+
+static const double bench_ratios[] = {
+   1.0,                  /* Rates match, no rate control */
+   1.0 + 0.005,          /* Rates match, rate control at its limit */
+   44100.0 / BENCH_RATE  /* 48 kHz core on a 44.1 kHz device */
+};
+
+typedef struct
+{
+   const int16_t *input;
+   int16_t *output;
+   float *in_buf;
+   float *out_buf;
+   size_t frames;
+   size_t flush_frames;
+   size_t block_frames;
+   size_t out_max;
+} bench_ctx_t;
+
+/* The stages of one flush are shorter than the timer resolution,
+ * but the rounding errors average out over a run */
+static double bench_ns_per_frame(retro_time_t usec, size_t frames)
+{
+   return (double)usec * 1000.0 / frames;
+}
+
+/* Two detuned square-ish tones with some noise, like a chip
+ * tune core would output */
+static void bench_fill_input(int16_t *buf, size_t frames)
+{
+   size_t i;
+   uint32_t seed = 0x9e3779b9;
+
+   for (i = 0; i < frames; i++)
+   {
+      double t    = (double)i / BENCH_RATE;
+      double l    = 0.4 * sin(2.0 * M_PI * 440.0 * t)
+                  + 0.3 * (sin(2.0 * M_PI * 110.0 * t) > 0 ? 1.0 : -1.0);
+      double r    = 0.4 * sin(2.0 * M_PI * 443.0 * t)
+                  + 0.3 * (sin(2.0 * M_PI * 220.0 * t) > 0 ? 1.0 : -1.0);
+      seed        = seed * 1664525 + 1013904223;
+      buf[i * 2 + 0] = (int16_t)(l * 30000.0 + ((int32_t)(seed >> 20) - 2048));
+      buf[i * 2 + 1] = (int16_t)(r * 30000.0 + ((int32_t)(seed >> 20) - 2048));
+   }
+}
+
+/* A one second 48 kHz stereo WAV, played as a looping mixer voice */
+static void *bench_make_wav(int32_t *size)
+{
+   static const unsigned frames = BENCH_RATE;
+   uint32_t data_size           = frames * 4;
+   uint8_t *wav                 = (uint8_t*)malloc(44 + data_size);
+   int16_t *pcm                 = (int16_t*)(wav + 44);
+   unsigned i;
+
+   if (!wav)
+      return NULL;
+
+   memcpy(wav, "RIFF\0\0\0\0WAVEfmt ", 16);
+   wav[4]  = (uint8_t)((36 + data_size) >>  0);
+   wav[5]  = (uint8_t)((36 + data_size) >>  8);
+   wav[6]  = (uint8_t)((36 + data_size) >> 16);
+   wav[7]  = (uint8_t)((36 + data_size) >> 24);
+   wav[16] = 16; wav[17] = 0; wav[18] = 0; wav[19] = 0;
+   wav[20] = 1;  wav[21] = 0;                           /* PCM */
+   wav[22] = 2;  wav[23] = 0;                           /* Stereo */
+   wav[24] = BENCH_RATE & 0xff;  wav[25] = (BENCH_RATE >> 8) & 0xff;
+   wav[26] = 0;  wav[27] = 0;
+   wav[28] = (BENCH_RATE * 4) & 0xff;
+   wav[29] = ((BENCH_RATE * 4) >> 8) & 0xff;
+   wav[30] = ((BENCH_RATE * 4) >> 16) & 0xff;
+   wav[31] = 0;
+   wav[32] = 4;  wav[33] = 0;                           /* Block align */
+   wav[34] = 16; wav[35] = 0;                           /* Bits */
+   memcpy(wav + 36, "data", 4);
+   wav[40] = (uint8_t)(data_size >>  0);
+   wav[41] = (uint8_t)(data_size >>  8);
+   wav[42] = (uint8_t)(data_size >> 16);
+   wav[43] = (uint8_t)(data_size >> 24);
+
+   for (i = 0; i < frames; i++)
+   {
+      int16_t s      = (int16_t)(8000.0 * sin(2.0 * M_PI * 660.0 * i / BENCH_RATE));
+      pcm[i * 2 + 0] = s;
+      pcm[i * 2 + 1] = (int16_t)-s;
+   }
+
+   *size = 44 + data_size;
+   return wav;
+}
+
+/* The SIMD float to s16 loops round while the scalar tail
+ * truncates, and block boundaries move which samples end up in
+ * the tail: allow one LSB, anything more is a real difference */
+static bool bench_outputs_match(const int16_t *a, const int16_t *b,
+      size_t frames)
+{
+   size_t i;
+   for (i = 0; i < frames * 2; i++)
+      if (abs(a[i] - b[i]) > 1)
+         return false;
+   return true;
+}
+
+/* Returns the number of output frames, or 0 on overflow */
+static size_t bench_run_staged(bench_ctx_t *ctx,
+      const bench_resampler_t *rs, double ratio, retro_time_t *stage_us)
+{
+   size_t pos;
+   size_t out_frames = 0;
+   void *re          = rs->backend->init(NULL, 1.0, rs->quality,
+         (resampler_simd_mask_t)cpu_features_get());
+
+   if (!re)
+      return 0;
+
+   for (pos = 0; pos < ctx->frames; pos += ctx->flush_frames)
+   {
+      struct resampler_data src_data;
+      retro_time_t t0, t1, t2, t3, t4;
+      size_t frames = MIN(ctx->flush_frames, ctx->frames - pos);
+
+      if (out_frames + frames * 2 + 16 > ctx->out_max)
+         break;
+
+      t0 = cpu_features_get_time_usec();
+      convert_s16_to_float(ctx->in_buf, ctx->input + pos * 2,
+            frames * 2, 0.8f);
+      t1 = cpu_features_get_time_usec();
+
+      src_data.data_in       = ctx->in_buf;
+      src_data.data_out      = ctx->out_buf;
+      src_data.input_frames  = frames;
+      src_data.output_frames = 0;
+      src_data.ratio         = ratio;
+      rs->backend->process(re, &src_data);
+      t2 = cpu_features_get_time_usec();
+
+      audio_mixer_mix(ctx->out_buf, src_data.output_frames, 0.5f, true);
+      t3 = cpu_features_get_time_usec();
+
+      convert_float_to_s16(ctx->output + out_frames * 2, ctx->out_buf,
+            src_data.output_frames * 2);
+      t4 = cpu_features_get_time_usec();
+
+      stage_us[0] += t1 - t0;
+      stage_us[1] += t2 - t1;
+      stage_us[2] += t3 - t2;
+      stage_us[3] += t4 - t3;
+      out_frames  += src_data.output_frames;
+   }
+
+   rs->backend->free(re);
+   return out_frames;
+}
+
+static size_t bench_run_blocked(bench_ctx_t *ctx,
+      const bench_resampler_t *rs, double ratio, bool passthrough,
+      retro_time_t *total_us)
+{
+   size_t pos;
+   size_t out_frames = 0;
+   void *re          = rs->backend->init(NULL, 1.0, rs->quality,
+         (resampler_simd_mask_t)cpu_features_get());
+
+   if (!re)
+      return 0;
+
+   for (pos = 0; pos < ctx->frames; pos += ctx->flush_frames)
+   {
+      size_t i;
+      size_t flush_out = 0;
+      size_t frames    = MIN(ctx->flush_frames, ctx->frames - pos);
+      retro_time_t t0;
+
+      if (out_frames + frames * 2 + 16 > ctx->out_max)
+         break;
+
+      t0 = cpu_features_get_time_usec();
+
+      for (i = 0; i < frames; i += ctx->block_frames)
+      {
+         struct resampler_data src_data;
+         size_t block   = MIN(ctx->block_frames, frames - i);
+         float *out     = ctx->out_buf + flush_out * 2;
+
+         src_data.data_in       = ctx->in_buf;
+         src_data.data_out      = out;
+         src_data.input_frames  = block;
+         src_data.output_frames = 0;
+         src_data.ratio         = ratio;
+
+         if (passthrough)
+         {
+            convert_s16_to_float(out, ctx->input + (pos + i) * 2,
+                  block * 2, 0.8f);
+            src_data.output_frames = block;
+         }
+         else
+         {
+            convert_s16_to_float(ctx->in_buf, ctx->input + (pos + i) * 2,
+                  block * 2, 0.8f);
+            rs->backend->process(re, &src_data);
+         }
+
+         audio_mixer_mix(out, src_data.output_frames, 0.5f, true);
+         convert_float_to_s16(ctx->output + (out_frames + flush_out) * 2,
+               out, src_data.output_frames * 2);
+         flush_out += src_data.output_frames;
+      }
+
+      *total_us  += cpu_features_get_time_usec() - t0;
+      out_frames += flush_out;
+   }
+
+   rs->backend->free(re);
+   return out_frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j, k;
+   bench_ctx_t ctx;
+   int32_t wav_size            = 0;
+   void *wav                   = NULL;
+   audio_mixer_sound_t *sound  = NULL;
+   int16_t *reference          = NULL;
+   int16_t *blocked            = NULL;
+   unsigned seconds            = (argc > 1) ? (unsigned)atoi(argv[1]) : 10;
+   bool ok                     = true;
+   bench_resampler_t resamplers[4];
+   unsigned num_resamplers     = 0;
+
+   memset(&ctx, 0, sizeof(ctx));
+   ctx.flush_frames            = (argc > 2) ? (size_t)atoi(argv[2]) : 800;
+   ctx.block_frames            = (argc > 3) ? (size_t)atoi(argv[3]) : 256;
+   ctx.frames                  = (size_t)seconds * BENCH_RATE;
+
+   if (!ctx.frames || !ctx.flush_frames || !ctx.block_frames)
+      return 1;
+
+   resamplers[num_resamplers].name    = "sinc";
+   resamplers[num_resamplers].backend = &sinc_resampler;
+   resamplers[num_resamplers].quality = RESAMPLER_QUALITY_NORMAL;
+   num_resamplers++;
+   resamplers[num_resamplers].name    = "sinc-low";
+   resamplers[num_resamplers].backend = &sinc_resampler;
+   resamplers[num_resamplers].quality = RESAMPLER_QUALITY_LOWER;
+   num_resamplers++;
+#ifdef HAVE_CC_RESAMPLER
+   resamplers[num_resamplers].name    = "cc";
+   resamplers[num_resamplers].backend = &CC_resampler;
+   resamplers[num_resamplers].quality = RESAMPLER_QUALITY_DONTCARE;
+   num_resamplers++;
+#endif
+   resamplers[num_resamplers].name    = "nearest";
+   resamplers[num_resamplers].backend = &nearest_resampler;
+   resamplers[num_resamplers].quality = RESAMPLER_QUALITY_DONTCARE;
+   num_resamplers++;
+
+   /* Worst case is the flush at 1.005 plus what resamplers hold back */
+   ctx.out_max   = ctx.frames * 2 + 1024;
+   ctx.input     = (int16_t*)malloc(ctx.frames * 2 * sizeof(int16_t));
+   blocked       = (int16_t*)malloc(ctx.out_max * 2 * sizeof(int16_t));
+   reference     = (int16_t*)malloc(ctx.out_max * 2 * sizeof(int16_t));
+   ctx.in_buf    = (float*)memalign_alloc(64,
+         MAX(ctx.flush_frames, ctx.block_frames) * 2 * sizeof(float));
+   ctx.out_buf   = (float*)memalign_alloc(64,
+         (ctx.flush_frames * 2 + 64) * 2 * sizeof(float));
+
+   if (!ctx.input || !blocked || !reference || !ctx.in_buf || !ctx.out_buf)
+      return 1;
+
+   bench_fill_input((int16_t*)ctx.input, ctx.frames);
+
+   convert_s16_to_float_init_simd();
+   convert_float_to_s16_init_simd();
+   audio_mixer_init(BENCH_RATE);
+
+   if (     !(wav   = bench_make_wav(&wav_size))
+         || !(sound = audio_mixer_load_wav(wav, wav_size, NULL,
+               RESAMPLER_QUALITY_DONTCARE)))
+   {
+      fprintf(stderr, "Failed to create the mixer voice.\n");
+      return 1;
+   }
+
+   printf("[bench_audio_pipeline] %u s of 48 kHz stereo, flush: %u frames, "
+         "block: %u frames\n", seconds, (unsigned)ctx.flush_frames,
+         (unsigned)ctx.block_frames);
+   printf("[bench_audio_pipeline] %-9s %-7s", "resampler", "ratio");
+   for (k = 0; k < BENCH_STAGES; k++)
+      printf(" %10s", bench_stage_names[k]);
+   printf(" %10s %10s  (ns/frame)\n", "staged", "blocked");
+
+   for (i = 0; i < num_resamplers; i++)
+   {
+      for (j = 0; j < ARRAY_SIZE(bench_ratios); j++)
+      {
+         audio_mixer_voice_t *voice;
+         retro_time_t stage_us[BENCH_STAGES] = {0};
+         retro_time_t staged_us              = 0;
+         retro_time_t blocked_us             = 0;
+         bool passthrough                    = bench_ratios[j] == 1.0;
+         size_t ref_frames, out_frames;
+         const char *match;
+
+         voice      = audio_mixer_play(sound, true, 1.0f, NULL,
+               RESAMPLER_QUALITY_DONTCARE, NULL);
+         ctx.output = reference;
+         ref_frames = bench_run_staged(&ctx, &resamplers[i],
+               bench_ratios[j], stage_us);
+         audio_mixer_stop(voice);
+
+         voice      = audio_mixer_play(sound, true, 1.0f, NULL,
+               RESAMPLER_QUALITY_DONTCARE, NULL);
+         ctx.output = blocked;
+         out_frames = bench_run_blocked(&ctx, &resamplers[i],
+               bench_ratios[j], false, &blocked_us);
+         audio_mixer_stop(voice);
+
+         match = (ref_frames && ref_frames == out_frames
+               && bench_outputs_match(reference, ctx.output, ref_frames))
+            ? "ok" : "MISMATCH";
+         if (*match == 'M')
+            ok = false;
+
+         for (k = 0; k < BENCH_STAGES; k++)
+            staged_us += stage_us[k];
+
+         printf("[bench_audio_pipeline] %-9s %-7.4f", resamplers[i].name,
+               bench_ratios[j]);
+         for (k = 0; k < BENCH_STAGES; k++)
+            printf(" %10.3f", bench_ns_per_frame(stage_us[k], ctx.frames));
+         printf(" %10.3f %10.3f  %s\n",
+               bench_ns_per_frame(staged_us, ctx.frames),
+               bench_ns_per_frame(blocked_us, ctx.frames), match);
+
+         /* With matching rates and no rate control, the
+          * resampler is skipped entirely */
+         if (passthrough && i == 0)
+         {
+            blocked_us = 0;
+            voice      = audio_mixer_play(sound, true, 1.0f, NULL,
+                  RESAMPLER_QUALITY_DONTCARE, NULL);
+            bench_run_blocked(&ctx, &resamplers[i], 1.0, true, &blocked_us);
+            audio_mixer_stop(voice);
+            printf("[bench_audio_pipeline] %-9s %-7.4f %54s %10.3f\n",
+                  "bypass", 1.0, "",
+                  bench_ns_per_frame(blocked_us, ctx.frames));
+         }
+      }
+   }
+
+   audio_mixer_destroy(sound);
+   audio_mixer_done();
+   free(wav);
+   free((void*)ctx.input);
+   free(reference);
+   free(blocked);
+   memalign_free(ctx.in_buf);
+   memalign_free(ctx.out_buf);
+
+   return ok ? 0 : 1;
+}
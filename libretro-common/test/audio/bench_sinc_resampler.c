@@ -0,0 +1,297 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_sinc_resampler.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Sinc resampler benchmark.
+ *
+ * Runs every sinc quality level on common core to device rate
+ * pairs, at the nominal ratio and with rate control holding the
+ * ratio slightly off (which the polyphase level handles with
+ * interpolated phases). For each run, reports the time per
+ * output frame and the THD+N of a 1 kHz and a 12 kHz tone,
+ * measured with a four parameter sine fit on the output.
+ *
+ * Usage: bench_sinc_resampler [seconds] [simd]
+ *
+ * 'simd' set to 0 forces the C kernels, e.g. to compare with
+ * targets that don't have SSE or NEON.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <audio/audio_resampler.h>
+#include <features/features_cpu.h>
+#include <retro_miscellaneous.h>
+
+#define BENCH_FLUSH_FRAMES 800
+#define BENCH_FIT_SKIP     8192
+#define BENCH_FIT_FRAMES   16384
+
+typedef struct
+{
+   const char *name;
+   enum resampler_quality quality;
+} bench_quality_t;
+
+static const bench_quality_t bench_qualities[] = {
+   { "lower",     RESAMPLER_QUALITY_LOWER     },
+   { "normal",    RESAMPLER_QUALITY_NORMAL    },
+   { "higher",    RESAMPLER_QUALITY_HIGHER    },
+   { "highest",   RESAMPLER_QUALITY_HIGHEST   },
+   { "polyphase", RESAMPLER_QUALITY_POLYPHASE }
+};
+
+static const unsigned bench_rates[][2] = {
+   { 32040, 48000 },  /* SNES */
+   { 44100, 48000 },
+   { 48000, 44100 }
+};
+
+/* 0.3% off: well inside the default rate control delta */
+static const double bench_drifts[] = { 1.0, 1.003 };
+
+/* Solves the 4x4 system m.x = v in place, Gaussian elimination */
+static void bench_solve4(double m[4][4], double v[4])
+{
+   int i, j, k;
+
+   for (i = 0; i < 4; i++)
+   {
+      int pivot = i;
+      for (j = i + 1; j < 4; j++)
+         if (fabs(m[j][i]) > fabs(m[pivot][i]))
+            pivot = j;
+      for (k = 0; k < 4; k++)
+      {
+         double t    = m[i][k];
+         m[i][k]     = m[pivot][k];
+         m[pivot][k] = t;
+      }
+      {
+         double t = v[i];
+         v[i]     = v[pivot];
+         v[pivot] = t;
+      }
+      for (j = i + 1; j < 4; j++)
+      {
+         double f = m[j][i] / m[i][i];
+         for (k = i; k < 4; k++)
+            m[j][k] -= f * m[i][k];
+         v[j] -= f * v[i];
+      }
+   }
+
+   for (i = 3; i >= 0; i--)
+   {
+      for (k = i + 1; k < 4; k++)
+         v[i] -= m[i][k] * v[k];
+      v[i] /= m[i][i];
+   }
+}
+
+/* THD+N in dB of the left channel: fits a.cos(wn) + b.sin(wn) + c,
+ * refining w (IEEE 1057 four parameter fit), everything that isn't
+ * the fitted tone counts as distortion and noise */
+static double bench_thd_n(const float *out, size_t frames, double w)
+{
+   int iter;
+   size_t n;
+   double a = 0.0, b = 0.0, c = 0.0;
+   double signal, residual = 0.0;
+
+   for (iter = 0; iter < 8; iter++)
+   {
+      double m[4][4] = {{0}};
+      double v[4]    = {0};
+
+      for (n = 0; n < frames; n++)
+      {
+         int i, j;
+         double x    = out[n * 2];
+         double co   = cos(w * n);
+         double si   = sin(w * n);
+         double d[4];
+
+         d[0] = co;
+         d[1] = si;
+         d[2] = 1.0;
+         d[3] = n * (b * co - a * si);
+         x   -= (iter ? (a * co + b * si + c) : 0.0);
+         if (!iter)
+            d[3] = 0.0;
+
+         for (i = 0; i < 4; i++)
+         {
+            for (j = 0; j < 4; j++)
+               m[i][j] += d[i] * d[j];
+            v[i] += d[i] * x;
+         }
+      }
+
+      if (!iter)
+      {
+         /* Plain three parameter fit to get started */
+         m[3][3] = 1.0;
+         bench_solve4(m, v);
+         a = v[0];
+         b = v[1];
+         c = v[2];
+      }
+      else
+      {
+         bench_solve4(m, v);
+         a += v[0];
+         b += v[1];
+         c += v[2];
+         w += v[3];
+      }
+   }
+
+   for (n = 0; n < frames; n++)
+   {
+      double e  = out[n * 2] - (a * cos(w * n) + b * sin(w * n) + c);
+      residual += e * e;
+   }
+
+   signal = (a * a + b * b) / 2.0 * frames;
+   if (residual <= 0.0)
+      return -200.0;
+   return 10.0 * log10(residual / signal);
+}
+
+/* Returns the number of output frames */
+static size_t bench_resample(const retro_resampler_t *backend, void *re,
+      const float *input, size_t frames, float *output, double ratio,
+      retro_time_t *elapsed)
+{
+   size_t pos;
+   size_t out_frames = 0;
+   retro_time_t t0   = cpu_features_get_time_usec();
+
+   for (pos = 0; pos < frames; pos += BENCH_FLUSH_FRAMES)
+   {
+      struct resampler_data src_data;
+
+      src_data.data_in       = input + pos * 2;
+      src_data.data_out      = output + out_frames * 2;
+      src_data.input_frames  = MIN(BENCH_FLUSH_FRAMES, frames - pos);
+      src_data.output_frames = 0;
+      src_data.ratio         = ratio;
+      backend->process(re, &src_data);
+      out_frames            += src_data.output_frames;
+   }
+
+   *elapsed += cpu_features_get_time_usec() - t0;
+   return out_frames;
+}
+
+static void bench_fill_tone(float *buf, size_t frames, double freq,
+      unsigned rate)
+{
+   size_t i;
+   for (i = 0; i < frames; i++)
+      buf[i * 2] = buf[i * 2 + 1] = (float)(0.5 * sin(2.0 * M_PI * freq * i / rate));
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j, k;
+   float *input                = NULL;
+   float *output               = NULL;
+   unsigned seconds            = (argc > 1) ? (unsigned)atoi(argv[1]) : 5;
+   bool simd                   = (argc > 2) ? atoi(argv[2]) != 0 : true;
+   resampler_simd_mask_t mask  = simd ? (resampler_simd_mask_t)cpu_features_get() : 0;
+   size_t max_frames           = (size_t)MAX(seconds, 1) * 48000;
+
+   input  = (float*)malloc(max_frames * 2 * sizeof(float));
+   output = (float*)malloc((max_frames * 2 + 4096) * 2 * sizeof(float));
+   if (!input || !output)
+      return 1;
+
+   printf("[bench_sinc_resampler] %u s per run, %s kernels\n",
+         MAX(seconds, 1), simd ? "SIMD" : "C");
+   printf("[bench_sinc_resampler] %-9s %-13s %-6s %10s %10s %10s\n",
+         "quality", "rates", "drift", "ns/frame", "thd+n@1k", "thd+n@12k");
+
+   for (i = 0; i < ARRAY_SIZE(bench_rates); i++)
+   {
+      unsigned in_rate   = bench_rates[i][0];
+      unsigned out_rate  = bench_rates[i][1];
+      double ratio       = (double)out_rate / in_rate;
+      size_t frames      = (size_t)MAX(seconds, 1) * in_rate;
+
+      for (j = 0; j < ARRAY_SIZE(bench_qualities); j++)
+      {
+         for (k = 0; k < ARRAY_SIZE(bench_drifts); k++)
+         {
+            unsigned t;
+            double thd[2];
+            static const double tones[2] = { 1000.0, 12000.0 };
+            retro_time_t best  = 0;
+            size_t out_frames  = 0;
+            double run_ratio   = ratio * bench_drifts[k];
+
+            for (t = 0; t < 2; t++)
+            {
+               unsigned rep;
+
+               bench_fill_tone(input, frames, tones[t], in_rate);
+
+               /* Best of a few runs for the timing */
+               for (rep = 0; rep < (t ? 1 : 3); rep++)
+               {
+                  retro_time_t elapsed = 0;
+                  void *re             = sinc_resampler.init(NULL, ratio,
+                        bench_qualities[j].quality, mask);
+
+                  if (!re)
+                     return 1;
+
+                  out_frames = bench_resample(&sinc_resampler, re, input,
+                        frames, output, run_ratio, &elapsed);
+                  sinc_resampler.free(re);
+
+                  if (!t && (!best || elapsed < best))
+                     best = elapsed;
+               }
+
+               thd[t] = (out_frames > BENCH_FIT_SKIP + BENCH_FIT_FRAMES)
+                  ? bench_thd_n(output + BENCH_FIT_SKIP * 2,
+                        BENCH_FIT_FRAMES,
+                        2.0 * M_PI * tones[t] / in_rate / run_ratio)
+                  : 0.0;
+            }
+
+            printf("[bench_sinc_resampler] %-9s %5u->%-6u %-6.3f %10.3f %8.1f dB %7.1f dB\n",
+                  bench_qualities[j].name, in_rate, out_rate,
+                  bench_drifts[k], (double)best * 1000.0 / out_frames,
+                  thd[0], thd[1]);
+         }
+      }
+   }
+
+   free(input);
+   free(output);
+   return 0;
+}
@@ -0,0 +1,520 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_rpng.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* PNG decoder benchmark.
+ *
+ * Checks the reverse filters of rpng against the byte at a time
+ * loops on random scanlines, then decodes a corpus of PNG files
+ * and reports megapixels per second on one thread and with
+ * several threads decoding different images at once, the way
+ * image tasks run on the task queue workers.
+ *
+ * The corpus is every .png under 'directory' (a checkout of
+ * libretro-thumbnails, say), up to 1000 files. Without one, a
+ * synthetic corpus of RGB and RGBA images is encoded first, and
+ * the decoded pixels are checked against the originals.
+ *
+ * 'make bench' also builds this with RPNG_NO_SIMD, which gives
+ * the numbers of the scalar decoder to compare with.
+ *
+ * Usage: bench_rpng [directory] [threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+/* The reverse filters are used directly */
+#include "../../formats/png/rpng.c"
+
+#if defined(RPNG_SIMD_SSE2)
+#define BENCH_KERNELS "sse2"
+#elif defined(RPNG_SIMD_NEON)
+#define BENCH_KERNELS "neon"
+#else
+#define BENCH_KERNELS "scalar"
+#endif
+
+#define BENCH_MAX_THREADS 16
+#define BENCH_MAX_FILES   1000
+
+struct bench_image
+{
+   uint8_t *png;
+   uint32_t *pixels; /* Original pixels of synthetic images */
+   size_t len;
+   unsigned width;
+   unsigned height;
+};
+
+struct bench_corpus
+{
+   struct bench_image *images;
+   size_t count;
+   size_t capacity;
+};
+
+struct bench_worker
+{
+   struct bench_corpus *corpus;
+   slock_t *lock;
+   size_t *next;
+   bool ok;
+};
+
+/* The reverse filters as they were, one byte at a time */
+static void bench_filter_bytewise(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp, unsigned filter)
+{
+   unsigned i;
+
+   memcpy(out, in, pitch);
+
+   switch (filter)
+   {
+      case PNG_FILTER_SUB:
+         for (i = bpp; i < pitch; i++)
+            out[i] += out[i - bpp];
+         break;
+      case PNG_FILTER_UP:
+         for (i = 0; i < pitch; i++)
+            out[i] += prev[i];
+         break;
+      case PNG_FILTER_AVERAGE:
+         for (i = 0; i < bpp; i++)
+            out[i] += prev[i] >> 1;
+         for (i = bpp; i < pitch; i++)
+            out[i] += (out[i - bpp] + prev[i]) >> 1;
+         break;
+      case PNG_FILTER_PAETH:
+         for (i = 0; i < bpp; i++)
+            out[i] += prev[i];
+         for (i = bpp; i < pitch; i++)
+            out[i] += paeth(out[i - bpp], prev[i], prev[i - bpp]);
+         break;
+   }
+}
+
+static bool bench_check_filters(void)
+{
+   unsigned bpp, filter, width, i;
+   uint8_t in[4 * 67], prev[4 * 67], expected[4 * 67], out[4 * 67];
+   uint32_t seed = 1;
+
+   for (bpp = 1; bpp <= 4; bpp++)
+   {
+      for (filter = PNG_FILTER_NONE; filter <= PNG_FILTER_PAETH; filter++)
+      {
+         for (width = 1; width <= 67; width++)
+         {
+            unsigned pitch = width * bpp;
+
+            for (i = 0; i < pitch; i++)
+            {
+               seed    = seed * 1103515245 + 12345;
+               in[i]   = (uint8_t)(seed >> 16);
+               seed    = seed * 1103515245 + 12345;
+               prev[i] = (uint8_t)(seed >> 16);
+            }
+
+            bench_filter_bytewise(expected, in, prev, pitch, bpp, filter);
+            rpng_reverse_filter_line(out, in, prev, pitch, bpp, filter);
+
+            if (memcmp(out, expected, pitch))
+            {
+               printf("[bench_rpng] filter %u MISMATCH at %u bytes per "
+                     "pixel, width %u\n", filter, bpp, width);
+               return false;
+            }
+         }
+      }
+   }
+
+   return true;
+}
+
+static void bench_filters(void)
+{
+   static const char *names[] = { "none", "sub", "up", "average", "paeth" };
+   unsigned bpp, filter, rep;
+   unsigned pitch = 4 * 1024;
+   uint8_t *in    = (uint8_t*)malloc(pitch);
+   uint8_t *prev  = (uint8_t*)malloc(pitch);
+   uint8_t *out   = (uint8_t*)malloc(pitch);
+
+   if (!in || !prev || !out)
+      goto end;
+
+   for (rep = 0; rep < pitch; rep++)
+   {
+      in[rep]   = (uint8_t)((rep * 2654435761U) >> 13);
+      prev[rep] = (uint8_t)((rep * 40503U) >> 7);
+   }
+
+   for (bpp = 3; bpp <= 4; bpp++)
+   {
+      unsigned len = (pitch / bpp) * bpp;
+
+      for (filter = PNG_FILTER_NONE; filter <= PNG_FILTER_PAETH; filter++)
+      {
+         retro_time_t t0, bytewise, kernel;
+
+         t0       = cpu_features_get_time_usec();
+         for (rep = 0; rep < 4096; rep++)
+            bench_filter_bytewise(out, in, prev, len, bpp, filter);
+         bytewise = cpu_features_get_time_usec() - t0;
+
+         t0       = cpu_features_get_time_usec();
+         for (rep = 0; rep < 4096; rep++)
+            rpng_reverse_filter_line(out, in, prev, len, bpp, filter);
+         kernel   = cpu_features_get_time_usec() - t0;
+
+         printf("[bench_rpng] %u bpp %-7s bytewise %7.2f GB/s, "
+               BENCH_KERNELS " %7.2f GB/s\n",
+               bpp, names[filter],
+               (double)len * 4096 / (bytewise * 1000.0),
+               (double)len * 4096 / (kernel * 1000.0));
+      }
+   }
+
+end:
+   free(in);
+   free(prev);
+   free(out);
+}
+
+static struct bench_image *bench_corpus_add(struct bench_corpus *corpus)
+{
+   if (corpus->count == corpus->capacity)
+   {
+      size_t capacity            = corpus->capacity ? corpus->capacity * 2 : 64;
+      struct bench_image *images = (struct bench_image*)realloc(
+            corpus->images, capacity * sizeof(*images));
+
+      if (!images)
+         return NULL;
+
+      corpus->images   = images;
+      corpus->capacity = capacity;
+   }
+
+   memset(&corpus->images[corpus->count], 0, sizeof(struct bench_image));
+   return &corpus->images[corpus->count++];
+}
+
+static void bench_corpus_scan(struct bench_corpus *corpus, const char *dir)
+{
+   struct dirent *ent;
+   DIR *d = opendir(dir);
+
+   if (!d)
+      return;
+
+   while ((ent = readdir(d)) && corpus->count < BENCH_MAX_FILES)
+   {
+      char path[PATH_MAX_LENGTH];
+      struct stat st;
+
+      if (ent->d_name[0] == '.')
+         continue;
+
+      snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+
+      if (stat(path, &st) != 0)
+         continue;
+
+      if (S_ISDIR(st.st_mode))
+         bench_corpus_scan(corpus, path);
+      else if (string_ends_with(ent->d_name, ".png"))
+      {
+         void *buf   = NULL;
+         int64_t len = 0;
+         struct bench_image *image;
+
+         if (     !filestream_read_file(path, &buf, &len)
+               || !(image = bench_corpus_add(corpus)))
+         {
+            free(buf);
+            continue;
+         }
+
+         image->png = (uint8_t*)buf;
+         image->len = (size_t)len;
+      }
+   }
+
+   closedir(d);
+}
+
+/* Boxart-like content: gradients, flat areas, text-like edges
+ * and some noise, so that the encoder uses every filter */
+static bool bench_corpus_synthesize(struct bench_corpus *corpus)
+{
+   static const char *path = "/tmp/bench_rpng.png";
+   unsigned n;
+   uint32_t seed = 7;
+
+   for (n = 0; n < 24; n++)
+   {
+      unsigned x, y;
+      void *buf                 = NULL;
+      int64_t len               = 0;
+      bool alpha                = (n & 1);
+      unsigned width            = 512 + (n % 4) * 64 + n;
+      unsigned height           = 512 + (n % 3) * 96;
+      struct bench_image *image = bench_corpus_add(corpus);
+      uint8_t *bgr              = NULL;
+      bool saved;
+
+      if (!image || !(image->pixels = (uint32_t*)malloc(
+                  width * height * sizeof(uint32_t))))
+         return false;
+
+      image->width  = width;
+      image->height = height;
+
+      for (y = 0; y < height; y++)
+      {
+         for (x = 0; x < width; x++)
+         {
+            uint32_t r, g, b, a;
+
+            seed = seed * 1103515245 + 12345;
+
+            if (((x / 32) + (y / 48) + n) % 5 == 0)
+            {
+               r = 0x20;
+               g = 0x40;
+               b = 0x80;
+            }
+            else
+            {
+               r = (x * 255) / width;
+               g = (y * 255) / height;
+               b = ((x + y) ^ (n * 37)) & 0xff;
+               if (((x / 4) ^ (y / 6)) % 7 == 0)
+                  r = g = b = 0xf0;
+               r = (r + ((seed >> 16) & 7)) & 0xff;
+            }
+
+            a = alpha ? ((x + y * 3) & 0xff) : 0xff;
+
+            image->pixels[y * width + x] = (a << 24) | (r << 16)
+               | (g << 8) | b;
+         }
+      }
+
+      if (alpha)
+         saved = rpng_save_image_argb(path, image->pixels, width, height,
+               width * sizeof(uint32_t));
+      else
+      {
+         if (!(bgr = (uint8_t*)malloc(width * height * 3)))
+            return false;
+
+         for (x = 0; x < width * height; x++)
+         {
+            bgr[x * 3 + 0] = (uint8_t)(image->pixels[x] >>  0);
+            bgr[x * 3 + 1] = (uint8_t)(image->pixels[x] >>  8);
+            bgr[x * 3 + 2] = (uint8_t)(image->pixels[x] >> 16);
+         }
+
+         saved = rpng_save_image_bgr24(path, bgr, width, height, width * 3);
+         free(bgr);
+      }
+
+      if (!saved || !filestream_read_file(path, &buf, &len))
+         return false;
+
+      image->png = (uint8_t*)buf;
+      image->len = (size_t)len;
+   }
+
+   filestream_delete(path);
+   return true;
+}
+
+static bool bench_decode(struct bench_image *image, uint64_t *pixels)
+{
+   int ret;
+   unsigned width   = 0;
+   unsigned height  = 0;
+   uint32_t *data   = NULL;
+   rpng_t *rpng     = rpng_alloc();
+   bool ok          = false;
+
+   if (     !rpng
+         || !rpng_set_buf_ptr(rpng, image->png, image->len)
+         || !rpng_start(rpng))
+      goto end;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto end;
+
+   do
+   {
+      ret = rpng_process_image(rpng, (void**)&data, image->len,
+            &width, &height);
+   } while (ret == IMAGE_PROCESS_NEXT);
+
+   if (ret != IMAGE_PROCESS_END)
+      goto end;
+
+   ok       = true;
+   *pixels += (uint64_t)width * height;
+
+   if (image->pixels)
+      ok = (width == image->width) && (height == image->height)
+         && !memcmp(data, image->pixels, width * height * sizeof(uint32_t));
+
+end:
+   free(data);
+   rpng_free(rpng);
+   return ok;
+}
+
+static void bench_worker_thread(void *data)
+{
+   struct bench_worker *worker = (struct bench_worker*)data;
+
+   for (;;)
+   {
+      size_t i;
+      uint64_t pixels = 0;
+
+      slock_lock(worker->lock);
+      i = (*worker->next)++;
+      slock_unlock(worker->lock);
+
+      if (i >= worker->corpus->count)
+         break;
+
+      if (!bench_decode(&worker->corpus->images[i], &pixels))
+         worker->ok = false;
+   }
+}
+
+static bool bench_threaded(struct bench_corpus *corpus, unsigned threads)
+{
+   unsigned i;
+   size_t next = 0;
+   bool ok     = true;
+   sthread_t *thread[BENCH_MAX_THREADS];
+   struct bench_worker workers[BENCH_MAX_THREADS];
+   slock_t *lock = slock_new();
+
+   if (!lock)
+      return false;
+
+   for (i = 0; i < threads; i++)
+   {
+      workers[i].corpus = corpus;
+      workers[i].lock   = lock;
+      workers[i].next   = &next;
+      workers[i].ok     = true;
+      thread[i]         = sthread_create(bench_worker_thread, &workers[i]);
+   }
+
+   for (i = 0; i < threads; i++)
+   {
+      sthread_join(thread[i]);
+      ok = ok && workers[i].ok;
+   }
+
+   slock_free(lock);
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   retro_time_t t0, single, multi;
+   struct bench_corpus corpus = {0};
+   uint64_t pixels            = 0;
+   uint64_t timed_pixels      = 0;
+   bool ok                    = true;
+   const char *dir            = (argc > 1) ? argv[1] : NULL;
+   unsigned threads           = (argc > 2) ? (unsigned)atoi(argv[2]) : 4;
+
+   threads = MAX(1, MIN(threads, BENCH_MAX_THREADS));
+
+   ok = bench_check_filters();
+   printf("[bench_rpng] " BENCH_KERNELS " filters match the bytewise "
+         "loops: %s\n", ok ? "yes" : "NO");
+   bench_filters();
+
+   if (dir)
+      bench_corpus_scan(&corpus, dir);
+   else if (!bench_corpus_synthesize(&corpus))
+      return 1;
+
+   if (!corpus.count)
+   {
+      printf("[bench_rpng] no PNG files found in %s\n", dir);
+      return 1;
+   }
+
+   /* One pass to warm up and count the pixels */
+   for (i = 0; i < corpus.count; i++)
+   {
+      if (!bench_decode(&corpus.images[i], &pixels))
+      {
+         printf("[bench_rpng] image %u failed to decode%s\n", (unsigned)i,
+               corpus.images[i].pixels ? " to its original pixels" : "");
+         ok = false;
+      }
+   }
+
+   t0     = cpu_features_get_time_usec();
+   for (i = 0; i < corpus.count; i++)
+      bench_decode(&corpus.images[i], &timed_pixels);
+   single = cpu_features_get_time_usec() - t0;
+
+   t0     = cpu_features_get_time_usec();
+   ok     = bench_threaded(&corpus, threads) && ok;
+   multi  = cpu_features_get_time_usec() - t0;
+
+   printf("[bench_rpng] %u %s images, %.1f MP, " BENCH_KERNELS
+         ": 1 thread %7.2f MP/s, %u threads %7.2f MP/s\n",
+         (unsigned)corpus.count, dir ? "corpus" : "synthetic",
+         pixels / 1e6, (double)pixels / single, threads,
+         (double)pixels / multi);
+
+   for (i = 0; i < corpus.count; i++)
+   {
+      free(corpus.images[i].png);
+      free(corpus.images[i].pixels);
+   }
+   free(corpus.images);
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_task_queue.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Queue latency benchmark for the threaded task queue.
+ *
+ * Pushes a mixed workload (short interactive jobs, network-like
+ * jobs that mostly sleep, long CPU-bound background scans) and
+ * reports p50/p99 time-to-first-run for every priority class.
+ *
+ * Usage: bench_task_queue [workers] [rounds] [parallel]
+ *
+ * Pass 0 as 'parallel' to run every task on the serial lane.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <queues/task_queue.h>
+#include <features/features_cpu.h>
+#include <retro_timers.h>
+
+#define BENCH_TASKS_PER_ROUND 16
+
+typedef struct
+{
+   retro_time_t pushed;
+   retro_time_t first_run;
+   unsigned iterations;
+} bench_task_state_t;
+
+static const char *bench_class_names[TASK_PRIORITY_LAST] = {
+   "interactive",
+   "network",
+   "background"
+};
+
+/* Busy-waits for 'usec' microseconds, standing in for CPU-bound work */
+static void bench_spin(retro_time_t usec)
+{
+   retro_time_t end = cpu_features_get_time_usec() + usec;
+   while (cpu_features_get_time_usec() < end);
+}
+
+static void bench_task_handler(retro_task_t *task)
+{
+   bench_task_state_t *state = (bench_task_state_t*)task->state;
+
+   if (!state->first_run)
+      state->first_run = cpu_features_get_time_usec();
+
+   switch (task->priority)
+   {
+      case TASK_PRIORITY_INTERACTIVE:
+         /* e.g. an image load: one short burst */
+         bench_spin(1000);
+         break;
+      case TASK_PRIORITY_NETWORK:
+         /* e.g. a download: mostly waiting on the socket */
+         retro_sleep(2);
+         bench_spin(100);
+         break;
+      default:
+         /* e.g. a database scan: many long iterations */
+         bench_spin(5000);
+         break;
+   }
+
+   if (--state->iterations == 0)
+      task_set_finished(task, true);
+}
+
+static int bench_cmp_time(const void *a, const void *b)
+{
+   retro_time_t ta = *(const retro_time_t*)a;
+   retro_time_t tb = *(const retro_time_t*)b;
+   return (ta > tb) - (ta < tb);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j;
+   unsigned workers                 = (argc > 1) ? (unsigned)atoi(argv[1]) : 0;
+   unsigned rounds                  = (argc > 2) ? (unsigned)atoi(argv[2]) : 20;
+   bool parallel                    = (argc > 3) ? !!atoi(argv[3]) : true;
+   unsigned total                   = rounds * BENCH_TASKS_PER_ROUND;
+   bench_task_state_t *states       = (bench_task_state_t*)
+      calloc(total, sizeof(*states));
+   enum task_priority *classes      = (enum task_priority*)
+      calloc(total, sizeof(*classes));
+   retro_time_t *latencies          = (retro_time_t*)
+      calloc(total, sizeof(*latencies));
+   retro_time_t start               = 0;
+
+   if (!states || !classes || !latencies)
+      return 1;
+
+   task_queue_set_worker_count(workers);
+   task_queue_init(true, NULL);
+
+   printf("[bench_task_queue] workers: %u, rounds: %u, parallel: %s\n",
+         task_queue_get_worker_count(), rounds, parallel ? "yes" : "no");
+
+   start = cpu_features_get_time_usec();
+
+   for (i = 0; i < rounds; i++)
+   {
+      for (j = 0; j < BENCH_TASKS_PER_ROUND; j++)
+      {
+         unsigned n         = i * BENCH_TASKS_PER_ROUND + j;
+         retro_task_t *task = task_init();
+
+         /* 1 background scan, 3 network jobs and
+          * 12 interactive jobs per round */
+         if (j == 0)
+         {
+            classes[n]           = TASK_PRIORITY_BACKGROUND;
+            states[n].iterations = 40;
+         }
+         else if (j < 4)
+         {
+            classes[n]           = TASK_PRIORITY_NETWORK;
+            states[n].iterations = 5;
+         }
+         else
+         {
+            classes[n]           = TASK_PRIORITY_INTERACTIVE;
+            states[n].iterations = 1;
+         }
+
+         task->handler      = bench_task_handler;
+         task->state        = &states[n];
+         task->priority     = classes[n];
+         task->parallel     = parallel;
+         task->mute         = true;
+         states[n].pushed   = cpu_features_get_time_usec();
+         task_queue_push(task);
+      }
+
+      /* Let the frontend run a few frames between bursts */
+      for (j = 0; j < 3; j++)
+      {
+         retro_sleep(16);
+         task_queue_check();
+      }
+   }
+
+   task_queue_wait(NULL, NULL);
+
+   printf("[bench_task_queue] total: %.1f ms\n",
+         (cpu_features_get_time_usec() - start) / 1000.0);
+
+   for (i = 0; i < TASK_PRIORITY_LAST; i++)
+   {
+      unsigned count = 0;
+
+      for (j = 0; j < total; j++)
+         if (classes[j] == (enum task_priority)i)
+            latencies[count++] = states[j].first_run - states[j].pushed;
+
+      if (!count)
+         continue;
+
+      qsort(latencies, count, sizeof(*latencies), bench_cmp_time);
+
+      printf("[bench_task_queue] %-12s n=%-5u p50: %8.3f ms  p99: %8.3f ms\n",
+            bench_class_names[i], count,
+            latencies[count / 2] / 1000.0,
+            latencies[(count * 99) / 100] / 1000.0);
+   }
+
+   task_queue_deinit();
+
+   free(states);
+   free(classes);
+   free(latencies);
+
+   return 0;
+}
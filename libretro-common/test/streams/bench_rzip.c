@@ -0,0 +1,189 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_rzip.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* RZIP compression benchmark.
+ *
+ * Writes a synthetic save state through rzipstream_write() the
+ * way the save state task does, on one thread and then with
+ * rzipstream_set_threads(), and reports megabytes per second.
+ * Every file written with threads must be identical to the
+ * single threaded one, and read back to the original data.
+ *
+ * Usage: bench_rzip [size_mb] [threads] [path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <features/features_cpu.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <streams/rzip_stream.h>
+
+#define BENCH_MAX_THREADS 16
+
+/* Written per call, as the save state task does
+ * with compression threads */
+#define BENCH_WRITE_SIZE 131072
+
+/* Mostly repetitive memory with noisy regions,
+ * which compresses about as well as typical
+ * save states */
+static void bench_fill(uint8_t *buf, size_t size)
+{
+   size_t i;
+   uint32_t seed = 1;
+
+   for (i = 0; i < size; i++)
+   {
+      seed = seed * 1103515245 + 12345;
+      buf[i] = ((i % 4093) < 1024)
+         ? (uint8_t)(seed >> 16)
+         : (uint8_t)(i >> 9);
+   }
+}
+
+static bool bench_write(const char *path, const uint8_t *buf, size_t size,
+      unsigned threads, retro_time_t *elapsed)
+{
+   size_t i;
+   retro_time_t t0      = cpu_features_get_time_usec();
+   rzipstream_t *stream = rzipstream_open(path, RETRO_VFS_FILE_ACCESS_WRITE);
+
+   if (!stream)
+      return false;
+
+   if (threads > 1 && !rzipstream_set_threads(stream, threads))
+   {
+      printf("[bench_rzip] Could not start %u threads\n", threads);
+      rzipstream_close(stream);
+      return false;
+   }
+
+   for (i = 0; i < size; i += BENCH_WRITE_SIZE)
+   {
+      int64_t len = (int64_t)MIN(BENCH_WRITE_SIZE, size - i);
+      if (rzipstream_write(stream, buf + i, len) != len)
+      {
+         rzipstream_close(stream);
+         return false;
+      }
+   }
+
+   if (rzipstream_close(stream) != 0)
+      return false;
+
+   *elapsed = cpu_features_get_time_usec() - t0;
+   return true;
+}
+
+static bool bench_compare(const char *path, const void *data, int64_t len)
+{
+   void *file_data;
+   int64_t file_len;
+   bool same;
+
+   if (!filestream_read_file(path, &file_data, &file_len))
+      return false;
+
+   same = (file_len == len) && !memcmp(file_data, data, (size_t)len);
+   free(file_data);
+   return same;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned threads;
+   retro_time_t elapsed;
+   void *reference       = NULL;
+   void *read_back       = NULL;
+   int64_t reference_len = 0;
+   int64_t read_len      = 0;
+   bool ok               = true;
+   size_t size           = ((argc > 1) ? (size_t)atoi(argv[1]) : 64) << 20;
+   unsigned max_threads  = (argc > 2) ? (unsigned)atoi(argv[2]) : 4;
+   const char *path      = (argc > 3) ? argv[3] : "bench_rzip.state";
+   uint8_t *buf          = (uint8_t*)malloc(size);
+
+   if (!buf || !size)
+      return 1;
+
+   max_threads = MAX(1, MIN(max_threads, BENCH_MAX_THREADS));
+   bench_fill(buf, size);
+
+   for (threads = 1; threads <= max_threads; threads *= 2)
+   {
+      if (!bench_write(path, buf, size, threads, &elapsed))
+      {
+         printf("[bench_rzip] %2u threads: write FAILED\n", threads);
+         ok = false;
+         break;
+      }
+
+      if (threads == 1)
+      {
+         if (!filestream_read_file(path, &reference, &reference_len))
+         {
+            ok = false;
+            break;
+         }
+
+         printf("[bench_rzip] %u MB compressed to %.1f MB\n",
+               (unsigned)(size >> 20), reference_len / (1024.0 * 1024.0));
+      }
+      else if (!bench_compare(path, reference, reference_len))
+      {
+         printf("[bench_rzip] %2u threads: MISMATCH with single thread\n",
+               threads);
+         ok = false;
+      }
+
+      printf("[bench_rzip] %2u threads: %8.1f MB/s\n", threads,
+            (size / (1024.0 * 1024.0)) / (elapsed / 1000000.0));
+
+      if (threads == max_threads)
+         break;
+      if (threads * 2 > max_threads)
+         threads = max_threads / 2;
+   }
+
+   if (ok)
+   {
+      if (     !rzipstream_read_file(path, &read_back, &read_len)
+            || (read_len != (int64_t)size)
+            || memcmp(read_back, buf, size))
+      {
+         printf("[bench_rzip] Read back MISMATCH\n");
+         ok = false;
+      }
+   }
+
+   filestream_delete(path);
+   free(read_back);
+   free(reference);
+   free(buf);
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (bench_crc32.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* CRC32 benchmark.
+ *
+ * Checks every CRC32 kernel against the byte at a time table
+ * loop on all lengths up to 1 KiB and every alignment, then
+ * reports the throughput of each kernel, of encoding_crc32()
+ * as dispatched on this CPU, and of a buffer hashed in chunks
+ * on several threads and put back together with
+ * encoding_crc32_combine().
+ *
+ * Usage: bench_crc32 [size_mb] [threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#include <retro_miscellaneous.h>
+
+/* The kernels are used directly */
+#include "../../encodings/encoding_crc32.c"
+
+#define BENCH_MAX_THREADS 16
+
+typedef uint32_t (*bench_kernel_t)(uint32_t crc, const uint8_t *buf,
+      size_t len);
+
+struct bench_chunk
+{
+   const uint8_t *buf;
+   size_t len;
+   uint32_t crc;
+};
+
+static uint32_t bench_bytewise(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   while (len--)
+      crc = crc32_table[0][(crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+   return crc;
+}
+
+#ifdef CRC32_PCLMUL
+/* The folding kernels only take the 16 byte aligned bulk */
+static uint32_t bench_pclmul(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   size_t bulk = len & ~(size_t)15;
+   if (len < CRC32_PCLMUL_MIN_LEN)
+      return crc32_slice16(crc, buf, len);
+   return crc32_slice16(crc32_pclmul(crc, buf, bulk),
+         buf + bulk, len - bulk);
+}
+
+#ifdef CRC32_VPCLMUL
+static uint32_t bench_vpclmul(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   size_t bulk = len & ~(size_t)15;
+   if (len < CRC32_VPCLMUL_MIN_LEN)
+      return crc32_slice16(crc, buf, len);
+   return crc32_slice16(crc32_vpclmul(crc, buf, bulk),
+         buf + bulk, len - bulk);
+}
+#endif
+#endif
+
+static uint32_t bench_dispatched(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   return ~encoding_crc32(~crc, buf, len);
+}
+
+static bool bench_check(const char *name, bench_kernel_t kernel,
+      const uint8_t *buf)
+{
+   size_t len, align;
+
+   for (len = 0; len <= 1024; len++)
+   {
+      for (align = 0; align < 16; align++)
+      {
+         uint32_t expected = bench_bytewise(~0U, buf + align, len);
+         if (kernel(~0U, buf + align, len) != expected)
+         {
+            printf("[bench_crc32] %-10s MISMATCH at length %u, offset %u\n",
+                  name, (unsigned)len, (unsigned)align);
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+static void bench_run(const char *name, bench_kernel_t kernel,
+      const uint8_t *buf, size_t size)
+{
+   unsigned rep;
+   uint32_t crc      = 0;
+   retro_time_t best = 0;
+
+   for (rep = 0; rep < 3; rep++)
+   {
+      retro_time_t t0 = cpu_features_get_time_usec();
+      retro_time_t elapsed;
+      crc             = kernel(~0U, buf, size);
+      elapsed         = cpu_features_get_time_usec() - t0;
+      if (!best || elapsed < best)
+         best = elapsed;
+   }
+
+   printf("[bench_crc32] %-10s %8.2f GB/s  crc %08x\n",
+         name, (double)size / (best * 1000.0), (unsigned)~crc);
+}
+
+static void bench_chunk_thread(void *data)
+{
+   struct bench_chunk *chunk = (struct bench_chunk*)data;
+   chunk->crc                = encoding_crc32(0, chunk->buf, chunk->len);
+}
+
+static uint32_t bench_threaded(const uint8_t *buf, size_t size,
+      unsigned threads)
+{
+   unsigned i;
+   uint32_t crc = 0;
+   sthread_t *thread[BENCH_MAX_THREADS];
+   struct bench_chunk chunks[BENCH_MAX_THREADS];
+   size_t chunk_size = size / threads;
+
+   for (i = 0; i < threads; i++)
+   {
+      chunks[i].buf = buf + i * chunk_size;
+      chunks[i].len = (i == threads - 1) ? size - i * chunk_size : chunk_size;
+      thread[i]     = sthread_create(bench_chunk_thread, &chunks[i]);
+   }
+
+   for (i = 0; i < threads; i++)
+   {
+      sthread_join(thread[i]);
+      crc = i ? encoding_crc32_combine(crc, chunks[i].crc, chunks[i].len)
+         : chunks[i].crc;
+   }
+
+   return crc;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   unsigned rep;
+   uint32_t crc, expected;
+   retro_time_t best = 0;
+   bool ok           = true;
+   size_t size       = ((argc > 1) ? (size_t)atoi(argv[1]) : 256) << 20;
+   unsigned threads  = (argc > 2) ? (unsigned)atoi(argv[2]) : 4;
+   uint8_t *buf      = (uint8_t*)malloc(size + 16);
+
+   if (!buf || !size)
+      return 1;
+
+   threads = MAX(1, MIN(threads, BENCH_MAX_THREADS));
+
+   for (i = 0; i < size + 16; i++)
+      buf[i] = (uint8_t)((i * 2654435761U) >> 13);
+
+   ok = bench_check("slice16", crc32_slice16, buf) && ok;
+#ifdef CRC32_PCLMUL
+   if (crc32_detect_kernel() >= CRC32_KERNEL_PCLMUL)
+      ok = bench_check("pclmul", bench_pclmul, buf) && ok;
+#ifdef CRC32_VPCLMUL
+   if (crc32_detect_kernel() >= CRC32_KERNEL_VPCLMUL)
+      ok = bench_check("vpclmul", bench_vpclmul, buf) && ok;
+#endif
+#endif
+   ok = bench_check("dispatched", bench_dispatched, buf) && ok;
+
+   /* Combining must match hashing in one go at every split */
+   expected = encoding_crc32(0, buf, 4096);
+   for (i = 0; i <= 4096; i += 7)
+   {
+      if (encoding_crc32_combine(encoding_crc32(0, buf, i),
+               encoding_crc32(0, buf + i, 4096 - i), 4096 - i) != expected)
+      {
+         printf("[bench_crc32] combine    MISMATCH at split %u\n",
+               (unsigned)i);
+         ok = false;
+         break;
+      }
+   }
+
+   printf("[bench_crc32] %u MB, all kernels match the table: %s\n",
+         (unsigned)(size >> 20), ok ? "yes" : "NO");
+
+   bench_run("bytewise", bench_bytewise, buf, size);
+   bench_run("slice16", crc32_slice16, buf, size);
+#ifdef CRC32_PCLMUL
+   if (crc32_detect_kernel() >= CRC32_KERNEL_PCLMUL)
+      bench_run("pclmul", bench_pclmul, buf, size);
+#ifdef CRC32_VPCLMUL
+   if (crc32_detect_kernel() >= CRC32_KERNEL_VPCLMUL)
+      bench_run("vpclmul", bench_vpclmul, buf, size);
+#endif
+#endif
+   bench_run("dispatched", bench_dispatched, buf, size);
+
+   expected = encoding_crc32(0, buf, size);
+   for (rep = 0; rep < 3; rep++)
+   {
+      retro_time_t t0 = cpu_features_get_time_usec();
+      retro_time_t elapsed;
+      crc             = bench_threaded(buf, size, threads);
+      elapsed         = cpu_features_get_time_usec() - t0;
+      if (!best || elapsed < best)
+         best = elapsed;
+   }
+
+   printf("[bench_crc32] %u threads  %8.2f GB/s  crc %08x (%s)\n",
+         threads, (double)size / (best * 1000.0), (unsigned)crc,
+         crc == expected ? "ok" : "MISMATCH");
+
+   free(buf);
+   return (ok && crc == expected) ? 0 : 1;
+}
@@ -71,6 +71,57 @@ START_TEST (test_crc32)
 }
 END_TEST
 
+/* Byte at a time reference */
+static uint32_t crc32_reference(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   crc = ~crc;
+   while (len--)
+   {
+      unsigned k;
+      crc ^= *buf++;
+      for (k = 0; k < 8; k++)
+         crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+   }
+   return ~crc;
+}
+
+START_TEST (test_crc32_lengths)
+{
+   size_t i, len, align;
+   uint8_t buf[4096 + 16];
+   for (i = 0; i < sizeof(buf); i++)
+      buf[i] = (uint8_t)((i * 2654435761U) >> 13);
+
+   /* Covers the tails and alignments of every kernel */
+   for (len = 0; len <= 1024; len++)
+      for (align = 0; align < 16; align++)
+         ck_assert_uint_eq(encoding_crc32(0, buf + align, len),
+               crc32_reference(0, buf + align, len));
+
+   ck_assert_uint_eq(encoding_crc32(0, buf, 4096),
+         crc32_reference(0, buf, 4096));
+   ck_assert_uint_eq(encoding_crc32(0x12345678, buf + 3, 4093),
+         crc32_reference(0x12345678, buf + 3, 4093));
+}
+END_TEST
+
+START_TEST (test_crc32_combine)
+{
+   size_t i;
+   uint8_t buf[1000];
+   uint32_t crc;
+   for (i = 0; i < sizeof(buf); i++)
+      buf[i] = (uint8_t)(i * 7);
+   crc = encoding_crc32(0, buf, sizeof(buf));
+
+   for (i = 0; i <= sizeof(buf); i++)
+      ck_assert_uint_eq(encoding_crc32_combine(
+               encoding_crc32(0, buf, i),
+               encoding_crc32(0, buf + i, sizeof(buf) - i),
+               sizeof(buf) - i), crc);
+}
+END_TEST
+
 #define CRC32_BUFFER_SIZE 1048576
 #define CRC32_MAX_MB 64
 
@@ -141,6 +192,8 @@ Suite *create_suite(void)
    TCase *tc_core = tcase_create("Core");
    tcase_add_test(tc_core, test_md5);
    tcase_add_test(tc_core, test_crc32);
+   tcase_add_test(tc_core, test_crc32_lengths);
+   tcase_add_test(tc_core, test_crc32_combine);
    tcase_add_test(tc_core, test_crc32_file);
    suite_add_tcase(s, tc_core);
 
@@ -20,6 +20,10 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <sys/types.h>
 #ifdef _WIN32
 #include <direct.h>
@@ -29,12 +33,16 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <stdlib.h>
-
 #include <streams/file_stream.h>
 #include <retro_endianness.h>
 #include <string/stdstring.h>
 #include <compat/strl.h>
 
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 #include "rmsgpack.h"
@@ -44,6 +52,9 @@
 
 #define MAGIC_NUMBER "RARCHDB"
 
+/* Equality predicates checked on the raw records of a query */
+#define LIBRETRODB_MAX_EQUALS 16
+
 struct node_iter_ctx
 {
    libretrodb_t *db;
@@ -54,15 +65,23 @@ struct libretrodb
 {
    RFILE *fd;
    char *path;
-   bool can_write;
+   /* Read only databases are kept in memory as a whole,
+    * mapped if possible, along with their indexes */
+   const uint8_t *data;
+   libretrodb_index_t *indexes;
+   uint64_t size;
    uint64_t root;
    uint64_t count;
    uint64_t first_index_offset;
+   unsigned num_indexes;
+   bool can_write;
+   bool mapped;
 };
 
 struct libretrodb_index
 {
    char name[50];
+   const uint8_t *keys; /* In memory databases only */
    uint64_t key_size;
    uint64_t next;
    uint64_t count;
@@ -84,6 +103,13 @@ struct libretrodb_cursor
    RFILE *fd;
    libretrodb_query_t *query;
    libretrodb_t *db;
+   /* In memory databases */
+   const uint8_t *pos;
+   const uint8_t *index_match;  /* Record found through an index */
+   const struct rmsgpack_dom_value *eq_field[LIBRETRODB_MAX_EQUALS];
+   const struct rmsgpack_dom_value *eq_value[LIBRETRODB_MAX_EQUALS];
+   unsigned num_equals;
+   bool use_index;
    int is_valid;
    int eof;
 };
@@ -171,12 +197,171 @@ clean:
    return rv;
 }
 
+static void libretrodb_unload(libretrodb_t *db)
+{
+   if (db->data)
+   {
+#ifdef HAVE_MMAP
+      if (db->mapped)
+         munmap((void*)db->data, (size_t)db->size);
+      else
+#endif
+         free((void*)db->data);
+   }
+   free(db->indexes);
+   db->data        = NULL;
+   db->indexes     = NULL;
+   db->num_indexes = 0;
+   db->size        = 0;
+   db->mapped      = false;
+}
+
+/* Maps the whole file, or reads it if it can't be mapped */
+static int libretrodb_load(const char *path, libretrodb_t *db)
+{
+   void *buf   = NULL;
+   int64_t len = 0;
+#ifdef HAVE_MMAP
+   struct stat st;
+   int fd      = open(path, O_RDONLY);
+
+   if (fd >= 0)
+   {
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+         /* Nothing is written through the mapping, keep
+          * it private to this process */
+         void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ,
+               MAP_PRIVATE, fd, 0);
+         if (ptr != MAP_FAILED)
+         {
+            db->data   = (const uint8_t*)ptr;
+            db->size   = (uint64_t)st.st_size;
+            db->mapped = true;
+         }
+      }
+      close(fd);
+      if (db->data)
+         return 0;
+   }
+#endif
+
+   if (!filestream_read_file(path, &buf, &len) || !buf)
+      return -1;
+
+   db->data   = (const uint8_t*)buf;
+   db->size   = (uint64_t)len;
+   db->mapped = false;
+   return 0;
+}
+
+static int libretrodb_read_map_uint(const struct rmsgpack_dom_value *map,
+      const char *name, uint64_t *out)
+{
+   struct rmsgpack_dom_value key;
+   struct rmsgpack_dom_value *value;
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = (uint32_t)strlen(name);
+   key.val.string.buff = (char*)name;
+
+   if (!(value = rmsgpack_dom_value_map_value(map, &key)))
+      return -1;
+
+   if (value->type == RDT_UINT)
+      *out = value->val.uint_;
+   else if (value->type == RDT_INT && value->val.int_ >= 0)
+      *out = (uint64_t)value->val.int_;
+   else
+      return -1;
+
+   return 0;
+}
+
+/* Reads the header, the metadata and the index headers of an
+ * in memory database; the index keys stay where they are */
+static int libretrodb_parse(libretrodb_t *db)
+{
+   libretrodb_header_t header;
+   struct rmsgpack_dom_value md;
+   const uint8_t *end = db->data + db->size;
+   const uint8_t *ptr;
+
+   if (db->size < sizeof(header))
+      return -1;
+
+   memcpy(&header, db->data, sizeof(header));
+   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+      return -1;
+
+   header.metadata_offset = swap_if_little64(header.metadata_offset);
+   if (header.metadata_offset >= db->size)
+      return -1;
+
+   ptr = db->data + header.metadata_offset;
+   if (rmsgpack_dom_read_buf(&ptr, end, &md) < 0)
+      return -1;
+   if (libretrodb_read_map_uint(&md, "count", &db->count) < 0)
+   {
+      rmsgpack_dom_value_free(&md);
+      return -1;
+   }
+   rmsgpack_dom_value_free(&md);
+
+   db->root               = 0;
+   db->first_index_offset = (uint64_t)(ptr - db->data);
+
+   while (ptr < end)
+   {
+      libretrodb_index_t idx;
+      struct rmsgpack_dom_value hdr, key;
+      struct rmsgpack_dom_value *name;
+      libretrodb_index_t *indexes;
+
+      if (rmsgpack_dom_read_buf(&ptr, end, &hdr) < 0)
+         break;
+
+      key.type            = RDT_STRING;
+      key.val.string.len  = STRLEN_CONST("name");
+      key.val.string.buff = (char*)"name";
+      name                = rmsgpack_dom_value_map_value(&hdr, &key);
+
+      if (     !name
+            || name->type != RDT_STRING
+            || libretrodb_read_map_uint(&hdr, "key_size", &idx.key_size) < 0
+            || libretrodb_read_map_uint(&hdr, "next",     &idx.next)     < 0
+            || libretrodb_read_map_uint(&hdr, "count",    &idx.count)    < 0
+            || idx.key_size == 0
+            || idx.key_size > 255
+            || idx.next > (uint64_t)(end - ptr)
+            || idx.count > idx.next / (idx.key_size + sizeof(uint64_t)))
+      {
+         rmsgpack_dom_value_free(&hdr);
+         break;
+      }
+
+      strlcpy(idx.name, name->val.string.buff, sizeof(idx.name));
+      rmsgpack_dom_value_free(&hdr);
+      idx.keys = ptr;
+      ptr     += idx.next;
+
+      if (!(indexes = (libretrodb_index_t*)realloc(db->indexes,
+                  (db->num_indexes + 1) * sizeof(*indexes))))
+         break;
+      db->indexes                    = indexes;
+      db->indexes[db->num_indexes++] = idx;
+   }
+
+   return 0;
+}
+
 void libretrodb_close(libretrodb_t *db)
 {
    if (db->fd)
       filestream_close(db->fd);
    if (!string_is_empty(db->path))
       free(db->path);
+   libretrodb_unload(db);
    db->path = NULL;
    db->fd   = NULL;
 }
@@ -185,10 +370,27 @@ int libretrodb_open(const char *path, libretrodb_t *db, bool write)
 {
    libretrodb_header_t header;
    libretrodb_metadata_t md;
-   RFILE *fd = filestream_open(path,
+   RFILE *fd = NULL;
+
+   db->can_write = write;
+
+   if (!write && libretrodb_load(path, db) == 0)
+   {
+      if (libretrodb_parse(db) < 0)
+      {
+         libretrodb_unload(db);
+         return -1;
+      }
+
+      if (!string_is_empty(db->path))
+         free(db->path);
+      db->path = strdup(path);
+      return 0;
+   }
+
+   fd = filestream_open(path,
          write ? RETRO_VFS_FILE_ACCESS_READ_WRITE | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING : RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
-   db->can_write = write;
    if (!fd)
      return -1;
 
@@ -225,6 +427,21 @@ error:
 static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
       libretrodb_index_t *idx)
 {
+   if (db->data)
+   {
+      unsigned i;
+      for (i = 0; i < db->num_indexes; i++)
+      {
+         if (strncmp(index_name, db->indexes[i].name,
+                  strlen(db->indexes[i].name)) == 0)
+         {
+            *idx = db->indexes[i];
+            return 0;
+         }
+      }
+      return -1;
+   }
+
    filestream_seek(db->fd,
                    (ssize_t)db->first_index_offset,
                    RETRO_VFS_SEEK_POSITION_START);
@@ -253,28 +470,47 @@ static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
    return -1;
 }
 
+/* Index entries are sorted keys, each followed by the offset
+ * of its record */
 static int binsearch(const void *buff, const void *item,
       uint64_t count, uint8_t field_size, uint64_t *offset)
 {
-   int mid            = (int)(count / 2);
-   int item_size      = field_size + sizeof(uint64_t);
-   uint8_t *current   = ((uint8_t *)buff + (mid * item_size));
-   int rv             = memcmp(current, item, field_size);
+   size_t item_size   = field_size + sizeof(uint64_t);
+   uint64_t lo        = 0;
+   uint64_t hi        = count;
 
-   if (rv == 0)
+   while (lo < hi)
    {
-      *offset         = *(uint64_t *)(current + field_size);
-      return 0;
-   }
+      uint64_t mid     = lo + (hi - lo) / 2;
+      const uint8_t *current = (const uint8_t*)buff + mid * item_size;
+      int rv           = memcmp(current, item, field_size);
 
-   if (count == 0)
-      return -1;
+      if (rv == 0)
+      {
+         memcpy(offset, current + field_size, sizeof(uint64_t));
+         return 0;
+      }
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+      if (rv > 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   return -1;
+}
+
+static const libretrodb_index_t *libretrodb_get_index(libretrodb_t *db,
+      const char *name, size_t len)
+{
+   unsigned i;
+   for (i = 0; i < db->num_indexes; i++)
+   {
+      if (     strlen(db->indexes[i].name) == len
+            && !strncmp(db->indexes[i].name, name, len))
+         return &db->indexes[i];
+   }
+   return NULL;
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
@@ -289,6 +525,21 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
    if (libretrodb_find_index(db, index_name, &idx) < 0)
       return -1;
 
+   /* Resident index, no need to read it */
+   if (db->data)
+   {
+      const uint8_t *ptr;
+
+      if (     binsearch(idx.keys, key, idx.count,
+               (uint8_t)idx.key_size, &offset) != 0
+            || offset >= db->size)
+         return -1;
+
+      ptr = db->data + offset;
+      return rmsgpack_dom_read_buf(&ptr, db->data + db->size, out) < 0
+         ? -1 : 0;
+   }
+
    bufflen        = idx.next;
    if (!(buff = malloc(bufflen)))
       return -1;
@@ -329,11 +580,126 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
    cursor->eof = 0;
+
+   if (cursor->db->data)
+   {
+      if (cursor->use_index)
+      {
+         cursor->pos = cursor->index_match;
+         cursor->eof = !cursor->index_match;
+      }
+      else
+         cursor->pos = cursor->db->data + cursor->db->root
+            + sizeof(libretrodb_header_t);
+      return 0;
+   }
+
    return (int)filestream_seek(cursor->fd,
          (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
          RETRO_VFS_SEEK_POSITION_START);
 }
 
+/* Returns 1 if the raw value is equal to @value, as func_equals()
+ * in query.c would find, 0 if not, -1 if it can't tell */
+static int libretrodb_raw_equals(const struct rmsgpack_raw *raw,
+      const struct rmsgpack_dom_value *value)
+{
+   switch (raw->type)
+   {
+      case RMSGPACK_RAW_NIL:
+         return value->type == RDT_NULL;
+      case RMSGPACK_RAW_BOOL:
+         return value->type == RDT_BOOL
+            && value->val.bool_ == raw->val.bool_;
+      case RMSGPACK_RAW_UINT:
+         if (value->type == RDT_INT)
+            return (uint64_t)value->val.int_ == raw->val.uint_;
+         return value->type == RDT_UINT
+            && value->val.uint_ == raw->val.uint_;
+      case RMSGPACK_RAW_INT:
+         return value->type == RDT_INT
+            && value->val.int_ == raw->val.int_;
+      case RMSGPACK_RAW_STRING:
+         return value->type == RDT_STRING
+            && value->val.string.len == raw->val.buff.len
+            && !strncmp(value->val.string.buff, raw->val.buff.buff,
+                  raw->val.buff.len);
+      case RMSGPACK_RAW_BIN:
+         return value->type == RDT_BINARY
+            && value->val.binary.len == raw->val.buff.len
+            && !memcmp(value->val.binary.buff, raw->val.buff.buff,
+                  raw->val.buff.len);
+      default:
+         break;
+   }
+
+   return -1;
+}
+
+/* Checks the equality predicates of the query on the raw record
+ * at *ptr, moving *ptr past it. Returns false if it can't match,
+ * so that it doesn't have to be decoded. */
+static bool libretrodb_cursor_prefilter(libretrodb_cursor_t *cursor,
+      const uint8_t **ptr, const uint8_t *end)
+{
+   uint32_t i;
+   unsigned j;
+   struct rmsgpack_raw raw;
+   uint32_t seen = 0;
+   bool match    = true;
+
+   /* Not a map, or a broken one: leave it to the query */
+   if (     rmsgpack_read_raw(ptr, end, &raw) < 0
+         || raw.type != RMSGPACK_RAW_MAP)
+      return true;
+
+   for (i = 0; i < raw.val.len; i++)
+   {
+      struct rmsgpack_raw key;
+      const uint8_t *value_ptr;
+
+      if (     rmsgpack_read_raw(ptr, end, &key) < 0
+            || key.type == RMSGPACK_RAW_MAP
+            || key.type == RMSGPACK_RAW_ARRAY)
+         return true;
+
+      value_ptr = *ptr;
+
+      if (match && key.type == RMSGPACK_RAW_STRING)
+      {
+         for (j = 0; j < cursor->num_equals; j++)
+         {
+            const struct rmsgpack_dom_value *field = cursor->eq_field[j];
+
+            /* The first field of that name counts */
+            if (     !(seen & (1U << j))
+                  && field->val.string.len == key.val.buff.len
+                  && !strncmp(field->val.string.buff, key.val.buff.buff,
+                     key.val.buff.len))
+            {
+               struct rmsgpack_raw value;
+               const uint8_t *p = value_ptr;
+
+               seen |= (1U << j);
+               if (     rmsgpack_read_raw(&p, end, &value) == 0
+                     && libretrodb_raw_equals(&value, cursor->eq_value[j]) == 0)
+                  match = false;
+            }
+         }
+      }
+
+      if (rmsgpack_skip(ptr, end) < 0)
+         return true;
+   }
+
+   /* Missing fields are nil */
+   for (j = 0; match && j < cursor->num_equals; j++)
+      if (!(seen & (1U << j)) && cursor->eq_value[j]->type != RDT_NULL)
+         match = false;
+
+   return match;
+}
+
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out)
 {
@@ -342,6 +708,42 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
    if (cursor->eof)
       return EOF;
 
+   if (cursor->db->data)
+   {
+      const uint8_t *end = cursor->db->data + cursor->db->size;
+
+      for (;;)
+      {
+         const uint8_t *record = cursor->pos;
+         const uint8_t *next   = record;
+
+         if (!record || record >= end || *record == 0xc0 /* nil */)
+         {
+            cursor->eof = 1;
+            return EOF;
+         }
+
+         if (     cursor->num_equals
+               && !libretrodb_cursor_prefilter(cursor, &next, end))
+         {
+            cursor->pos = next;
+            continue;
+         }
+
+         next = record;
+         if ((rv = rmsgpack_dom_read_buf(&next, end, out)) < 0)
+            return rv;
+
+         /* Only one record to look at */
+         cursor->pos = cursor->use_index ? NULL : next;
+
+         if (!cursor->query || libretrodb_query_filter(cursor->query, out))
+            return 0;
+
+         rmsgpack_dom_value_free(out);
+      }
+   }
+
 retry:
    if ((rv = rmsgpack_dom_read(cursor->fd, out)) < 0)
       return rv;
@@ -381,6 +783,10 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
+   cursor->pos         = NULL;
+   cursor->index_match = NULL;
+   cursor->num_equals  = 0;
+   cursor->use_index   = false;
    cursor->is_valid = 0;
    cursor->eof      = 1;
    cursor->fd       = NULL;
@@ -406,6 +812,58 @@ int libretrodb_cursor_open(libretrodb_t *db,
    if (!db || string_is_empty(db->path))
       return -1;
 
+   if (db->data)
+   {
+      unsigned i;
+      const struct rmsgpack_dom_value *field, *value;
+
+      cursor->fd          = NULL;
+      cursor->db          = db;
+      cursor->query       = q;
+      cursor->is_valid    = 1;
+      cursor->num_equals  = 0;
+      cursor->use_index   = false;
+      cursor->index_match = NULL;
+
+      for (i = 0; q && libretrodb_query_get_equal(q, i, &field, &value); i++)
+      {
+         const libretrodb_index_t *idx;
+
+         if (field->type != RDT_STRING)
+            continue;
+
+         if (cursor->num_equals < LIBRETRODB_MAX_EQUALS)
+         {
+            cursor->eq_field[cursor->num_equals] = field;
+            cursor->eq_value[cursor->num_equals] = value;
+            cursor->num_equals++;
+         }
+
+         /* An index named after the field resolves it directly */
+         if (     !cursor->use_index
+               && value->type == RDT_BINARY
+               && (idx = libretrodb_get_index(db,
+                     field->val.string.buff, field->val.string.len))
+               && idx->key_size == value->val.binary.len)
+         {
+            uint64_t offset;
+
+            cursor->use_index = true;
+            if (     binsearch(idx->keys, value->val.binary.buff, idx->count,
+                     (uint8_t)idx->key_size, &offset) == 0
+                  && offset < db->size)
+               cursor->index_match = db->data + offset;
+         }
+      }
+
+      libretrodb_cursor_reset(cursor);
+
+      if (q)
+         libretrodb_query_inc_ref(q);
+
+      return 0;
+   }
+
    if (!(fd = filestream_open(db->path,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE)))
@@ -451,7 +909,7 @@ int libretrodb_create_index(libretrodb_t *db,
    void *buff                       = NULL;
    uint64_t *buff_u64               = NULL;
    uint8_t field_size               = 0;
-   uint64_t item_loc                = filestream_tell(db->fd);
+   uint64_t item_loc                = 0;
    bintree_t *tree;
    uint64_t item_count              = 0;
    int rval                         = -1;
@@ -460,7 +918,7 @@ int libretrodb_create_index(libretrodb_t *db,
    {
      return 1;
    }
-   if (!db->can_write)
+   if (!db->can_write || db->data)
    {
      return -1;
    }
@@ -472,6 +930,9 @@ int libretrodb_create_index(libretrodb_t *db,
    if (!tree || (libretrodb_cursor_open(db, &cur, NULL) != 0))
       goto clean;
 
+   /* The first record starts where the cursor does */
+   item_loc                         = filestream_tell(cur.fd);
+
    key.type                         = RDT_STRING;
    key.val.string.len               = (uint32_t)strlen(field_name);
    key.val.string.buff              = (char *)field_name;   /* We know we aren't going to change it */
@@ -567,6 +1028,10 @@ libretrodb_cursor_t *libretrodb_cursor_new(void)
 
    dbc->is_valid            = 0;
    dbc->fd                  = NULL;
+   dbc->pos                 = NULL;
+   dbc->index_match         = NULL;
+   dbc->num_equals          = 0;
+   dbc->use_index           = false;
    dbc->eof                 = 0;
    dbc->query               = NULL;
    dbc->db                  = NULL;
@@ -588,6 +1053,11 @@ libretrodb_t *libretrodb_new(void)
       return NULL;
 
    db->fd                 = NULL;
+   db->data               = NULL;
+   db->indexes            = NULL;
+   db->size               = 0;
+   db->num_indexes        = 0;
+   db->mapped             = false;
    db->root               = 0;
    db->count              = 0;
    db->first_index_offset = 0;
@@ -21,13 +21,187 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <features/features_cpu.h>
 #include <string/stdstring.h>
 
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 
+#define BENCH_DEFAULT_KEYS 1000
+#define BENCH_SCAN_USEC    1000000
+
+/* Builds an equality query on @field for the value of a record */
+static bool bench_build_query(char *s, size_t len, const char *field,
+      const struct rmsgpack_dom_value *value)
+{
+   uint32_t i;
+   size_t _len = (size_t)snprintf(s, len, "{'%s': ", field);
+
+   if (value->type == RDT_BINARY)
+   {
+      if (_len + value->val.binary.len * 2 + 5 > len)
+         return false;
+      s[_len++] = 'b';
+      s[_len++] = '\'';
+      for (i = 0; i < value->val.binary.len; i++)
+         _len += snprintf(s + _len, len - _len, "%02X",
+               (uint8_t)value->val.binary.buff[i]);
+      s[_len++] = '\'';
+   }
+   else if (value->type == RDT_STRING)
+   {
+      if (     _len + value->val.string.len + 5 > len
+            || memchr(value->val.string.buff, '\'', value->val.string.len))
+         return false;
+      s[_len++] = '\'';
+      memcpy(s + _len, value->val.string.buff, value->val.string.len);
+      _len     += value->val.string.len;
+      s[_len++] = '\'';
+   }
+   else
+      return false;
+
+   s[_len++] = '}';
+   s[_len]   = '\0';
+   return true;
+}
+
+/* Runs a query to the end, returns the number of matches or -1 */
+static int bench_run_query(libretrodb_t *db, const char *query_exp)
+{
+   struct rmsgpack_dom_value item;
+   int matches              = 0;
+   const char *error        = NULL;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   libretrodb_query_t *q    = (libretrodb_query_t*)libretrodb_query_compile(
+         db, query_exp, strlen(query_exp), &error);
+
+   if (!cur || !q || error || libretrodb_cursor_open(db, cur, q) != 0)
+      matches = -1;
+   else
+   {
+      while (libretrodb_cursor_read_item(cur, &item) == 0)
+      {
+         rmsgpack_dom_value_free(&item);
+         matches++;
+      }
+      libretrodb_cursor_close(cur);
+   }
+
+   if (q)
+      libretrodb_query_free(q);
+   libretrodb_cursor_free(cur);
+   return matches;
+}
+
+static void bench_db(libretrodb_t *db, const char *mode, const char *field,
+      char **queries, unsigned num_queries)
+{
+   unsigned i;
+   unsigned scans       = 0;
+   unsigned misses      = 0;
+   retro_time_t t0      = cpu_features_get_time_usec();
+   retro_time_t elapsed;
+   char scan_exp[256];
+
+   for (i = 0; i < num_queries; i++)
+      if (bench_run_query(db, queries[i]) < 1)
+         misses++;
+   elapsed = cpu_features_get_time_usec() - t0;
+
+   printf("[libretrodb_tool] %-8s %u '%s' lookups: %10.1f lookups/s%s\n",
+         mode, num_queries, field,
+         num_queries * 1000000.0 / (elapsed > 0 ? elapsed : 1),
+         misses ? " (MISSED SOME)" : "");
+
+   /* Nothing matches, every record is decoded and looked at */
+   snprintf(scan_exp, sizeof(scan_exp),
+         "{'%s': glob('*no such value*')}", field);
+   t0 = cpu_features_get_time_usec();
+   do
+   {
+      bench_run_query(db, scan_exp);
+      scans++;
+      elapsed = cpu_features_get_time_usec() - t0;
+   } while (elapsed < BENCH_SCAN_USEC);
+
+   printf("[libretrodb_tool] %-8s full scan queries:  %10.2f queries/s\n",
+         mode, scans * 1000000.0 / elapsed);
+}
+
+static int bench(const char *path, const char *field, unsigned max_keys)
+{
+   unsigned i;
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value key;
+   char query_exp[1024];
+   unsigned num_queries     = 0;
+   char **queries           = (char**)calloc(max_keys, sizeof(char*));
+   libretrodb_t *db         = libretrodb_new();
+   libretrodb_t *db_stream  = libretrodb_new();
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!queries || !db || !db_stream || !cur)
+      return 1;
+
+   if (libretrodb_open(path, db, false) != 0)
+   {
+      printf("Could not open db file '%s'\n", path);
+      return 1;
+   }
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = (uint32_t)strlen(field);
+   key.val.string.buff = (char*)field;
+
+   /* Spread the keys over the whole database */
+   if (libretrodb_cursor_open(db, cur, NULL) == 0)
+   {
+      unsigned n = 0;
+      while (     num_queries < max_keys
+            && libretrodb_cursor_read_item(cur, &item) == 0)
+      {
+         struct rmsgpack_dom_value *value =
+            rmsgpack_dom_value_map_value(&item, &key);
+
+         if (     value
+               && (n++ % 7) == 0
+               && bench_build_query(query_exp, sizeof(query_exp),
+                  field, value))
+            queries[num_queries++] = strdup(query_exp);
+         rmsgpack_dom_value_free(&item);
+      }
+      libretrodb_cursor_close(cur);
+   }
+
+   if (!num_queries)
+   {
+      printf("No '%s' field to look up in '%s'\n", field, path);
+      return 1;
+   }
+
+   bench_db(db, "memory", field, queries, num_queries);
+
+   /* The streamed reader is the one used for writing */
+   if (libretrodb_open(path, db_stream, true) == 0)
+   {
+      bench_db(db_stream, "stream", field, queries, num_queries);
+      libretrodb_close(db_stream);
+   }
+
+   libretrodb_close(db);
+   libretrodb_free(db);
+   libretrodb_free(db_stream);
+   libretrodb_cursor_free(cur);
+   for (i = 0; i < num_queries; i++)
+      free(queries[i]);
+   free(queries);
+   return 0;
+}
+
 int main(int argc, char ** argv)
 {
    int rv;
@@ -48,19 +222,26 @@ int main(int argc, char ** argv)
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
       printf("\tget-names <query expression>\n");
+      printf("\tbench [field name] [keys]\n");
       return 1;
    }
 
    command = argv[2];
    path    = argv[1];
 
+   if (memcmp(command, "bench", 5) == 0)
+      return bench(path, (argc > 3) ? argv[3] : "crc",
+            (argc > 4) ? (unsigned)atoi(argv[4]) : BENCH_DEFAULT_KEYS);
+
    db      = libretrodb_new();
    cur     = libretrodb_cursor_new();
 
    if (!db || !cur)
       goto error;
 
-   if ((rv = libretrodb_open(path, db, true)) != 0)
+   /* Only indexing writes, everything else reads from memory */
+   if ((rv = libretrodb_open(path, db,
+               memcmp(command, "create-index", 12) == 0)) != 0)
    {
       printf("Could not open db file '%s'\n", path);
       goto error;
@@ -991,3 +991,30 @@ int libretrodb_query_filter(libretrodb_query_t *q,
    struct rmsgpack_dom_value res = inv.func(*v, inv.argc, inv.argv);
    return (res.type == RDT_BOOL && res.val.bool_);
 }
+
+bool libretrodb_query_get_equal(libretrodb_query_t *q, unsigned i,
+      const struct rmsgpack_dom_value **field,
+      const struct rmsgpack_dom_value **value)
+{
+   unsigned j;
+   struct invocation *inv = &((struct query*)q)->root;
+
+   if (inv->func != query_func_all_map || inv->argc % 2 != 0)
+      return false;
+
+   /* i-th field compared to a plain value, functions don't count */
+   for (j = 0; j < inv->argc; j += 2)
+   {
+      if (     inv->argv[j].type     != AT_VALUE
+            || inv->argv[j + 1].type != AT_VALUE)
+         continue;
+      if (i-- == 0)
+      {
+         *field = &inv->argv[j].a.value;
+         *value = &inv->argv[j + 1].a.value;
+         return true;
+      }
+   }
+
+   return false;
+}
@@ -24,6 +24,7 @@
 #define __LIBRETRODB_QUERY_H__
 
 #include <retro_common_api.h>
+#include <boolean.h>
 
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
@@ -38,6 +39,22 @@ void libretrodb_query_dec_ref(libretrodb_query_t *q);
 
 int libretrodb_query_filter(libretrodb_query_t *q, struct rmsgpack_dom_value *v);
 
+/**
+ * libretrodb_query_get_equal:
+ * @i     : Index of the predicate.
+ * @field : Name of the field.
+ * @value : Value it must be equal to.
+ *
+ * Enumerates the field equality predicates of a top level
+ * table query, e.g. {'crc': b'...'}, all of which a record must
+ * satisfy to match.
+ *
+ * Returns: false when there are no more.
+ **/
+bool libretrodb_query_get_equal(libretrodb_query_t *q, unsigned i,
+      const struct rmsgpack_dom_value **field,
+      const struct rmsgpack_dom_value **value);
+
 RETRO_END_DECLS
 
 #endif
@@ -593,3 +593,150 @@ end:
       free(buff);
    return 0;
 }
+
+static uint64_t rmsgpack_load_be(const uint8_t *p, size_t size)
+{
+   uint64_t v = 0;
+   while (size--)
+      v = (v << 8) | *p++;
+   return v;
+}
+
+int rmsgpack_read_raw(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_raw *out)
+{
+   size_t size;
+   uint8_t type;
+   const uint8_t *p = *ptr;
+
+   if (p >= end)
+      return -1;
+
+   type = *p++;
+
+   if (type < MPF_FIXMAP)
+   {
+      out->type     = RMSGPACK_RAW_INT;
+      out->val.int_ = type;
+      goto done;
+   }
+   else if (type < MPF_FIXARRAY)
+   {
+      out->type     = RMSGPACK_RAW_MAP;
+      out->val.len  = type - MPF_FIXMAP;
+      goto done;
+   }
+   else if (type < MPF_FIXSTR)
+   {
+      out->type     = RMSGPACK_RAW_ARRAY;
+      out->val.len  = type - MPF_FIXARRAY;
+      goto done;
+   }
+   else if (type < MPF_NIL)
+   {
+      out->type         = RMSGPACK_RAW_STRING;
+      out->val.buff.len = type - MPF_FIXSTR;
+      goto buff;
+   }
+   else if (type > MPF_MAP32)
+   {
+      out->type     = RMSGPACK_RAW_INT;
+      out->val.int_ = type - 0xff - 1;
+      goto done;
+   }
+
+   switch (type)
+   {
+      case _MPF_NIL:
+         out->type      = RMSGPACK_RAW_NIL;
+         goto done;
+      case _MPF_FALSE:
+      case _MPF_TRUE:
+         out->type      = RMSGPACK_RAW_BOOL;
+         out->val.bool_ = (type == _MPF_TRUE);
+         goto done;
+      case _MPF_BIN8:
+      case _MPF_BIN16:
+      case _MPF_BIN32:
+      case _MPF_STR8:
+      case _MPF_STR16:
+      case _MPF_STR32:
+         size           = (type >= _MPF_STR8)
+            ? (size_t)1 << (type - _MPF_STR8)
+            : (size_t)1 << (type - _MPF_BIN8);
+         if ((size_t)(end - p) < size)
+            return -1;
+         out->type         = (type >= _MPF_STR8)
+            ? RMSGPACK_RAW_STRING : RMSGPACK_RAW_BIN;
+         out->val.buff.len = (uint32_t)rmsgpack_load_be(p, size);
+         p                += size;
+         goto buff;
+      case _MPF_UINT8:
+      case _MPF_UINT16:
+      case _MPF_UINT32:
+      case _MPF_UINT64:
+         size           = (size_t)1 << (type - _MPF_UINT8);
+         if ((size_t)(end - p) < size)
+            return -1;
+         out->type      = RMSGPACK_RAW_UINT;
+         out->val.uint_ = rmsgpack_load_be(p, size);
+         p             += size;
+         goto done;
+      case _MPF_INT8:
+      case _MPF_INT16:
+      case _MPF_INT32:
+      case _MPF_INT64:
+         size           = (size_t)1 << (type - _MPF_INT8);
+         if ((size_t)(end - p) < size)
+            return -1;
+         out->type      = RMSGPACK_RAW_INT;
+         /* Sign extend */
+         out->val.int_  = (int64_t)(rmsgpack_load_be(p, size)
+               << (64 - size * 8)) >> (64 - size * 8);
+         p             += size;
+         goto done;
+      case _MPF_ARRAY16:
+      case _MPF_ARRAY32:
+      case _MPF_MAP16:
+      case _MPF_MAP32:
+         size           = (type == _MPF_ARRAY16 || type == _MPF_MAP16) ? 2 : 4;
+         if ((size_t)(end - p) < size)
+            return -1;
+         out->type      = (type >= _MPF_MAP16)
+            ? RMSGPACK_RAW_MAP : RMSGPACK_RAW_ARRAY;
+         out->val.len   = (uint32_t)rmsgpack_load_be(p, size);
+         p             += size;
+         goto done;
+      default:
+         return -1;
+   }
+
+buff:
+   if ((size_t)(end - p) < out->val.buff.len)
+      return -1;
+   out->val.buff.buff = (const char*)p;
+   p                 += out->val.buff.len;
+
+done:
+   *ptr = p;
+   return 0;
+}
+
+int rmsgpack_skip(const uint8_t **ptr, const uint8_t *end)
+{
+   struct rmsgpack_raw raw;
+   /* Values still to skip, maps count twice */
+   uint64_t pending = 1;
+
+   while (pending--)
+   {
+      if (rmsgpack_read_raw(ptr, end, &raw) < 0)
+         return -1;
+      if (raw.type == RMSGPACK_RAW_MAP)
+         pending += (uint64_t)raw.val.len * 2;
+      else if (raw.type == RMSGPACK_RAW_ARRAY)
+         pending += raw.val.len;
+   }
+
+   return 0;
+}
@@ -57,4 +57,43 @@ int rmsgpack_write_uint(RFILE *fd, uint64_t value );
 
 int rmsgpack_read(RFILE *fd, struct rmsgpack_read_callbacks *callbacks, void *data);
 
+/* In-memory reading, for databases loaded or mapped in memory.
+ * Strings and binaries point into the buffer, which isn't copied:
+ * they are not null terminated. Maps and arrays only give their
+ * length, *ptr is then on their first element. */
+enum rmsgpack_raw_type
+{
+   RMSGPACK_RAW_NIL = 0,
+   RMSGPACK_RAW_BOOL,
+   RMSGPACK_RAW_UINT,
+   RMSGPACK_RAW_INT,
+   RMSGPACK_RAW_STRING,
+   RMSGPACK_RAW_BIN,
+   RMSGPACK_RAW_MAP,
+   RMSGPACK_RAW_ARRAY
+};
+
+struct rmsgpack_raw
+{
+   union
+   {
+      uint64_t uint_;
+      int64_t int_;
+      int bool_;
+      uint32_t len;   /* Map or array */
+      struct
+      {
+         const char *buff;
+         uint32_t len;
+      } buff;         /* String or binary */
+   } val;
+   enum rmsgpack_raw_type type;
+};
+
+int rmsgpack_read_raw(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_raw *out);
+
+/* Skips a whole value, maps and arrays included */
+int rmsgpack_skip(const uint8_t **ptr, const uint8_t *end);
+
 #endif
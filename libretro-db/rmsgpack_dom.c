@@ -496,3 +496,90 @@ clean:
    rmsgpack_dom_value_free(&map);
    return 0;
 }
+
+static int rmsgpack_dom_read_buf_depth(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_dom_value *out, unsigned depth)
+{
+   uint32_t i;
+   struct rmsgpack_raw raw;
+
+   out->type = RDT_NULL;
+
+   if (depth >= MAX_DEPTH || rmsgpack_read_raw(ptr, end, &raw) < 0)
+      return -1;
+
+   switch (raw.type)
+   {
+      case RMSGPACK_RAW_NIL:
+         break;
+      case RMSGPACK_RAW_BOOL:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = raw.val.bool_;
+         break;
+      case RMSGPACK_RAW_UINT:
+         out->type      = RDT_UINT;
+         out->val.uint_ = raw.val.uint_;
+         break;
+      case RMSGPACK_RAW_INT:
+         out->type      = RDT_INT;
+         out->val.int_  = raw.val.int_;
+         break;
+      case RMSGPACK_RAW_STRING:
+      case RMSGPACK_RAW_BIN:
+         /* Owned and null terminated, like rmsgpack_dom_read() */
+         if (!(out->val.string.buff = (char*)malloc(raw.val.buff.len + 1)))
+            return -1;
+         memcpy(out->val.string.buff, raw.val.buff.buff, raw.val.buff.len);
+         out->val.string.buff[raw.val.buff.len] = '\0';
+         out->val.string.len = raw.val.buff.len;
+         out->type           = (raw.type == RMSGPACK_RAW_STRING)
+            ? RDT_STRING : RDT_BINARY;
+         break;
+      case RMSGPACK_RAW_MAP:
+         out->type        = RDT_MAP;
+         out->val.map.len = 0;
+         if (!(out->val.map.items = (struct rmsgpack_dom_pair*)
+                  calloc(raw.val.len ? raw.val.len : 1,
+                     sizeof(struct rmsgpack_dom_pair))))
+            return -1;
+         for (i = 0; i < raw.val.len; i++)
+         {
+            out->val.map.len++;
+            if (rmsgpack_dom_read_buf_depth(ptr, end,
+                     &out->val.map.items[i].key, depth + 1) < 0)
+               return -1;
+            if (rmsgpack_dom_read_buf_depth(ptr, end,
+                     &out->val.map.items[i].value, depth + 1) < 0)
+               return -1;
+         }
+         break;
+      case RMSGPACK_RAW_ARRAY:
+         out->type          = RDT_ARRAY;
+         out->val.array.len = 0;
+         if (!(out->val.array.items = (struct rmsgpack_dom_value*)
+                  calloc(raw.val.len ? raw.val.len : 1,
+                     sizeof(struct rmsgpack_dom_value))))
+            return -1;
+         for (i = 0; i < raw.val.len; i++)
+         {
+            out->val.array.len++;
+            if (rmsgpack_dom_read_buf_depth(ptr, end,
+                     &out->val.array.items[i], depth + 1) < 0)
+               return -1;
+         }
+         break;
+   }
+
+   return 0;
+}
+
+int rmsgpack_dom_read_buf(const uint8_t **ptr, const uint8_t *end,
+      struct rmsgpack_dom_value *out)
+{
+   int rv;
+
+   if ((rv = rmsgpack_dom_read_buf_depth(ptr, end, out, 0)) < 0)
+      rmsgpack_dom_value_free(out);
+
+   return rv;
+}
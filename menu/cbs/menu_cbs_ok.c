@@ -8079,6 +8079,7 @@ static int action_ok_core_delete(const char *path,
 static int action_ok_delete_playlist(const char *path,
       const char *label, unsigned type, size_t idx, size_t entry_idx)
 {
+   char cache_path[PATH_MAX_LENGTH];
    playlist_t       *playlist = playlist_get_cached();
    struct menu_state *menu_st = menu_state_get_ptr();
 
@@ -8089,6 +8090,12 @@ static int action_ok_delete_playlist(const char *path,
 
    filestream_delete(path);
 
+   /* And its binary cache, if it has one */
+   strlcpy(cache_path, path, sizeof(cache_path));
+   strlcat(cache_path, PLAYLIST_CACHE_FILE_EXTENSION, sizeof(cache_path));
+   if (path_is_valid(cache_path))
+      filestream_delete(cache_path);
+
    if (menu_st->driver_ctx->environ_cb)
       menu_st->driver_ctx->environ_cb(MENU_ENVIRON_RESET_HORIZONTAL_LIST,
                NULL, menu_st->userdata);
@@ -64,6 +64,7 @@ int action_scan_file(const char *path,
          path_content_db,
          fullpath, false,
          show_hidden_files,
+         false,
          handle_dbscan_finished);
 
    return 0;
@@ -91,6 +92,7 @@ int action_scan_directory(const char *path,
          path_content_db,
          fullpath, true,
          show_hidden_files,
+         false,
          handle_dbscan_finished);
 
    return 0;
@@ -3837,6 +3837,29 @@ static void materialui_render(void *data,
          break;
    }
 
+   /* Prefetch thumbnails of the entries about to
+    * scroll on screen */
+   if (      mui->playlist
+         && (mui->last_onscreen_entry < entries_end)
+         && (   (materialui_render_process_entry
+                  == materialui_render_process_entry_playlist_thumb_list)
+             || (materialui_render_process_entry
+                  == materialui_render_process_entry_playlist_dual_icon)))
+   {
+      size_t first_idx = list->list[mui->first_onscreen_entry].entry_idx;
+      size_t last_idx  = list->list[mui->last_onscreen_entry].entry_idx;
+
+      if (first_idx <= last_idx)
+         gfx_thumbnail_prefetch(
+               menu_st->thumbnail_path_data,
+               mui->playlist,
+               first_idx, last_idx, last_idx - first_idx + 1,
+                  (mui->flags & MUI_FLAG_SECONDARY_THUMBNAIL_ENABLED)
+               || (materialui_render_process_entry
+                  == materialui_render_process_entry_playlist_dual_icon),
+               thumbnail_upscale_threshold);
+   }
+
    menu_st->entries.begin = mui->first_onscreen_entry;
 }
 
@@ -8034,7 +8057,9 @@ static void materialui_layout(
    p_disp->header_height = new_header_height;
 
    materialui_init_font(p_disp, &mui->font_data.title, title_font_size, video_is_threaded, "a");
+   font_driver_set_prewarm(true);
    materialui_init_font(p_disp, &mui->font_data.list, list_font_size, video_is_threaded, "a");
+   font_driver_set_prewarm(false);
    materialui_init_font(p_disp, &mui->font_data.hint, hint_font_size, video_is_threaded, "t");
 
    /* When updating the layout, the system bar
@@ -10298,6 +10323,7 @@ static void materialui_list_insert(
 
       node->thumbnails.primary.status        = GFX_THUMBNAIL_STATUS_UNKNOWN;
       node->thumbnails.primary.texture       = 0;
+      node->thumbnails.primary.cache_entry   = NULL;
       node->thumbnails.primary.width         = 0;
       node->thumbnails.primary.height        = 0;
       node->thumbnails.primary.alpha         = 0.0f;
@@ -10306,6 +10332,7 @@ static void materialui_list_insert(
 
       node->thumbnails.secondary.status      = GFX_THUMBNAIL_STATUS_UNKNOWN;
       node->thumbnails.secondary.texture     = 0;
+      node->thumbnails.secondary.cache_entry = NULL;
       node->thumbnails.secondary.width       = 0;
       node->thumbnails.secondary.height      = 0;
       node->thumbnails.secondary.alpha       = 0.0f;
@@ -9143,8 +9143,10 @@ static void ozone_set_layout(
       ozone->flags &= ~OZONE_FLAG_HAS_ALL_ASSETS;
 
    /* Entries */
+   font_driver_set_prewarm(true);
    font_inited = ozone_init_font(&ozone->fonts.entries_label,
          is_threaded, font_path, FONT_SIZE_ENTRIES_LABEL * scale_factor);
+   font_driver_set_prewarm(false);
    if (!(((ozone->flags & OZONE_FLAG_HAS_ALL_ASSETS) > 0) && font_inited))
       ozone->flags &= ~OZONE_FLAG_HAS_ALL_ASSETS;
 
@@ -10167,6 +10169,22 @@ static void ozone_render(void *data,
       }
    }
 
+   /* Prefetch thumbnails of the next playlist entries */
+   if (     ozone->show_thumbnail_bar
+         && (ozone->flags & OZONE_FLAG_IS_PLAYLIST)
+         && menu_st->thumbnail_path_data
+         && !string_is_empty(menu_st->thumbnail_path_data->content_path))
+   {
+      size_t playlist_idx = menu_st->thumbnail_path_data->playlist_index;
+
+      gfx_thumbnail_prefetch(
+            menu_st->thumbnail_path_data,
+            playlist_get_cached(),
+            playlist_idx, playlist_idx,
+            GFX_THUMBNAIL_PREFETCH_ENTRIES, true,
+            settings->uints.gfx_thumbnail_upscale_threshold);
+   }
+
    /* Handle any pending thumbnail load requests */
    if (ozone->show_thumbnail_bar && (ozone->thumbnails.pending != OZONE_PENDING_THUMBNAIL_NONE))
    {
@@ -4969,6 +4969,21 @@ static void xmb_render(void *data,
       }
    }
 
+   /* Prefetch thumbnails of the next playlist entries */
+   if (     xmb->is_playlist
+         && menu_st->thumbnail_path_data
+         && !string_is_empty(menu_st->thumbnail_path_data->content_path))
+   {
+      size_t playlist_idx = menu_st->thumbnail_path_data->playlist_index;
+
+      gfx_thumbnail_prefetch(
+            menu_st->thumbnail_path_data,
+            playlist_get_cached(),
+            playlist_idx, playlist_idx,
+            GFX_THUMBNAIL_PREFETCH_ENTRIES, true,
+            settings->uints.gfx_thumbnail_upscale_threshold);
+   }
+
    /* Handle any pending thumbnail load requests */
    if (xmb->thumbnails.pending != XMB_PENDING_THUMBNAIL_NONE)
    {
@@ -7362,7 +7377,9 @@ static void xmb_context_reset_internal(xmb_handle_t *xmb,
 
    fill_pathname_application_special(
          fontpath, sizeof(fontpath), APPLICATION_SPECIAL_DIRECTORY_ASSETS_XMB_FONT);
+   font_driver_set_prewarm(true);
    xmb->font            = gfx_display_font_file(p_disp, fontpath, xmb->font_size, is_threaded);
+   font_driver_set_prewarm(false);
    xmb->font2           = gfx_display_font_file(p_disp, fontpath, xmb->font2_size, is_threaded);
 
    xmb->wideglyph_width = 100;
@@ -1720,6 +1720,26 @@ static unsigned menu_displaylist_parse_supported_cores(menu_displaylist_info_t *
    return count;
 }
 
+#ifdef HAVE_REWIND
+static unsigned menu_displaylist_parse_rewind_tier(file_list_t *list,
+      enum msg_hash_enums label, enum msg_hash_enums value,
+      size_t bytes, unsigned entries)
+{
+   char entry[256];
+   size_t _len     = strlcpy(entry, msg_hash_to_str(value), sizeof(entry));
+   entry[  _len]   = ':';
+   entry[++_len]   = ' ';
+   entry[++_len]   = '\0';
+   snprintf(entry + _len, sizeof(entry) - _len,
+         msg_hash_to_str(MSG_REWIND_TIER_STATS),
+         bytes / (1024.0 * 1024.0), entries);
+   if (menu_entries_append(list, entry, msg_hash_to_str(label),
+         label, MENU_SETTINGS_CORE_INFO_NONE, 0, 0, NULL))
+      return 1;
+   return 0;
+}
+#endif
+
 static unsigned menu_displaylist_parse_system_info(file_list_t *list)
 {
    char entry[256];
@@ -9066,6 +9086,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_MOUSE_ENABLE,                                          PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_POINTER_ENABLE,                                        PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE,                          PARSE_ONLY_BOOL,   true},
+               {MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS,                         PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_TIMEOUT,                              PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_ANIMATION,                            PARSE_ONLY_UINT,   false},
                {MENU_ENUM_LABEL_MENU_SCREENSAVER_ANIMATION_SPEED,                      PARSE_ONLY_FLOAT,  false},
@@ -10966,6 +10987,11 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_REWIND_GRANULARITY,      PARSE_ONLY_UINT, false},
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE,      PARSE_ONLY_SIZE, false},
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP, PARSE_ONLY_UINT, false},
+               {MENU_ENUM_LABEL_REWIND_COLD_BUFFER_SIZE, PARSE_ONLY_SIZE, false},
+               {MENU_ENUM_LABEL_REWIND_SPILL_SIZE,       PARSE_ONLY_SIZE, false},
+#ifdef HAVE_THREADS
+               {MENU_ENUM_LABEL_REWIND_THREADED,         PARSE_ONLY_BOOL, false},
+#endif
             };
 
             for (i = 0; i < ARRAY_SIZE(build_list); i++)
@@ -10975,6 +11001,9 @@ unsigned menu_displaylist_build_list(
                   case MENU_ENUM_LABEL_REWIND_GRANULARITY:
                   case MENU_ENUM_LABEL_REWIND_BUFFER_SIZE:
                   case MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP:
+                  case MENU_ENUM_LABEL_REWIND_THREADED:
+                  case MENU_ENUM_LABEL_REWIND_COLD_BUFFER_SIZE:
+                  case MENU_ENUM_LABEL_REWIND_SPILL_SIZE:
                      if (rewind_enable)
                         build_list[i].checked = true;
                      break;
@@ -10993,6 +11022,33 @@ unsigned menu_displaylist_build_list(
                         false) == 0)
                   count++;
             }
+
+#ifdef HAVE_REWIND
+            /* Current size of each tier of the rewind buffer */
+            {
+               struct state_manager_tier_stats stats;
+               runloop_state_t *runloop_st = runloop_state_get_ptr();
+
+               if (state_manager_get_tier_stats(&runloop_st->rewind_st,
+                        &stats))
+               {
+                  count += menu_displaylist_parse_rewind_tier(list,
+                        MENU_ENUM_LABEL_REWIND_TIER_HOT,
+                        MENU_ENUM_LABEL_VALUE_REWIND_TIER_HOT,
+                        stats.hot_bytes, stats.hot_entries);
+                  if (settings->sizes.rewind_cold_buffer_size)
+                     count += menu_displaylist_parse_rewind_tier(list,
+                           MENU_ENUM_LABEL_REWIND_TIER_COLD,
+                           MENU_ENUM_LABEL_VALUE_REWIND_TIER_COLD,
+                           stats.cold_bytes, stats.cold_entries);
+                  if (settings->sizes.rewind_spill_size)
+                     count += menu_displaylist_parse_rewind_tier(list,
+                           MENU_ENUM_LABEL_REWIND_TIER_SPILL,
+                           MENU_ENUM_LABEL_VALUE_REWIND_TIER_SPILL,
+                           stats.spill_bytes, stats.spill_entries);
+               }
+            }
+#endif
          }
          break;
       case DISPLAYLIST_FRAME_THROTTLE_SETTINGS_LIST:
@@ -11121,6 +11177,8 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_MENU_XMB_THUMBNAIL_SCALE_FACTOR,              PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_OZONE_THUMBNAIL_SCALE_FACTOR,                 PARSE_ONLY_FLOAT,  true},
                {MENU_ENUM_LABEL_MENU_THUMBNAIL_UPSCALE_THRESHOLD,             PARSE_ONLY_UINT,   true},
+               {MENU_ENUM_LABEL_IMAGE_CACHE_SIZE,                             PARSE_ONLY_UINT,   true},
+               {MENU_ENUM_LABEL_MENU_THUMBNAIL_CACHE_SIZE,                    PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_MENU_RGUI_SWAP_THUMBNAILS,                    PARSE_ONLY_BOOL,   true},
                {MENU_ENUM_LABEL_MENU_RGUI_THUMBNAIL_DOWNSCALER,               PARSE_ONLY_UINT,   true},
                {MENU_ENUM_LABEL_MENU_RGUI_THUMBNAIL_DELAY,                    PARSE_ONLY_UINT,   true},
@@ -65,6 +65,7 @@
 #endif
 
 #include "../gfx/gfx_animation.h"
+#include "../gfx/gfx_thumbnail.h"
 #include "../input/input_driver.h"
 #include "../input/input_remapping.h"
 #include "../performance_counters.h"
@@ -6593,6 +6594,10 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
                && menu_st->driver_ctx->context_destroy)
             menu_st->driver_ctx->context_destroy(menu_st->userdata);
 
+         /* Thumbnails have been reset by context_destroy,
+          * cached textures can go */
+         gfx_thumbnail_flush_cache();
+
          if (menu_st->flags & MENU_ST_FLAG_DATA_OWN)
             return true;
 
@@ -582,6 +582,7 @@ typedef struct menu_ctx_bind
 
 #if defined(HAVE_LIBRETRODB)
 typedef struct explore_state explore_state_t;
+typedef struct explore_build explore_build_t;
 #endif
 
 typedef struct
@@ -600,6 +601,14 @@ typedef struct
 #if defined(HAVE_LIBRETRODB)
 explore_state_t *menu_explore_build_list(const char *directory_playlist,
       const char *directory_database);
+/* Same as menu_explore_build_list(), in stages: the database scans
+ * are independent and can run on several threads at once */
+explore_build_t *menu_explore_build_begin(const char *directory_playlist,
+      const char *directory_database);
+size_t menu_explore_build_get_scan_count(explore_build_t *build);
+void menu_explore_build_scan(explore_build_t *build, size_t i);
+explore_state_t *menu_explore_build_end(explore_build_t *build);
+void menu_explore_build_free(explore_build_t *build);
 uintptr_t menu_explore_get_entry_icon(unsigned type);
 ssize_t menu_explore_get_entry_playlist_index(unsigned type,
       playlist_t **playlist, const struct playlist_entry **entry,
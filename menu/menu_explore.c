@@ -20,9 +20,12 @@
 #include <compat/strl.h>
 #include <array/rbuf.h>
 #include <array/rhmap.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
 #include <formats/rjson.h>
 #include <formats/rjson_helpers.h>
 #include <retro_endianness.h>
+#include <streams/file_stream.h>
 
 #include "menu_driver.h"
 #include "menu_cbs.h"
@@ -84,6 +87,16 @@ enum
    EXPLORE_TYPE_FIRSTITEM        = EXPLORE_TYPE_FIRSTCATEGORY + EXPLORE_CAT_COUNT
 };
 
+/* Fields of a database record kept for explore */
+#define EXPLORE_META_ORIGINAL_TITLE EXPLORE_CAT_COUNT
+#define EXPLORE_META_FIELDS         (EXPLORE_CAT_COUNT + 1)
+
+/* Index cache, kept in the playlist directory */
+#define EXPLORE_CACHE_FILE          "explore_index.cache"
+#define EXPLORE_CACHE_MAGIC         "RAEXIDX"
+#define EXPLORE_CACHE_MAGIC_LEN     8
+#define EXPLORE_CACHE_VERSION       1
+
 /* Arena allocator */
 typedef struct ex_arena
 {
@@ -450,47 +463,661 @@ static void explore_load_icons(explore_state_t *state)
    }
 }
 
-explore_state_t *menu_explore_build_list(const char *directory_playlist,
-      const char *directory_database)
+/* Metadata of a database record, raw: numbers and booleans as
+ * decimal strings, empty fields as NULL */
+typedef struct
 {
-   unsigned i;
-   char tmp[PATH_MAX_LENGTH];
-   struct explore_source
+   const char *fields[EXPLORE_META_FIELDS];
+} explore_meta_t;
+
+/* A playlist entry looked up in a database, by CRC or by label */
+struct explore_source
+{
+   const struct playlist_entry *source;
+   const explore_meta_t *meta;   /* Best matching record, if any */
+   uint32_t meta_count;
+   bool resolved;                /* From the cache or scanned */
+};
+
+struct explore_rdb
+{
+   ex_arena arena;               /* Metadata found by the scan */
+   struct explore_source *playlist_crcs;
+   struct explore_source *playlist_names;
+   int64_t size;                 /* -1 if the file is missing */
+   int64_t mtime;
+   size_t pending;               /* Sources left to resolve */
+   char name[256];               /* As referenced by playlists */
+   char systemname[256];
+   char path[PATH_MAX_LENGTH];
+};
+
+struct explore_stamp
+{
+   const char *name;
+   int64_t size;
+   int64_t mtime;
+};
+
+struct explore_shard_entry
+{
+   uint32_t index;               /* Playlist entry */
+   explore_meta_t meta;
+};
+
+/* What the databases had for the entries of one playlist, valid as
+ * long as the playlist and the databases it references don't change */
+typedef struct
+{
+   const char *name;
+   struct explore_stamp *rdbs;
+   struct explore_shard_entry *entries;
+   int64_t size;
+   int64_t mtime;
+   uint32_t crc;
+} explore_shard_t;
+
+/* Playlist entry resolved through a database */
+struct explore_ref
+{
+   const char *label;
+   uint32_t index;
+   uint32_t crc;
+   int rdb_num;
+};
+
+struct explore_playlist
+{
+   char *name;
+   const explore_shard_t *shard; /* Reused shard, NULL if rebuilt */
+   struct explore_ref *refs;
+   int *rdb_nums;
+   int64_t size;
+   int64_t mtime;
+   uint32_t crc;
+};
+
+struct explore_scan_order
+{
+   int64_t size;
+   int rdb;
+};
+
+struct explore_build
+{
+   explore_state_t *state;
+   struct explore_rdb *rdbs;
+   struct explore_playlist *playlists;
+   explore_shard_t *shards;
+   int *rdb_indices;
+   int *scan;
+   uint8_t *cache_data;
+   size_t num_shards;
+   char cache_path[PATH_MAX_LENGTH];
+};
+
+typedef struct
+{
+   const uint8_t *ptr;
+   const uint8_t *end;
+   bool error;
+} explore_reader_t;
+
+static const char *explore_arena_strdup(ex_arena *arena, const char *str)
+{
+   char *copy;
+   size_t len;
+
+   if (!str || !*str)
+      return NULL;
+
+   len  = strlen(str) + 1;
+   copy = (char*)ex_arena_alloc(arena, len);
+   memcpy(copy, str, len);
+   return copy;
+}
+
+/* Cache file, little endian */
+
+static uint32_t explore_read_u32(explore_reader_t *r)
+{
+   uint32_t v = 0;
+   if (r->end - r->ptr < 4)
+      r->error = true;
+   else
    {
-      const struct playlist_entry *source;
-      uint32_t entry_index, meta_count;
-   };
-   struct explore_rdb
+      memcpy(&v, r->ptr, 4);
+      r->ptr += 4;
+   }
+   return swap_if_big32(v);
+}
+
+static int64_t explore_read_i64(explore_reader_t *r)
+{
+   uint64_t v = 0;
+   if (r->end - r->ptr < 8)
+      r->error = true;
+   else
    {
-      libretrodb_t *handle;
-      struct explore_source *playlist_crcs;
-      struct explore_source *playlist_names;
-      size_t count;
-      char systemname[256];
+      memcpy(&v, r->ptr, 8);
+      r->ptr += 8;
    }
-   *rdbs                                          = NULL;
-   int *rdb_indices                               = NULL;
-   explore_string_t **cat_maps[EXPLORE_CAT_COUNT] = {NULL};
-   explore_string_t **split_buf                   = NULL;
-   libretro_vfs_implementation_dir *dir           = NULL;
+   return (int64_t)swap_if_big64(v);
+}
 
-   explore_state_t *state = (explore_state_t*)calloc(1, sizeof(*state));
+/* Strings are stored null terminated and used in place */
+static const char *explore_read_str(explore_reader_t *r)
+{
+   const char *str;
+   uint32_t len = explore_read_u32(r);
 
-   if (!state)
+   if (r->error || (size_t)(r->end - r->ptr) <= len || r->ptr[len] != '\0')
+   {
+      r->error = true;
       return NULL;
+   }
+   str     = (const char*)r->ptr;
+   r->ptr += len + 1;
+   return str;
+}
+
+static void explore_write(uint8_t **buf, const void *data, size_t len)
+{
+   size_t pos = RBUF_LEN(*buf);
+   RBUF_RESIZE(*buf, pos + len);
+   memcpy(*buf + pos, data, len);
+}
+
+static void explore_write_u32(uint8_t **buf, uint32_t v)
+{
+   v = swap_if_big32(v);
+   explore_write(buf, &v, 4);
+}
 
-   state->label_explore_item_str    = 
+static void explore_write_i64(uint8_t **buf, int64_t v)
+{
+   uint64_t u = swap_if_big64((uint64_t)v);
+   explore_write(buf, &u, 8);
+}
+
+static void explore_write_str(uint8_t **buf, const char *str)
+{
+   size_t len = strlen(str);
+   explore_write_u32(buf, (uint32_t)len);
+   explore_write(buf, str, len + 1);
+}
+
+static void explore_free_shards(struct explore_build *build)
+{
+   size_t i;
+
+   for (i = 0; i < build->num_shards; i++)
+   {
+      RBUF_FREE(build->shards[i].rdbs);
+      RBUF_FREE(build->shards[i].entries);
+   }
+   free(build->shards);
+   free(build->cache_data);
+   build->shards     = NULL;
+   build->cache_data = NULL;
+   build->num_shards = 0;
+}
+
+static bool explore_load_cache(struct explore_build *build)
+{
+   size_t i;
+   explore_reader_t r;
+   int64_t len    = 0;
+   void *buf      = NULL;
+   uint32_t count = 0;
+
+   if (     !path_is_valid(build->cache_path)
+         || !filestream_read_file(build->cache_path, &buf, &len))
+      return false;
+
+   build->cache_data = (uint8_t*)buf;
+   r.ptr             = build->cache_data;
+   r.end             = build->cache_data + len;
+   r.error           = false;
+
+   if (     len < EXPLORE_CACHE_MAGIC_LEN
+         || memcmp(r.ptr, EXPLORE_CACHE_MAGIC, EXPLORE_CACHE_MAGIC_LEN))
+      goto error;
+   r.ptr += EXPLORE_CACHE_MAGIC_LEN;
+
+   if (explore_read_u32(&r) != EXPLORE_CACHE_VERSION)
+      goto error;
+   count = explore_read_u32(&r);
+   if (r.error || count > (uint32_t)len)
+      goto error;
+
+   if (!(build->shards = (explore_shard_t*)calloc(count, sizeof(explore_shard_t))))
+      goto error;
+   build->num_shards = count;
+
+   for (i = 0; i < count && !r.error; i++)
+   {
+      uint32_t j, num;
+      const char **strings   = NULL;
+      explore_shard_t *shard = &build->shards[i];
+
+      shard->name  = explore_read_str(&r);
+      shard->size  = explore_read_i64(&r);
+      shard->mtime = explore_read_i64(&r);
+      shard->crc   = explore_read_u32(&r);
+
+      num          = explore_read_u32(&r);
+      for (j = 0; j < num && !r.error; j++)
+      {
+         struct explore_stamp stamp;
+         stamp.name  = explore_read_str(&r);
+         stamp.size  = explore_read_i64(&r);
+         stamp.mtime = explore_read_i64(&r);
+         RBUF_PUSH(shard->rdbs, stamp);
+      }
+
+      num          = explore_read_u32(&r);
+      for (j = 0; j < num && !r.error; j++)
+      {
+         const char *str = explore_read_str(&r);
+         RBUF_PUSH(strings, str);
+      }
+
+      num          = explore_read_u32(&r);
+      for (j = 0; j < num && !r.error; j++)
+      {
+         unsigned k;
+         struct explore_shard_entry entry;
+         uint32_t mask = 0;
+
+         entry.index   = explore_read_u32(&r);
+         mask          = explore_read_u32(&r);
+         if (mask >> EXPLORE_META_FIELDS)
+            r.error    = true;
+         for (k = 0; k < EXPLORE_META_FIELDS; k++)
+         {
+            uint32_t str  = 0;
+            if (mask & (1u << k))
+               str        = explore_read_u32(&r) + 1;
+            if (str > RBUF_LEN(strings))
+               r.error    = true;
+            entry.meta.fields[k] = (str && !r.error) ? strings[str - 1] : NULL;
+         }
+         RBUF_PUSH(shard->entries, entry);
+      }
+
+      RBUF_FREE(strings);
+   }
+
+   if (r.error)
+      goto error;
+   return true;
+
+error:
+   explore_free_shards(build);
+   return false;
+}
+
+static void explore_write_shard(uint8_t **buf,
+      const char *name, int64_t size, int64_t mtime, uint32_t crc,
+      const struct explore_stamp *rdbs, size_t num_rdbs,
+      const struct explore_shard_entry *entries, size_t num_entries)
+{
+   size_t i;
+   unsigned k;
+   uint32_t *string_indices = NULL;
+   const char **strings     = NULL;
+
+   explore_write_str(buf, name);
+   explore_write_i64(buf, size);
+   explore_write_i64(buf, mtime);
+   explore_write_u32(buf, crc);
+
+   explore_write_u32(buf, (uint32_t)num_rdbs);
+   for (i = 0; i < num_rdbs; i++)
+   {
+      explore_write_str(buf, rdbs[i].name);
+      explore_write_i64(buf, rdbs[i].size);
+      explore_write_i64(buf, rdbs[i].mtime);
+   }
+
+   /* Each distinct string once per shard, entries refer to them */
+   for (i = 0; i < num_entries; i++)
+      for (k = 0; k < EXPLORE_META_FIELDS; k++)
+      {
+         const char *str = entries[i].meta.fields[k];
+         if (str && !RHMAP_HAS_STR(string_indices, str))
+         {
+            RHMAP_SET_STR(string_indices, str, (uint32_t)RBUF_LEN(strings));
+            RBUF_PUSH(strings, str);
+         }
+      }
+
+   explore_write_u32(buf, (uint32_t)RBUF_LEN(strings));
+   for (i = 0; i < RBUF_LEN(strings); i++)
+      explore_write_str(buf, strings[i]);
+
+   explore_write_u32(buf, (uint32_t)num_entries);
+   for (i = 0; i < num_entries; i++)
+   {
+      uint32_t mask = 0;
+      for (k = 0; k < EXPLORE_META_FIELDS; k++)
+         if (entries[i].meta.fields[k])
+            mask |= 1u << k;
+      explore_write_u32(buf, entries[i].index);
+      explore_write_u32(buf, mask);
+      for (k = 0; k < EXPLORE_META_FIELDS; k++)
+         if (entries[i].meta.fields[k])
+            explore_write_u32(buf,
+                  RHMAP_GET_STR(string_indices, entries[i].meta.fields[k]));
+   }
+
+   RHMAP_FREE(string_indices);
+   RBUF_FREE(strings);
+}
+
+static void explore_save_cache(struct explore_build *build)
+{
+   size_t i, j;
+   char tmp_path[PATH_MAX_LENGTH];
+   uint8_t *buf = NULL;
+
+   explore_write(&buf, EXPLORE_CACHE_MAGIC, EXPLORE_CACHE_MAGIC_LEN);
+   explore_write_u32(&buf, EXPLORE_CACHE_VERSION);
+   explore_write_u32(&buf, (uint32_t)RBUF_LEN(build->playlists));
+
+   for (i = 0; i < RBUF_LEN(build->playlists); i++)
+   {
+      struct explore_playlist *pl = &build->playlists[i];
+
+      if (pl->shard)
+         explore_write_shard(&buf, pl->name, pl->size, pl->mtime, pl->crc,
+               pl->shard->rdbs, RBUF_LEN(pl->shard->rdbs),
+               pl->shard->entries, RBUF_LEN(pl->shard->entries));
+      else
+      {
+         struct explore_stamp *stamps        = NULL;
+         struct explore_shard_entry *entries = NULL;
+
+         for (j = 0; j < RBUF_LEN(pl->rdb_nums); j++)
+         {
+            struct explore_rdb *rdb = &build->rdbs[pl->rdb_nums[j] - 1];
+            struct explore_stamp stamp;
+            stamp.name  = rdb->name;
+            stamp.size  = rdb->size;
+            stamp.mtime = rdb->mtime;
+            RBUF_PUSH(stamps, stamp);
+         }
+
+         for (j = 0; j < RBUF_LEN(pl->refs); j++)
+         {
+            struct explore_ref *ref   = &pl->refs[j];
+            struct explore_rdb *rdb   = &build->rdbs[ref->rdb_num - 1];
+            struct explore_source *src = NULL;
+            ptrdiff_t idx;
+
+            if (ref->crc)
+            {
+               idx = RHMAP_IDX(rdb->playlist_crcs, ref->crc);
+               src = (idx != -1 ? &rdb->playlist_crcs[idx] : NULL);
+            }
+            else
+            {
+               idx = RHMAP_IDX_STR(rdb->playlist_names, ref->label);
+               src = (idx != -1 ? &rdb->playlist_names[idx] : NULL);
+            }
+
+            if (src && src->meta)
+            {
+               struct explore_shard_entry entry;
+               entry.index = ref->index;
+               entry.meta  = *src->meta;
+               RBUF_PUSH(entries, entry);
+            }
+         }
+
+         explore_write_shard(&buf, pl->name, pl->size, pl->mtime, pl->crc,
+               stamps, RBUF_LEN(stamps), entries, RBUF_LEN(entries));
+         RBUF_FREE(stamps);
+         RBUF_FREE(entries);
+      }
+   }
+
+   /* Written aside and renamed over the old cache, so a crash
+    * never leaves a torn file behind */
+   strlcpy(tmp_path, build->cache_path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (     !filestream_write_file(tmp_path, buf, RBUF_LEN(buf))
+         || (path_is_valid(build->cache_path)
+            && filestream_delete(build->cache_path) != 0)
+         || filestream_rename(tmp_path, build->cache_path) != 0)
+   {
+      RARCH_WARN("[Explore]: Failed to write index cache \"%s\".\n",
+            build->cache_path);
+      filestream_delete(tmp_path);
+   }
+   RBUF_FREE(buf);
+}
+
+/* Returns the 1-based index of the database @db_name refers to,
+ * adding it if needed */
+static int explore_get_rdb(struct explore_build *build,
+      const char *directory_database, const char *db_name)
+{
+   int rdb_num;
+   size_t systemname_len;
+   struct explore_rdb newrdb;
+   char *ext_path     = NULL;
+   const char *db_ext = strrchr(db_name, '.');
+   uint32_t rdb_hash;
+
+   if (!db_ext)
+      db_ext = db_name + strlen(db_name);
+   rdb_hash = ex_hash32_nocase_filtered(
+         (unsigned char*)db_name, db_ext - db_name, '0', 255);
+
+   if ((rdb_num = RHMAP_GET(build->rdb_indices, rdb_hash)))
+      return rdb_num;
+
+   memset(&newrdb, 0, sizeof(newrdb));
+   strlcpy(newrdb.name, db_name, sizeof(newrdb.name));
+
+   systemname_len        = db_ext - db_name;
+   if (systemname_len >= sizeof(newrdb.systemname))
+      systemname_len     = sizeof(newrdb.systemname)-1;
+   memcpy(newrdb.systemname, db_name, systemname_len);
+   newrdb.systemname[systemname_len] = '\0';
+
+   fill_pathname_join_special(newrdb.path, directory_database, db_name,
+         sizeof(newrdb.path));
+
+   /* Replace the extension - change 'lpl' to 'rdb' */
+   if ((    ext_path = path_get_extension_mutable(newrdb.path))
+         && ext_path[0] == '.'
+         && ext_path[1] == 'l'
+         && ext_path[2] == 'p'
+         && ext_path[3] == 'l')
+   {
+      ext_path[1] = 'r';
+      ext_path[2] = 'd';
+      ext_path[3] = 'b';
+   }
+
+   if (!path_get_size_mtime(newrdb.path, &newrdb.size, &newrdb.mtime))
+   {
+      newrdb.size  = -1;
+      newrdb.mtime = 0;
+   }
+
+   RBUF_PUSH(build->rdbs, newrdb);
+   rdb_num = (int)RBUF_LEN(build->rdbs);
+   RHMAP_SET(build->rdb_indices, rdb_hash, rdb_num);
+   return rdb_num;
+}
+
+/* Keeps what is known of a key when another entry takes its place */
+static void explore_set_source(struct explore_source *old,
+      struct explore_source *src)
+{
+   if (!src->resolved && old->resolved)
+   {
+      src->meta     = old->meta;
+      src->resolved = true;
+   }
+   *old = *src;
+}
+
+static const explore_shard_t *explore_find_shard(
+      struct explore_build *build, struct explore_playlist *pl,
+      const char *path, const char *directory_database)
+{
+   size_t i;
+   const explore_shard_t *shard = NULL;
+   bool crc_done                = false;
+
+   for (i = 0; i < build->num_shards; i++)
+      if (string_is_equal(build->shards[i].name, pl->name))
+      {
+         shard = &build->shards[i];
+         break;
+      }
+
+   /* Same size and date, or a touched file with the same content */
+   if (     !shard
+         || shard->size != pl->size
+         || shard->mtime != pl->mtime)
+   {
+      void *buf   = NULL;
+      int64_t len = 0;
+
+      if (filestream_read_file(path, &buf, &len))
+      {
+         pl->crc  = encoding_crc32(0, (const uint8_t*)buf, (size_t)len);
+         crc_done = true;
+         free(buf);
+      }
+
+      if (     !shard
+            || !crc_done
+            || shard->size != pl->size
+            || shard->crc != pl->crc)
+         return NULL;
+   }
+   else
+      pl->crc = shard->crc;
+
+   for (i = 0; i < RBUF_LEN(shard->rdbs); i++)
+   {
+      int rdb_num             = explore_get_rdb(build,
+            directory_database, shard->rdbs[i].name);
+      struct explore_rdb *rdb = &build->rdbs[rdb_num - 1];
+      if (     rdb->size  != shard->rdbs[i].size
+            || rdb->mtime != shard->rdbs[i].mtime)
+         return NULL;
+   }
+
+   return shard;
+}
+
+static int explore_scan_cmp(const void *a_, const void *b_)
+{
+   const struct explore_scan_order *a = (const struct explore_scan_order*)a_;
+   const struct explore_scan_order *b = (const struct explore_scan_order*)b_;
+   return (a->size < b->size) - (a->size > b->size);
+}
+
+static void explore_add_entry(explore_state_t *state,
+      explore_string_t **cat_maps[EXPLORE_CAT_COUNT],
+      explore_string_t ***split_buf,
+      const struct playlist_entry *source, const explore_meta_t *meta,
+      const char *systemname)
+{
+   unsigned cat;
+   explore_entry_t *e;
+   const char *fields[EXPLORE_CAT_COUNT];
+   size_t len = RBUF_LEN(state->entries);
+
+   RBUF_RESIZE(state->entries, len + 1);
+   e                 = &state->entries[len];
+   e->playlist_entry = source;
+   e->split          = NULL;
+#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
+   e->original_title = NULL;
+#endif
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+   {
+      e->by[cat]  = NULL;
+      fields[cat] = meta->fields[cat];
+      if (fields[cat] && explore_by_info[cat].is_boolean)
+         fields[cat] = msg_hash_to_str(string_is_equal(fields[cat], "0")
+               ? MENU_ENUM_LABEL_VALUE_NO : MENU_ENUM_LABEL_VALUE_YES);
+   }
+   fields[EXPLORE_BY_SYSTEM] = systemname;
+
+   for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+      explore_add_unique_string(state, cat_maps, e, cat, fields[cat],
+            split_buf);
+
+#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
+   if (meta->fields[EXPLORE_META_ORIGINAL_TITLE])
+   {
+      size_t len        =
+         strlen(meta->fields[EXPLORE_META_ORIGINAL_TITLE]) + 1;
+      e->original_title = (char*)ex_arena_alloc(&state->arena, len);
+      memcpy(e->original_title,
+            meta->fields[EXPLORE_META_ORIGINAL_TITLE], len);
+   }
+#endif
+
+   if (RBUF_LEN(*split_buf))
+   {
+      size_t len;
+
+      RBUF_PUSH(*split_buf, NULL); /* terminator */
+      len        = RBUF_SIZEOF(*split_buf);
+      e->split   = (explore_string_t **)
+         ex_arena_alloc(&state->arena, len);
+      memcpy(e->split, *split_buf, len);
+      RBUF_CLEAR(*split_buf);
+   }
+}
+
+explore_build_t *menu_explore_build_begin(const char *directory_playlist,
+      const char *directory_database)
+{
+   size_t i, j;
+   libretro_vfs_implementation_dir *dir = NULL;
+   struct explore_build *build          = (struct explore_build*)
+      calloc(1, sizeof(*build));
+
+   if (!build)
+      return NULL;
+
+   if (!(build->state = (explore_state_t*)calloc(1, sizeof(*build->state))))
+   {
+      free(build);
+      return NULL;
+   }
+
+   build->state->label_explore_item_str =
       msg_hash_to_str(MENU_ENUM_LABEL_EXPLORE_ITEM);
 
+   fill_pathname_join_special(build->cache_path, directory_playlist,
+         EXPLORE_CACHE_FILE, sizeof(build->cache_path));
+   explore_load_cache(build);
+
    /* Index all playlists */
    for (dir = retro_vfs_opendir_impl(directory_playlist, false); dir;)
    {
       playlist_config_t playlist_config;
-      size_t j, used_entries                    = 0;
+      struct explore_playlist pl;
+      size_t used_entries                       = 0;
+      size_t shard_pos                          = 0;
       playlist_t *playlist                      = NULL;
       const char *fext                          = NULL;
       const char *fname                         = NULL;
-      uint32_t fhash                            = 0;
 
       playlist_config.path[0]                   = '\0';
       playlist_config.base_content_directory[0] = '\0';
@@ -515,22 +1142,26 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
 
       fill_pathname_join_special(playlist_config.path,
             directory_playlist, fname, sizeof(playlist_config.path));
+
+      memset(&pl, 0, sizeof(pl));
+      pl.name = strdup(fname);
+      if (!path_get_size_mtime(playlist_config.path, &pl.size, &pl.mtime))
+         pl.size = -1;
+      pl.shard  = explore_find_shard(build, &pl, playlist_config.path,
+            directory_database);
+
       playlist_config.capacity          = COLLECTION_SIZE;
       playlist                          = playlist_init(&playlist_config);
 
-      fhash = ex_hash32_nocase_filtered(
-            (unsigned char*)fname, fext - fname, '0', 255);
-
       for (j = 0; j < playlist_size(playlist); j++)
       {
          int rdb_num;
          uint32_t entry_crc32;
-         struct explore_source src = { NULL, (uint32_t)-1, 0 };
+         ptrdiff_t idx;
+         struct explore_source src           = { NULL, NULL, 0, false };
          struct explore_rdb* rdb             = NULL;
          const struct playlist_entry *entry  = NULL;
          const char *db_name                 = fname;
-         const char *db_ext                  = fext;
-         uint32_t rdb_hash                   = fhash;
          playlist_get_index(playlist, j, &entry);
 
          /* We also could build label from file name, for now it's required */
@@ -541,271 +1172,337 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
           * lpl file name and we can just use that */
          if (entry->db_name && *entry->db_name
                && strcasecmp(entry->db_name, fname))
-         {
             db_name = entry->db_name;
-            db_ext = strrchr(db_name, '.');
-            if (!db_ext)
-               db_ext = db_name + strlen(db_name);
-            rdb_hash = ex_hash32_nocase_filtered(
-               (unsigned char*)db_name, db_ext - db_name, '0', 255);
-         }
-
-         rdb_num = RHMAP_GET(rdb_indices, rdb_hash);
-         if (!rdb_num)
-         {
-            size_t systemname_len;
-            struct explore_rdb newrdb;
-            char *ext_path        = NULL;
-
-            newrdb.handle         = libretrodb_new();
-            newrdb.count          = 0;
-            newrdb.playlist_crcs  = NULL;
-            newrdb.playlist_names = NULL;
-
-            systemname_len        = db_ext - db_name;
-            if (systemname_len >= sizeof(newrdb.systemname))
-               systemname_len     = sizeof(newrdb.systemname)-1;
-            memcpy(newrdb.systemname, db_name, systemname_len);
-            newrdb.systemname[systemname_len] = '\0';
-
-            fill_pathname_join_special(
-                  tmp, directory_database, db_name, sizeof(tmp));
-
-            /* Replace the extension - change 'lpl' to 'rdb' */
-            if ((    ext_path = path_get_extension_mutable(tmp)) 
-                  && ext_path[0] == '.'
-                  && ext_path[1] == 'l'
-                  && ext_path[2] == 'p'
-                  && ext_path[3] == 'l')
-            {
-               ext_path[1] = 'r';
-               ext_path[2] = 'd';
-               ext_path[3] = 'b';
-            }
 
-            if (libretrodb_open(tmp, newrdb.handle, false) != 0)
-            {
-               /* Invalid RDB file */
-               libretrodb_free(newrdb.handle);
-               RHMAP_SET(rdb_indices, rdb_hash, -1);
-               continue;
-            }
+         rdb_num = explore_get_rdb(build, directory_database, db_name);
+         rdb     = &build->rdbs[rdb_num - 1];
 
-            RBUF_PUSH(rdbs, newrdb);
-            rdb_num = (int)RBUF_LEN(rdbs);
-            RHMAP_SET(rdb_indices, rdb_hash, rdb_num);
-         }
+         for (i = 0; i < RBUF_LEN(pl.rdb_nums); i++)
+            if (pl.rdb_nums[i] == rdb_num)
+               break;
+         if (i == RBUF_LEN(pl.rdb_nums))
+            RBUF_PUSH(pl.rdb_nums, rdb_num);
 
-         if ((uintptr_t)rdb_num == (uintptr_t)-1)
+         /* Invalid RDB file */
+         if (rdb->size < 0)
             continue;
 
-         rdb = &rdbs[rdb_num - 1];
-         rdb->count++;
+         src.source  = entry;
+         if (pl.shard)
+         {
+            const struct explore_shard_entry *entries = pl.shard->entries;
+            while (     shard_pos < RBUF_LEN(entries)
+                  && entries[shard_pos].index < j)
+               shard_pos++;
+            if (     shard_pos < RBUF_LEN(entries)
+                  && entries[shard_pos].index == j)
+               src.meta = &entries[shard_pos].meta;
+            src.resolved = true;
+         }
+
          entry_crc32 = (uint32_t)strtoul(
                (entry->crc32 ? entry->crc32 : ""), NULL, 16);
-         src.source = entry;
          if (entry_crc32)
          {
-            RHMAP_SET(rdb->playlist_crcs, entry_crc32, src);
+            if ((idx = RHMAP_IDX(rdb->playlist_crcs, entry_crc32)) != -1)
+               explore_set_source(&rdb->playlist_crcs[idx], &src);
+            else
+               RHMAP_SET(rdb->playlist_crcs, entry_crc32, src);
          }
          else
          {
-            RHMAP_SET_STR(rdb->playlist_names, entry->label, src);
+            if ((idx = RHMAP_IDX_STR(rdb->playlist_names, entry->label)) != -1)
+               explore_set_source(&rdb->playlist_names[idx], &src);
+            else
+               RHMAP_SET_STR(rdb->playlist_names, entry->label, src);
+         }
+
+         if (!pl.shard)
+         {
+            struct explore_ref ref;
+            ref.label   = entry->label;
+            ref.index   = (uint32_t)j;
+            ref.crc     = entry_crc32;
+            ref.rdb_num = rdb_num;
+            RBUF_PUSH(pl.refs, ref);
          }
          used_entries++;
       }
 
       if (used_entries)
-         RBUF_PUSH(state->playlists, playlist);
+         RBUF_PUSH(build->state->playlists, playlist);
       else
          playlist_free(playlist);
+
+      RBUF_PUSH(build->playlists, pl);
+   }
+
+   /* Databases with entries the cache doesn't know about need
+    * scanning, biggest first so that scans spread evenly */
+   for (i = 0; i < RBUF_LEN(build->rdbs); i++)
+   {
+      struct explore_rdb *rdb = &build->rdbs[i];
+
+      for (j = 0; j < RHMAP_CAP(rdb->playlist_crcs); j++)
+         if (RHMAP_KEY(rdb->playlist_crcs, j)
+               && !rdb->playlist_crcs[j].resolved)
+            rdb->pending++;
+      for (j = 0; j < RHMAP_CAP(rdb->playlist_names); j++)
+         if (RHMAP_KEY(rdb->playlist_names, j)
+               && !rdb->playlist_names[j].resolved)
+            rdb->pending++;
+
+      if (rdb->pending)
+         RBUF_PUSH(build->scan, (int)i);
    }
 
-   /* Loop through all RDBs referenced in the playlists 
-    * and load meta data strings */
-   for (i = 0; i != RBUF_LEN(rdbs); i++)
+   if (RBUF_LEN(build->scan) > 1)
    {
-      struct rmsgpack_dom_value item;
-      struct explore_rdb* rdb  = &rdbs[i];
-      libretrodb_cursor_t *cur = libretrodb_cursor_new();
-      bool more                = 
-         (
-          libretrodb_cursor_open(rdb->handle, cur, NULL) == 0
-          && libretrodb_cursor_read_item(cur, &item) == 0);
-
-      for (; more; more = (rmsgpack_dom_value_free(&item),
-               libretrodb_cursor_read_item(cur, &item) == 0))
+      struct explore_scan_order *order = (struct explore_scan_order*)
+         malloc(RBUF_LEN(build->scan) * sizeof(*order));
+      if (order)
       {
-         unsigned k, l, cat;
-         explore_entry_t* e;
-         const char *fields[EXPLORE_CAT_COUNT];
-         char numeric_buf[EXPLORE_CAT_COUNT][16];
-         uint32_t crc32                     = 0;
-         uint32_t meta_count                = 0;
-         char *name                         = NULL;
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-         char *original_title               = NULL;
-#endif
-         struct explore_source* src         = NULL;
+         for (i = 0; i < RBUF_LEN(build->scan); i++)
+         {
+            order[i].size = build->rdbs[build->scan[i]].size;
+            order[i].rdb  = build->scan[i];
+         }
+         qsort(order, RBUF_LEN(build->scan), sizeof(*order),
+               explore_scan_cmp);
+         for (i = 0; i < RBUF_LEN(build->scan); i++)
+            build->scan[i] = order[i].rdb;
+         free(order);
+      }
+   }
 
-         if (item.type != RDT_MAP)
-            continue;
+   return build;
+}
 
-         for (k = 0; k < EXPLORE_CAT_COUNT; k++)
-            fields[k]                       = NULL;
+size_t menu_explore_build_get_scan_count(explore_build_t *build)
+{
+   return build ? RBUF_LEN(build->scan) : 0;
+}
 
-         for (k = 0; k < item.val.map.len; k++)
-         {
-            const char *key_str             = NULL;
-            struct rmsgpack_dom_value *key  = &item.val.map.items[k].key;
-            struct rmsgpack_dom_value *val  = &item.val.map.items[k].value;
-            if (!key || !val || key->type != RDT_STRING)
-               continue;
+void menu_explore_build_scan(explore_build_t *build, size_t i)
+{
+   size_t j;
+   struct rmsgpack_dom_value item;
+   struct explore_rdb *rdb  = &build->rdbs[build->scan[i]];
+   libretrodb_t *handle     = libretrodb_new();
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   bool opened              = handle
+      && libretrodb_open(rdb->path, handle, false) == 0;
+   bool more                = opened && cur
+      && libretrodb_cursor_open(handle, cur, NULL) == 0
+      && libretrodb_cursor_read_item(cur, &item) == 0;
+
+   /* Load the meta data strings of the entries that aren't cached */
+   for (; more; more = (rmsgpack_dom_value_free(&item),
+            libretrodb_cursor_read_item(cur, &item) == 0))
+   {
+      unsigned k, cat;
+      explore_meta_t *meta;
+      const char *fields[EXPLORE_META_FIELDS];
+      char numeric_buf[EXPLORE_CAT_COUNT][16];
+      uint32_t crc32                     = 0;
+      uint32_t meta_count                = 0;
+      char *name                         = NULL;
+      struct explore_source* src         = NULL;
+
+      if (item.type != RDT_MAP)
+         continue;
 
-            key_str                         = key->val.string.buff;
-            if (string_is_equal(key_str, "crc"))
-            {
-               switch (val->val.binary.len)
-               {
-                  case 1:
-                     crc32 = *(uint8_t*)val->val.binary.buff;
-                     break;
-                  case 2:
-                     crc32 = swap_if_little16(*(uint16_t*)val->val.binary.buff);
-                     break;
-                  case 4:
-                     crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
-                     break;
-                  default:
-                     crc32 = 0;
-                     break;
-               }
+      for (k = 0; k < EXPLORE_META_FIELDS; k++)
+         fields[k]                       = NULL;
 
-               continue;
-            }
-            else if (string_is_equal(key_str, "name"))
-            {
-               name = val->val.string.buff;
-               continue;
-            }
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-            else if (string_is_equal(key_str, "original_title"))
-            {
-               original_title = val->val.string.buff;
-               continue;
-            }
-#endif
+      for (k = 0; k < item.val.map.len; k++)
+      {
+         const char *key_str             = NULL;
+         struct rmsgpack_dom_value *key  = &item.val.map.items[k].key;
+         struct rmsgpack_dom_value *val  = &item.val.map.items[k].value;
+         if (!key || !val || key->type != RDT_STRING)
+            continue;
 
-            for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+         key_str                         = key->val.string.buff;
+         if (string_is_equal(key_str, "crc"))
+         {
+            switch (val->val.binary.len)
             {
-               if (!string_is_equal(key_str, explore_by_info[cat].rdbkey))
-                  continue;
-
-               meta_count++;
-               if (explore_by_info[cat].is_numeric)
-               {
-                  if (val->type >= RDT_STRING)
-                     break;
-                  snprintf(numeric_buf[cat],
-                        sizeof(numeric_buf[cat]),
-                        "%d", (int)val->val.int_);
-                  fields[cat] = numeric_buf[cat];
+               case 1:
+                  crc32 = *(uint8_t*)val->val.binary.buff;
                   break;
-               }
-               if (explore_by_info[cat].is_boolean)
-               {
-                  if (val->type >= RDT_STRING)
-                     break;
-                  fields[cat] = msg_hash_to_str(val->val.int_ ?
-                        MENU_ENUM_LABEL_VALUE_YES : MENU_ENUM_LABEL_VALUE_NO);
+               case 2:
+                  crc32 = swap_if_little16(*(uint16_t*)val->val.binary.buff);
                   break;
-               }
-               if (val->type != RDT_STRING)
+               case 4:
+                  crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
+                  break;
+               default:
+                  crc32 = 0;
                   break;
-               fields[cat] = val->val.string.buff;
-               break;
             }
-         }
 
-         if (crc32)
-         {
-            ptrdiff_t idx = RHMAP_IDX(rdb->playlist_crcs, crc32);
-            src = (idx != -1 ? &rdb->playlist_crcs[idx] : NULL);
+            continue;
          }
-         if (!src && name)
+         else if (string_is_equal(key_str, "name"))
          {
-            ptrdiff_t idx = RHMAP_IDX_STR(rdb->playlist_names, name);
-            src = (idx != -1 ? &rdb->playlist_names[idx] : NULL);
-         }
-         if (!src)
-            continue;
-         if (src->entry_index != (uint32_t)-1 && src->meta_count >= meta_count)
+            name = val->val.string.buff;
             continue;
-
-         if (src->entry_index == (uint32_t)-1)
+         }
+         else if (string_is_equal(key_str, "original_title"))
          {
-            src->entry_index = (uint32_t)RBUF_LEN(state->entries);
-            RBUF_RESIZE(state->entries, src->entry_index + 1);
+            if (val->type == RDT_STRING)
+               fields[EXPLORE_META_ORIGINAL_TITLE] = val->val.string.buff;
+            continue;
          }
-         e = &state->entries[src->entry_index];
-         src->meta_count = meta_count;
-         e->playlist_entry = src->source;
-         for (l = 0; l < EXPLORE_CAT_COUNT; l++)
-            e->by[l]       = NULL;
-         e->split          = NULL;
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-         e->original_title = NULL;
-#endif
-
-         fields[EXPLORE_BY_SYSTEM] = rdb->systemname;
 
          for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
          {
-            explore_add_unique_string(state,
-                  cat_maps, e, cat,
-                  fields[cat], &split_buf);
-         }
+            if (!string_is_equal(key_str, explore_by_info[cat].rdbkey))
+               continue;
 
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-         if (original_title && *original_title)
-         {
-            size_t len        = strlen(original_title) + 1;
-            e->original_title = (char*)
-               ex_arena_alloc(&state->arena, len);
-            memcpy(e->original_title, original_title, len);
+            meta_count++;
+            if (     explore_by_info[cat].is_numeric
+                  || explore_by_info[cat].is_boolean)
+            {
+               if (val->type >= RDT_STRING)
+                  break;
+               snprintf(numeric_buf[cat],
+                     sizeof(numeric_buf[cat]),
+                     "%d", (int)val->val.int_);
+               fields[cat] = numeric_buf[cat];
+               break;
+            }
+            if (val->type != RDT_STRING)
+               break;
+            fields[cat] = val->val.string.buff;
+            break;
          }
-#endif
+      }
 
-         if (RBUF_LEN(split_buf))
-         {
-            size_t len;
-
-            RBUF_PUSH(split_buf, NULL); /* terminator */
-            len        = RBUF_SIZEOF(split_buf);
-            e->split   = (explore_string_t **)
-               ex_arena_alloc(&state->arena, len);
-            memcpy(e->split, split_buf, len);
-            RBUF_CLEAR(split_buf);
-         }
+      if (crc32)
+      {
+         ptrdiff_t idx = RHMAP_IDX(rdb->playlist_crcs, crc32);
+         src = (idx != -1 ? &rdb->playlist_crcs[idx] : NULL);
+      }
+      if (!src && name)
+      {
+         ptrdiff_t idx = RHMAP_IDX_STR(rdb->playlist_names, name);
+         src = (idx != -1 ? &rdb->playlist_names[idx] : NULL);
+      }
+      if (!src || src->resolved)
+         continue;
+      if (src->meta && src->meta_count >= meta_count)
+         continue;
 
-         /* if all entries have found connections, we can leave early */
-         if (--rdb->count == 0)
-         {
-            rmsgpack_dom_value_free(&item);
-            break;
-         }
+      /* Named after the database, not taken from the record */
+      fields[EXPLORE_BY_SYSTEM] = NULL;
+
+      meta = (explore_meta_t*)ex_arena_alloc(&rdb->arena, sizeof(*meta));
+      for (k = 0; k < EXPLORE_META_FIELDS; k++)
+         meta->fields[k] = explore_arena_strdup(&rdb->arena, fields[k]);
+
+      if (!src->meta)
+         rdb->pending--;
+      src->meta       = meta;
+      src->meta_count = meta_count;
+
+      /* if all entries have found connections, we can leave early */
+      if (rdb->pending == 0)
+      {
+         rmsgpack_dom_value_free(&item);
+         break;
       }
+   }
 
+   if (cur)
+   {
       libretrodb_cursor_close(cur);
       libretrodb_cursor_free(cur);
-      libretrodb_close(rdb->handle);
-      libretrodb_free(rdb->handle);
-      RHMAP_FREE(rdb->playlist_crcs);
-      RHMAP_FREE(rdb->playlist_names);
+   }
+   if (opened)
+      libretrodb_close(handle);
+   if (handle)
+      libretrodb_free(handle);
+
+   for (j = 0; j < RHMAP_CAP(rdb->playlist_crcs); j++)
+      rdb->playlist_crcs[j].resolved = true;
+   for (j = 0; j < RHMAP_CAP(rdb->playlist_names); j++)
+      rdb->playlist_names[j].resolved = true;
+}
+
+void menu_explore_build_free(explore_build_t *build)
+{
+   size_t i;
+
+   if (!build)
+      return;
+
+   for (i = 0; i < RBUF_LEN(build->rdbs); i++)
+   {
+      RHMAP_FREE(build->rdbs[i].playlist_crcs);
+      RHMAP_FREE(build->rdbs[i].playlist_names);
+      ex_arena_free(&build->rdbs[i].arena);
+   }
+   for (i = 0; i < RBUF_LEN(build->playlists); i++)
+   {
+      free(build->playlists[i].name);
+      RBUF_FREE(build->playlists[i].refs);
+      RBUF_FREE(build->playlists[i].rdb_nums);
+   }
+   RBUF_FREE(build->rdbs);
+   RBUF_FREE(build->playlists);
+   RBUF_FREE(build->scan);
+   RHMAP_FREE(build->rdb_indices);
+   explore_free_shards(build);
+
+   if (build->state)
+   {
+      menu_explore_free_state(build->state);
+      free(build->state);
+   }
+   free(build);
+}
+
+explore_state_t *menu_explore_build_end(explore_build_t *build)
+{
+   size_t i, j;
+   unsigned reused                                = 0;
+   explore_string_t **cat_maps[EXPLORE_CAT_COUNT] = {NULL};
+   explore_string_t **split_buf                   = NULL;
+   explore_state_t *state                         = build->state;
+
+   for (i = 0; i < RBUF_LEN(build->rdbs); i++)
+   {
+      struct explore_rdb *rdb = &build->rdbs[i];
+
+      for (j = 0; j < RHMAP_CAP(rdb->playlist_crcs); j++)
+         if (RHMAP_KEY(rdb->playlist_crcs, j) && rdb->playlist_crcs[j].meta)
+            explore_add_entry(state, cat_maps, &split_buf,
+                  rdb->playlist_crcs[j].source, rdb->playlist_crcs[j].meta,
+                  rdb->systemname);
+      for (j = 0; j < RHMAP_CAP(rdb->playlist_names); j++)
+         if (RHMAP_KEY(rdb->playlist_names, j) && rdb->playlist_names[j].meta)
+            explore_add_entry(state, cat_maps, &split_buf,
+                  rdb->playlist_names[j].source, rdb->playlist_names[j].meta,
+                  rdb->systemname);
    }
    RBUF_FREE(split_buf);
-   RHMAP_FREE(rdb_indices);
-   RBUF_FREE(rdbs);
+
+   for (i = 0; i < RBUF_LEN(build->playlists); i++)
+      if (build->playlists[i].shard)
+         reused++;
+
+   /* Only rewrite the cache if a shard changed or went away */
+   if (     reused != RBUF_LEN(build->playlists)
+         || reused != build->num_shards)
+      explore_save_cache(build);
+
+   RARCH_LOG("[Explore]: Indexed %u entries from %u playlists "
+         "(%u cached), %u databases scanned.\n",
+         (unsigned)RBUF_LEN(state->entries),
+         (unsigned)RBUF_LEN(build->playlists), reused,
+         (unsigned)RBUF_LEN(build->scan));
 
    for (i = 0; i != EXPLORE_CAT_COUNT; i++)
    {
@@ -827,9 +1524,28 @@ explore_state_t *menu_explore_build_list(const char *directory_playlist,
       qsort(state->entries,
          RBUF_LEN(state->entries),
          sizeof(*state->entries), explore_qsort_func_entries);
+
+   build->state = NULL;
+   menu_explore_build_free(build);
    return state;
 }
 
+explore_state_t *menu_explore_build_list(const char *directory_playlist,
+      const char *directory_database)
+{
+   size_t i;
+   explore_build_t *build = menu_explore_build_begin(directory_playlist,
+         directory_database);
+
+   if (!build)
+      return NULL;
+
+   for (i = 0; i < menu_explore_build_get_scan_count(build); i++)
+      menu_explore_build_scan(build, i);
+
+   return menu_explore_build_end(build);
+}
+
 static int explore_action_get_title(
       const char *path, const char *label,
       unsigned menu_type, char *s, size_t len)
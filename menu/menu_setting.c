@@ -6678,6 +6678,10 @@ static void setting_get_string_representation_uint_audio_resampler_quality(
          strlcpy(s, msg_hash_to_str(MSG_RESAMPLER_QUALITY_HIGHEST),
                len);
          break;
+      case RESAMPLER_QUALITY_POLYPHASE:
+         strlcpy(s, msg_hash_to_str(MSG_RESAMPLER_QUALITY_POLYPHASE),
+               len);
+         break;
       case RESAMPLER_QUALITY_NORMAL:
          strlcpy(s, msg_hash_to_str(MSG_RESAMPLER_QUALITY_NORMAL),
                len);
@@ -6776,6 +6780,22 @@ static void setting_get_string_representation_uint_autosave_interval(
 }
 #endif
 
+#ifdef HAVE_THREADS
+static void setting_get_string_representation_uint_threaded_data_runloop_workers(
+      rarch_setting_t *setting,
+      char *s, size_t len)
+{
+   if (!setting)
+      return;
+
+   if (*setting->value.target.unsigned_integer)
+      snprintf(s, len, "%u", *setting->value.target.unsigned_integer);
+   else
+      strlcpy(s, msg_hash_to_str(
+               MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_WORKERS_AUTO), len);
+}
+#endif
+
 #ifdef HAVE_BSV_MOVIE
 static void setting_get_string_representation_uint_replay_checkpoint_interval(
       rarch_setting_t *setting,
@@ -8136,6 +8156,9 @@ static void general_write_handler(rarch_setting_t *setting)
          else
             task_queue_unset_threaded();
          break;
+      case MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS:
+         task_queue_set_worker_count(*setting->value.target.unsigned_integer);
+         break;
 #ifndef HAVE_LAKKA
       case MENU_ENUM_LABEL_GAMEMODE_ENABLE:
          if (frontend_driver_has_gamemode())
@@ -11744,6 +11767,56 @@ static bool setting_append_list(
             (*list)[list_info->index - 1].offset_by     = 1;
             menu_settings_list_current_add_range(list, list_info, 1, 100, 1, true, true);
 
+            CONFIG_SIZE(
+                  list, list_info,
+                  &settings->sizes.rewind_cold_buffer_size,
+                  MENU_ENUM_LABEL_REWIND_COLD_BUFFER_SIZE,
+                  MENU_ENUM_LABEL_VALUE_REWIND_COLD_BUFFER_SIZE,
+                  DEFAULT_REWIND_COLD_BUFFER_SIZE,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  &setting_get_string_representation_size_in_mb);
+            menu_settings_list_current_add_range(list, list_info,
+                  0, 2048.0f * 1024 * 1024, 16 * 1024 * 1024, true, true);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+
+            CONFIG_SIZE(
+                  list, list_info,
+                  &settings->sizes.rewind_spill_size,
+                  MENU_ENUM_LABEL_REWIND_SPILL_SIZE,
+                  MENU_ENUM_LABEL_VALUE_REWIND_SPILL_SIZE,
+                  DEFAULT_REWIND_SPILL_SIZE,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  &setting_get_string_representation_size_in_mb);
+            menu_settings_list_current_add_range(list, list_info,
+                  0, 2048.0f * 1024 * 1024, 64 * 1024 * 1024, true, true);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+
+#ifdef HAVE_THREADS
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.rewind_threaded,
+                  MENU_ENUM_LABEL_REWIND_THREADED,
+                  MENU_ENUM_LABEL_VALUE_REWIND_THREADED,
+                  DEFAULT_REWIND_THREADED,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_CMD_APPLY_AUTO);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+#endif
+
          END_SUB_GROUP(list, list_info, parent_group);
          END_GROUP(list, list_info, parent_group);
          break;
@@ -14209,7 +14282,7 @@ static bool setting_append_list(
          (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
          (*list)[list_info->index - 1].get_string_representation =
             &setting_get_string_representation_uint_audio_resampler_quality;
-         menu_settings_list_current_add_range(list, list_info, RESAMPLER_QUALITY_DONTCARE, RESAMPLER_QUALITY_HIGHEST, 1.0, true, true);
+         menu_settings_list_current_add_range(list, list_info, RESAMPLER_QUALITY_DONTCARE, RESAMPLER_QUALITY_POLYPHASE, 1.0, true, true);
 
          CONFIG_FLOAT(
                list, list_info,
@@ -14575,7 +14648,7 @@ static bool setting_append_list(
          (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
          (*list)[list_info->index - 1].get_string_representation =
             &setting_get_string_representation_uint_audio_resampler_quality;
-         menu_settings_list_current_add_range(list, list_info, RESAMPLER_QUALITY_DONTCARE, RESAMPLER_QUALITY_HIGHEST, 1.0, true, true);
+         menu_settings_list_current_add_range(list, list_info, RESAMPLER_QUALITY_DONTCARE, RESAMPLER_QUALITY_POLYPHASE, 1.0, true, true);
 
 #ifdef HAVE_WASAPI
          if (string_is_equal(settings->arrays.microphone_driver, "wasapi"))
@@ -17999,6 +18072,23 @@ static bool setting_append_list(
                general_read_handler,
                SD_FLAG_ADVANCED
                );
+
+         CONFIG_UINT(
+               list, list_info,
+               &settings->uints.threaded_data_runloop_workers,
+               MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_WORKERS,
+               MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_WORKERS,
+               DEFAULT_THREADED_DATA_RUNLOOP_WORKERS,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler);
+         (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+         (*list)[list_info->index - 1].get_string_representation =
+            &setting_get_string_representation_uint_threaded_data_runloop_workers;
+         menu_settings_list_current_add_range(list, list_info, 0, 8, 1, true, true);
+         SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
 #endif
 
          END_SUB_GROUP(list, list_info, parent_group);
@@ -19240,6 +19330,34 @@ static bool setting_append_list(
                   general_read_handler);
             (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint_special;
             menu_settings_list_current_add_range(list, list_info, 0, 1024, 256, true, true);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.image_cache_size,
+                  MENU_ENUM_LABEL_IMAGE_CACHE_SIZE,
+                  MENU_ENUM_LABEL_VALUE_IMAGE_CACHE_SIZE,
+                  DEFAULT_IMAGE_CACHE_SIZE,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 4096, 64, true, true);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.menu_thumbnail_cache_size,
+                  MENU_ENUM_LABEL_MENU_THUMBNAIL_CACHE_SIZE,
+                  MENU_ENUM_LABEL_VALUE_MENU_THUMBNAIL_CACHE_SIZE,
+                  DEFAULT_MENU_THUMBNAIL_CACHE_SIZE,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 512, 16, true, true);
          }
 
          if (string_is_equal(settings->arrays.menu_driver, "rgui"))
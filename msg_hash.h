@@ -241,6 +241,7 @@ enum msg_hash_enums
    MSG_RESAMPLER_QUALITY_NORMAL,
    MSG_RESAMPLER_QUALITY_HIGHER,
    MSG_RESAMPLER_QUALITY_HIGHEST,
+   MSG_RESAMPLER_QUALITY_POLYPHASE,
    MSG_DISCORD_CONNECTION_REQUEST,
    MSG_ADDED_TO_FAVORITES,
    MSG_ADD_TO_FAVORITES_FAILED,
@@ -421,6 +422,7 @@ enum msg_hash_enums
    MSG_REWIND_UNSUPPORTED,
    MSG_REWIND_INIT,
    MSG_REWIND_INIT_FAILED,
+   MSG_REWIND_TIER_STATS,
    MSG_REWIND_INIT_FAILED_THREADED_AUDIO,
    MSG_LIBRETRO_ABI_BREAK,
    MSG_DETECTED_VIEWPORT_OF,
@@ -1547,6 +1549,8 @@ enum msg_hash_enums
    MENU_LABEL(NAVIGATION_WRAPAROUND),
    MENU_LABEL(SHOW_ADVANCED_SETTINGS),
    MENU_LABEL(THREADED_DATA_RUNLOOP_ENABLE),
+   MENU_LABEL(THREADED_DATA_RUNLOOP_WORKERS),
+   MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_WORKERS_AUTO,
    MENU_LABEL(XMB_ALPHA_FACTOR),
    MENU_LABEL(MENU_FONT_COLOR_RED),
    MENU_LABEL(MENU_FONT_COLOR_GREEN),
@@ -1592,6 +1596,8 @@ enum msg_hash_enums
    MENU_LABEL(MENU_XMB_TITLE_MARGIN),
    MENU_LABEL(MENU_XMB_TITLE_MARGIN_HORIZONTAL_OFFSET),
    MENU_LABEL(MENU_THUMBNAIL_UPSCALE_THRESHOLD),
+   MENU_LABEL(IMAGE_CACHE_SIZE),
+   MENU_LABEL(MENU_THUMBNAIL_CACHE_SIZE),
    MENU_LABEL(MENU_RGUI_INLINE_THUMBNAILS),
    MENU_LABEL(MENU_RGUI_SWAP_THUMBNAILS),
    MENU_LABEL(MENU_RGUI_THUMBNAIL_DOWNSCALER),
@@ -2323,6 +2329,12 @@ enum msg_hash_enums
    MENU_LABEL(REWIND_GRANULARITY),
    MENU_LABEL(REWIND_BUFFER_SIZE),
    MENU_LABEL(REWIND_BUFFER_SIZE_STEP),
+   MENU_LABEL(REWIND_THREADED),
+   MENU_LABEL(REWIND_COLD_BUFFER_SIZE),
+   MENU_LABEL(REWIND_SPILL_SIZE),
+   MENU_LABEL(REWIND_TIER_HOT),
+   MENU_LABEL(REWIND_TIER_COLD),
+   MENU_LABEL(REWIND_TIER_SPILL),
    /* TODO/FIXME: INPUT_META_REWIND is incorrectly defined;
     * the LABEL/SUBLABEL enums should be entered 'manually',
     * like all the other hotkeys. Moreover, the resultant
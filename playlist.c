@@ -15,21 +15,36 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+#ifdef HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 #include <libretro.h>
 #include <boolean.h>
 #include <retro_miscellaneous.h>
 #include <compat/posix_string.h>
+#include <compat/strl.h>
 #include <string/stdstring.h>
 #include <streams/interface_stream.h>
+#include <streams/file_stream.h>
 #include <file/file_path.h>
 #include <file/archive_file.h>
 #include <lists/string_list.h>
 #include <formats/rjson.h>
 #include <array/rbuf.h>
+#include <array/rhmap.h>
 
 #include "playlist.h"
 #include "verbosity.h"
@@ -67,11 +82,35 @@ struct content_playlist
    char *default_core_name;
    char *base_content_directory;
 
+   /* Entries live in the middle of 'entries_buf', with free
+    * slots on both sides so that pushing to the top doesn't
+    * have to shift the whole playlist */
    struct playlist_entry *entries;
+   struct playlist_entry *entries_buf;
+
+   /* Lookup index: hash -> first node + 1 of a chain of
+    * playlist_index_node, see playlist_index_build() */
+   uint32_t *index_paths;                     /* Real path hash */
+   uint32_t *index_archives;                  /* Parent archive path hash */
+   uint32_t *index_crcs;                      /* Content CRC32 */
+   struct playlist_index_node *index_nodes;   /* RBUF */
+   size_t *index_matches;                     /* RBUF, lookup results */
+
+   /* Binary cache the playlist was loaded from, see
+    * playlist_cache_load(). While it is attached, the
+    * strings of the entries point into it */
+   const uint8_t *cache_data;
+   uint8_t *cache_loaded;                     /* Per entry, NULL once all are */
 
    playlist_manual_scan_record_t scan_record; /* ptr alignment */
    playlist_config_t config;                  /* size_t alignment */
 
+   size_t entries_len;
+   size_t entries_cap;
+   size_t index_base;
+   size_t cache_size;
+   uint32_t index_free;                       /* Free node list */
+
    enum playlist_label_display_mode label_display_mode;
    enum playlist_thumbnail_mode right_thumbnail_mode;
    enum playlist_thumbnail_mode left_thumbnail_mode;
@@ -82,6 +121,18 @@ struct content_playlist
    bool old_format;
    bool compressed;
    bool cached_external;
+   bool index_valid;
+   bool cache_mapped;
+   bool cache_detached;                       /* Entries own their strings */
+};
+
+/* Index nodes don't store entry indices, which change each
+ * time an entry is pushed to the top, but 'stamps': the index
+ * of an entry is its stamp minus playlist->index_base */
+struct playlist_index_node
+{
+   size_t stamp;
+   uint32_t next;                             /* Next node + 1, or 0 */
 };
 
 typedef struct
@@ -528,11 +579,982 @@ static bool playlist_core_path_equal(const char *real_core_path, const char *ent
    return false;
 }
 
+/* Binary playlist cache
+ *
+ * Parsing a large playlist and duplicating each of its strings
+ * takes a while, so playlists of PLAYLIST_CACHE_MIN_ENTRIES
+ * entries or more get a companion file (playlist path +
+ * PLAYLIST_CACHE_FILE_EXTENSION) holding the same data in a
+ * form that is used as is. All values are little endian 32 bit
+ * words:
+ *
+ * - Header, PLAYLIST_CACHE_HEADER_SIZE bytes:
+ *    0  magic              2  version         3  entry count
+ *    4  capacity           5  flags           6  playlist file size (64 bit)
+ *    8  playlist file time (64 bit)           10 label display mode
+ *    11 right thumb mode   12 left thumb mode 13 thumbnail match mode
+ *    14 sort mode          15 scan flags      16 6 metadata strings
+ *    22 string table size  23 reserved
+ * - One PLAYLIST_CACHE_RECORD_SIZE bytes record per entry:
+ *    0  8 strings (path, label, core path, core name, crc32,
+ *       db name, subsystem ident, subsystem name)
+ *    8  first subsystem rom 9  subsystem rom count
+ *    10 entry slot         11 runtime h/m/s, last played y/m/d/h/m/s
+ * - The string table: NUL terminated strings, referred to by
+ *   offset + 1 (0 is NULL).
+ *
+ * The playlist file stays the reference: the cache is ignored
+ * as soon as the size or time of the playlist file differ, and
+ * is rewritten each time the playlist file is written or had
+ * to be parsed.
+ *
+ * Loading maps the cache, and entries are only filled in from
+ * their record when first accessed, with strings pointing into
+ * the cache. The first change to the playlist detaches it from
+ * the cache: all entries get their own copies, as if they had
+ * been parsed. */
+#define PLAYLIST_CACHE_MAGIC         "RAPLCACH"
+#define PLAYLIST_CACHE_VERSION       1
+#define PLAYLIST_CACHE_HEADER_SIZE   96
+#define PLAYLIST_CACHE_RECORD_SIZE   80
+#define PLAYLIST_CACHE_STRINGS       8
+#define PLAYLIST_CACHE_META_STRINGS  6
+
+/* Smaller playlists are parsed fast enough */
+#define PLAYLIST_CACHE_MIN_ENTRIES   1000
+
+/* Header flags */
+#define PLAYLIST_CACHE_FULL          (1 << 0) /* Entries may have been dropped */
+#define PLAYLIST_CACHE_MODIFIED      (1 << 1)
+#define PLAYLIST_CACHE_OLD_FORMAT    (1 << 2)
+#define PLAYLIST_CACHE_COMPRESSED    (1 << 3)
+
+/* Scan flags */
+#define PLAYLIST_CACHE_SCAN_RECURSIVELY (1 << 0)
+#define PLAYLIST_CACHE_SCAN_ARCHIVES    (1 << 1)
+#define PLAYLIST_CACHE_SCAN_FILTER_DAT  (1 << 2)
+#define PLAYLIST_CACHE_SCAN_OVERWRITE   (1 << 3)
+
+#define PLAYLIST_CACHE_WORD(p, i) playlist_cache_get_u32((p) + (i) * 4)
+
+/* What the playlist file holds, so that loading the
+ * cache gives the same result as parsing the file */
+enum playlist_cache_fields
+{
+   PLAYLIST_CACHE_FIELDS_PARSED = 0,  /* Everything, as parsed */
+   PLAYLIST_CACHE_FIELDS_JSON,        /* Written by playlist_write_file() */
+   PLAYLIST_CACHE_FIELDS_OLD_FORMAT   /* Same, old format */
+};
+
+typedef struct
+{
+   char *strings;                               /* RBUF */
+   const char *prev[PLAYLIST_CACHE_STRINGS];    /* Previous record */
+   uint32_t prev_refs[PLAYLIST_CACHE_STRINGS];
+   bool out_of_memory;
+} playlist_cache_writer_t;
+
+static uint32_t playlist_cache_get_u32(const uint8_t *p)
+{
+   return  (uint32_t)p[0]
+         | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+}
+
+static void playlist_cache_set_u32(uint8_t *p, uint32_t val)
+{
+   p[0] = (uint8_t)val;
+   p[1] = (uint8_t)(val >> 8);
+   p[2] = (uint8_t)(val >> 16);
+   p[3] = (uint8_t)(val >> 24);
+}
+
+static int64_t playlist_cache_get_i64(const uint8_t *p)
+{
+   return (int64_t)(playlist_cache_get_u32(p)
+         | ((uint64_t)playlist_cache_get_u32(p + 4) << 32));
+}
+
+static void playlist_cache_set_i64(uint8_t *p, int64_t val)
+{
+   playlist_cache_set_u32(p,     (uint32_t)(uint64_t)val);
+   playlist_cache_set_u32(p + 4, (uint32_t)((uint64_t)val >> 32));
+}
+
+static void playlist_cache_get_path(const playlist_t *playlist,
+      char *s, size_t len)
+{
+   strlcpy(s, playlist->config.path, len);
+   strlcat(s, PLAYLIST_CACHE_FILE_EXTENSION, len);
+}
+
+static void playlist_cache_get_fields(struct playlist_entry *entry,
+      char **fields[PLAYLIST_CACHE_STRINGS])
+{
+   fields[0] = &entry->path;
+   fields[1] = &entry->label;
+   fields[2] = &entry->core_path;
+   fields[3] = &entry->core_name;
+   fields[4] = &entry->crc32;
+   fields[5] = &entry->db_name;
+   fields[6] = &entry->subsystem_ident;
+   fields[7] = &entry->subsystem_name;
+}
+
+static void playlist_cache_get_meta(playlist_t *playlist,
+      char **meta[PLAYLIST_CACHE_META_STRINGS])
+{
+   meta[0] = &playlist->default_core_path;
+   meta[1] = &playlist->default_core_name;
+   meta[2] = &playlist->base_content_directory;
+   meta[3] = &playlist->scan_record.content_dir;
+   meta[4] = &playlist->scan_record.file_exts;
+   meta[5] = &playlist->scan_record.dat_file_path;
+}
+
+/* String of the cache for @ref, NULL for 0 or anything
+ * outside the string table (which ends with a NUL) */
+static char *playlist_cache_string(const playlist_t *playlist,
+      uint32_t ref)
+{
+   const uint8_t *data = playlist->cache_data;
+   uint32_t count      = PLAYLIST_CACHE_WORD(data, 3);
+
+   if (!ref || ref > PLAYLIST_CACHE_WORD(data, 22))
+      return NULL;
+   return (char*)data + PLAYLIST_CACHE_HEADER_SIZE
+         + (size_t)count * PLAYLIST_CACHE_RECORD_SIZE + ref - 1;
+}
+
+static void playlist_cache_unmap(playlist_t *playlist)
+{
+   if (!playlist->cache_data)
+      return;
+
+#ifdef HAVE_MMAP
+   if (playlist->cache_mapped)
+      munmap((void*)playlist->cache_data, playlist->cache_size);
+   else
+#endif
+      free((void*)playlist->cache_data);
+
+   free(playlist->cache_loaded);
+   playlist->cache_data     = NULL;
+   playlist->cache_loaded   = NULL;
+   playlist->cache_size     = 0;
+   playlist->cache_mapped   = false;
+   playlist->cache_detached = false;
+}
+
+/**
+ * playlist_cache_fill:
+ * @playlist           : Playlist handle.
+ * @idx                : Index of playlist entry.
+ *
+ * Fills in entry @idx from its record, if the playlist was
+ * loaded from the cache and that hasn't been done yet. Must
+ * be called before anything reads an entry.
+ **/
+static void playlist_cache_fill(playlist_t *playlist, size_t idx)
+{
+   size_t i;
+   const uint8_t *rec;
+   const char *rom;
+   uint32_t rom_count;
+   struct playlist_entry *entry;
+   char **fields[PLAYLIST_CACHE_STRINGS];
+
+   if (!playlist->cache_loaded || playlist->cache_loaded[idx])
+      return;
+
+   rec   = playlist->cache_data + PLAYLIST_CACHE_HEADER_SIZE
+         + idx * PLAYLIST_CACHE_RECORD_SIZE;
+   entry = &playlist->entries[idx];
+
+   memset(entry, 0, sizeof(*entry));
+
+   playlist_cache_get_fields(entry, fields);
+   for (i = 0; i < PLAYLIST_CACHE_STRINGS; i++)
+      *fields[i] = playlist_cache_string(playlist,
+            PLAYLIST_CACHE_WORD(rec, i));
+
+   rom       = playlist_cache_string(playlist, PLAYLIST_CACHE_WORD(rec, 8));
+   rom_count = PLAYLIST_CACHE_WORD(rec, 9);
+
+   if (rom && rom_count && (entry->subsystem_roms = string_list_new()))
+   {
+      union string_list_elem_attr attr = {0};
+      const char *end = (const char*)playlist->cache_data
+            + playlist->cache_size;
+
+      for (i = 0; i < rom_count && rom < end; i++)
+      {
+         string_list_append(entry->subsystem_roms, rom, attr);
+         rom += strlen(rom) + 1;
+      }
+   }
+
+   entry->entry_slot         = PLAYLIST_CACHE_WORD(rec, 10);
+   entry->runtime_hours      = PLAYLIST_CACHE_WORD(rec, 11);
+   entry->runtime_minutes    = PLAYLIST_CACHE_WORD(rec, 12);
+   entry->runtime_seconds    = PLAYLIST_CACHE_WORD(rec, 13);
+   entry->last_played_year   = PLAYLIST_CACHE_WORD(rec, 14);
+   entry->last_played_month  = PLAYLIST_CACHE_WORD(rec, 15);
+   entry->last_played_day    = PLAYLIST_CACHE_WORD(rec, 16);
+   entry->last_played_hour   = PLAYLIST_CACHE_WORD(rec, 17);
+   entry->last_played_minute = PLAYLIST_CACHE_WORD(rec, 18);
+   entry->last_played_second = PLAYLIST_CACHE_WORD(rec, 19);
+
+   playlist->cache_loaded[idx] = 1;
+}
+
+static void playlist_cache_fill_all(playlist_t *playlist)
+{
+   size_t i;
+
+   if (!playlist->cache_loaded)
+      return;
+
+   for (i = 0; i < playlist->entries_len; i++)
+      playlist_cache_fill(playlist, i);
+
+   free(playlist->cache_loaded);
+   playlist->cache_loaded = NULL;
+}
+
+/* Gives every entry its own copy of its strings, before
+ * the playlist is modified. The cache itself stays around
+ * until the playlist is freed, since callers may hold strings
+ * they got from it (e.g. to pass back to playlist_update()) */
+static void playlist_cache_detach(playlist_t *playlist)
+{
+   size_t i, j;
+
+   if (!playlist->cache_data || playlist->cache_detached)
+      return;
+
+   playlist_cache_fill_all(playlist);
+
+   for (i = 0; i < playlist->entries_len; i++)
+   {
+      char **fields[PLAYLIST_CACHE_STRINGS];
+
+      playlist_cache_get_fields(&playlist->entries[i], fields);
+      for (j = 0; j < PLAYLIST_CACHE_STRINGS; j++)
+         if (*fields[j])
+            *fields[j] = strdup(*fields[j]);
+   }
+
+   playlist->cache_detached = true;
+}
+
+/**
+ * playlist_cache_load:
+ * @playlist           : Playlist handle.
+ *
+ * Loads the playlist from its cache, if it matches the
+ * playlist file. Entries are left uninitialised, to be
+ * filled in by playlist_cache_fill().
+ *
+ * Returns: true if the playlist was loaded.
+ **/
+static bool playlist_cache_load(playlist_t *playlist)
+{
+   size_t i, len;
+   int64_t lpl_size, lpl_mtime;
+   uint32_t count, flags, scan_flags, strings_size;
+   char **meta[PLAYLIST_CACHE_META_STRINGS];
+   char cache_path[PATH_MAX_LENGTH];
+   const uint8_t *data = NULL;
+   int64_t size        = 0;
+
+   if (!path_get_size_mtime(playlist->config.path, &lpl_size, &lpl_mtime))
+      return false;
+
+   playlist_cache_get_path(playlist, cache_path, sizeof(cache_path));
+
+#ifdef HAVE_MMAP
+   {
+      struct stat st;
+      int fd = open(cache_path, O_RDONLY);
+
+      if (fd >= 0)
+      {
+         if (fstat(fd, &st) == 0 && st.st_size > 0)
+         {
+            void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ,
+                  MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+               data                   = (const uint8_t*)ptr;
+               size                   = (int64_t)st.st_size;
+               playlist->cache_mapped = true;
+            }
+         }
+         close(fd);
+      }
+   }
+#endif
+
+   if (!data)
+   {
+      void *buf = NULL;
+      if (!filestream_read_file(cache_path, &buf, &size) || !buf)
+         return false;
+      data = (const uint8_t*)buf;
+   }
+
+   playlist->cache_data = data;
+   playlist->cache_size = (size_t)size;
+
+   if (     (size < PLAYLIST_CACHE_HEADER_SIZE)
+         || memcmp(data, PLAYLIST_CACHE_MAGIC, 8)
+         || (PLAYLIST_CACHE_WORD(data, 2) != PLAYLIST_CACHE_VERSION)
+         || (playlist_cache_get_i64(data + 6 * 4) != lpl_size)
+         || (playlist_cache_get_i64(data + 8 * 4) != lpl_mtime))
+      goto error;
+
+   count        = PLAYLIST_CACHE_WORD(data, 3);
+   flags        = PLAYLIST_CACHE_WORD(data, 5);
+   scan_flags   = PLAYLIST_CACHE_WORD(data, 15);
+   strings_size = PLAYLIST_CACHE_WORD(data, 22);
+
+   if (     ((uint64_t)size != PLAYLIST_CACHE_HEADER_SIZE
+               + (uint64_t)count * PLAYLIST_CACHE_RECORD_SIZE + strings_size)
+         || (strings_size && data[size - 1] != '\0'))
+      goto error;
+
+   /* Entries beyond the capacity the cache was made with
+    * may have been dropped */
+   if (     (flags & PLAYLIST_CACHE_FULL)
+         && (playlist->config.capacity > PLAYLIST_CACHE_WORD(data, 4)))
+      goto error;
+
+   len = MIN(count, playlist->config.capacity);
+
+   /* Not cleared: with many entries, that alone would take
+    * longer than the rest of the load */
+   if (len)
+   {
+      if (!(playlist->entries_buf = (struct playlist_entry*)
+               malloc(len * sizeof(struct playlist_entry))))
+         goto error;
+      if (!(playlist->cache_loaded = (uint8_t*)calloc(len, sizeof(uint8_t))))
+      {
+         free(playlist->entries_buf);
+         playlist->entries_buf = NULL;
+         goto error;
+      }
+   }
+
+   playlist->entries     = playlist->entries_buf;
+   playlist->entries_len = len;
+   playlist->entries_cap = len;
+
+   playlist_cache_get_meta(playlist, meta);
+   for (i = 0; i < PLAYLIST_CACHE_META_STRINGS; i++)
+   {
+      const char *str = playlist_cache_string(playlist,
+            PLAYLIST_CACHE_WORD(data, 16 + i));
+      if (str)
+         *meta[i] = strdup(str);
+   }
+
+   playlist->label_display_mode   = (enum playlist_label_display_mode)
+      PLAYLIST_CACHE_WORD(data, 10);
+   playlist->right_thumbnail_mode = (enum playlist_thumbnail_mode)
+      PLAYLIST_CACHE_WORD(data, 11);
+   playlist->left_thumbnail_mode  = (enum playlist_thumbnail_mode)
+      PLAYLIST_CACHE_WORD(data, 12);
+   playlist->thumbnail_match_mode = (enum playlist_thumbnail_match_mode)
+      PLAYLIST_CACHE_WORD(data, 13);
+   playlist->sort_mode            = (enum playlist_sort_mode)
+      PLAYLIST_CACHE_WORD(data, 14);
+
+   playlist->scan_record.search_recursively = (scan_flags & PLAYLIST_CACHE_SCAN_RECURSIVELY) != 0;
+   playlist->scan_record.search_archives    = (scan_flags & PLAYLIST_CACHE_SCAN_ARCHIVES)    != 0;
+   playlist->scan_record.filter_dat_content = (scan_flags & PLAYLIST_CACHE_SCAN_FILTER_DAT)  != 0;
+   playlist->scan_record.overwrite_playlist = (scan_flags & PLAYLIST_CACHE_SCAN_OVERWRITE)   != 0;
+
+   playlist->old_format = (flags & PLAYLIST_CACHE_OLD_FORMAT) != 0;
+   playlist->compressed = (flags & PLAYLIST_CACHE_COMPRESSED) != 0;
+   playlist->modified   = (flags & PLAYLIST_CACHE_MODIFIED)   || (len < count);
+
+   if (!len)
+      playlist_cache_unmap(playlist);
+   return true;
+
+error:
+   playlist_cache_unmap(playlist);
+   return false;
+}
+
+static uint32_t playlist_cache_add_string(playlist_cache_writer_t *writer,
+      const char *str)
+{
+   size_t len;
+   char *strings = writer->strings;
+   size_t pos    = RBUF_LEN(strings);
+
+   if (string_is_empty(str))
+      return 0;
+
+   len = strlen(str) + 1;
+   if (     (pos + len >= 0xFFFFFFFF)
+         || !RBUF_TRYFIT(strings, pos + len))
+   {
+      writer->strings       = strings;
+      writer->out_of_memory = true;
+      return 0;
+   }
+
+   RBUF_RESIZE(strings, pos + len);
+   memcpy(strings + pos, str, len);
+   writer->strings = strings;
+   return (uint32_t)(pos + 1);
+}
+
+/**
+ * playlist_cache_write:
+ * @playlist           : Playlist handle.
+ * @fields             : What the playlist file holds.
+ *
+ * Writes the cache of the playlist, to match the playlist
+ * file as it is on disk, or removes it if the playlist is
+ * too small to need one.
+ **/
+static void playlist_cache_write(playlist_t *playlist,
+      enum playlist_cache_fields fields)
+{
+   size_t i, j;
+   RFILE *file;
+   int64_t lpl_size, lpl_mtime;
+   char cache_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   char **meta[PLAYLIST_CACHE_META_STRINGS];
+   playlist_cache_writer_t writer;
+   uint8_t *head    = NULL;
+   size_t len       = playlist->entries_len;
+   size_t head_size = PLAYLIST_CACHE_HEADER_SIZE
+         + len * PLAYLIST_CACHE_RECORD_SIZE;
+   bool old_format  = (fields == PLAYLIST_CACHE_FIELDS_OLD_FORMAT);
+   uint32_t flags   = 0;
+   uint32_t scan    = 0;
+
+   playlist_cache_get_path(playlist, cache_path, sizeof(cache_path));
+
+   if (     (len < PLAYLIST_CACHE_MIN_ENTRIES)
+         || (len > 0xFFFFFFFF / PLAYLIST_CACHE_RECORD_SIZE)
+         || !path_get_size_mtime(playlist->config.path,
+               &lpl_size, &lpl_mtime))
+   {
+      if (path_is_valid(cache_path))
+         filestream_delete(cache_path);
+      return;
+   }
+
+   if (!(head = (uint8_t*)calloc(1, head_size)))
+      return;
+
+   memset(&writer, 0, sizeof(writer));
+   playlist_cache_fill_all(playlist);
+
+   for (i = 0; i < len; i++)
+   {
+      char **entry_fields[PLAYLIST_CACHE_STRINGS];
+      struct playlist_entry *entry = &playlist->entries[i];
+      uint8_t *rec                 = head + PLAYLIST_CACHE_HEADER_SIZE
+            + i * PLAYLIST_CACHE_RECORD_SIZE;
+
+      playlist_cache_get_fields(entry, entry_fields);
+
+      /* The old format only has the first six strings */
+      for (j = 0; j < (old_format ? 6 : PLAYLIST_CACHE_STRINGS); j++)
+      {
+         const char *str = *entry_fields[j];
+         uint32_t ref;
+
+         /* Runs of entries from the same core or database
+          * share their strings */
+         if (     writer.prev[j]
+               && str
+               && string_is_equal(writer.prev[j], str))
+            ref = writer.prev_refs[j];
+         else
+            ref = playlist_cache_add_string(&writer, str);
+
+         writer.prev[j]      = str;
+         writer.prev_refs[j] = ref;
+         playlist_cache_set_u32(rec + j * 4, ref);
+      }
+
+      if (old_format)
+         continue;
+
+      if (entry->subsystem_roms)
+      {
+         uint32_t first = 0;
+         uint32_t count = 0;
+
+         for (j = 0; j < entry->subsystem_roms->size; j++)
+         {
+            uint32_t ref = playlist_cache_add_string(&writer,
+                  entry->subsystem_roms->elems[j].data);
+            if (!ref)
+               continue;
+            if (!count++)
+               first = ref;
+         }
+
+         playlist_cache_set_u32(rec + 8 * 4, first);
+         playlist_cache_set_u32(rec + 9 * 4, count);
+      }
+
+      playlist_cache_set_u32(rec + 10 * 4, entry->entry_slot);
+
+      if (fields == PLAYLIST_CACHE_FIELDS_PARSED)
+      {
+         playlist_cache_set_u32(rec + 11 * 4, entry->runtime_hours);
+         playlist_cache_set_u32(rec + 12 * 4, entry->runtime_minutes);
+         playlist_cache_set_u32(rec + 13 * 4, entry->runtime_seconds);
+         playlist_cache_set_u32(rec + 14 * 4, entry->last_played_year);
+         playlist_cache_set_u32(rec + 15 * 4, entry->last_played_month);
+         playlist_cache_set_u32(rec + 16 * 4, entry->last_played_day);
+         playlist_cache_set_u32(rec + 17 * 4, entry->last_played_hour);
+         playlist_cache_set_u32(rec + 18 * 4, entry->last_played_minute);
+         playlist_cache_set_u32(rec + 19 * 4, entry->last_played_second);
+      }
+   }
+
+   /* Metadata, the old format only has the default
+    * core (when both path and name are set) and modes */
+   playlist_cache_get_meta(playlist, meta);
+   for (i = 0; i < PLAYLIST_CACHE_META_STRINGS; i++)
+   {
+      if (old_format && (   (i > 1)
+               || string_is_empty(playlist->default_core_path)
+               || string_is_empty(playlist->default_core_name)))
+         continue;
+      playlist_cache_set_u32(head + (16 + i) * 4,
+            playlist_cache_add_string(&writer, *meta[i]));
+   }
+
+   if (writer.out_of_memory)
+      goto end;
+
+   if (len >= playlist->config.capacity)
+      flags |= PLAYLIST_CACHE_FULL;
+   if (playlist->modified)
+      flags |= PLAYLIST_CACHE_MODIFIED;
+   if (playlist->old_format)
+      flags |= PLAYLIST_CACHE_OLD_FORMAT;
+   if (playlist->compressed)
+      flags |= PLAYLIST_CACHE_COMPRESSED;
+
+   if (!old_format)
+   {
+      if (playlist->scan_record.search_recursively)
+         scan |= PLAYLIST_CACHE_SCAN_RECURSIVELY;
+      if (playlist->scan_record.search_archives)
+         scan |= PLAYLIST_CACHE_SCAN_ARCHIVES;
+      if (playlist->scan_record.filter_dat_content)
+         scan |= PLAYLIST_CACHE_SCAN_FILTER_DAT;
+      if (playlist->scan_record.overwrite_playlist)
+         scan |= PLAYLIST_CACHE_SCAN_OVERWRITE;
+   }
+
+   memcpy(head, PLAYLIST_CACHE_MAGIC, 8);
+   playlist_cache_set_u32(head +  2 * 4, PLAYLIST_CACHE_VERSION);
+   playlist_cache_set_u32(head +  3 * 4, (uint32_t)len);
+   playlist_cache_set_u32(head +  4 * 4, (uint32_t)MIN(
+            playlist->config.capacity, 0xFFFFFFFF));
+   playlist_cache_set_u32(head +  5 * 4, flags);
+   playlist_cache_set_i64(head +  6 * 4, lpl_size);
+   playlist_cache_set_i64(head +  8 * 4, lpl_mtime);
+   playlist_cache_set_u32(head + 10 * 4, playlist->label_display_mode);
+   playlist_cache_set_u32(head + 11 * 4, playlist->right_thumbnail_mode);
+   playlist_cache_set_u32(head + 12 * 4, playlist->left_thumbnail_mode);
+   playlist_cache_set_u32(head + 13 * 4, old_format
+         ? PLAYLIST_THUMBNAIL_MATCH_MODE_DEFAULT
+         : playlist->thumbnail_match_mode);
+   playlist_cache_set_u32(head + 14 * 4, playlist->sort_mode);
+   playlist_cache_set_u32(head + 15 * 4, scan);
+   playlist_cache_set_u32(head + 22 * 4, (uint32_t)RBUF_LEN(writer.strings));
+
+   strlcpy(tmp_path, cache_path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if ((file = filestream_open(tmp_path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+   {
+      int64_t strings_size = (int64_t)RBUF_LEN(writer.strings);
+      bool ok              =
+            (filestream_write(file, head, head_size) == (int64_t)head_size)
+         && (!strings_size || filestream_write(file, writer.strings,
+               strings_size) == strings_size);
+
+      filestream_close(file);
+
+      if (ok)
+      {
+         filestream_delete(cache_path);
+         filestream_rename(tmp_path, cache_path);
+      }
+      else
+         filestream_delete(tmp_path);
+   }
+
+end:
+   RBUF_FREE(writer.strings);
+   free(head);
+}
+
+/**
+ * playlist_entries_reserve:
+ * @playlist           : Playlist handle.
+ * @front              : Make room before the first entry,
+ *                       rather than after the last one.
+ *
+ * Makes room for one more entry. When the buffer has to be
+ * reorganised, most of the free slots go to the requested
+ * side, so that pushing entries to the top of a playlist
+ * (as scans and history do) only moves the existing ones
+ * every so often, rather than on each push.
+ *
+ * Returns: false if out of memory.
+ **/
+static bool playlist_entries_reserve(playlist_t *playlist, bool front)
+{
+   struct playlist_entry *buf = playlist->entries_buf;
+   size_t len                 = playlist->entries_len;
+   size_t cap                 = playlist->entries_cap;
+   size_t head                = buf ? (size_t)(playlist->entries - buf) : 0;
+   size_t room, head_new;
+
+   if (front ? (head > 0) : (head + len < cap))
+      return true;
+
+   /* Grow unless more than half the buffer is free */
+   if (len >= cap / 2)
+   {
+      size_t new_cap = cap ? cap * 2 : 16;
+      if (!(buf = (struct playlist_entry*)realloc(buf,
+            new_cap * sizeof(*buf))))
+         return false;
+      playlist->entries_buf = buf;
+      playlist->entries_cap = cap = new_cap;
+   }
+
+   room               = cap - len;
+   head_new           = front ? room - room / 4 : room / 4;
+   memmove(buf + head_new, buf + head, len * sizeof(*buf));
+   playlist->entries  = buf + head_new;
+   return true;
+}
+
+/* Value of a 'crc32' entry field, 0 if it isn't a CRC
+ * ("DETECT", a hash of another type...) */
+static uint32_t playlist_crc32_key(const char *crc32)
+{
+   char *end = NULL;
+   unsigned long crc;
+
+   if (string_is_empty(crc32))
+      return 0;
+
+   crc = strtoul(crc32, &end, 16);
+   if (!end || (end == crc32) || !string_is_equal_noncase(end, "|crc"))
+      return 0;
+
+   return (uint32_t)crc;
+}
+
+/* Key of the entries without a path, playlist_path_hash("") */
+#define PLAYLIST_INDEX_NO_PATH 0x811c9dc5
+
+static bool playlist_index_link(playlist_t *playlist,
+      uint32_t **map, uint32_t key, size_t stamp)
+{
+   uint32_t node;
+   size_t len;
+   uint32_t *chains = *map;
+
+   if (!key)
+      return true;
+
+   if (!RHMAP_TRYFIT(chains, RHMAP_LEN(chains) + 1))
+      return false;
+   *map = chains;
+
+   if ((node = playlist->index_free))
+      playlist->index_free = playlist->index_nodes[node - 1].next;
+   else
+   {
+      len = RBUF_LEN(playlist->index_nodes);
+      if (!RBUF_TRYFIT(playlist->index_nodes, len + 1))
+         return false;
+      RBUF_RESIZE(playlist->index_nodes, len + 1);
+      node = (uint32_t)(len + 1);
+   }
+
+   playlist->index_nodes[node - 1].stamp = stamp;
+   playlist->index_nodes[node - 1].next  = RHMAP_GET(chains, key);
+   RHMAP_SET(chains, key, node);
+   *map = chains;
+   return true;
+}
+
+static void playlist_index_unlink(playlist_t *playlist,
+      uint32_t **map, uint32_t key, size_t stamp)
+{
+   uint32_t found;
+   uint32_t *link;
+   ptrdiff_t pos;
+   uint32_t *chains = *map;
+
+   if (!key || (pos = RHMAP_IDX(chains, key)) == -1)
+      return;
+
+   /* Chains are short: same path or CRC, or hash collisions */
+   for (link = &chains[pos]; *link;
+         link = &playlist->index_nodes[*link - 1].next)
+   {
+      struct playlist_index_node *node =
+            &playlist->index_nodes[*link - 1];
+
+      if (node->stamp != stamp)
+         continue;
+
+      /* Move the node from the chain to the free list */
+      found                = *link;
+      *link                = node->next;
+      node->next           = playlist->index_free;
+      playlist->index_free = found;
+      break;
+   }
+
+   if (!chains[pos])
+      (void)RHMAP_DEL(chains, key);
+}
+
+/**
+ * playlist_index_entry:
+ * @playlist           : Playlist handle.
+ * @idx                : Index of playlist entry.
+ * @add                : Add the entry to the index, or remove it.
+ *
+ * Entries are indexed by real path hash, by parent archive
+ * hash when inside an archive, and by CRC32.
+ *
+ * Returns: false if out of memory.
+ **/
+static bool playlist_index_entry(playlist_t *playlist, size_t idx, bool add)
+{
+   struct playlist_entry *entry = &playlist->entries[idx];
+   size_t stamp                 = playlist->index_base + idx;
+   uint32_t path_key            = PLAYLIST_INDEX_NO_PATH;
+   uint32_t archive_key         = 0;
+   uint32_t crc_key             = playlist_crc32_key(entry->crc32);
+
+   if (!string_is_empty(entry->path))
+   {
+      if (!entry->path_id)
+         if (!(entry->path_id = playlist_path_id_init(entry->path)))
+            return false;
+
+      if (entry->path_id->real_path_hash)
+         path_key    = entry->path_id->real_path_hash;
+      if (entry->path_id->is_in_archive)
+         archive_key = entry->path_id->archive_path_hash;
+   }
+
+   if (!add)
+   {
+      playlist_index_unlink(playlist, &playlist->index_paths,
+            path_key, stamp);
+      playlist_index_unlink(playlist, &playlist->index_archives,
+            archive_key, stamp);
+      playlist_index_unlink(playlist, &playlist->index_crcs,
+            crc_key, stamp);
+      return true;
+   }
+
+   return playlist_index_link(playlist, &playlist->index_paths,
+            path_key, stamp)
+       && playlist_index_link(playlist, &playlist->index_archives,
+            archive_key, stamp)
+       && playlist_index_link(playlist, &playlist->index_crcs,
+            crc_key, stamp);
+}
+
+/**
+ * playlist_index_build:
+ * @playlist           : Playlist handle.
+ *
+ * The index is built on the first lookup, so that playlists
+ * which are only displayed never pay for it, then kept up to
+ * date as entries are pushed to the top or removed from either
+ * end. Anything that reorders the entries (sorting, moving an
+ * existing entry to the top, deleting from the middle) just
+ * marks it for a rebuild, since that costs O(n) anyway.
+ *
+ * Returns: false if out of memory, in which case lookups
+ * fall back to scanning the entries.
+ **/
+static bool playlist_index_build(playlist_t *playlist)
+{
+   size_t i;
+
+   if (playlist->index_valid)
+      return true;
+
+   playlist_cache_fill_all(playlist);
+
+   RHMAP_CLEAR(playlist->index_paths);
+   RHMAP_CLEAR(playlist->index_archives);
+   RHMAP_CLEAR(playlist->index_crcs);
+   RBUF_CLEAR(playlist->index_nodes);
+   playlist->index_free = 0;
+   playlist->index_base = 0;
+
+   for (i = 0; i < playlist->entries_len; i++)
+      if (!playlist_index_entry(playlist, i, true))
+         return false;
+
+   playlist->index_valid = true;
+   return true;
+}
+
+static void playlist_index_add(playlist_t *playlist, size_t idx)
+{
+   if (playlist->index_valid && !playlist_index_entry(playlist, idx, true))
+      playlist->index_valid = false;
+}
+
+static void playlist_index_remove(playlist_t *playlist, size_t idx)
+{
+   if (playlist->index_valid)
+      playlist_index_entry(playlist, idx, false);
+}
+
+static void playlist_index_free(playlist_t *playlist)
+{
+   RHMAP_FREE(playlist->index_paths);
+   RHMAP_FREE(playlist->index_archives);
+   RHMAP_FREE(playlist->index_crcs);
+   RBUF_FREE(playlist->index_nodes);
+   RBUF_FREE(playlist->index_matches);
+   playlist->index_free  = 0;
+   playlist->index_valid = false;
+}
+
+static bool playlist_entry_matches_path(playlist_t *playlist,
+      playlist_path_id_t *path_id, struct playlist_entry *entry)
+{
+   /* An empty path only matches entries without a path */
+   if (string_is_empty(path_id->real_path))
+      return string_is_empty(entry->path);
+   return playlist_path_matches_entry(path_id, entry, &playlist->config);
+}
+
+static void playlist_index_collect(playlist_t *playlist,
+      uint32_t *map, uint32_t key, playlist_path_id_t *path_id)
+{
+   ptrdiff_t pos = RHMAP_IDX(map, key);
+   uint32_t node = (pos != -1) ? map[pos] : 0;
+
+   for (; node; node = playlist->index_nodes[node - 1].next)
+   {
+      size_t idx = playlist->index_nodes[node - 1].stamp
+            - playlist->index_base;
+
+      if (playlist_entry_matches_path(playlist, path_id,
+            &playlist->entries[idx]))
+         RBUF_PUSH(playlist->index_matches, idx);
+   }
+}
+
+static int playlist_index_cmp(const void *a, const void *b)
+{
+   size_t idx_a = *(const size_t*)a;
+   size_t idx_b = *(const size_t*)b;
+   return (idx_a > idx_b) - (idx_a < idx_b);
+}
+
+/**
+ * playlist_find_path:
+ * @playlist           : Playlist handle.
+ * @path_id            : Path identity to search for.
+ *
+ * Collects the indices of the entries matching @path_id
+ * (see playlist_path_matches_entry()) in playlist->index_matches,
+ * in ascending order.
+ *
+ * Returns: number of matching entries.
+ **/
+static size_t playlist_find_path(playlist_t *playlist,
+      playlist_path_id_t *path_id)
+{
+   size_t i, len;
+
+   RBUF_CLEAR(playlist->index_matches);
+
+   if (!playlist_index_build(playlist))
+   {
+      for (i = 0; i < playlist->entries_len; i++)
+         if (playlist_entry_matches_path(playlist, path_id,
+               &playlist->entries[i]))
+            RBUF_PUSH(playlist->index_matches, i);
+      return RBUF_LEN(playlist->index_matches);
+   }
+
+   if (string_is_empty(path_id->real_path))
+      playlist_index_collect(playlist, playlist->index_paths,
+            PLAYLIST_INDEX_NO_PATH, path_id);
+   else
+   {
+      playlist_index_collect(playlist, playlist->index_paths,
+            path_id->real_path_hash, path_id);
+
+      /* Fuzzy archive matches: the archive itself when
+       * searching for a file inside it, files inside it
+       * when searching for the archive */
+      if (path_id->is_in_archive)
+      {
+         if (path_id->archive_path_hash != path_id->real_path_hash)
+            playlist_index_collect(playlist, playlist->index_paths,
+                  path_id->archive_path_hash, path_id);
+      }
+      else if (path_id->is_archive)
+         playlist_index_collect(playlist, playlist->index_archives,
+               path_id->archive_path_hash, path_id);
+   }
+
+   if ((len = RBUF_LEN(playlist->index_matches)) > 1)
+   {
+      size_t j;
+
+      qsort(playlist->index_matches, len, sizeof(size_t),
+            playlist_index_cmp);
+
+      /* An entry can be reached through both maps on
+       * hash collisions */
+      for (i = j = 1; i < len; i++)
+         if (playlist->index_matches[i] != playlist->index_matches[j - 1])
+            playlist->index_matches[j++] = playlist->index_matches[i];
+      RBUF_RESIZE(playlist->index_matches, j);
+      len = j;
+   }
+
+   return len;
+}
+
 uint32_t playlist_get_size(playlist_t *playlist)
 {
    if (!playlist)
       return 0;
-   return (uint32_t)RBUF_LEN(playlist->entries);
+   return (uint32_t)playlist->entries_len;
 }
 
 char *playlist_get_conf_path(playlist_t *playlist)
@@ -556,9 +1578,10 @@ void playlist_get_index(playlist_t *playlist,
       size_t idx,
       const struct playlist_entry **entry)
 {
-   if (!playlist || !entry || (idx >= RBUF_LEN(playlist->entries)))
+   if (!playlist || !entry || (idx >= playlist->entries_len))
       return;
 
+   playlist_cache_fill(playlist, idx);
    *entry = &playlist->entries[idx];
 }
 
@@ -623,6 +1646,41 @@ static void playlist_free_entry(struct playlist_entry *entry)
    entry->last_played_second = 0;
 }
 
+/* Frees all entries. Entries loaded from the cache only
+ * own their path ID and subsystem roms until detached */
+static void playlist_free_entries(playlist_t *playlist)
+{
+   size_t i;
+   bool borrowed = playlist->cache_data && !playlist->cache_detached;
+
+   for (i = 0; i < playlist->entries_len; i++)
+   {
+      struct playlist_entry *entry = &playlist->entries[i];
+
+      if (!borrowed)
+      {
+         playlist_free_entry(entry);
+         continue;
+      }
+
+      if (playlist->cache_loaded && !playlist->cache_loaded[i])
+         continue;
+
+      if (entry->path_id)
+         playlist_path_id_free(entry->path_id);
+      if (entry->subsystem_roms)
+         string_list_free(entry->subsystem_roms);
+      memset(entry, 0, sizeof(*entry));
+   }
+
+   if (borrowed)
+   {
+      free(playlist->cache_loaded);
+      playlist->cache_loaded   = NULL;
+      playlist->cache_detached = true;
+   }
+}
+
 /**
  * playlist_delete_index:
  * @playlist            : Playlist handle.
@@ -639,22 +1697,43 @@ void playlist_delete_index(playlist_t *playlist,
    if (!playlist)
       return;
 
-   len = RBUF_LEN(playlist->entries);
+   len = playlist->entries_len;
    if (idx >= len)
       return;
 
+   playlist_cache_detach(playlist);
+
    /* Free unwanted entry */
    entry_to_delete = (struct playlist_entry *)(playlist->entries + idx);
    if (entry_to_delete)
+   {
+      playlist_index_remove(playlist, idx);
       playlist_free_entry(entry_to_delete);
+   }
 
-   /* Shift remaining entries to fill the gap */
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (len - 1 - idx) * sizeof(struct playlist_entry));
-
-   RBUF_RESIZE(playlist->entries, len - 1);
+   /* Shift the entries on the shorter side of the gap
+    * to fill it; the index only survives if there is
+    * nothing to shift on one side */
+   if (idx < len / 2)
+   {
+      memmove(playlist->entries + 1, playlist->entries,
+            idx * sizeof(struct playlist_entry));
+      playlist->entries++;
+      if (idx == 0)
+         playlist->index_base++;
+      else
+         playlist->index_valid = false;
+   }
+   else
+   {
+      memmove(playlist->entries + idx, playlist->entries + idx + 1,
+            (len - 1 - idx) * sizeof(struct playlist_entry));
+      if (idx != len - 1)
+         playlist->index_valid = false;
+   }
 
-   playlist->modified = true;
+   playlist->entries_len = len - 1;
+   playlist->modified    = true;
 }
 
 /**
@@ -669,7 +1748,7 @@ void playlist_delete_by_path(playlist_t *playlist,
       const char *search_path)
 {
    playlist_path_id_t *path_id = NULL;
-   size_t i                    = 0;
+   size_t i;
 
    if (!playlist || string_is_empty(search_path))
       return;
@@ -677,21 +1756,10 @@ void playlist_delete_by_path(playlist_t *playlist,
    if (!(path_id = playlist_path_id_init(search_path)))
       return;
 
-   while (i < RBUF_LEN(playlist->entries))
-   {
-      if (!playlist_path_matches_entry(path_id,
-            &playlist->entries[i], &playlist->config))
-      {
-         i++;
-         continue;
-      }
-
-      /* Paths are equal - delete entry */
-      playlist_delete_index(playlist, i);
-
-      /* Entries are shifted up by the delete
-       * operation - *do not* increment i */
-   }
+   /* Delete from the last match, so that the
+    * indices of the others stay the same */
+   for (i = playlist_find_path(playlist, path_id); i > 0; i--)
+      playlist_delete_index(playlist, playlist->index_matches[i - 1]);
 
    playlist_path_id_free(path_id);
 }
@@ -701,7 +1769,6 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const struct playlist_entry **entry)
 {
    playlist_path_id_t *path_id = NULL;
-   size_t i, len;
 
    if (!playlist || !entry || string_is_empty(search_path))
       return;
@@ -709,15 +1776,8 @@ void playlist_get_index_by_path(playlist_t *playlist,
    if (!(path_id = playlist_path_id_init(search_path)))
       return;
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      if (!playlist_path_matches_entry(path_id,
-            &playlist->entries[i], &playlist->config))
-         continue;
-
-      *entry = &playlist->entries[i];
-      break;
-   }
+   if (playlist_find_path(playlist, path_id))
+      *entry = &playlist->entries[playlist->index_matches[0]];
 
    playlist_path_id_free(path_id);
 }
@@ -725,8 +1785,8 @@ void playlist_get_index_by_path(playlist_t *playlist,
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path)
 {
+   bool exists;
    playlist_path_id_t *path_id = NULL;
-   size_t i, len;
 
    if (!playlist || string_is_empty(path))
       return false;
@@ -734,30 +1794,72 @@ bool playlist_entry_exists(playlist_t *playlist,
    if (!(path_id = playlist_path_id_init(path)))
       return false;
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+   exists = playlist_find_path(playlist, path_id) > 0;
+
+   playlist_path_id_free(path_id);
+   return exists;
+}
+
+void playlist_get_index_by_crc32(playlist_t *playlist,
+      uint32_t crc32, const struct playlist_entry **entry)
+{
+   size_t i;
+
+   if (!playlist || !entry || !crc32)
+      return;
+
+   if (!playlist_index_build(playlist))
    {
-      if (playlist_path_matches_entry(path_id,
-            &playlist->entries[i], &playlist->config))
+      for (i = 0; i < playlist->entries_len; i++)
       {
-         playlist_path_id_free(path_id);
-         return true;
+         if (playlist_crc32_key(playlist->entries[i].crc32) == crc32)
+         {
+            *entry = &playlist->entries[i];
+            break;
+         }
       }
+      return;
    }
 
-   playlist_path_id_free(path_id);
-   return false;
+   /* Lowest index wins, as with a linear search */
+   {
+      size_t best   = playlist->entries_len;
+      ptrdiff_t pos = RHMAP_IDX(playlist->index_crcs, crc32);
+      uint32_t node = (pos != -1) ? playlist->index_crcs[pos] : 0;
+
+      for (; node; node = playlist->index_nodes[node - 1].next)
+      {
+         size_t idx = playlist->index_nodes[node - 1].stamp
+               - playlist->index_base;
+         if (idx < best)
+            best = idx;
+      }
+
+      if (best < playlist->entries_len)
+         *entry = &playlist->entries[best];
+   }
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
       const struct playlist_entry *update_entry)
 {
    struct playlist_entry *entry = NULL;
+   bool reindex                 = false;
 
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return;
 
+   playlist_cache_detach(playlist);
    entry            = &playlist->entries[idx];
 
+   /* Path and CRC are index keys */
+   if (   (update_entry->path  && (update_entry->path  != entry->path))
+       || (update_entry->crc32 && (update_entry->crc32 != entry->crc32)))
+   {
+      playlist_index_remove(playlist, idx);
+      reindex = true;
+   }
+
    if (update_entry->path && (update_entry->path != entry->path))
    {
       if (entry->path)
@@ -813,6 +1915,9 @@ void playlist_update(playlist_t *playlist, size_t idx,
       entry->crc32       = strdup(update_entry->crc32);
       playlist->modified = true;
    }
+
+   if (reindex)
+      playlist_index_add(playlist, idx);
 }
 
 void playlist_update_runtime(playlist_t *playlist, size_t idx,
@@ -821,13 +1926,16 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return;
 
+   playlist_cache_detach(playlist);
    entry            = &playlist->entries[idx];
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
+      playlist_index_remove(playlist, idx);
+
       if (entry->path)
          free(entry->path);
       entry->path        = strdup(update_entry->path);
@@ -838,6 +1946,7 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
          entry->path_id  = NULL;
       }
 
+      playlist_index_add(playlist, idx);
       playlist->modified = playlist->modified || register_update;
    }
 
@@ -929,11 +2038,41 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
    }
 }
 
+/**
+ * playlist_push_front:
+ * @playlist           : Playlist handle.
+ *
+ * Adds a blank entry at the top of the playlist,
+ * removing the last entry if the playlist is full.
+ *
+ * Returns: false if out of memory.
+ **/
+static bool playlist_push_front(playlist_t *playlist)
+{
+   size_t len = playlist->entries_len;
+
+   if (len == playlist->config.capacity)
+   {
+      playlist_index_remove(playlist, len - 1);
+      playlist_free_entry(&playlist->entries[len - 1]);
+      playlist->entries_len = --len;
+   }
+
+   if (!playlist_entries_reserve(playlist, true))
+      return false;
+
+   playlist->entries--;
+   playlist->entries_len++;
+   playlist->index_base--;
+   memset(&playlist->entries[0], 0, sizeof(struct playlist_entry));
+   return true;
+}
+
 bool playlist_push_runtime(playlist_t *playlist,
       const struct playlist_entry *entry)
 {
    playlist_path_id_t *path_id = NULL;
-   size_t i, len;
+   size_t i, m, len;
    char real_core_path[PATH_MAX_LENGTH];
 
    if (!playlist || !entry)
@@ -962,18 +2101,13 @@ bool playlist_push_runtime(playlist_t *playlist,
       goto error;
    }
 
-   len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < len; i++)
+   playlist_cache_detach(playlist);
+
+   for (m = 0, len = playlist_find_path(playlist, path_id); m < len; m++)
    {
       struct playlist_entry tmp;
-      bool equal_path  = (string_is_empty(path_id->real_path)
-            && string_is_empty(playlist->entries[i].path));
-
-      equal_path       = equal_path || playlist_path_matches_entry(
-            path_id, &playlist->entries[i], &playlist->config);
 
-      if (!equal_path)
-         continue;
+      i = playlist->index_matches[m];
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -989,7 +2123,8 @@ bool playlist_push_runtime(playlist_t *playlist,
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist->entries[0]  = tmp;
+      playlist->index_valid = false;
 
       goto success;
    }
@@ -997,25 +2132,11 @@ bool playlist_push_runtime(playlist_t *playlist,
    if (playlist->config.capacity == 0)
       goto error;
 
-   if (len == playlist->config.capacity)
-   {
-      struct playlist_entry *last_entry = &playlist->entries[len - 1];
-      playlist_free_entry(last_entry);
-      len--;
-   }
-   else
-   {
-      /* Allocate memory to fit one more item and resize the buffer */
-      if (!RBUF_TRYFIT(playlist->entries, len + 1))
-         goto error; /* out of memory */
-      RBUF_RESIZE(playlist->entries, len + 1);
-   }
+   if (!playlist_push_front(playlist))
+      goto error; /* out of memory */
 
    if (playlist->entries)
    {
-      memmove(playlist->entries + 1, playlist->entries,
-            len * sizeof(struct playlist_entry));
-
       playlist->entries[0].path               = NULL;
       playlist->entries[0].core_path          = NULL;
 
@@ -1045,6 +2166,8 @@ bool playlist_push_runtime(playlist_t *playlist,
          playlist->entries[0].runtime_str     = strdup(entry->runtime_str);
       if (!string_is_empty(entry->last_played_str))
          playlist->entries[0].last_played_str = strdup(entry->last_played_str);
+
+      playlist_index_add(playlist, 0);
    }
 
 success:
@@ -1064,9 +2187,10 @@ void playlist_update_thumbnail_name_flag(playlist_t *playlist, size_t idx,
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return;
 
+   playlist_cache_fill(playlist, idx);
    entry                   = &playlist->entries[idx];
    entry->thumbnail_flags |= thumbnail_flags;
 }
@@ -1075,9 +2199,10 @@ enum playlist_thumbnail_name_flags playlist_get_curr_thumbnail_name_flag(playlis
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return    PLAYLIST_THUMBNAIL_FLAG_NONE;
 
+   playlist_cache_fill(playlist, idx);
    entry = &playlist->entries[idx];
    return entry->thumbnail_flags;
 }
@@ -1087,8 +2212,9 @@ enum playlist_thumbnail_name_flags playlist_get_next_thumbnail_name_flag(playlis
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return    PLAYLIST_THUMBNAIL_FLAG_NONE;
+   playlist_cache_fill(playlist, idx);
    entry = &playlist->entries[idx];
 
    if (entry->thumbnail_flags & PLAYLIST_THUMBNAIL_FLAG_SHORT_NAME)
@@ -1100,7 +2226,7 @@ enum playlist_thumbnail_name_flags playlist_get_next_thumbnail_name_flag(playlis
    /* Special case: only one entry in playlist, only one query is possible
     * as flag swapping relies on going back and forth among entries
     * so just use the most likely version here */
-   if (idx == 0 && RBUF_LEN(playlist->entries) == 1)
+   if (idx == 0 && playlist->entries_len == 1)
             return PLAYLIST_THUMBNAIL_FLAG_STD_NAME;
    return PLAYLIST_THUMBNAIL_FLAG_FULL_NAME;
 }
@@ -1252,7 +2378,7 @@ bool playlist_content_path_is_valid(const char *path)
 bool playlist_push(playlist_t *playlist,
       const struct playlist_entry *entry)
 {
-   size_t i, len;
+   size_t i, m, len;
    char real_core_path[PATH_MAX_LENGTH];
    playlist_path_id_t *path_id = NULL;
    const char *core_name       = entry->core_name;
@@ -1299,18 +2425,13 @@ bool playlist_push(playlist_t *playlist,
       }
    }
 
-   len = RBUF_LEN(playlist->entries);
-   for (i = 0; i < len; i++)
+   playlist_cache_detach(playlist);
+
+   for (m = 0, len = playlist_find_path(playlist, path_id); m < len; m++)
    {
       struct playlist_entry tmp;
-      bool equal_path  = (string_is_empty(path_id->real_path)
-                       && string_is_empty(playlist->entries[i].path));
 
-      equal_path       = equal_path || playlist_path_matches_entry(
-            path_id, &playlist->entries[i], &playlist->config);
-
-      if (!equal_path)
-         continue;
+      i = playlist->index_matches[m];
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -1395,7 +2516,9 @@ bool playlist_push(playlist_t *playlist,
       if (     !playlist->entries[i].crc32 
             && !string_is_empty(entry->crc32))
       {
+         playlist_index_remove(playlist, i);
          playlist->entries[i].crc32       = strdup(entry->crc32);
+         playlist_index_add(playlist, i);
          entry_updated                    = true;
       }
       if (     !playlist->entries[i].db_name 
@@ -1419,7 +2542,8 @@ bool playlist_push(playlist_t *playlist,
       tmp = playlist->entries[i];
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist->entries[0]  = tmp;
+      playlist->index_valid = false;
 
       goto success;
    }
@@ -1427,25 +2551,11 @@ bool playlist_push(playlist_t *playlist,
    if (playlist->config.capacity == 0)
       goto error;
 
-   if (len == playlist->config.capacity)
-   {
-      struct playlist_entry *last_entry = &playlist->entries[len - 1];
-      playlist_free_entry(last_entry);
-      len--;
-   }
-   else
-   {
-      /* Allocate memory to fit one more item and resize the buffer */
-      if (!RBUF_TRYFIT(playlist->entries, len + 1))
-         goto error; /* out of memory */
-      RBUF_RESIZE(playlist->entries, len + 1);
-   }
+   if (!playlist_push_front(playlist))
+      goto error; /* out of memory */
 
    if (playlist->entries)
    {
-      memmove(playlist->entries + 1, playlist->entries,
-            len * sizeof(struct playlist_entry));
-
       playlist->entries[0].path               = NULL;
       playlist->entries[0].label              = NULL;
       playlist->entries[0].core_path          = NULL;
@@ -1500,6 +2610,8 @@ bool playlist_push(playlist_t *playlist,
          for (i = 0; i < entry->subsystem_roms->size; i++)
             string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
       }
+
+      playlist_index_add(playlist, 0);
    }
 
 success:
@@ -1523,6 +2635,8 @@ void playlist_write_runtime_file(playlist_t *playlist)
    if (!playlist || !playlist->modified)
       return;
 
+   playlist_cache_fill_all(playlist);
+
    if (!(file = intfstream_open_file(playlist->config.path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
    {
@@ -1552,7 +2666,7 @@ void playlist_write_runtime_file(playlist_t *playlist)
    rjsonwriter_raw(writer, "[", 1);
    rjsonwriter_raw(writer, "\n", 1);
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+   for (i = 0, len = playlist->entries_len; i < len; i++)
    {
       rjsonwriter_add_spaces(writer, 4);
       rjsonwriter_raw(writer, "{", 1);
@@ -1676,6 +2790,7 @@ void playlist_write_file(playlist_t *playlist)
    size_t i, len;
    intfstream_t *file = NULL;
    bool compressed    = false;
+   bool written       = false;
 
    /* Playlist will be written if any of the
     * following are true:
@@ -1692,6 +2807,8 @@ void playlist_write_file(playlist_t *playlist)
         (playlist->old_format != playlist->config.old_format)))
       return;
 
+   playlist_cache_fill_all(playlist);
+
 #if defined(HAVE_ZLIB)
    if (playlist->config.compress)
       file = intfstream_open_rzip_file(playlist->config.path,
@@ -1714,7 +2831,7 @@ void playlist_write_file(playlist_t *playlist)
 #ifdef RARCH_INTERNAL
    if (playlist->config.old_format)
    {
-      for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+      for (i = 0, len = playlist->entries_len; i < len; i++)
          intfstream_printf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
                playlist->entries[i].path      ? playlist->entries[i].path      : "",
                playlist->entries[i].label     ? playlist->entries[i].label     : "",
@@ -1914,7 +3031,7 @@ void playlist_write_file(playlist_t *playlist)
       rjsonwriter_raw(writer, "[", 1);
       rjsonwriter_raw(writer, "\n", 1);
 
-      for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+      for (i = 0, len = playlist->entries_len; i < len; i++)
       {
          rjsonwriter_add_spaces(writer, 4);
          rjsonwriter_raw(writer, "{", 1);
@@ -2061,11 +3178,19 @@ void playlist_write_file(playlist_t *playlist)
 
    playlist->modified   = false;
    playlist->compressed = compressed;
+   written              = true;
 
    RARCH_LOG("[Playlist]: Written to playlist file: \"%s\".\n", playlist->config.path);
 end:
    intfstream_close(file);
    free(file);
+
+   /* Once closed, so that the cache gets the final
+    * size and time of the playlist file */
+   if (written)
+      playlist_cache_write(playlist, playlist->old_format
+            ? PLAYLIST_CACHE_FIELDS_OLD_FORMAT
+            : PLAYLIST_CACHE_FIELDS_JSON);
 }
 
 /**
@@ -2076,8 +3201,6 @@ end:
  */
 void playlist_free(playlist_t *playlist)
 {
-   size_t i, len;
-
    if (!playlist)
       return;
 
@@ -2107,17 +3230,13 @@ void playlist_free(playlist_t *playlist)
 
    if (playlist->entries)
    {
-      for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-      {
-         struct playlist_entry *entry = &playlist->entries[i];
-
-         if (entry)
-            playlist_free_entry(entry);
-      }
-
-      RBUF_FREE(playlist->entries);
+      playlist_free_entries(playlist);
+      free(playlist->entries_buf);
    }
 
+   playlist_index_free(playlist);
+   playlist_cache_unmap(playlist);
+
    free(playlist);
 }
 
@@ -2129,18 +3248,12 @@ void playlist_free(playlist_t *playlist)
  **/
 void playlist_clear(playlist_t *playlist)
 {
-   size_t i, len;
    if (!playlist)
       return;
 
-   for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
-   {
-      struct playlist_entry *entry = &playlist->entries[i];
-
-      if (entry)
-         playlist_free_entry(entry);
-   }
-   RBUF_CLEAR(playlist->entries);
+   playlist_free_entries(playlist);
+   playlist->entries_len = 0;
+   playlist->index_valid = false;
 }
 
 /**
@@ -2154,7 +3267,7 @@ size_t playlist_size(playlist_t *playlist)
 {
    if (!playlist)
       return 0;
-   return RBUF_LEN(playlist->entries);
+   return playlist->entries_len;
 }
 
 /**
@@ -2211,12 +3324,12 @@ static bool JSONStartObjectHandler(void *context)
             (pCtx->array_depth == 1) 
          && !pCtx->capacity_exceeded)
       {
-         size_t len = RBUF_LEN(pCtx->playlist->entries);
+         size_t len = pCtx->playlist->entries_len;
          if (len < pCtx->playlist->config.capacity)
          {
             /* Allocate memory to fit one more item but don't resize the
              * buffer just yet, wait until JSONEndObjectHandler for that */
-            if (!RBUF_TRYFIT(pCtx->playlist->entries, len + 1))
+            if (!playlist_entries_reserve(pCtx->playlist, false))
             {
                pCtx->out_of_memory     = true;
                return false;
@@ -2253,8 +3366,7 @@ static bool JSONEndObjectHandler(void *context)
    {
       if (     (pCtx->array_depth == 1) 
             && !pCtx->capacity_exceeded)
-         RBUF_RESIZE(pCtx->playlist->entries,
-               RBUF_LEN(pCtx->playlist->entries) + 1);
+         pCtx->playlist->entries_len++;
    }
 
    pCtx->object_depth--;
@@ -2540,16 +3652,24 @@ static bool playlist_read_file(playlist_t *playlist)
 {
    unsigned i;
    int test_char;
+   intfstream_t *file   = NULL;
    bool res             = true;
+   bool parsed          = false;
+
+   /* Large playlists are loaded from their cache,
+    * as long as it matches the playlist file */
+   if (playlist_cache_load(playlist))
+      return true;
+
 #if defined(HAVE_ZLIB)
       /* Always use RZIP interface when reading playlists
        * > this will automatically handle uncompressed
        *   data */
-   intfstream_t *file   = intfstream_open_rzip_file(
+   file                 = intfstream_open_rzip_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ);
 #else
-   intfstream_t *file   = intfstream_open_file(
+   file                 = intfstream_open_file(
          playlist->config.path,
          RETRO_VFS_FILE_ACCESS_READ,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
@@ -2605,7 +3725,9 @@ static bool playlist_read_file(playlist_t *playlist)
             JSONEndArrayHandler,
             JSONBoolHandler,
             NULL) /* Unused null handler */
-            != RJSON_DONE)
+            == RJSON_DONE)
+         parsed = true;
+      else
       {
          if (context.out_of_memory)
          {
@@ -2627,7 +3749,7 @@ static bool playlist_read_file(playlist_t *playlist)
    }
    else
    {
-      size_t len = RBUF_LEN(playlist->entries);
+      size_t len = playlist->entries_len;
       char line_buf[PLAYLIST_ENTRIES][PATH_MAX_LENGTH] = {{0}};
 
       /* Unnecessary, but harmless */
@@ -2662,13 +3784,13 @@ static bool playlist_read_file(playlist_t *playlist)
          {
             struct playlist_entry* entry;
 
-            if (!RBUF_TRYFIT(playlist->entries, len + 1))
+            if (!playlist_entries_reserve(playlist, false))
             {
                res = false; /* out of memory */
                goto end;
             }
-            RBUF_RESIZE(playlist->entries, len + 1);
-            entry = &playlist->entries[len++];
+            entry                 = &playlist->entries[len++];
+            playlist->entries_len = len;
 
             memset(entry, 0, sizeof(*entry));
 
@@ -2815,11 +3937,16 @@ static bool playlist_read_file(playlist_t *playlist)
             break;
          }
       }
+
+      parsed = true;
    }
 
 end:
    intfstream_close(file);
    free(file);
+
+   if (parsed)
+      playlist_cache_write(playlist, PLAYLIST_CACHE_FIELDS_PARSED);
    return res;
 }
 
@@ -2880,6 +4007,22 @@ playlist_t *playlist_init(const playlist_config_t *config)
    playlist->default_core_path      = NULL;
    playlist->base_content_directory = NULL;
    playlist->entries                = NULL;
+   playlist->entries_buf            = NULL;
+   playlist->entries_len            = 0;
+   playlist->entries_cap            = 0;
+   playlist->index_paths            = NULL;
+   playlist->index_archives         = NULL;
+   playlist->index_crcs             = NULL;
+   playlist->index_nodes            = NULL;
+   playlist->index_matches          = NULL;
+   playlist->index_base             = 0;
+   playlist->index_free             = 0;
+   playlist->index_valid            = false;
+   playlist->cache_data             = NULL;
+   playlist->cache_loaded           = NULL;
+   playlist->cache_size             = 0;
+   playlist->cache_mapped           = false;
+   playlist->cache_detached         = false;
    playlist->label_display_mode     = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode   = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode    = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
@@ -2912,7 +4055,9 @@ playlist_t *playlist_init(const playlist_config_t *config)
          size_t i, j, len;
          char tmp_entry_path[PATH_MAX_LENGTH];
 
-         for (i = 0, len = RBUF_LEN(playlist->entries); i < len; i++)
+         playlist_cache_detach(playlist);
+
+         for (i = 0, len = playlist->entries_len; i < len; i++)
          {
             struct playlist_entry* entry = &playlist->entries[i];
 
@@ -3099,9 +4244,14 @@ void playlist_qsort(playlist_t *playlist)
        || (playlist->sort_mode == PLAYLIST_SORT_MODE_OFF))
       return;
 
-   qsort(playlist->entries, RBUF_LEN(playlist->entries),
+   playlist_cache_fill_all(playlist);
+
+   qsort(playlist->entries, playlist->entries_len,
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+
+   /* Every entry may have moved, rebuild on next lookup */
+   playlist->index_valid = false;
 }
 
 void command_playlist_push_write(
@@ -3136,9 +4286,11 @@ bool playlist_index_is_valid(playlist_t *playlist, size_t idx,
    if (!playlist)
       return false;
 
-   if (idx >= RBUF_LEN(playlist->entries))
+   if (idx >= playlist->entries_len)
       return false;
 
+   playlist_cache_fill(playlist, idx);
+
    return    playlist_path_equal(path, playlist->entries[idx].path, &playlist->config)
           && string_is_equal(path_basename_nocompression(playlist->entries[idx].core_path),
                 path_basename_nocompression(core_path));
@@ -3203,12 +4355,14 @@ bool playlist_index_entries_are_equal(
    if (!playlist)
       return false;
 
-   len = RBUF_LEN(playlist->entries);
+   len = playlist->entries_len;
 
    if ((idx_a >= len) || (idx_b >= len))
       return false;
 
    /* Fetch entries */
+   playlist_cache_fill(playlist, idx_a);
+   playlist_cache_fill(playlist, idx_b);
    entry_a = &playlist->entries[idx_a];
    entry_b = &playlist->entries[idx_b];
 
@@ -3228,9 +4382,11 @@ bool playlist_index_entries_are_equal(
 void playlist_get_crc32(playlist_t *playlist, size_t idx,
       const char **crc32)
 {
-   if (!playlist || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || idx >= playlist->entries_len)
       return;
 
+   playlist_cache_fill(playlist, idx);
+
    if (crc32)
       *crc32 = playlist->entries[idx].crc32;
 }
@@ -3238,9 +4394,11 @@ void playlist_get_crc32(playlist_t *playlist, size_t idx,
 void playlist_get_db_name(playlist_t *playlist, size_t idx,
       const char **db_name)
 {
-   if (!playlist || !db_name || idx >= RBUF_LEN(playlist->entries))
+   if (!playlist || !db_name || idx >= playlist->entries_len)
       return;
 
+   playlist_cache_fill(playlist, idx);
+
    if (!string_is_empty(playlist->entries[idx].db_name))
        *db_name = playlist->entries[idx].db_name;
    else
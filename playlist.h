@@ -29,6 +29,11 @@
 /* Default maximum playlist size */
 #define COLLECTION_SIZE 0x7FFFFFFF
 
+/* Appended to the path of a playlist to get the path of its
+ * binary cache, from which large playlists are loaded while
+ * it matches the playlist file */
+#define PLAYLIST_CACHE_FILE_EXTENSION ".cache"
+
 RETRO_BEGIN_DECLS
 
 enum playlist_runtime_status
@@ -313,6 +318,15 @@ void playlist_get_index_by_path(playlist_t *playlist,
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path);
 
+/**
+ * playlist_get_index_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : Content CRC32, as in "%08X|crc" entry values.
+ * @entry               : Set to the first entry with that CRC, if any.
+ **/
+void playlist_get_index_by_crc32(playlist_t *playlist,
+      uint32_t crc32, const struct playlist_entry **entry);
+
 char *playlist_get_conf_path(playlist_t *playlist);
 
 uint32_t playlist_get_size(playlist_t *playlist);
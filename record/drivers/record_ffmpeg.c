@@ -23,8 +23,10 @@
 #include <compat/strl.h>
 
 #include <boolean.h>
-#include <queues/fifo_queue.h>
+#include <retro_atomic.h>
+#include <retro_math.h>
 #include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
 #include <file/config_file.h>
@@ -71,6 +73,12 @@ extern "C" {
 
 #define FFMPEG3 (LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 10, 100))
 
+#define MAX_FRAMES 32
+/* Default depth of the video queue. */
+#define DEFAULT_QUEUE_FRAMES 8
+#define MAX_AUDIO_SLOTS 32
+#define AUDIO_SLOT_FRAMES 1024
+
 struct ff_video_info
 {
    AVCodecContext *codec;
@@ -157,8 +165,13 @@ struct ff_config_param
    unsigned threads;
    unsigned frame_drop_ratio;
    unsigned sample_rate;
+   unsigned queue_frames;
    float scale_factor;
 
+   /* Drop frames when the encoder falls behind
+    * instead of blocking the core thread. */
+   bool queue_drop;
+
    bool audio_enable;
    /* Keep same naming conventions as libavcodec. */
    bool audio_qscale;
@@ -172,6 +185,25 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+/* Lock-free single producer, single consumer ring of
+ * preallocated slots between the core thread and the
+ * encoder thread. Only the producer writes tail and
+ * only the consumer writes head. size is a power of two. */
+struct ff_queue
+{
+   retro_atomic_long_t head;
+   retro_atomic_long_t tail;
+   unsigned size;
+};
+
+struct ff_video_slot
+{
+   struct record_video_data attr;
+   uint8_t *data;
+   retro_time_t time;  /* When the frame was queued. */
+   unsigned skipped;   /* Frames dropped right before this one. */
+};
+
 typedef struct ffmpeg
 {
    struct ff_video_info video;
@@ -183,16 +215,35 @@ typedef struct ffmpeg
 
    AVPacket *pkt;
 
+   /* Only used to sleep while a queue is empty or full. */
    scond_t *cond;
    slock_t *cond_lock;
-   slock_t *lock;
-   fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
    sthread_t *thread;
 
+   struct ff_queue video_queue;
+   struct ff_queue audio_queue;
+   struct ff_video_slot *video_slots;
+   uint8_t *video_buf;
+   int16_t *audio_buf;
+   /* One slot worth of silence, right after the last slot. */
+   const int16_t *audio_silence;
+   size_t audio_slot_frames[MAX_AUDIO_SLOTS];
+   /* Frames dropped right before each slot. */
+   size_t audio_slot_skipped[MAX_AUDIO_SLOTS];
+
+   /* Written by the core thread. */
+   uint64_t video_frames;
+   uint64_t video_frames_dropped;
+   uint64_t audio_frames_dropped;
+   size_t audio_skipped;
+   unsigned video_skipped;
+   unsigned video_queue_depth_max;
+
+   /* Written by the encoder thread. */
+   retro_atomic_long_t encoder_lag;
+   retro_atomic_long_t encoder_lag_max;
+
    volatile bool alive;
-   volatile bool can_sleep;
 } ffmpeg_t;
 
 AVFormatContext *ctx;
@@ -725,6 +776,7 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
 {
    struct config_file_entry entry;
    char pix_fmt[64]         = {0};
+   char queue_policy[16]    = {0};
 
    params->out_pix_fmt      = AV_PIX_FMT_NONE;
    params->scale_factor     = 1;
@@ -761,6 +813,18 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
 
    config_get_uint(params->conf, "sample_rate", &params->sample_rate);
    config_get_float(params->conf, "scale_factor", &params->scale_factor);
+   config_get_uint(params->conf, "queue_frames", &params->queue_frames);
+
+   if (config_get_array(params->conf, "queue_policy",
+            queue_policy, sizeof(queue_policy)))
+   {
+      if (string_is_equal(queue_policy, "drop"))
+         params->queue_drop = true;
+      else if (string_is_equal(queue_policy, "block"))
+         params->queue_drop = false;
+      else
+         RARCH_WARN("[FFmpeg] Unknown queue_policy \"%s\".\n", queue_policy);
+   }
 
    params->audio_qscale = config_get_int(params->conf, "audio_global_quality",
          &params->audio_global_quality);
@@ -862,23 +926,115 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
-
 static void ffmpeg_thread(void *data);
 
+static unsigned ff_queue_depth(struct ff_queue *queue)
+{
+   return (unsigned)(
+           (unsigned long)retro_atomic_load_acquire(&queue->tail)
+         - (unsigned long)retro_atomic_load_acquire(&queue->head));
+}
+
+/* Producer side. Returns false if the queue is full. */
+static bool ff_queue_write_index(struct ff_queue *queue, unsigned *index)
+{
+   unsigned long tail = (unsigned long)queue->tail;
+
+   if (tail - (unsigned long)retro_atomic_load_acquire(&queue->head)
+         >= queue->size)
+      return false;
+
+   *index = (unsigned)(tail & (queue->size - 1));
+   return true;
+}
+
+static void ff_queue_push(struct ff_queue *queue)
+{
+   retro_atomic_store_release(&queue->tail,
+         (long)((unsigned long)queue->tail + 1));
+}
+
+/* Consumer side. Returns false if the queue is empty. */
+static bool ff_queue_read_index(struct ff_queue *queue, unsigned *index)
+{
+   unsigned long head = (unsigned long)queue->head;
+
+   if ((unsigned long)retro_atomic_load_acquire(&queue->tail) == head)
+      return false;
+
+   *index = (unsigned)(head & (queue->size - 1));
+   return true;
+}
+
+static void ff_queue_pop(struct ff_queue *queue)
+{
+   retro_atomic_store_release(&queue->head,
+         (long)((unsigned long)queue->head + 1));
+}
+
+static void ffmpeg_wake(ffmpeg_t *handle)
+{
+   /* The final flush runs on the core thread after
+    * the encoder thread is gone, nobody to wake up. */
+   if (!handle->thread)
+      return;
+
+   slock_lock(handle->cond_lock);
+   scond_signal(handle->cond);
+   slock_unlock(handle->cond_lock);
+}
+
+static size_t ffmpeg_video_slot_size(ffmpeg_t *handle)
+{
+   /* sws_scale() tends to read a bit past the end of
+    * the frame, leave a spare line at the end. */
+   return handle->params.fb_width * (handle->params.fb_height + 1)
+      * handle->video.pix_size;
+}
+
 static bool init_thread(ffmpeg_t *handle)
 {
-   handle->lock       = slock_new();
-   handle->cond_lock  = slock_new();
-   handle->cond       = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
-         handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo  = fifo_new(sizeof(struct record_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+   unsigned i;
+   size_t slot_size                = ffmpeg_video_slot_size(handle);
+   unsigned queue_frames           = handle->config.queue_frames;
+
+   if (queue_frames < 2)
+      queue_frames                 = 2;
+   else if (queue_frames > MAX_FRAMES)
+      queue_frames                 = MAX_FRAMES;
+
+   handle->video_queue.size        = next_pow2(queue_frames);
+   handle->audio_queue.size        = MAX_AUDIO_SLOTS;
+
+   handle->video_slots             = (struct ff_video_slot*)calloc(
+         handle->video_queue.size, sizeof(*handle->video_slots));
+   handle->video_buf               = (uint8_t*)av_malloc(
+         slot_size * handle->video_queue.size);
+
+   if (!handle->video_slots || !handle->video_buf)
+      return false;
+
+   for (i = 0; i < handle->video_queue.size; i++)
+      handle->video_slots[i].data  = handle->video_buf + i * slot_size;
+
+   if (handle->config.audio_enable)
+   {
+      if (!(handle->audio_buf      = (int16_t*)av_mallocz(
+                  (MAX_AUDIO_SLOTS + 1) * AUDIO_SLOT_FRAMES
+                  * handle->params.channels * sizeof(int16_t))))
+         return false;
+      handle->audio_silence        = handle->audio_buf
+         + MAX_AUDIO_SLOTS * AUDIO_SLOT_FRAMES * handle->params.channels;
+   }
+
+   RARCH_LOG("[FFmpeg]: Queueing up to %u frames, %s when the encoder falls behind.\n",
+         handle->video_queue.size,
+         handle->config.queue_drop ? "dropping frames" : "blocking");
+
+   handle->cond_lock = slock_new();
+   handle->cond      = scond_new();
 
    handle->alive     = true;
-   handle->can_sleep = true;
    handle->thread    = sthread_create(ffmpeg_thread, handle);
 
    return true;
@@ -891,38 +1047,30 @@ static void deinit_thread(ffmpeg_t *handle)
 
    slock_lock(handle->cond_lock);
    handle->alive = false;
-   handle->can_sleep = false;
+   scond_signal(handle->cond);
    slock_unlock(handle->cond_lock);
 
-   scond_signal(handle->cond);
    sthread_join(handle->thread);
 
-   slock_free(handle->lock);
    slock_free(handle->cond_lock);
    scond_free(handle->cond);
 
-   handle->thread = NULL;
+   handle->cond_lock = NULL;
+   handle->cond      = NULL;
+   handle->thread    = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
-   if (handle->audio_fifo)
-   {
-      fifo_free(handle->audio_fifo);
-      handle->audio_fifo = NULL;
-   }
+   free(handle->video_slots);
+   handle->video_slots = NULL;
 
-   if (handle->attr_fifo)
-   {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
-   }
+   av_free(handle->video_buf);
+   handle->video_buf   = NULL;
 
-   if (handle->video_fifo)
-   {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
-   }
+   av_free(handle->audio_buf);
+   handle->audio_buf     = NULL;
+   handle->audio_silence = NULL;
 }
 
 static void ffmpeg_free(void *data)
@@ -999,6 +1147,11 @@ static void *ffmpeg_new(const struct record_params *params)
    handle->params       = *params;
    handle->pkt          = av_packet_alloc();
 
+   /* Streams would rather skip a frame than stall. */
+   handle->config.queue_frames = DEFAULT_QUEUE_FRAMES;
+   handle->config.queue_drop   =
+      params->preset >= RECORD_CONFIG_TYPE_STREAMING_CUSTOM;
+
    switch (params->preset)
    {
       case RECORD_CONFIG_TYPE_RECORDING_CUSTOM:
@@ -1045,14 +1198,34 @@ error:
    return NULL;
 }
 
+/* Finds a free slot for the core thread. When the queue
+ * is full, either waits for the encoder or gives up,
+ * depending on the queue policy. */
+static bool ffmpeg_queue_reserve(ffmpeg_t *handle,
+      struct ff_queue *queue, unsigned *index)
+{
+   if (ff_queue_write_index(queue, index))
+      return true;
+
+   if (handle->config.queue_drop)
+      return false;
+
+   slock_lock(handle->cond_lock);
+   while (handle->alive && !ff_queue_write_index(queue, index))
+      scond_wait(handle->cond, handle->cond_lock);
+   slock_unlock(handle->cond_lock);
+
+   return handle->alive;
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct record_video_data *vid)
 {
-   unsigned y;
-   struct record_video_data attr_data;
+   unsigned index, depth;
+   size_t size;
+   struct ff_video_slot *slot;
    bool drop_frame  = false;
    ffmpeg_t *handle = (ffmpeg_t*)data;
-   int       offset = 0;
 
    if (!handle || !vid)
       return false;
@@ -1065,53 +1238,65 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
+   size             = vid->is_dupe ? 0
+      : vid->width * vid->height * handle->video.pix_size;
 
-      slock_lock(handle->lock);
-      avail = FIFO_WRITE_AVAIL(handle->attr_fifo);
-      slock_unlock(handle->lock);
+   if (size > ffmpeg_video_slot_size(handle))
+      return false;
 
+   if (!ffmpeg_queue_reserve(handle, &handle->video_queue, &index))
+   {
       if (!handle->alive)
          return false;
 
-      if (avail >= sizeof(*vid))
-         break;
-
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
+      /* The encoder fell behind. Skip this frame's
+       * timestamp so audio and video stay in sync. */
+      handle->video_skipped++;
+      handle->video_frames_dropped++;
+      return true;
    }
 
-   slock_lock(handle->lock);
-
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *vid;
+   slot                = &handle->video_slots[index];
+   slot->attr          = *vid;
+   slot->attr.data     = NULL;
+   slot->time          = cpu_features_get_time_usec();
+   slot->skipped       = handle->video_skipped;
+   handle->video_skipped = 0;
 
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
+   if (slot->attr.is_dupe)
+      slot->attr.width = slot->attr.height = slot->attr.pitch = 0;
    else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+   {
+      /* Tightly pack our frame straight into the slot the
+       * encoder will read it from.
+       * libretro tends to use a very large pitch.
+       * This is the one copy a frame still takes: with GPU
+       * recording, vid->data points into a mapped readback
+       * buffer that is only valid until the next readback
+       * and can't be handed to the encoder thread. */
+      const uint8_t *src = (const uint8_t*)vid->data;
+      slot->attr.pitch   = vid->width * handle->video.pix_size;
+
+      if (vid->pitch == slot->attr.pitch)
+         memcpy(slot->data, src, size);
+      else
+      {
+         unsigned y;
+         uint8_t *dst    = slot->data;
+         for (y = 0; y < vid->height; y++,
+               src += vid->pitch, dst += slot->attr.pitch)
+            memcpy(dst, src, slot->attr.pitch);
+      }
+   }
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   ff_queue_push(&handle->video_queue);
+   handle->video_frames++;
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+   if ((depth = ff_queue_depth(&handle->video_queue))
+         > handle->video_queue_depth_max)
+      handle->video_queue_depth_max = depth;
 
-   slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+   ffmpeg_wake(handle);
 
    return true;
 }
@@ -1119,6 +1304,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct record_audio_data *audio_data)
 {
+   size_t written   = 0;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -1127,39 +1313,40 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
+   while (written < audio_data->frames)
    {
-      unsigned avail;
+      unsigned index;
+      size_t frames = audio_data->frames - written;
 
-      slock_lock(handle->lock);
-      avail = FIFO_WRITE_AVAIL(handle->audio_fifo);
-      slock_unlock(handle->lock);
+      if (frames > AUDIO_SLOT_FRAMES)
+         frames = AUDIO_SLOT_FRAMES;
 
-      if (!handle->alive)
-         return false;
+      if (!ffmpeg_queue_reserve(handle, &handle->audio_queue, &index))
+      {
+         if (!handle->alive)
+            return false;
 
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
+         /* The encoder fell behind. Fill the gap with
+          * silence so audio stays in sync with video. */
+         handle->audio_skipped        += audio_data->frames - written;
+         handle->audio_frames_dropped += audio_data->frames - written;
          break;
-
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
       }
-      else
-         scond_signal(handle->cond);
 
-      slock_unlock(handle->cond_lock);
+      memcpy(handle->audio_buf
+            + index * AUDIO_SLOT_FRAMES * handle->params.channels,
+            (const int16_t*)audio_data->data
+            + written * handle->params.channels,
+            frames * handle->params.channels * sizeof(int16_t));
+      handle->audio_slot_frames[index]  = frames;
+      handle->audio_slot_skipped[index] = handle->audio_skipped;
+      handle->audio_skipped             = 0;
+
+      ff_queue_push(&handle->audio_queue);
+      written += frames;
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
-   slock_unlock(handle->lock);
-   scond_signal(handle->cond);
+   ffmpeg_wake(handle);
 
    return true;
 }
@@ -1530,89 +1717,107 @@ static bool ffmpeg_push_audio_thread(ffmpeg_t *handle,
    return true;
 }
 
-static void ffmpeg_flush_audio(ffmpeg_t *handle, void *audio_buf,
-      size_t audio_buf_size)
+/* Encoder thread side of the queues. */
+static bool ffmpeg_pop_video(ffmpeg_t *handle)
 {
-   size_t avail = FIFO_READ_AVAIL(handle->audio_fifo);
+   unsigned index;
+   retro_time_t lag;
+   struct record_video_data attr;
+   struct ff_video_slot *slot = NULL;
 
-   if (avail)
+   if (!ff_queue_read_index(&handle->video_queue, &index))
+      return false;
+
+   slot                      = &handle->video_slots[index];
+   attr                      = slot->attr;
+   attr.data                 = slot->data;
+
+   /* Leave a gap for frames dropped while the queue was full. */
+   handle->video.frame_cnt  += slot->skipped;
+   ffmpeg_push_video_thread(handle, &attr);
+
+   lag                       = cpu_features_get_time_usec() - slot->time;
+   retro_atomic_store_release(&handle->encoder_lag, (long)lag);
+   if (lag > retro_atomic_load_acquire(&handle->encoder_lag_max))
+      retro_atomic_store_release(&handle->encoder_lag_max, (long)lag);
+
+   ff_queue_pop(&handle->video_queue);
+   ffmpeg_wake(handle);
+
+   return true;
+}
+
+static bool ffmpeg_pop_audio(ffmpeg_t *handle)
+{
+   unsigned index;
+   size_t skipped;
+   struct record_audio_data aud;
+
+   if (!ff_queue_read_index(&handle->audio_queue, &index))
+      return false;
+
+   /* Leave a gap for frames dropped while the queue was full. */
+   skipped    = handle->audio_slot_skipped[index];
+   while (skipped)
    {
-      struct record_audio_data aud = {0};
+      aud.frames = MIN(skipped, AUDIO_SLOT_FRAMES);
+      aud.data   = handle->audio_silence;
+      ffmpeg_push_audio_thread(handle, &aud, true);
+      skipped   -= aud.frames;
+   }
 
-      fifo_read(handle->audio_fifo, audio_buf, avail);
+   aud.frames = handle->audio_slot_frames[index];
+   aud.data   = handle->audio_buf
+      + index * AUDIO_SLOT_FRAMES * handle->params.channels;
 
-      aud.frames = avail / (sizeof(int16_t) * handle->params.channels);
-      aud.data = audio_buf;
+   ffmpeg_push_audio_thread(handle, &aud, true);
 
-      ffmpeg_push_audio_thread(handle, &aud, false);
+   ff_queue_pop(&handle->audio_queue);
+   ffmpeg_wake(handle);
+
+   return true;
+}
+
+static void ffmpeg_flush_audio(ffmpeg_t *handle)
+{
+   /* Encode the last, partial, codec frame. */
+   if (handle->audio.frames_in_buffer)
+   {
+      encode_audio(handle, false);
+      handle->audio.frame_cnt       += handle->audio.frames_in_buffer;
+      handle->audio.frames_in_buffer = 0;
    }
 
    encode_audio(handle, true);
-   }
+}
 
 static void ffmpeg_flush_video(ffmpeg_t *handle)
 {
    encode_video(handle, NULL);
-
 }
 
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
-   void *audio_buf       = NULL;
-   bool did_work         = false;
-   void *video_buf       = av_malloc(2 * handle->params.fb_width *
-         handle->params.fb_height * handle->video.pix_size);
-   size_t audio_buf_size = handle->config.audio_enable ?
-      (handle->audio.codec->frame_size *
-       handle->params.channels * sizeof(int16_t)) : 0;
-
-   if (audio_buf_size)
-      audio_buf = av_malloc(audio_buf_size);
+   bool did_work;
+
    /* Try pushing data in an interleaving pattern to
     * ease the work of the muxer a bit. */
-
    do
    {
-      struct record_video_data attr_buf;
-
       did_work = false;
 
-      if (handle->config.audio_enable)
-      {
-         if (FIFO_READ_AVAIL(handle->audio_fifo) >= audio_buf_size)
-         {
-            struct record_audio_data aud = {0};
-
-            fifo_read(handle->audio_fifo, audio_buf, audio_buf_size);
-            aud.frames = handle->audio.codec->frame_size;
-            aud.data   = audio_buf;
-            ffmpeg_push_audio_thread(handle, &aud, true);
-
-            did_work = true;
-         }
-      }
-
-      if (FIFO_READ_AVAIL(handle->attr_fifo) >= sizeof(attr_buf))
-      {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
-
+      if (ffmpeg_pop_audio(handle))
          did_work = true;
-      }
-   }while (did_work);
+      if (ffmpeg_pop_video(handle))
+         did_work = true;
+   } while (did_work);
 
    /* Flush out last audio. */
    if (handle->config.audio_enable)
-      ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
+      ffmpeg_flush_audio(handle);
 
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
-
-   av_free(video_buf);
-   av_free(audio_buf);
 }
 
 static bool ffmpeg_finalize(void *data)
@@ -1624,7 +1829,17 @@ static bool ffmpeg_finalize(void *data)
    deinit_thread(handle);
 
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
-   ffmpeg_flush_buffers(handle);
+   if (handle->video_slots)
+      ffmpeg_flush_buffers(handle);
+
+   RARCH_LOG("[FFmpeg]: Queued %u frames, dropped %u video frames and %u audio frames. "
+         "Peak queue depth %u of %u, peak encoder lag %.2f ms.\n",
+         (unsigned)handle->video_frames,
+         (unsigned)handle->video_frames_dropped,
+         (unsigned)handle->audio_frames_dropped,
+         handle->video_queue_depth_max,
+         handle->video_queue.size,
+         retro_atomic_load_acquire(&handle->encoder_lag_max) / 1000.0f);
 
    deinit_thread_buf(handle);
 
@@ -1636,79 +1851,49 @@ static bool ffmpeg_finalize(void *data)
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+static bool ffmpeg_get_stats(void *data, struct record_stats *stats)
 {
-   ffmpeg_t *ff          = (ffmpeg_t*)data;
-   /* For some reason, FFmpeg has a tendency to crash
-    * if we don't overallocate a bit. */
-   void *video_buf       = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-   size_t audio_buf_size = ff->config.audio_enable ?
-      (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
-   void *audio_buf       = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
-
-   while (ff->alive)
-   {
-      struct record_video_data attr_buf;
-
-      bool avail_video = false;
-      bool avail_audio = false;
+   ffmpeg_t *handle = (ffmpeg_t*)data;
 
-      slock_lock(ff->lock);
-      if (FIFO_READ_AVAIL(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+   if (!handle || !handle->thread)
+      return false;
 
-      if (ff->config.audio_enable)
-         if (FIFO_READ_AVAIL(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+   stats->video_frames         = handle->video_frames;
+   stats->video_frames_dropped = handle->video_frames_dropped;
+   stats->audio_frames_dropped = handle->audio_frames_dropped;
+   stats->encoder_lag          = retro_atomic_load_acquire(&handle->encoder_lag);
+   stats->encoder_lag_max      = retro_atomic_load_acquire(&handle->encoder_lag_max);
+   stats->video_queue_depth    = ff_queue_depth(&handle->video_queue);
+   stats->video_queue_size     = handle->video_queue.size;
+   stats->audio_queue_depth    = ff_queue_depth(&handle->audio_queue);
+   stats->audio_queue_size     = handle->audio_queue.size;
 
-      if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
-
-         slock_unlock(ff->cond_lock);
-      }
+   return true;
+}
 
-      if (avail_video && video_buf)
-      {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
-      }
+static void ffmpeg_thread(void *data)
+{
+   ffmpeg_t *ff = (ffmpeg_t*)data;
 
-      if (avail_audio && audio_buf)
-      {
-         struct record_audio_data aud = {0};
+   while (ff->alive)
+   {
+      bool did_work = false;
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
+      if (ffmpeg_pop_audio(ff))
+         did_work = true;
+      if (ffmpeg_pop_video(ff))
+         did_work = true;
 
-         aud.frames = ff->audio.codec->frame_size;
-         aud.data   = audio_buf;
+      if (did_work)
+         continue;
 
-         ffmpeg_push_audio_thread(ff, &aud, true);
-      }
+      slock_lock(ff->cond_lock);
+      while (     ff->alive
+            && !ff_queue_depth(&ff->video_queue)
+            && !ff_queue_depth(&ff->audio_queue))
+         scond_wait(ff->cond, ff->cond_lock);
+      slock_unlock(ff->cond_lock);
    }
-
-   av_free(video_buf);
-   av_free(audio_buf);
 }
 
 const record_driver_t record_ffmpeg = {
@@ -1718,4 +1903,5 @@ const record_driver_t record_ffmpeg = {
    ffmpeg_push_audio,
    ffmpeg_finalize,
    "ffmpeg",
+   ffmpeg_get_stats
 };
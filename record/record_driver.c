@@ -41,6 +41,7 @@ static const record_driver_t record_null = {
    NULL, /* push_audio */
    NULL, /* finalize */
    "null",
+   NULL  /* get_stats */
 };
 
 const record_driver_t *record_drivers[] = {
@@ -56,6 +57,18 @@ recording_state_t *recording_state_get_ptr(void)
    return &recording_state;
 }
 
+bool recording_get_stats(struct record_stats *stats)
+{
+   recording_state_t *recording_st = &recording_state;
+
+   if (     !recording_st->data
+         || !recording_st->driver
+         || !recording_st->driver->get_stats)
+      return false;
+
+   return recording_st->driver->get_stats(recording_st->data, stats);
+}
+
 /**
  * config_get_record_driver_options:
  *
@@ -394,9 +407,23 @@ bool recording_init(void)
       RARCH_LOG("[Recording]: %s %ux%u.\n", msg_hash_to_str(MSG_DETECTED_VIEWPORT_OF),
             vp.width, vp.height);
 
-      gpu_size = vp.width * vp.height * 3;
-      if (!(video_st->record_gpu_buffer = (uint8_t*)malloc(gpu_size)))
-         return false;
+      /* The driver can hand us frames straight out of its readback
+       * ring, the recorder then does the pixel conversion on its
+       * own thread. */
+      if (     video_st->poke
+            && video_st->poke->read_viewport_ring
+            && video_st->poke->read_viewport_ring(video_st->data, NULL))
+      {
+         params.pix_fmt                   = FFEMU_PIX_ARGB8888;
+         recording_st->gpu_readback_ring  = true;
+         RARCH_LOG("[Recording]: Using asynchronous readback ring.\n");
+      }
+      else
+      {
+         gpu_size = vp.width * vp.height * 3;
+         if (!(video_st->record_gpu_buffer = (uint8_t*)malloc(gpu_size)))
+            return false;
+      }
    }
    else
    {
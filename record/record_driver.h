@@ -1,7 +1,11 @@
 #ifndef _RECORD_DRIVER_H
 #define _RECORD_DRIVER_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 #include <boolean.h>
+#include <libretro.h>
 
 enum ffemu_pix_format
 {
@@ -97,6 +101,19 @@ struct record_audio_data
    size_t frames;
 };
 
+struct record_stats
+{
+   uint64_t video_frames;         /* Video frames handed to the encoder. */
+   uint64_t video_frames_dropped; /* Dropped because the queue was full. */
+   uint64_t audio_frames_dropped;
+   retro_time_t encoder_lag;      /* Queue to encode time of the last frame, usec. */
+   retro_time_t encoder_lag_max;
+   unsigned video_queue_depth;    /* Frames waiting for the encoder. */
+   unsigned video_queue_size;
+   unsigned audio_queue_depth;
+   unsigned audio_queue_size;
+};
+
 typedef struct record_driver
 {
    void *(*init)(const struct record_params *params);
@@ -107,6 +124,8 @@ typedef struct record_driver
          const struct record_audio_data *audio_data);
    bool  (*finalize)(void *data);
    const char *ident;
+   /* Optional. Fills in queue and encoder statistics. */
+   bool  (*get_stats)(void *data, struct record_stats *stats);
 } record_driver_t;
 
 
@@ -129,6 +148,9 @@ struct recording
    bool enable;
    bool streaming_enable;
    bool use_output_dir;
+   /* GPU recording pulls frames from the video driver's
+    * readback ring instead of record_gpu_buffer. */
+   bool gpu_readback_ring;
 };
 
 typedef struct recording recording_state_t;
@@ -161,6 +183,16 @@ void streaming_set_state(bool state);
 
 recording_state_t *recording_state_get_ptr(void);
 
+/**
+ * recording_get_stats:
+ *
+ * Gets queue and encoder statistics of the active recording.
+ *
+ * Returns: true (1) if recording and the driver provides them,
+ * otherwise false (0).
+ **/
+bool recording_get_stats(struct record_stats *stats);
+
 extern const record_driver_t *record_drivers[];
 
 #endif
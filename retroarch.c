@@ -200,7 +200,11 @@
 #include "cheat_manager.h"
 #endif
 #include "tasks/task_content.h"
+#include "tasks/task_image_cache.h"
 #include "tasks/tasks_internal.h"
+#ifdef HAVE_SLANG
+#include "gfx/drivers_shader/slang_cache.h"
+#endif
 
 #include "version.h"
 #include "version_git.h"
@@ -3801,7 +3805,10 @@ bool command_event(enum event_command cmd, void *data)
 #ifdef HAVE_REWIND
          {
             bool rewind_enable        = settings->bools.rewind_enable;
+            bool rewind_threaded      = settings->bools.rewind_threaded;
             size_t rewind_buf_size    = settings->sizes.rewind_buffer_size;
+            size_t rewind_cold_size   = settings->sizes.rewind_cold_buffer_size;
+            size_t rewind_spill_size  = settings->sizes.rewind_spill_size;
             bool core_type_is_dummy   = runloop_st->current_core_type == CORE_TYPE_DUMMY;
 
             if (core_type_is_dummy)
@@ -3824,7 +3831,9 @@ bool command_event(enum event_command cmd, void *data)
 #endif
                {
                   state_manager_event_init(&runloop_st->rewind_st,
-                        (unsigned)rewind_buf_size);
+                        (unsigned)rewind_buf_size, rewind_threaded,
+                        rewind_cold_size, rewind_spill_size,
+                        settings->paths.directory_cache);
                }
             }
          }
@@ -5694,12 +5703,16 @@ void main_exit(void *args)
 
    runloop_msg_queue_deinit();
    driver_uninit(DRIVERS_CMD_ALL, 0);
+#ifdef HAVE_SLANG
+   slang_cache_deinit();
+#endif
 
    retro_main_log_file_deinit();
 
    retroarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
    global_free(p_rarch);
    task_queue_deinit();
+   image_cache_deinit();
 
    ui_companion_driver_deinit();
    retroarch_config_deinit();
@@ -7189,11 +7202,14 @@ static bool retroarch_parse_input_and_config(
                      cb_task_dbscan = handle_dbscan_finished;
 #endif
 
+                  /* Batch scans get run again after being
+                   * interrupted, pick up where they stopped */
                   task_push_dbscan(
                         directory_playlist,
                         path_content_db,
                         optarg, path_is_directory(optarg),
                         show_hidden_files,
+                        true,
                         cb_task_dbscan);
 
                   if (!explicit_menu)
@@ -7696,6 +7712,8 @@ void retroarch_init_task_queue(void)
 #ifdef HAVE_THREADS
    settings_t *settings        = config_get_ptr();
    bool threaded_enable        = settings->bools.threaded_data_runloop_enable;
+
+   task_queue_set_worker_count(settings->uints.threaded_data_runloop_workers);
 #else
    bool threaded_enable        = false;
 #endif
@@ -23,6 +23,8 @@
 #endif
 
 #include <encodings/utf.h>
+#include <memalign.h>
+#include <retro_miscellaneous.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
 #include <time/rtime.h>
@@ -34,6 +36,7 @@
 #include "audio/audio_driver.h"
 #include "gfx/video_driver.h"
 #include "paths.h"
+#include "performance_counters.h"
 #include "runloop.h"
 #include "verbosity.h"
 
@@ -902,48 +905,69 @@ static void runahead_remove_input_state_hook(runloop_state_t *runloop_st)
    }
 }
 
-static void *runahead_save_state_alloc(void)
-{
-   runloop_state_t     *runloop_st       = runloop_state_get_ptr();
-   retro_ctx_serialize_info_t *savestate = (retro_ctx_serialize_info_t*)
-      malloc(sizeof(retro_ctx_serialize_info_t));
+/* Snapshot pool */
+
+#define RUNAHEAD_PAGE_SIZE 4096
+#define RUNAHEAD_PAGE_ALIGN(x) \
+   (((x) + RUNAHEAD_PAGE_SIZE - 1) & ~(size_t)(RUNAHEAD_PAGE_SIZE - 1))
 
-   if (!savestate)
+static struct retro_perf_counter runahead_serialize_perf   = {0};
+static struct retro_perf_counter runahead_unserialize_perf = {0};
+static struct retro_perf_counter runahead_replay_perf      = {0};
+
+static void *runahead_snapshot_alloc(size_t size)
+{
+   if (!size)
       return NULL;
+   return memalign_alloc(RUNAHEAD_PAGE_SIZE, RUNAHEAD_PAGE_ALIGN(size));
+}
 
-   savestate->data          = NULL;
-   savestate->data_const    = NULL;
-   savestate->size          = 0;
+static void runahead_pool_destroy(runahead_pool_t **pool_p)
+{
+   unsigned i;
+   runahead_pool_t *pool = *pool_p;
 
-   if (     (runloop_st->runahead_save_state_size > 0)
-         && (runloop_st->flags & RUNLOOP_FLAG_RUNAHEAD_SAVE_STATE_SIZE_KNOWN))
-   {
-      savestate->data       = malloc(runloop_st->runahead_save_state_size);
-      savestate->data_const = savestate->data;
-      savestate->size       = runloop_st->runahead_save_state_size;
-   }
+   if (!pool)
+      return;
 
-   return savestate;
+   for (i = 0; i < RUNAHEAD_POOL_SIZE; i++)
+      memalign_free(pool->buffer[i]);
+   free(pool);
+   *pool_p = NULL;
 }
 
-static void runahead_save_state_free(void *data)
+static runahead_pool_t *runahead_pool_new(size_t state_size)
 {
-   retro_ctx_serialize_info_t *savestate = (retro_ctx_serialize_info_t*)data;
-   if (!savestate)
-      return;
-   free(savestate->data);
-   free(savestate);
+   unsigned i;
+   runahead_pool_t *pool = (runahead_pool_t*)calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->state_size = state_size;
+
+   for (i = 0; i < RUNAHEAD_POOL_SIZE; i++)
+   {
+      if (!(pool->buffer[i] = runahead_snapshot_alloc(state_size)))
+      {
+         runahead_pool_destroy(&pool);
+         return NULL;
+      }
+   }
+
+   return pool;
 }
 
-static void runahead_save_state_list_init(
+static void runahead_pool_init(
       runloop_state_t *runloop_st,
       size_t save_state_size)
 {
    runloop_st->runahead_save_state_size  = save_state_size;
    runloop_st->flags                    |= RUNLOOP_FLAG_RUNAHEAD_SAVE_STATE_SIZE_KNOWN;
 
-   mylist_create(&runloop_st->runahead_save_state_list, 16,
-         runahead_save_state_alloc, runahead_save_state_free);
+   runahead_pool_destroy(&runloop_st->runahead_pool);
+   if (!(runloop_st->runahead_pool = runahead_pool_new(save_state_size)))
+      runloop_st->runahead_save_state_size = 0;
 }
 
 /* Hooks - Hooks to cleanup, and add dirty input hooks */
@@ -967,7 +991,7 @@ static void runahead_remove_hooks(runloop_state_t *runloop_st)
 
 static void runahead_destroy(runloop_state_t *runloop_st)
 {
-   mylist_destroy(&runloop_st->runahead_save_state_list);
+   runahead_pool_destroy(&runloop_st->runahead_pool);
    runahead_remove_hooks(runloop_st);
    runahead_clear_variables(runloop_st);
 }
@@ -1017,7 +1041,7 @@ static void runahead_add_hooks(runloop_state_t *runloop_st)
 static void runahead_error(runloop_state_t *runloop_st)
 {
    runloop_st->flags &= ~RUNLOOP_FLAG_RUNAHEAD_AVAILABLE;
-   mylist_destroy(&runloop_st->runahead_save_state_list);
+   runahead_pool_destroy(&runloop_st->runahead_pool);
    runahead_remove_hooks(runloop_st);
    runloop_st->runahead_save_state_size       = 0;
    runloop_st->flags                         |= RUNLOOP_FLAG_RUNAHEAD_SAVE_STATE_SIZE_KNOWN;
@@ -1029,7 +1053,7 @@ static bool runahead_create(runloop_state_t *runloop_st)
    video_driver_state_t *video_st = video_state_get_ptr();
    size_t info_size               = core_serialize_size_special();
 
-   runahead_save_state_list_init(runloop_st, info_size);
+   runahead_pool_init(runloop_st, info_size);
    if (video_st->flags & VIDEO_FLAG_ACTIVE)
       video_st->flags |=  VIDEO_FLAG_RUNAHEAD_IS_ACTIVE;
    else
@@ -1044,22 +1068,30 @@ static bool runahead_create(runloop_state_t *runloop_st)
 
    runahead_add_hooks(runloop_st);
    runloop_st->flags |= RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY;
-   if (runloop_st->runahead_save_state_list)
-      mylist_resize(runloop_st->runahead_save_state_list, 1, true);
    return true;
 }
 
 static bool runahead_save_state(runloop_state_t *runloop_st)
 {
-   retro_ctx_serialize_info_t *serialize_info;
+   bool ret;
+   retro_ctx_serialize_info_t serialize_info;
+   runahead_pool_t *pool       = runloop_st->runahead_pool;
+   bool perfcnt_enable         = runloop_st->perfcnt_enable;
 
-   if (!runloop_st->runahead_save_state_list)
+   if (!pool)
       return false;
 
-   serialize_info                  =
-      (retro_ctx_serialize_info_t*)runloop_st->runahead_save_state_list->data[0];
+   serialize_info.data         = pool->buffer[0];
+   serialize_info.data_const   = pool->buffer[0];
+   serialize_info.size         = pool->state_size;
+
+   performance_counter_init(runahead_serialize_perf, "runahead_serialize");
+   performance_counter_start_plus(perfcnt_enable, runahead_serialize_perf);
+   ret = core_serialize_special(&serialize_info);
+
+   performance_counter_stop_plus(perfcnt_enable, runahead_serialize_perf);
 
-   if (core_serialize_special(serialize_info))
+   if (ret)
       return true;
 
    runahead_error(runloop_st);
@@ -1068,11 +1100,21 @@ static bool runahead_save_state(runloop_state_t *runloop_st)
 
 static bool runahead_load_state(runloop_state_t *runloop_st)
 {
-   retro_ctx_serialize_info_t *serialize_info =
-      (retro_ctx_serialize_info_t*)
-      runloop_st->runahead_save_state_list->data[0];
+   retro_ctx_serialize_info_t serialize_info;
+   bool ret                                   = false;
+   runahead_pool_t *pool                      = runloop_st->runahead_pool;
+   bool perfcnt_enable                        = runloop_st->perfcnt_enable;
    bool last_dirty                            = (runloop_st->flags & RUNLOOP_FLAG_INPUT_IS_DIRTY) ? true : false;
-   bool ret                                   = core_unserialize_special(serialize_info);
+
+   serialize_info.data                        = pool->buffer[0];
+   serialize_info.data_const                  = pool->buffer[0];
+   serialize_info.size                        = pool->state_size;
+
+   performance_counter_init(runahead_unserialize_perf, "runahead_unserialize");
+   performance_counter_start_plus(perfcnt_enable, runahead_unserialize_perf);
+   ret = core_unserialize_special(&serialize_info);
+   performance_counter_stop_plus(perfcnt_enable, runahead_unserialize_perf);
+
    if (last_dirty)
       runloop_st->flags                      |=  RUNLOOP_FLAG_INPUT_IS_DIRTY;
    else
@@ -1087,12 +1129,17 @@ static bool runahead_load_state(runloop_state_t *runloop_st)
 #if HAVE_DYNAMIC
 static bool runahead_load_state_secondary(runloop_state_t *runloop_st, settings_t *settings)
 {
-   retro_ctx_serialize_info_t *serialize_info =
-      (retro_ctx_serialize_info_t*)runloop_st->runahead_save_state_list->data[0];
+   bool ret;
+   runahead_pool_t *pool = runloop_st->runahead_pool;
+   bool perfcnt_enable   = runloop_st->perfcnt_enable;
+
+   performance_counter_init(runahead_unserialize_perf, "runahead_unserialize");
+   performance_counter_start_plus(perfcnt_enable, runahead_unserialize_perf);
+   ret = secondary_core_deserialize(runloop_st,
+            settings, pool->buffer[0], pool->state_size);
+   performance_counter_stop_plus(perfcnt_enable, runahead_unserialize_perf);
 
-   if (!secondary_core_deserialize(runloop_st,
-            settings, serialize_info->data_const,
-            serialize_info->size))
+   if (!ret)
    {
       runloop_st->flags &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
       runahead_error(runloop_st);
@@ -1132,6 +1179,7 @@ void runahead_run(void *data,
 {
    runloop_state_t *runloop_st = (runloop_state_t*)data;
    int frame_number        = 0;
+   bool perfcnt_enable     = runloop_st->perfcnt_enable;
    bool last_frame         = false;
    bool suspended_frame    = false;
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
@@ -1210,7 +1258,12 @@ void runahead_run(void *data,
          if (frame_number == 0)
             core_run();
          else
+         {
+            performance_counter_init(runahead_replay_perf, "runahead_replay");
+            performance_counter_start_plus(perfcnt_enable, runahead_replay_perf);
             runahead_core_run_use_last_input(runloop_st);
+            performance_counter_stop_plus(perfcnt_enable, runahead_replay_perf);
+         }
 
          if (suspended_frame)
          {
@@ -1297,10 +1350,13 @@ void runahead_run(void *data,
             video_st->flags             &= ~VIDEO_FLAG_ACTIVE;
             audio_st->flags             |= AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE;
+            performance_counter_init(runahead_replay_perf, "runahead_replay");
+            performance_counter_start_plus(perfcnt_enable, runahead_replay_perf);
             if (secondary_core_run_use_last_input(runloop_st))
                runloop_st->flags        |=  RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
             else
                runloop_st->flags        &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
+            performance_counter_stop_plus(perfcnt_enable, runahead_replay_perf);
             audio_st->flags             &= ~(AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE);
             if (video_st->flags & VIDEO_FLAG_RUNAHEAD_IS_ACTIVE)
@@ -1311,10 +1367,13 @@ void runahead_run(void *data,
       }
       audio_st->flags                   |= AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE;
+      performance_counter_init(runahead_replay_perf, "runahead_replay");
+      performance_counter_start_plus(perfcnt_enable, runahead_replay_perf);
       if (secondary_core_run_use_last_input(runloop_st))
          runloop_st->flags              |=  RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
       else
          runloop_st->flags              &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
+      performance_counter_stop_plus(perfcnt_enable, runahead_replay_perf);
       audio_st->flags                   &= ~(AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE);
 #endif
@@ -1379,7 +1438,7 @@ static const char* preempt_allocate(runloop_state_t *runloop_st,
 
    for (i = 0; i < frames; i++)
    {
-      preempt->buffer[i] = malloc(preempt->state_size);
+      preempt->buffer[i] = runahead_snapshot_alloc(preempt->state_size);
       if (!preempt->buffer[i])
          return msg_hash_to_str(MSG_PREEMPT_FAILED_TO_ALLOCATE);
    }
@@ -1404,7 +1463,7 @@ void preempt_deinit(void *data)
 
    /* Free memory */
    for (i = 0; i < preempt->frames; i++)
-      free(preempt->buffer[i]);
+      memalign_free(preempt->buffer[i]);
 
    free(preempt);
    runloop_st->preempt_data = NULL;
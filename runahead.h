@@ -64,6 +64,17 @@ typedef struct preemptive_frames_data
    uint8_t frames;
 } preempt_t;
 
+/* Savestate buffers kept by run-ahead */
+#define RUNAHEAD_POOL_SIZE 1
+
+typedef struct runahead_pool
+{
+   /* Page aligned savestate buffers, allocated once per core:
+    * [0] is the snapshot run-ahead returns to */
+   void *buffer[RUNAHEAD_POOL_SIZE];
+   size_t state_size;
+} runahead_pool_t;
+
 RETRO_BEGIN_DECLS
 
 typedef bool(*runahead_load_state_function)(const void*, size_t);
@@ -182,7 +182,7 @@ struct runloop
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
    char    *secondary_library_path;
 #endif
-   my_list *runahead_save_state_list;
+   runahead_pool_t *runahead_pool;
    my_list *input_state_list;
    preempt_t *preempt_data;
 #endif
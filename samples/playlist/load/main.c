@@ -0,0 +1,309 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Playlist load benchmark.
+ *
+ * Writes a playlist of synthetic entries, then reports how long
+ * opening it takes when the JSON has to be parsed and when it
+ * comes from the binary cache, up to the point where a menu
+ * could show its first screen of entries. Then checks that both
+ * give the same entries, that the cache follows changes to the
+ * playlist, and that it is ignored once the playlist file
+ * changes behind its back.
+ *
+ * Usage: playlist_load_bench [entries] [directory]
+ *
+ * 'entries' defaults to 100000 (and can't be less than the
+ * size from which playlists get a cache), 'directory' (where
+ * the playlist and its cache are written, then removed) to /tmp.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+/* The playlist is used through its internal API */
+#include "../../../playlist.c"
+
+/* Frontend symbols used by the playlist */
+
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_WARN(const char *fmt, ...) { }
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+bool core_info_find(const char *core_path, core_info_t **core_info) { return false; }
+bool core_info_core_file_id_is_equal(const char *core_path_a,
+      const char *core_path_b) { return false; }
+
+/* Entries a menu shows on its first screen */
+#define BENCH_SCREEN_ENTRIES 32
+
+static uint64_t bench_time_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_config(playlist_config_t *config, const char *path,
+      size_t capacity)
+{
+   memset(config, 0, sizeof(*config));
+   config->capacity = capacity;
+   playlist_config_set_path(config, path);
+}
+
+static bool bench_fill(const char *path, unsigned count)
+{
+   unsigned i;
+   char entry_path[PATH_MAX_LENGTH];
+   char label[PATH_MAX_LENGTH];
+   char crc[32];
+   playlist_config_t config;
+   struct string_list *roms         = string_list_new();
+   union string_list_elem_attr attr = {0};
+   playlist_t *playlist             = NULL;
+
+   bench_config(&config, path, COLLECTION_SIZE);
+
+   if (!roms || !(playlist = playlist_init(&config)))
+      return false;
+
+   string_list_append(roms, "/roms/Sufami Turbo/Base.st", attr);
+   string_list_append(roms, "/roms/Sufami Turbo/Slot.st", attr);
+
+   for (i = 0; i < count; i++)
+   {
+      struct playlist_entry entry = {0};
+
+      snprintf(entry_path, sizeof(entry_path),
+            "/roms/Nintendo - SNES/Game %06u (USA).sfc", i);
+      snprintf(label, sizeof(label), "Game %06u (USA)", i);
+      snprintf(crc, sizeof(crc), "%08X|crc", 0x9e3779b9 * (i + 1));
+
+      entry.path       = entry_path;
+      entry.label      = label;
+      entry.core_path  = (char*)"/cores/snes9x_libretro.so";
+      entry.core_name  = (char*)"Nintendo - SNES / SFC (Snes9x - Current)";
+      entry.crc32      = crc;
+      entry.db_name    = (char*)"Nintendo - Super Nintendo Entertainment System.lpl";
+      entry.entry_slot = i % 5;
+
+      if (i % 100 == 0)
+      {
+         entry.subsystem_ident = (char*)"sufami";
+         entry.subsystem_name  = (char*)"Sufami Turbo";
+         entry.subsystem_roms  = roms;
+      }
+
+      playlist_push(playlist, &entry);
+   }
+
+   playlist_set_default_core_path(playlist, "/cores/snes9x_libretro.so");
+   playlist_set_default_core_name(playlist, "Snes9x - Current");
+   playlist_set_scan_content_dir(playlist, "/roms/Nintendo - SNES");
+   playlist_write_file(playlist);
+   playlist_free(playlist);
+   string_list_free(roms);
+   return true;
+}
+
+/* Opens the playlist and reads its first screen of entries */
+static playlist_t *bench_open(const char *path, uint64_t *elapsed)
+{
+   size_t i;
+   playlist_config_t config;
+   playlist_t *playlist;
+   uint64_t t0 = bench_time_usec();
+
+   bench_config(&config, path, COLLECTION_SIZE);
+
+   if ((playlist = playlist_init(&config)))
+   {
+      for (i = 0; i < BENCH_SCREEN_ENTRIES; i++)
+      {
+         const struct playlist_entry *entry = NULL;
+         playlist_get_index(playlist, i, &entry);
+      }
+   }
+
+   *elapsed = bench_time_usec() - t0;
+   return playlist;
+}
+
+static bool bench_same_string(const char *a, const char *b)
+{
+   return string_is_equal(a ? a : "", b ? b : "");
+}
+
+static bool bench_same_entries(playlist_t *a, playlist_t *b)
+{
+   size_t i, j;
+
+   if (playlist_size(a) != playlist_size(b))
+      return false;
+
+   if (     !bench_same_string(playlist_get_default_core_path(a),
+               playlist_get_default_core_path(b))
+         || !bench_same_string(playlist_get_scan_content_dir(a),
+               playlist_get_scan_content_dir(b)))
+      return false;
+
+   for (i = 0; i < playlist_size(a); i++)
+   {
+      const struct playlist_entry *ea = NULL;
+      const struct playlist_entry *eb = NULL;
+      size_t roms_a, roms_b;
+
+      playlist_get_index(a, i, &ea);
+      playlist_get_index(b, i, &eb);
+
+      roms_a = ea->subsystem_roms ? ea->subsystem_roms->size : 0;
+      roms_b = eb->subsystem_roms ? eb->subsystem_roms->size : 0;
+
+      if (     !bench_same_string(ea->path,            eb->path)
+            || !bench_same_string(ea->label,           eb->label)
+            || !bench_same_string(ea->core_path,       eb->core_path)
+            || !bench_same_string(ea->core_name,       eb->core_name)
+            || !bench_same_string(ea->crc32,           eb->crc32)
+            || !bench_same_string(ea->db_name,         eb->db_name)
+            || !bench_same_string(ea->subsystem_ident, eb->subsystem_ident)
+            || !bench_same_string(ea->subsystem_name,  eb->subsystem_name)
+            || (ea->entry_slot != eb->entry_slot)
+            || (roms_a != roms_b))
+         return false;
+
+      for (j = 0; j < roms_a; j++)
+         if (!string_is_equal(ea->subsystem_roms->elems[j].data,
+               eb->subsystem_roms->elems[j].data))
+            return false;
+   }
+
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   char path[PATH_MAX_LENGTH];
+   char cache_path[PATH_MAX_LENGTH];
+   uint64_t parse_time, cache_time;
+   playlist_t *parsed  = NULL;
+   playlist_t *cached  = NULL;
+   bool ok             = true;
+   unsigned count      = (argc > 1) ? (unsigned)atoi(argv[1]) : 100000;
+   const char *dir     = (argc > 2) ? argv[2] : "/tmp";
+
+   /* Smaller playlists don't get a cache */
+   if (count < PLAYLIST_CACHE_MIN_ENTRIES)
+      count = PLAYLIST_CACHE_MIN_ENTRIES;
+
+   snprintf(path, sizeof(path), "%s/playlist_load_bench.lpl", dir);
+   strlcpy(cache_path, path, sizeof(cache_path));
+   strlcat(cache_path, PLAYLIST_CACHE_FILE_EXTENSION, sizeof(cache_path));
+   filestream_delete(path);
+   filestream_delete(cache_path);
+
+   if (!bench_fill(path, count))
+      return 1;
+
+   /* Without the cache: parse, which writes the cache again */
+   filestream_delete(cache_path);
+   if (!(parsed = bench_open(path, &parse_time)))
+      return 1;
+   ok = (parsed->cache_data == NULL) && path_is_valid(cache_path);
+
+   /* With the cache */
+   if (!(cached = bench_open(path, &cache_time)))
+      return 1;
+   ok = ok && (cached->cache_data != NULL);
+
+   printf("[playlist_load_bench] %u entries: parse %8.2f ms, "
+         "cache %8.2f ms (%.1fx)\n",
+         count, parse_time / 1000.0, cache_time / 1000.0,
+         cache_time ? (double)parse_time / cache_time : 0.0);
+
+   /* Both give the same playlist */
+   ok = ok && bench_same_entries(parsed, cached);
+
+   /* Changes made to a cached playlist go to the playlist
+    * file and to the cache */
+   if (ok)
+   {
+      struct playlist_entry entry = {0};
+      const struct playlist_entry *found = NULL;
+
+      entry.path      = (char*)"/roms/Nintendo - SNES/New Game (USA).sfc";
+      entry.label     = (char*)"New Game (USA)";
+      entry.core_path = (char*)"/cores/snes9x_libretro.so";
+      entry.core_name = (char*)"Snes9x - Current";
+
+      ok = playlist_push(cached, &entry);
+      playlist_delete_index(cached, playlist_size(cached) / 2);
+      playlist_write_file(cached);
+      playlist_free(cached);
+
+      if (!(cached = bench_open(path, &cache_time)))
+         return 1;
+
+      playlist_get_index(cached, 0, &found);
+      ok = ok
+         && (cached->cache_data != NULL)
+         && (playlist_size(cached) == count)
+         && found && string_is_equal(found->label, "New Game (USA)");
+
+      /* Same result as parsing */
+      playlist_free(parsed);
+      filestream_delete(cache_path);
+      parsed = bench_open(path, &parse_time);
+      ok     = ok && parsed && bench_same_entries(parsed, cached);
+   }
+
+   /* A playlist file changed behind the cache's back is parsed */
+   if (ok)
+   {
+      RFILE *file = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ_WRITE
+            | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (file)
+      {
+         filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END);
+         filestream_write(file, "\n", 1);
+         filestream_close(file);
+      }
+
+      playlist_free(cached);
+      cached = bench_open(path, &cache_time);
+      ok     = cached && (cached->cache_data == NULL);
+   }
+
+   printf("[playlist_load_bench] %u entries: checks: %s\n",
+         count, ok ? "ok" : "FAILED");
+
+   playlist_free(parsed);
+   playlist_free(cached);
+   filestream_delete(path);
+   filestream_delete(cache_path);
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless playlist push benchmark.
+ *
+ * Fills a playlist with synthetic entries the way the content
+ * scanners do (playlist_entry_exists() then playlist_push() for
+ * each new file), for a few playlist sizes, and reports the time
+ * per push over the whole run and over its last 10%, which shows
+ * how the cost grows with the size of the playlist. Then checks
+ * lookups by path and CRC, pushing duplicates, deleting and
+ * sorting.
+ *
+ * Usage: playlist_push_bench [max_entries]
+ *
+ * Sizes run from 1000 up to 'max_entries' (default 100000), ten
+ * times larger each time. One entry in eight is a file inside a
+ * zip archive. Nothing is written to disk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+/* The playlist is used through its internal API */
+#include "../../../playlist.c"
+
+/* Frontend symbols used by the playlist */
+
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_WARN(const char *fmt, ...) { }
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+bool core_info_find(const char *core_path, core_info_t **core_info) { return false; }
+bool core_info_core_file_id_is_equal(const char *core_path_a,
+      const char *core_path_b) { return false; }
+
+static uint64_t bench_time_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_path(char *s, size_t len, unsigned n)
+{
+   if (n % 8 == 7)
+      snprintf(s, len, "/roms/Sony - PlayStation/Disc %06u.zip#Game %06u.bin",
+            n, n);
+   else
+      snprintf(s, len, "/roms/Nintendo - SNES/Game %06u (USA).sfc", n);
+}
+
+static uint32_t bench_crc(unsigned n)
+{
+   return 0x9e3779b9 * (n + 1);
+}
+
+static void bench_entry(struct playlist_entry *entry, unsigned n,
+      char *path, char *label, char *crc, size_t len)
+{
+   bench_path(path, len, n);
+   snprintf(label, len, "Game %06u (USA)", n);
+   snprintf(crc, len, "%08lX|crc", (unsigned long)bench_crc(n));
+
+   memset(entry, 0, sizeof(*entry));
+   entry->path      = path;
+   entry->label     = label;
+   entry->core_path = (char*)FILE_PATH_DETECT;
+   entry->core_name = (char*)FILE_PATH_DETECT;
+   entry->crc32     = crc;
+   entry->db_name   = (char*)"Nintendo - Super Nintendo Entertainment System.lpl";
+}
+
+static bool bench_run(unsigned count)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   char label[PATH_MAX_LENGTH];
+   char crc[PATH_MAX_LENGTH];
+   playlist_config_t config;
+   struct playlist_entry entry;
+   const struct playlist_entry *found = NULL;
+   playlist_t *playlist               = NULL;
+   uint64_t total                     = 0;
+   uint64_t tail                      = 0;
+   uint64_t t0;
+   bool ok                            = true;
+
+   memset(&config, 0, sizeof(config));
+   config.capacity            = count;
+   config.fuzzy_archive_match = true;
+   playlist_config_set_path(&config, "/nonexistent/playlist_push_bench.lpl");
+
+   if (!(playlist = playlist_init(&config)))
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      uint64_t elapsed;
+
+      bench_entry(&entry, i, path, label, crc, sizeof(path));
+
+      t0      = bench_time_usec();
+      if (!playlist_entry_exists(playlist, path))
+         ok   = playlist_push(playlist, &entry) && ok;
+      elapsed = bench_time_usec() - t0;
+
+      total  += elapsed;
+      if (i >= count - count / 10)
+         tail += elapsed;
+   }
+
+   printf("[playlist_push_bench] %6u entries: %8.2f usec/push, "
+         "last 10%%: %8.2f usec/push\n",
+         count, (double)total / count,
+         (double)tail / (count / 10 ? count / 10 : 1));
+
+   if (playlist_size(playlist) != count)
+      ok = false;
+
+   /* Every entry is found by path and CRC, at the index
+    * a linear search would give */
+   t0 = bench_time_usec();
+   for (i = 0; i < count && ok; i++)
+   {
+      bench_path(path, sizeof(path), i);
+      found = NULL;
+      playlist_get_index_by_path(playlist, path, &found);
+      if (!found || found != &playlist->entries[count - 1 - i])
+         ok = false;
+
+      found = NULL;
+      playlist_get_index_by_crc32(playlist, bench_crc(i), &found);
+      if (!found || found != &playlist->entries[count - 1 - i])
+         ok = false;
+   }
+   total = bench_time_usec() - t0;
+
+   /* Fuzzy archive match: the bare archive finds the file inside */
+   if (ok && count > 7)
+   {
+      found = NULL;
+      playlist_get_index_by_path(playlist,
+            "/roms/Sony - PlayStation/Disc 000007.zip", &found);
+      ok    = found == &playlist->entries[count - 1 - 7];
+   }
+
+   /* Pushing an existing entry moves it to the top */
+   if (ok)
+   {
+      bench_entry(&entry, 0, path, label, crc, sizeof(path));
+      ok    = playlist_push(playlist, &entry)
+         && playlist_size(playlist) == count;
+      found = NULL;
+      playlist_get_index_by_path(playlist, path, &found);
+      ok    = ok && found == &playlist->entries[0];
+   }
+
+   /* Deleted entries are gone, the others stay */
+   if (ok && count > 2)
+   {
+      bench_path(path, sizeof(path), count / 2);
+      playlist_delete_by_path(playlist, path);
+      ok = !playlist_entry_exists(playlist, path)
+         && playlist_size(playlist) == count - 1;
+
+      bench_path(path, sizeof(path), count - 1);
+      playlist_delete_index(playlist, 1);
+      ok = ok && !playlist_entry_exists(playlist, path);
+
+      bench_path(path, sizeof(path), 1);
+      ok = ok && playlist_entry_exists(playlist, path);
+   }
+
+   /* And sorting keeps lookups right */
+   if (ok)
+   {
+      playlist_qsort(playlist);
+      bench_path(path, sizeof(path), count / 3);
+      found = NULL;
+      playlist_get_index_by_path(playlist, path, &found);
+      ok    = found && string_is_equal(found->path, path);
+   }
+
+   printf("[playlist_push_bench] %6u entries: %8.2f usec/lookup, "
+         "checks: %s\n",
+         count, (double)total / (2 * count), ok ? "ok" : "FAILED");
+
+   playlist_free(playlist);
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned count;
+   bool ok              = true;
+   unsigned max_entries = (argc > 1) ? (unsigned)atoi(argv[1]) : 100000;
+
+   for (count = 1000; count <= max_entries; count *= 10)
+      ok = bench_run(count) && ok;
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless benchmark for the rewind state manager.
+ *
+ * Replays a sequence of savestates through the rewind buffer,
+ * the way runloop does on every frame, once with compression on
+ * the main thread and once on a worker. Reports how long the
+ * main thread spends per push and the matching throughput (state
+ * bytes per second of main thread time), then pops everything
+ * back and checks the states come out in reverse order.
+ *
+ * Usage: rewind_bench [frames] [frame_usec] [buffer_mb]
+ *                     [cold_mb] [spill_mb] [state_file state_size]
+ *
+ * 'cold_mb' and 'spill_mb' enable the compressed tier and the
+ * spill file (created in the current directory), so that states
+ * pushed out of the ring can still be popped back.
+ * 'state_file' holds raw states of 'state_size' bytes back to
+ * back, e.g. dumped from a core's retro_serialize() every frame.
+ * Without it, a synthetic 512 KiB state is mutated like a core's
+ * RAM and VRAM would be. 'frame_usec' is how long the 'core'
+ * runs between two pushes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+
+/* The state manager is used through its internal API */
+#include "../../../state_manager.c"
+
+#define BENCH_SYNTH_STATE_SIZE (512 * 1024)
+
+static FILE *bench_file          = NULL;
+static size_t bench_cold_size    = 0;
+static size_t bench_spill_size   = 0;
+static size_t bench_state_size   = BENCH_SYNTH_STATE_SIZE;
+static uint8_t *bench_state      = NULL;
+static uint32_t bench_seed       = 0;
+
+/* Frontend symbols used by the state manager */
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vprintf(fmt, ap);
+   va_end(ap);
+}
+
+void RARCH_WARN(const char *fmt, ...) { }
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+const char *msg_hash_to_str(enum msg_hash_enums msg) { return ""; }
+bool core_info_get_current_core(core_info_t **core) { return false; }
+bool core_info_current_supports_rewind(void) { return true; }
+bool audio_driver_has_callback(void) { return false; }
+void audio_driver_setup_rewind(void) { }
+void audio_driver_frame_is_reverse(void) { }
+void audio_driver_sample(int16_t left, int16_t right) { }
+size_t audio_driver_sample_batch(const int16_t *data, size_t frames) { return frames; }
+void audio_driver_sample_rewind(int16_t left, int16_t right) { }
+size_t audio_driver_sample_batch_rewind(const int16_t *data, size_t frames) { return frames; }
+size_t content_get_serialized_size_rewind(void) { return bench_state_size; }
+bool content_serialize_state_rewind(void *buffer, size_t size) { return false; }
+bool content_deserialize_state(const void *data, size_t size) { return true; }
+bool retroarch_ctl(enum rarch_ctl_state state, void *data) { return false; }
+void runloop_msg_queue_push(const char *msg, unsigned prio,
+      unsigned duration, bool flush, char *title,
+      enum message_queue_icon icon,
+      enum message_queue_category category) { }
+
+static uint32_t bench_rand(void)
+{
+   bench_seed = bench_seed * 1664525 + 1013904223;
+   return bench_seed >> 8;
+}
+
+/* Produces the next state; returns false at the end of the sequence */
+static bool bench_next_state(unsigned frame)
+{
+   unsigned i;
+
+   if (bench_file)
+      return fread(bench_state, 1, bench_state_size, bench_file)
+         == bench_state_size;
+
+   if (frame == 0)
+   {
+      /* Mostly static layout: code, tiles, a zeroed tail */
+      bench_seed = 0x2545f491;
+      for (i = 0; i < BENCH_SYNTH_STATE_SIZE / 2; i++)
+         bench_state[i] = (uint8_t)bench_rand();
+      memset(bench_state + BENCH_SYNTH_STATE_SIZE / 2, 0,
+            BENCH_SYNTH_STATE_SIZE / 2);
+   }
+
+   /* Frame counter and timers */
+   memcpy(bench_state, &frame, sizeof(frame));
+
+   /* Scattered small writes into the first 128 KiB ('WRAM') */
+   for (i = 0; i < 512; i++)
+   {
+      size_t pos = bench_rand() % (128 * 1024 - 16);
+      size_t len = 1 + bench_rand() % 16;
+      memset(bench_state + pos, (int)bench_rand(), len);
+   }
+
+   /* A DMA-like transfer of low entropy tile data ('VRAM') */
+   {
+      size_t pos = 128 * 1024 + bench_rand() % (64 * 1024 - 8192);
+      size_t len = 2048 + bench_rand() % 6144;
+      size_t j;
+      for (j = 0; j < len; j++)
+         bench_state[pos + j] = (uint8_t)(bench_rand() & 0x03);
+   }
+
+   return true;
+}
+
+static void bench_spin(retro_time_t usec)
+{
+   retro_time_t end = cpu_features_get_time_usec() + usec;
+   while (cpu_features_get_time_usec() < end);
+}
+
+static int bench_cmp_time(const void *a, const void *b)
+{
+   retro_time_t ta = *(const retro_time_t*)a;
+   retro_time_t tb = *(const retro_time_t*)b;
+   return (ta > tb) - (ta < tb);
+}
+
+static bool bench_run(unsigned frames, unsigned frame_usec,
+      size_t buffer_size, bool threaded)
+{
+   unsigned i;
+   unsigned popped       = 0;
+   unsigned pushed       = 0;
+   bool ok               = true;
+   retro_time_t total    = 0;
+   const void *data      = NULL;
+   retro_time_t *times   = (retro_time_t*)malloc(frames * sizeof(*times));
+   uint32_t *crcs        = (uint32_t*)malloc(frames * sizeof(*crcs));
+   state_manager_t *st   = state_manager_new(bench_state_size,
+         buffer_size, threaded, bench_cold_size, bench_spill_size, ".");
+   struct state_manager_rewind_state rewind_st;
+   struct state_manager_tier_stats stats;
+
+   if (!times || !crcs || !st)
+   {
+      fprintf(stderr, "Failed to allocate the rewind buffer.\n");
+      ok = false;
+      goto end;
+   }
+
+   if (bench_file)
+      fseek(bench_file, 0, SEEK_SET);
+
+   for (i = 0; i < frames; i++)
+   {
+      void *where;
+      retro_time_t t0;
+
+      if (!bench_next_state(i))
+         break;
+      crcs[i] = encoding_crc32(0, bench_state, bench_state_size);
+
+      /* Same sequence as state_manager_check_rewind(); the
+       * memcpy stands in for retro_serialize() and isn't counted */
+      t0        = cpu_features_get_time_usec();
+      state_manager_push_where(st, &where);
+      times[i]  = cpu_features_get_time_usec() - t0;
+      memcpy(where, bench_state, bench_state_size);
+      t0        = cpu_features_get_time_usec();
+      state_manager_push_do(st);
+      times[i] += cpu_features_get_time_usec() - t0;
+      total    += times[i];
+      pushed++;
+
+      if (frame_usec)
+         bench_spin(frame_usec);
+   }
+
+   if (!pushed)
+   {
+      fprintf(stderr, "No states to push.\n");
+      ok = false;
+      goto end;
+   }
+
+   printf("[rewind_bench] %-8s %6u pushes  %8.1f MB/s  main thread: "
+         "avg %8.2f usec/push",
+         threaded ? "threaded" : "sync", pushed,
+         (double)bench_state_size * pushed / (total > 0 ? total : 1),
+         (double)total / pushed);
+
+   qsort(times, pushed, sizeof(*times), bench_cmp_time);
+   printf("  p99 %lld usec\n", (long long)times[(pushed * 99) / 100]);
+
+   rewind_st.state = st;
+   state_manager_flush(st);
+   state_manager_get_tier_stats(&rewind_st, &stats);
+   printf("[rewind_bench] %-8s hot: %.1f MB / %u, cold: %.1f MB / %u, "
+         "spill: %.1f MB / %u\n",
+         threaded ? "threaded" : "sync",
+         stats.hot_bytes / 1048576.0, stats.hot_entries,
+         stats.cold_bytes / 1048576.0, stats.cold_entries,
+         stats.spill_bytes / 1048576.0, stats.spill_entries);
+
+   /* Pop everything back; every state must match the one pushed */
+   while (state_manager_pop(st, &data))
+   {
+      if (encoding_crc32(0, (const uint8_t*)data, bench_state_size)
+            != crcs[pushed - 1 - popped])
+         ok = false;
+      popped++;
+   }
+
+   printf("[rewind_bench] %-8s %6u states held (%.1f:1 in RAM), "
+         "popped back: %s\n",
+         threaded ? "threaded" : "sync", popped,
+         (double)bench_state_size * popped
+         / (buffer_size + stats.cold_bytes),
+         ok ? "ok" : "MISMATCH");
+
+end:
+   if (st)
+   {
+      state_manager_free(st);
+      free(st);
+   }
+   free(times);
+   free(crcs);
+   return ok;
+}
+
+int main(int argc, char *argv[])
+{
+   bool ok;
+   unsigned frames     = (argc > 1) ? (unsigned)atoi(argv[1]) : 1200;
+   unsigned frame_usec = (argc > 2) ? (unsigned)atoi(argv[2]) : 0;
+   size_t buffer_size  = ((argc > 3) ? (size_t)atoi(argv[3]) : 20) << 20;
+
+   bench_cold_size     = ((argc > 4) ? (size_t)atoi(argv[4]) : 0) << 20;
+   bench_spill_size    = ((argc > 5) ? (size_t)atoi(argv[5]) : 0) << 20;
+
+   if (argc > 7)
+   {
+      bench_state_size = (size_t)strtoul(argv[7], NULL, 0);
+      if (!bench_state_size || !(bench_file = fopen(argv[6], "rb")))
+      {
+         fprintf(stderr, "Can't read states from %s.\n", argv[6]);
+         return 1;
+      }
+   }
+
+   if (!frames || !(bench_state = (uint8_t*)malloc(bench_state_size)))
+      return 1;
+
+   printf("[rewind_bench] %s, state: %u bytes, buffer: %u MB "
+         "(cold: %u MB, spill: %u MB), frame: %u usec\n",
+         bench_file ? argv[6] : "synthetic",
+         (unsigned)bench_state_size, (unsigned)(buffer_size >> 20),
+         (unsigned)(bench_cold_size >> 20),
+         (unsigned)(bench_spill_size >> 20), frame_usec);
+
+   ok = bench_run(frames, frame_usec, buffer_size, false);
+   ok = bench_run(frames, frame_usec, buffer_size, true) && ok;
+
+   if (bench_file)
+      fclose(bench_file);
+   free(bench_state);
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,385 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Slang cache benchmark.
+ *
+ * Loads every .slangp preset found in a shader directory the way
+ * the filter chains do, compiling then reflecting its passes on a
+ * worker pool, once with an empty cache and once with the cache
+ * it filled, and reports the time each preset took. Then checks that the warm
+ * load gave the same SPIR-V and reflection as the cold one.
+ *
+ * Usage: slang_cache_bench <shader directory> [cache directory]
+ *
+ * 'cache directory' defaults to /tmp; the slang cache directory
+ * made inside of it is emptied before the cold load.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <retro_miscellaneous.h>
+#include <file/config_file.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <lists/string_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "../../../gfx/drivers_shader/glslang_util.h"
+#include "../../../gfx/drivers_shader/glslang_util_cxx.h"
+#include "../../../gfx/drivers_shader/glslang.hpp"
+#include "../../../gfx/drivers_shader/slang_cache.hpp"
+
+/* Frontend symbols used by the shader code */
+
+extern "C" {
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_DBG(const char *fmt, ...) { }
+void RARCH_WARN(const char *fmt, ...) { }
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+}
+
+struct bench_pass
+{
+   std::vector<uint32_t> vertex;
+   std::vector<uint32_t> fragment;
+   std::vector<uint8_t> reflection;
+};
+
+static uint64_t bench_time_usec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* What the cached reflection is compared with */
+static void bench_put(std::vector<uint8_t> &out, const void *data, size_t len)
+{
+   out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+}
+
+static void bench_put_semantic(std::vector<uint8_t> &out,
+      const slang_semantic_meta &meta)
+{
+   bench_put(out, &meta.ubo_offset, sizeof(meta.ubo_offset));
+   bench_put(out, &meta.push_constant_offset,
+         sizeof(meta.push_constant_offset));
+   bench_put(out, &meta.num_components, sizeof(meta.num_components));
+   bench_put(out, &meta.uniform, sizeof(meta.uniform));
+   bench_put(out, &meta.push_constant, sizeof(meta.push_constant));
+}
+
+static std::vector<uint8_t> bench_flatten(const slang_reflection &reflection)
+{
+   unsigned i;
+   std::vector<uint8_t> out;
+
+   bench_put(out, &reflection.ubo_size, sizeof(reflection.ubo_size));
+   bench_put(out, &reflection.push_constant_size,
+         sizeof(reflection.push_constant_size));
+   bench_put(out, &reflection.ubo_binding, sizeof(reflection.ubo_binding));
+   bench_put(out, &reflection.ubo_stage_mask,
+         sizeof(reflection.ubo_stage_mask));
+   bench_put(out, &reflection.push_constant_stage_mask,
+         sizeof(reflection.push_constant_stage_mask));
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      for (auto &meta : reflection.semantic_textures[i])
+      {
+         bench_put(out, &meta.ubo_offset, sizeof(meta.ubo_offset));
+         bench_put(out, &meta.push_constant_offset,
+               sizeof(meta.push_constant_offset));
+         bench_put(out, &meta.binding, sizeof(meta.binding));
+         bench_put(out, &meta.stage_mask, sizeof(meta.stage_mask));
+         bench_put(out, &meta.texture, sizeof(meta.texture));
+         bench_put(out, &meta.uniform, sizeof(meta.uniform));
+         bench_put(out, &meta.push_constant, sizeof(meta.push_constant));
+      }
+      out.push_back(0xff);
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      bench_put_semantic(out, reflection.semantics[i]);
+   for (auto &meta : reflection.semantic_float_parameters)
+      bench_put_semantic(out, meta);
+
+   return out;
+}
+
+static void bench_add_texture(
+      std::unordered_map<std::string, slang_texture_semantic_map> &map,
+      std::unordered_map<std::string, slang_texture_semantic_map> &uniform_map,
+      const std::string &name, enum slang_texture_semantic semantic,
+      unsigned index)
+{
+   map[name]                  = slang_texture_semantic_map{ semantic, index };
+   uniform_map[name + "Size"] = slang_texture_semantic_map{ semantic, index };
+}
+
+/* Compiles and reflects the passes of a preset, with the aliases,
+ * look-up textures and parameters as semantics like the filter
+ * chains do. Returns false if any pass fails. */
+static bool bench_load_preset(const char *path,
+      std::vector<bench_pass> &passes)
+{
+   unsigned i, count;
+   std::vector<glslang_output> outputs;
+   std::vector<std::string> shader_paths;
+   std::vector<std::string> parameters;
+   std::unordered_map<std::string, slang_texture_semantic_map> textures;
+   std::unordered_map<std::string, slang_texture_semantic_map> uniforms;
+   std::unordered_map<std::string, slang_semantic_map> semantics;
+   char *luts          = NULL;
+   config_file_t *conf = config_file_new_from_path_to_string(path);
+   bool ok             = false;
+   bool ret            = false;
+
+   passes.clear();
+
+   if (!conf)
+      return false;
+
+   /* Presets only referencing another one aren't loaded here */
+   if (!config_get_uint(conf, "shaders", &count) || !count)
+      goto end;
+
+   outputs.resize(count);
+
+   for (i = 0; i < count; i++)
+   {
+      char key[64];
+      char shader_path[PATH_MAX_LENGTH];
+      struct config_entry_list *entry;
+
+      snprintf(key, sizeof(key), "shader%u", i);
+      if (!(entry = config_get_entry(conf, key)))
+         goto end;
+
+      fill_pathname_resolve_relative(shader_path, path, entry->value,
+            sizeof(shader_path));
+      shader_paths.push_back(shader_path);
+   }
+
+   /* Passes are compiled, then reflected, concurrently */
+   glslang::acquire_process();
+   ok = glslang_run_passes(count, "Compiled",
+         [&](unsigned j)
+         {
+            return glslang_compile_shader(shader_paths[j].c_str(),
+                  &outputs[j]);
+         });
+   glslang::release_process();
+
+   if (!ok)
+      goto end;
+
+   for (i = 0; i < count; i++)
+   {
+      struct config_entry_list *entry;
+      char key[64];
+
+      for (auto &param : outputs[i].meta.parameters)
+         if (std::find(parameters.begin(), parameters.end(), param.id)
+               == parameters.end())
+            parameters.push_back(param.id);
+
+      snprintf(key, sizeof(key), "alias%u", i);
+      if ((entry = config_get_entry(conf, key)) && *entry->value)
+         outputs[i].meta.name = entry->value;
+
+      if (!outputs[i].meta.name.empty())
+      {
+         bench_add_texture(textures, uniforms, outputs[i].meta.name,
+               SLANG_TEXTURE_SEMANTIC_PASS_OUTPUT, i);
+         bench_add_texture(textures, uniforms,
+               outputs[i].meta.name + "Feedback",
+               SLANG_TEXTURE_SEMANTIC_PASS_FEEDBACK, i);
+      }
+   }
+
+   if (config_get_string(conf, "textures", &luts))
+   {
+      struct string_list list = {0};
+
+      string_list_initialize(&list);
+      if (string_split_noalloc(&list, luts, ";"))
+         for (i = 0; i < list.size; i++)
+            bench_add_texture(textures, uniforms, list.elems[i].data,
+                  SLANG_TEXTURE_SEMANTIC_USER, i);
+      string_list_deinitialize(&list);
+      free(luts);
+   }
+
+   passes.resize(count);
+
+   for (i = 0; i < parameters.size(); i++)
+      semantics[parameters[i]] = slang_semantic_map{
+         SLANG_SEMANTIC_FLOAT_PARAMETER, i };
+
+   if (!glslang_run_passes(count, "Reflected",
+            [&](unsigned j)
+            {
+               slang_reflection reflection;
+
+               reflection.pass_number                  = j;
+               reflection.texture_semantic_map         = &textures;
+               reflection.texture_semantic_uniform_map = &uniforms;
+               reflection.semantic_map                 = &semantics;
+
+               if (!slang_reflect_spirv(outputs[j].vertex,
+                        outputs[j].fragment, &reflection))
+                  return false;
+
+               passes[j].vertex     = outputs[j].vertex;
+               passes[j].fragment   = outputs[j].fragment;
+               passes[j].reflection = bench_flatten(reflection);
+               return true;
+            }))
+      goto end;
+
+   ret = true;
+
+end:
+   config_file_free(conf);
+   return ret;
+}
+
+static void bench_clear_dir(const char *dir)
+{
+   unsigned i;
+   struct string_list *list = dir_list_new(dir, NULL,
+         false, true, false, false);
+
+   if (!list)
+      return;
+
+   for (i = 0; i < list->size; i++)
+      filestream_delete(list->elems[i].data);
+   string_list_free(list);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   char cache_dir[PATH_MAX_LENGTH];
+   struct slang_cache_stats stats;
+   struct string_list *presets;
+   const char *cache_root = argc > 2 ? argv[2] : "/tmp";
+   uint64_t total_cold    = 0;
+   uint64_t total_warm    = 0;
+   unsigned loaded        = 0;
+   int ret                = 0;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s <shader directory> [cache directory]\n",
+            argv[0]);
+      return 1;
+   }
+
+   if (!(presets = dir_list_new(argv[1], "slangp",
+               false, true, false, true)))
+   {
+      fprintf(stderr, "Could not read \"%s\".\n", argv[1]);
+      return 1;
+   }
+
+   dir_list_sort(presets, true);
+
+   fill_pathname_join_special(cache_dir, cache_root, SLANG_CACHE_DIR,
+         sizeof(cache_dir));
+   bench_clear_dir(cache_dir);
+   slang_cache_set_dir(cache_root);
+
+   printf("%-48s %6s %10s %10s %8s\n",
+         "Preset", "Passes", "Cold (ms)", "Warm (ms)", "Speedup");
+
+   for (i = 0; i < presets->size; i++)
+   {
+      std::vector<bench_pass> cold, warm;
+      const char *path = presets->elems[i].data;
+      uint64_t start   = bench_time_usec();
+      uint64_t cold_time, warm_time;
+      bool same        = true;
+      size_t j;
+
+      if (!bench_load_preset(path, cold))
+      {
+         printf("%-48s failed to load\n", path_basename(path));
+         continue;
+      }
+
+      cold_time = bench_time_usec() - start;
+      start     = bench_time_usec();
+
+      if (!bench_load_preset(path, warm))
+      {
+         printf("%-48s failed to load from the cache\n",
+               path_basename(path));
+         ret = 1;
+         continue;
+      }
+
+      warm_time = bench_time_usec() - start;
+
+      for (j = 0; j < cold.size(); j++)
+         if (     cold[j].vertex     != warm[j].vertex
+               || cold[j].fragment   != warm[j].fragment
+               || cold[j].reflection != warm[j].reflection)
+            same = false;
+
+      printf("%-48s %6u %10.2f %10.2f %7.1fx%s\n", path_basename(path),
+            (unsigned)cold.size(), cold_time / 1000.0, warm_time / 1000.0,
+            warm_time ? (double)cold_time / warm_time : 0.0,
+            same ? "" : " MISMATCH");
+
+      if (!same)
+         ret = 1;
+
+      total_cold += cold_time;
+      total_warm += warm_time;
+      loaded++;
+   }
+
+   slang_cache_get_stats(&stats);
+
+   printf("\n%u presets: %.1f ms cold, %.1f ms warm.\n",
+         loaded, total_cold / 1000.0, total_warm / 1000.0);
+   printf("Cache: %u/%u shader stages, %u/%u reflections.\n",
+         stats.spirv_hits, stats.spirv_hits + stats.spirv_misses,
+         stats.reflection_hits,
+         stats.reflection_hits + stats.reflection_misses);
+
+   string_list_free(presets);
+   slang_cache_deinit();
+   return ret;
+}
@@ -69,7 +69,7 @@ int main(int argc, char *argv[])
    core_info_init_list(core_info_dir, core_dir, exts, true, false);
 
    task_push_dbscan(playlist_dir, db_dir, input_dir, true,
-         true, main_db_cb);
+         true, false, main_db_cb);
 
    while (loop_active)
       task_queue_check();
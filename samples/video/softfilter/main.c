@@ -0,0 +1,207 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless benchmark for the software video filters.
+ *
+ * Loads every .filt preset found in the filter directory (with
+ * the filters built in), runs it on a synthetic frame at SNES
+ * (256x224) and 320x240 input sizes and reports the time per
+ * frame. Each run is also compared against a single threaded
+ * run of the same preset, to catch seams between row bands.
+ *
+ * Usage: softfilter_bench [filter_dir] [frames] [threads]
+ *
+ * 'threads' defaults to 0, i.e. one per CPU core.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <memalign.h>
+#include <retro_miscellaneous.h>
+
+#include "../../../gfx/video_filter.h"
+#include "../../../verbosity.h"
+
+/* Frontend symbols used by the filter host; presets that do
+ * not support a pixel format fail to load, keep that quiet */
+
+void RARCH_LOG(const char *fmt, ...) { }
+void RARCH_WARN(const char *fmt, ...) { }
+void RARCH_ERR(const char *fmt, ...) { }
+
+static const unsigned bench_sizes[][2] = {
+   { 256, 224 },
+   { 320, 240 }
+};
+
+/* Blocky test pattern with a small palette, so that edge
+ * detecting filters (scale2x, 2xSaI, ...) take every branch */
+static void bench_fill_frame(void *data, enum retro_pixel_format fmt,
+      unsigned width, unsigned height, size_t pitch)
+{
+   static const uint32_t palette[4] = {
+      0x00000000, 0x00ff8040, 0x0040c0ff, 0x00ffffff
+   };
+   unsigned x, y;
+   uint32_t seed = 0x12345678;
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t color;
+
+         if (((x | y) & 3) == 0)
+            seed = seed * 1664525 + 1013904223;
+         color = palette[(seed >> ((x & 3) + 28)) & 3];
+
+         if (fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+            ((uint32_t*)((uint8_t*)data + y * pitch))[x] = color;
+         else
+            ((uint16_t*)((uint8_t*)data + y * pitch))[x] = (uint16_t)
+                 (((color >> 8) & 0xf800)
+                | ((color >> 5) & 0x07e0)
+                | ((color >> 3) & 0x001f));
+      }
+   }
+}
+
+static bool bench_frames_equal(const uint8_t *a, const uint8_t *b,
+      unsigned width, unsigned height, size_t pitch, unsigned bpp)
+{
+   unsigned y;
+   for (y = 0; y < height; y++)
+      if (memcmp(a + y * pitch, b + y * pitch, width * bpp))
+         return false;
+   return true;
+}
+
+static void bench_run(const char *path, enum retro_pixel_format fmt,
+      unsigned width, unsigned height, unsigned frames, unsigned threads)
+{
+   unsigned i;
+   unsigned out_width, out_height, out_bpp;
+   size_t in_pitch, out_pitch;
+   retro_time_t start, elapsed;
+   rarch_softfilter_t *ref   = NULL;
+   void *input               = NULL;
+   void *output              = NULL;
+   void *ref_output          = NULL;
+   const char *match         = "n/a";
+   rarch_softfilter_t *filt  = rarch_softfilter_new(path, threads,
+         fmt, width, height);
+
+   if (!filt)
+      return;
+
+   in_pitch = width * (fmt == RETRO_PIXEL_FORMAT_XRGB8888
+         ? sizeof(uint32_t) : sizeof(uint16_t));
+   rarch_softfilter_get_output_size(filt, &out_width, &out_height,
+         width, height);
+   out_bpp   = (rarch_softfilter_get_output_format(filt)
+         == RETRO_PIXEL_FORMAT_XRGB8888)
+      ? sizeof(uint32_t) : sizeof(uint16_t);
+   out_pitch = out_width * out_bpp;
+
+   input      = memalign_alloc(64, in_pitch * height);
+   output     = memalign_alloc(64, out_pitch * out_height);
+   ref_output = memalign_alloc(64, out_pitch * out_height);
+   if (!input || !output || !ref_output)
+      goto end;
+
+   bench_fill_frame(input, fmt, width, height, in_pitch);
+
+   /* Warm up caches and the worker threads */
+   for (i = 0; i < 8; i++)
+      rarch_softfilter_process(filt, output, out_pitch,
+            input, width, height, in_pitch);
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < frames; i++)
+      rarch_softfilter_process(filt, output, out_pitch,
+            input, width, height, in_pitch);
+   elapsed = cpu_features_get_time_usec() - start;
+
+   /* Same preset, single row band. Filters with per frame
+    * state (e.g. NTSC burst phase) advance it once per frame,
+    * so compare against the same number of processed frames. */
+   if ((ref = rarch_softfilter_new(path, 1, fmt, width, height)))
+   {
+      for (i = 0; i < frames + 8; i++)
+         rarch_softfilter_process(ref, ref_output, out_pitch,
+               input, width, height, in_pitch);
+      match = bench_frames_equal((const uint8_t*)output,
+            (const uint8_t*)ref_output, out_width, out_height,
+            out_pitch, out_bpp) ? "ok" : "MISMATCH";
+   }
+
+   printf("%-56s %-8s %3ux%-3u -> %4ux%-4u %9.3f ms %9.1f Mpix/s  bands: %s\n",
+         path_basename(path),
+         fmt == RETRO_PIXEL_FORMAT_XRGB8888 ? "XRGB8888" : "RGB565",
+         width, height, out_width, out_height,
+         elapsed / 1000.0 / frames,
+         (double)out_width * out_height * frames / elapsed,
+         match);
+
+end:
+   rarch_softfilter_free(filt);
+   rarch_softfilter_free(ref);
+   memalign_free(input);
+   memalign_free(output);
+   memalign_free(ref_output);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j;
+   struct string_list *presets = NULL;
+   const char *dir             = (argc > 1)
+      ? argv[1] : "../../../gfx/video_filters";
+   unsigned frames             = (argc > 2) ? (unsigned)atoi(argv[2]) : 200;
+   unsigned threads            = (argc > 3) ? (unsigned)atoi(argv[3]) : 0;
+
+   if (!frames)
+      frames = 1;
+
+   if (!(presets = dir_list_new(dir, "filt", false, false, false, false)))
+   {
+      fprintf(stderr, "No .filt presets found in %s.\n", dir);
+      return 1;
+   }
+   dir_list_sort(presets, true);
+
+   printf("[softfilter_bench] %u presets, %u frames, threads: %u (cores: %u)\n",
+         (unsigned)presets->size, frames, threads,
+         cpu_features_get_core_amount());
+
+   for (i = 0; i < presets->size; i++)
+   {
+      for (j = 0; j < ARRAY_SIZE(bench_sizes); j++)
+      {
+         bench_run(presets->elems[i].data, RETRO_PIXEL_FORMAT_RGB565,
+               bench_sizes[j][0], bench_sizes[j][1], frames, threads);
+         bench_run(presets->elems[i].data, RETRO_PIXEL_FORMAT_XRGB8888,
+               bench_sizes[j][0], bench_sizes[j][1], frames, threads);
+      }
+   }
+
+   string_list_free(presets);
+   return 0;
+}
@@ -0,0 +1,248 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2020 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Headless benchmark for the threaded video wrapper.
+ *
+ * Drives video_init_thread() with a null video driver, pushes
+ * frames from the 'core' thread and reports how long the core
+ * thread spends inside the frame callback, i.e. how much the
+ * render thread stalls emulation.
+ *
+ * Usage: thread_wrapper_bench [width] [height] [frames]
+ *                             [present_ms] [nonblock] [zero_copy]
+ *
+ * 'present_ms' simulates the time the driver needs per frame
+ * (GPU submission, vsync...). With 'zero_copy' set, the 'core'
+ * renders into the buffer returned by
+ * GET_CURRENT_SOFTWARE_FRAMEBUFFER instead of its own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <retro_timers.h>
+
+#include "../../../gfx/video_driver.h"
+#include "../../../gfx/video_thread_wrapper.h"
+#include "../../../runloop.h"
+#include "../../../verbosity.h"
+
+static video_driver_state_t bench_video_st;
+static unsigned bench_present_ms = 0;
+
+/* Frontend symbols used by the wrapper */
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vprintf(fmt, ap);
+   va_end(ap);
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+uint32_t runloop_get_flags(void) { return 0; }
+
+video_driver_state_t *video_state_get_ptr(void) { return &bench_video_st; }
+
+void video_driver_build_info(video_frame_info_t *video_info)
+{
+   memset(video_info, 0, sizeof(*video_info));
+}
+
+/* Null video driver, optionally spending some time per frame */
+
+static void *bench_null_init(const video_info_t *video,
+      input_driver_t **input, void **input_data)
+{
+   *input      = NULL;
+   *input_data = NULL;
+   return (void*)-1;
+}
+
+static bool bench_null_frame(void *data, const void *frame,
+      unsigned width, unsigned height, uint64_t frame_count,
+      unsigned pitch, const char *msg, video_frame_info_t *video_info)
+{
+   if (bench_present_ms)
+      retro_sleep(bench_present_ms);
+   return true;
+}
+
+static void bench_null_free(void *data) { }
+static void bench_null_set_nonblock_state(void *a, bool b, bool c, unsigned d) { }
+static bool bench_null_alive(void *data) { return true; }
+static bool bench_null_focus(void *data) { return true; }
+static bool bench_null_has_windowed(void *data) { return true; }
+static bool bench_null_suppress_screensaver(void *data, bool b) { return false; }
+static bool bench_null_set_shader(void *data,
+      enum rarch_shader_type type, const char *path) { return false; }
+
+static const video_poke_interface_t bench_null_poke = {0};
+
+static void bench_null_get_poke_interface(void *data,
+      const video_poke_interface_t **iface)
+{
+   *iface = &bench_null_poke;
+}
+
+static video_driver_t bench_video_null = {
+   bench_null_init,
+   bench_null_frame,
+   bench_null_set_nonblock_state,
+   bench_null_alive,
+   bench_null_focus,
+   bench_null_suppress_screensaver,
+   bench_null_has_windowed,
+   bench_null_set_shader,
+   bench_null_free,
+   "null",
+   NULL, /* set_viewport */
+   NULL, /* set_rotation */
+   NULL, /* viewport_info */
+   NULL, /* read_viewport */
+   NULL, /* read_frame_raw */
+#ifdef HAVE_OVERLAY
+   NULL, /* overlay_interface */
+#endif
+   bench_null_get_poke_interface
+};
+
+static int bench_cmp_time(const void *a, const void *b)
+{
+   retro_time_t ta = *(const retro_time_t*)a;
+   retro_time_t tb = *(const retro_time_t*)b;
+   return (ta > tb) - (ta < tb);
+}
+
+int main(int argc, char *argv[])
+{
+   video_info_t info;
+   video_frame_info_t video_info;
+   unsigned i;
+   const video_driver_t *drv = NULL;
+   void *drv_data            = NULL;
+   input_driver_t *input     = NULL;
+   void *input_data          = NULL;
+   thread_video_t *thr       = NULL;
+   unsigned width            = (argc > 1) ? (unsigned)atoi(argv[1]) : 640;
+   unsigned height           = (argc > 2) ? (unsigned)atoi(argv[2]) : 480;
+   unsigned frames           = (argc > 3) ? (unsigned)atoi(argv[3]) : 2000;
+   bool nonblock             = (argc > 5) ? atoi(argv[5]) != 0 : true;
+   bool zero_copy            = (argc > 6) ? atoi(argv[6]) != 0 : false;
+   const video_poke_interface_t *poke = NULL;
+   size_t pitch              = width * sizeof(uint32_t);
+   uint32_t *frame           = NULL;
+   retro_time_t *times       = NULL;
+   retro_time_t total        = 0;
+   retro_time_t start        = 0;
+
+   bench_present_ms          = (argc > 4) ? (unsigned)atoi(argv[4]) : 0;
+
+   frame                     = (uint32_t*)malloc(pitch * height);
+   times                     = (retro_time_t*)malloc(frames * sizeof(*times));
+   if (!frame || !times)
+      return 1;
+
+   memset(&info, 0, sizeof(info));
+   info.input_scale          = (MAX(width, height) + RARCH_SCALE_BASE - 1)
+      / RARCH_SCALE_BASE;
+   info.rgb32                = true;
+
+   memset(&video_info, 0, sizeof(video_info));
+   video_info.refresh_rate   = 60.0f;
+
+   if (!video_init_thread(&drv, &drv_data, &input, &input_data,
+            &bench_video_null, info))
+   {
+      fprintf(stderr, "Failed to start threaded video.\n");
+      return 1;
+   }
+
+   thr                       = (thread_video_t*)drv_data;
+   bench_video_st.data       = drv_data;
+   bench_video_st.pix_fmt    = RETRO_PIXEL_FORMAT_XRGB8888;
+   drv->poke_interface(drv_data, &poke);
+   drv->set_nonblock_state(drv_data, nonblock, false, 1);
+
+   start                     = cpu_features_get_time_usec();
+
+   for (i = 0; i < frames; i++)
+   {
+      unsigned j;
+      retro_time_t t0;
+      struct retro_framebuffer fb = {0};
+      uint32_t *out               = frame;
+      size_t out_pitch            = pitch;
+
+      fb.width                    = width;
+      fb.height                   = height;
+      fb.access_flags             = RETRO_MEMORY_ACCESS_WRITE;
+
+      if (     zero_copy
+            && poke->get_current_software_framebuffer(drv_data, &fb))
+      {
+         out       = (uint32_t*)fb.data;
+         out_pitch = fb.pitch;
+      }
+
+      /* Render the frame like a core would */
+      for (j = 0; j < height; j++)
+         memset((uint8_t*)out + j * out_pitch, i & 0xff, pitch);
+
+      t0       = cpu_features_get_time_usec();
+      drv->frame(drv_data, out, width, height, i, (unsigned)out_pitch,
+            NULL, &video_info);
+      times[i] = cpu_features_get_time_usec() - t0;
+      total   += times[i];
+   }
+
+   printf("[thread_wrapper_bench] %ux%u XRGB8888, %u frames, "
+         "present: %u ms, nonblock: %s, zero-copy: %s\n",
+         width, height, frames, bench_present_ms,
+         nonblock ? "yes" : "no", zero_copy ? "yes" : "no");
+   printf("[thread_wrapper_bench] wall: %.1f ms (%.1f fps)\n",
+         (cpu_features_get_time_usec() - start) / 1000.0,
+         frames * 1000000.0 / (cpu_features_get_time_usec() - start));
+   printf("[thread_wrapper_bench] pushed: %u, dropped: %u, zero-copy: %u\n",
+         thr->hit_count, thr->miss_count, thr->zero_copy_count);
+   printf("[thread_wrapper_bench] stall per frame: %.3f usec\n",
+         (double)thr->frame.stall_time / frames);
+
+   qsort(times, frames, sizeof(*times), bench_cmp_time);
+   printf("[thread_wrapper_bench] frame() call: avg %.3f usec, "
+         "p50 %lld usec, p99 %lld usec, max %lld usec\n",
+         (double)total / frames,
+         (long long)times[frames / 2],
+         (long long)times[(frames * 99) / 100],
+         (long long)times[frames - 1]);
+
+   drv->free(drv_data);
+
+   free(frame);
+   free(times);
+
+   return 0;
+}
@@ -23,9 +23,30 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
+#include <features/features_cpu.h>
+#include <file/file_path.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_ZLIB
+#include <streams/trans_stream.h>
+#endif
+
+#ifdef HAVE_MMAP
+#include <memmap.h>
+#endif
+
+#ifdef HAVE_MMAN
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "state_manager.h"
 #include "msg_hash.h"
@@ -61,10 +82,43 @@
 #define NO_UNALIGNED_MEM
 #endif
 
-#if __SSE2__
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
 #include <emmintrin.h>
+#define STATE_MANAGER_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define STATE_MANAGER_NEON
+#endif
+
+/* The AVX2 scanners are built with a function target attribute
+ * and picked at runtime, so generic x86 builds get them too */
+#if defined(__AVX2__)
+#define STATE_MANAGER_AVX2
+#define STATE_MANAGER_AVX2_TARGET
+#elif defined(STATE_MANAGER_SSE2) \
+      && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define STATE_MANAGER_AVX2
+#define STATE_MANAGER_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(STATE_MANAGER_SSE2) && defined(_MSC_VER) && _MSC_VER >= 1900
+#define STATE_MANAGER_AVX2
+#define STATE_MANAGER_AVX2_TARGET
 #endif
 
+#ifdef STATE_MANAGER_AVX2
+#include <immintrin.h>
+
+/* Set by state_manager_new() */
+static bool state_manager_avx2 = false;
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/tpool.h>
+#endif
+
+/* Zeroed padding after each raw block; the vectorized scanners
+ * below read up to 64 bytes past the sentinel. */
+#define STATE_MANAGER_BLOCK_PAD 64
+
 /* Format per frame (pseudocode): */
 #if 0
 size nextstart;
@@ -86,33 +140,128 @@ size thisstart;
 #endif
 
 /* There's no equivalent in libc, you'd think so ...
- * std::mismatch exists, but it's not optimized at all. */
+ * std::mismatch exists, but it's not optimized at all.
+ *
+ * Both scanners rely on the sentinel set up by
+ * state_manager_raw_alloc() to terminate; neither checks bounds.
+ * The vectorized versions must return exactly what the scalar
+ * ones do (on x86), so the patch format does not depend on the
+ * build. */
+#ifdef STATE_MANAGER_AVX2
+STATE_MANAGER_AVX2_TARGET
+static size_t find_change_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const __m256i *a256 = (const __m256i*)a;
+   const __m256i *b256 = (const __m256i*)b;
+
+   /* Most of a savestate is unchanged from one frame to the
+    * next, so this is the hot loop; test 64 bytes at a time. */
+   for (;;)
+   {
+      __m256i c0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(a256),
+            _mm256_loadu_si256(b256));
+      __m256i c1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(a256 + 1),
+            _mm256_loadu_si256(b256 + 1));
+
+      if ((uint32_t)_mm256_movemask_epi8(_mm256_and_si256(c0, c1))
+            != 0xffffffff)
+      {
+         uint32_t mask = (uint32_t)_mm256_movemask_epi8(c0);
+         size_t ret    = (uint8_t*)a256 - (uint8_t*)a;
+
+         if (mask != 0xffffffff)
+            ret       += compat_ctz(~mask);
+         else
+            ret       += 32 + compat_ctz(~(uint32_t)_mm256_movemask_epi8(c1));
+
+         return (ret >> 1);
+      }
+
+      a256 += 2;
+      b256 += 2;
+   }
+}
+
+STATE_MANAGER_AVX2_TARGET
+static size_t find_same_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+
+   for (;;)
+   {
+      __m256i c = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256((const __m256i*)a),
+            _mm256_loadu_si256((const __m256i*)b));
+      int mask  = _mm256_movemask_ps(_mm256_castsi256_ps(c));
+
+      if (mask)
+         return (a - a_org) + compat_ctz(mask) * 2;
+
+      a += 16;
+      b += 16;
+   }
+}
+#endif
+
 static size_t find_change(const uint16_t *a, const uint16_t *b)
 {
-#if __SSE2__
+#if defined(STATE_MANAGER_SSE2)
    const __m128i *a128 = (const __m128i*)a;
    const __m128i *b128 = (const __m128i*)b;
 
+#ifdef STATE_MANAGER_AVX2
+   if (state_manager_avx2)
+      return find_change_avx2(a, b);
+#endif
+
    for (;;)
    {
-      __m128i v0    = _mm_loadu_si128(a128);
-      __m128i v1    = _mm_loadu_si128(b128);
-      __m128i c     = _mm_cmpeq_epi8(v0, v1);
-      uint32_t mask = _mm_movemask_epi8(c);
+      __m128i c0    = _mm_cmpeq_epi8(_mm_loadu_si128(a128),
+            _mm_loadu_si128(b128));
+      __m128i c1    = _mm_cmpeq_epi8(_mm_loadu_si128(a128 + 1),
+            _mm_loadu_si128(b128 + 1));
 
-      if (mask != 0xffff) /* Something has changed, figure out where. */
+      if (_mm_movemask_epi8(_mm_and_si128(c0, c1)) != 0xffff)
       {
+         /* Something has changed, figure out where. */
+         uint32_t mask = (uint32_t)_mm_movemask_epi8(c0)
+            | ((uint32_t)_mm_movemask_epi8(c1) << 16);
          /* calculate the real offset to the differing byte */
-         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) |
+         size_t ret    = (((uint8_t*)a128 - (uint8_t*)a) |
                (compat_ctz(~mask)));
 
          /* and convert that to the uint16_t offset */
          return (ret >> 1);
       }
 
-      a128++;
-      b128++;
+      a128 += 2;
+      b128 += 2;
+   }
+#elif defined(STATE_MANAGER_NEON)
+   const uint16_t *a_org = a;
+
+   for (;;)
+   {
+      uint64x2_t c0 = vreinterpretq_u64_u16(vceqq_u16(
+               vld1q_u16(a),     vld1q_u16(b)));
+      uint64x2_t c1 = vreinterpretq_u64_u16(vceqq_u16(
+               vld1q_u16(a + 8), vld1q_u16(b + 8)));
+      uint64x2_t c  = vandq_u64(c0, c1);
+
+      if ((vgetq_lane_u64(c, 0) & vgetq_lane_u64(c, 1)) != ~(uint64_t)0)
+         break;
+
+      a += 16;
+      b += 16;
    }
+
+   /* The difference is somewhere in the next 16 words */
+   while (*a == *b)
+   {
+      a++;
+      b++;
+   }
+   return a - a_org;
 #else
    const uint16_t *a_org = a;
 #ifdef NO_UNALIGNED_MEM
@@ -148,39 +297,90 @@ static size_t find_change(const uint16_t *a, const uint16_t *b)
 static size_t find_same(const uint16_t *a, const uint16_t *b)
 {
    const uint16_t *a_org = a;
-#ifdef NO_UNALIGNED_MEM
-   if (((uintptr_t)a & (sizeof(uint32_t) - 1)) && *a != *b)
+#ifdef STATE_MANAGER_AVX2
+   if (state_manager_avx2)
    {
-      a++;
-      b++;
+      size_t same = find_same_avx2(a, b);
+      a          += same;
+      b          += same;
    }
-   if (*a != *b)
+   else
 #endif
    {
-      /* With this, it's random whether two consecutive identical
-       * words are caught.
-       *
-       * Luckily, compression rate is the same for both cases, and
-       * three is always caught.
-       *
-       * (We prefer to miss two-word blocks, anyways; fewer iterations
-       * of the outer loop, as well as in the decompressor.) */
-      const uint32_t *a_big = (const uint32_t*)a;
-      const uint32_t *b_big = (const uint32_t*)b;
+#if defined(STATE_MANAGER_SSE2)
+      for (;;)
+      {
+         __m128i c = _mm_cmpeq_epi32(
+               _mm_loadu_si128((const __m128i*)a),
+               _mm_loadu_si128((const __m128i*)b));
+         int mask  = _mm_movemask_ps(_mm_castsi128_ps(c));
+
+         if (mask)
+         {
+            a += compat_ctz(mask) * 2;
+            b += compat_ctz(mask) * 2;
+            break;
+         }
 
-      while (*a_big != *b_big)
+         a += 8;
+         b += 8;
+      }
+#elif defined(STATE_MANAGER_NEON)
+      for (;;)
       {
-         a_big++;
-         b_big++;
+         uint64x2_t c = vreinterpretq_u64_u32(vceqq_u32(
+                  vreinterpretq_u32_u16(vld1q_u16(a)),
+                  vreinterpretq_u32_u16(vld1q_u16(b))));
+
+         if (vgetq_lane_u64(c, 0) | vgetq_lane_u64(c, 1))
+            break;
+
+         a += 8;
+         b += 8;
       }
-      a = (const uint16_t*)a_big;
-      b = (const uint16_t*)b_big;
 
-      if (a != a_org && a[-1] == b[-1])
+      /* One of the next four word pairs matches */
+      while (a[0] != b[0] || a[1] != b[1])
+      {
+         a += 2;
+         b += 2;
+      }
+#else
+#ifdef NO_UNALIGNED_MEM
+      if (((uintptr_t)a & (sizeof(uint32_t) - 1)) && *a != *b)
+      {
+         a++;
+         b++;
+      }
+      if (*a != *b)
+#endif
       {
-         a--;
-         b--;
+         const uint32_t *a_big = (const uint32_t*)a;
+         const uint32_t *b_big = (const uint32_t*)b;
+
+         while (*a_big != *b_big)
+         {
+            a_big++;
+            b_big++;
+         }
+         a = (const uint16_t*)a_big;
+         b = (const uint16_t*)b_big;
       }
+#endif
+   }
+
+   /* With this, it's random whether two consecutive identical
+    * words are caught.
+    *
+    * Luckily, compression rate is the same for both cases, and
+    * three is always caught.
+    *
+    * (We prefer to miss two-word blocks, anyways; fewer iterations
+    * of the outer loop, as well as in the decompressor.) */
+   if (a != a_org && a[-1] == b[-1])
+   {
+      a--;
+      b--;
    }
    return a - a_org;
 }
@@ -206,7 +406,8 @@ static size_t state_manager_raw_maxsize(size_t uncomp)
 static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
 {
    size_t  len16 = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 16, 1);
+   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4
+         + STATE_MANAGER_BLOCK_PAD, 1);
 
    if (!ret)
       return NULL;
@@ -220,8 +421,8 @@ static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
     * There is also some padding at the end. This is so we don't
     * read outside the buffer end if we're reading in large blocks;
     *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get
-    * Valgrind happy is worth it. */
+    * It doesn't make any difference to us, but sacrificing a few bytes to
+    * get Valgrind happy is worth it. */
    ret[len16/sizeof(uint16_t) + 3] = uniq;
 
    return ret;
@@ -375,11 +576,656 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+/* Cold tier.
+ *
+ * Patches pushed out of the tail of the ring are not dropped but
+ * appended to a staging buffer as [uint32 size][patch] records.
+ * Full staging buffers become segments, deflated on the worker
+ * (or inline without one). Past the RAM budget, the oldest
+ * segments move to a memory-mapped spill file, and past that
+ * they are dropped, oldest first.
+ *
+ * The tiers form one chain: when popping empties the ring, the
+ * newest records (staging buffer first, then the newest segment)
+ * are written back into the empty ring and popping carries on.
+ * Eviction and refill are always done at the oldest/newest ends
+ * respectively, so the chain of patches is never broken. */
+
+/* Raw size of a cold segment, before compression */
+#define STATE_MANAGER_SEGMENT_SIZE (128 * 1024)
+
+typedef struct state_manager_segment
+{
+   uint8_t *data;       /* NULL once spilled */
+   size_t offset;       /* Position in the spill map */
+   size_t size;         /* Stored size */
+   size_t raw_size;
+   unsigned entries;
+   bool deflated;
+} state_manager_segment_t;
+
+struct state_manager_cold
+{
+   /* Oldest first. The first 'spilled' segments live in the
+    * spill map, the last 'pending' ones are being deflated. */
+   state_manager_segment_t **segments;
+   size_t count;
+   size_t cap;
+   size_t spilled;
+   size_t pending;
+
+   uint8_t *stage;
+   size_t stage_size;
+   size_t stage_cap;
+   /* What the staged records take up once back in the ring */
+   size_t stage_cost;
+   size_t stage_limit;
+   unsigned stage_entries;
+
+   /* RAM held by segments, against 'budget' */
+   size_t budget;
+   size_t bytes;
+   unsigned entries;
+
+   uint8_t *map;
+   size_t map_size;
+   size_t map_write;
+   size_t map_bytes;
+   unsigned map_entries;
+
+#ifdef HAVE_ZLIB
+   void *deflate_stream;
+   void *inflate_stream;
+#endif
+};
+
+static void state_manager_commit(state_manager_t *state, size_t size);
+
+/* Returns the size of a patch made by state_manager_raw_compress() */
+static size_t state_manager_raw_patch_size(const void *patch)
+{
+   const uint16_t *patch16 = (const uint16_t*)patch;
+
+   for (;;)
+   {
+      uint16_t numchanged  = *(patch16++);
+
+      if (numchanged)
+         patch16          += 1 + numchanged;
+      else
+      {
+         uint32_t numunchanged = patch16[0] | (patch16[1] << 16);
+
+         patch16          += 2;
+         if (!numunchanged)
+            break;
+      }
+   }
+
+   return (const uint8_t*)patch16 - (const uint8_t*)patch;
+}
+
+static uint8_t *state_manager_segment_bytes(
+      struct state_manager_cold *cold, state_manager_segment_t *seg)
+{
+   return seg->data ? seg->data : cold->map + seg->offset;
+}
+
+#ifdef HAVE_ZLIB
+/* Replaces a zlib stream left mid-stream by a failed segment
+ * with a fresh one. */
+static void state_manager_cold_stream_reset(
+      struct state_manager_cold *cold, bool deflate)
+{
+   const struct trans_stream_backend *backend = deflate
+      ? trans_stream_get_zlib_deflate_backend()
+      : trans_stream_get_zlib_inflate_backend();
+   void **stream = deflate
+      ? &cold->deflate_stream
+      : &cold->inflate_stream;
+
+   if (*stream)
+      backend->stream_free(*stream);
+
+   if ((*stream = backend->stream_new()) && deflate)
+      backend->define(*stream, "level", 1);
+}
+#endif
+
+/* Replaces the raw records of a segment with their deflated
+ * form, unless that does not save anything. Runs on the worker
+ * in threaded mode. */
+static void state_manager_segment_deflate(
+      struct state_manager_cold *cold, state_manager_segment_t *seg)
+{
+#ifdef HAVE_ZLIB
+   uint32_t rd, wn;
+   bool ret;
+   enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+   const struct trans_stream_backend *backend =
+      trans_stream_get_zlib_deflate_backend();
+   size_t out_size = seg->raw_size + (seg->raw_size >> 8) + 64;
+   uint8_t *out;
+
+   /* Lost the stream in an earlier reset, keep the records raw */
+   if (!cold->deflate_stream)
+      return;
+   if (!(out = (uint8_t*)malloc(out_size)))
+      return;
+
+   backend->set_in(cold->deflate_stream, seg->data, (uint32_t)seg->raw_size);
+   backend->set_out(cold->deflate_stream, out, (uint32_t)out_size);
+
+   ret = backend->trans(cold->deflate_stream, true, &rd, &wn, &err);
+
+   if (     ret
+         && err == TRANS_STREAM_ERROR_NONE
+         && rd  == seg->raw_size
+         && wn  <  seg->raw_size)
+   {
+      uint8_t *shrunk = (uint8_t*)realloc(out, wn);
+      free(seg->data);
+      seg->data       = shrunk ? shrunk : out;
+      seg->size       = wn;
+      seg->deflated   = true;
+   }
+   else
+      free(out);
+
+   /* The backend only ends the zlib stream once it reached
+    * Z_STREAM_END, anything else would leave it stuck for
+    * every segment after this one. */
+   if (err != TRANS_STREAM_ERROR_NONE)
+      state_manager_cold_stream_reset(cold, true);
+#endif
+}
+
+#ifdef HAVE_THREADS
+typedef struct
+{
+   struct state_manager_cold *cold;
+   state_manager_segment_t *seg;
+} state_manager_deflate_job_t;
+
+static void state_manager_deflate_job(void *data)
+{
+   state_manager_deflate_job_t *job = (state_manager_deflate_job_t*)data;
+
+   state_manager_segment_deflate(job->cold, job->seg);
+   free(job);
+}
+#endif
+
+/* Waits for segments being deflated and accounts for their final size */
+static void state_manager_cold_wait(state_manager_t *state)
+{
+   struct state_manager_cold *cold = state->cold;
+
+   if (!cold || !cold->pending)
+      return;
+
+#ifdef HAVE_THREADS
+   tpool_wait(state->pool);
+#endif
+
+   for (; cold->pending; cold->pending--)
+   {
+      state_manager_segment_t *seg =
+         cold->segments[cold->count - cold->pending];
+      cold->bytes += seg->size;
+      cold->bytes -= seg->raw_size;
+   }
+}
+
+static void state_manager_segment_free(state_manager_segment_t *seg)
+{
+   if (seg->data)
+      free(seg->data);
+   free(seg);
+}
+
+static void state_manager_cold_drop_oldest(struct state_manager_cold *cold)
+{
+   state_manager_segment_t *seg = cold->segments[0];
+
+   if (cold->spilled)
+   {
+      cold->spilled--;
+      cold->map_bytes   -= seg->size;
+      cold->map_entries -= seg->entries;
+   }
+   else
+   {
+      cold->bytes       -= seg->size;
+      cold->entries     -= seg->entries;
+   }
+
+   state_manager_segment_free(seg);
+   memmove(cold->segments, cold->segments + 1,
+         --cold->count * sizeof(*cold->segments));
+}
+
+/* Moves the oldest segment still in RAM to the spill map,
+ * dropping the oldest spilled segments it overwrites. */
+static bool state_manager_cold_spill(struct state_manager_cold *cold)
+{
+   size_t i;
+   state_manager_segment_t *seg = cold->segments[cold->spilled];
+   size_t offset                = cold->map_write;
+
+   if (!cold->map || seg->size > cold->map_size)
+      return false;
+
+   if (offset + seg->size > cold->map_size)
+      offset = 0;
+
+   for (i = 0; i < cold->spilled; )
+   {
+      state_manager_segment_t *old = cold->segments[i];
+
+      if (     old->offset < offset + seg->size
+            && offset < old->offset + old->size)
+      {
+         /* Can only let go of history from the far end */
+         state_manager_cold_drop_oldest(cold);
+         i = 0;
+      }
+      else
+         i++;
+   }
+
+   /* Dropping may have moved it down */
+   seg = cold->segments[cold->spilled];
+
+   memcpy(cold->map + offset, seg->data, seg->size);
+   free(seg->data);
+   seg->data          = NULL;
+   seg->offset        = offset;
+   cold->map_write    = offset + seg->size;
+
+   cold->bytes       -= seg->size;
+   cold->entries     -= seg->entries;
+   cold->map_bytes   += seg->size;
+   cold->map_entries += seg->entries;
+   cold->spilled++;
+   return true;
+}
+
+static void state_manager_cold_trim(struct state_manager_cold *cold)
+{
+   while (     cold->bytes > cold->budget
+         &&    cold->spilled < cold->count - cold->pending)
+   {
+      if (!state_manager_cold_spill(cold))
+      {
+         /* Nowhere to put it; the chain must stay unbroken,
+          * so everything older goes too. */
+         size_t drop = cold->spilled + 1;
+         while (drop--)
+            state_manager_cold_drop_oldest(cold);
+      }
+   }
+}
+
+/* Turns the staging buffer into a new segment */
+static void state_manager_cold_seal(state_manager_t *state)
+{
+   struct state_manager_cold *cold = state->cold;
+   state_manager_segment_t *seg    = NULL;
+   uint8_t *stage                  = NULL;
+
+   if (!cold->stage_entries)
+      return;
+
+   state_manager_cold_wait(state);
+
+   if (cold->count == cold->cap)
+   {
+      size_t cap                       = cold->cap ? cold->cap * 2 : 64;
+      state_manager_segment_t **segs   = (state_manager_segment_t**)
+         realloc(cold->segments, cap * sizeof(*segs));
+      if (!segs)
+         return;
+      cold->segments = segs;
+      cold->cap      = cap;
+   }
+
+   if (!(seg = (state_manager_segment_t*)calloc(1, sizeof(*seg))))
+      return;
+   if (!(stage = (uint8_t*)malloc(cold->stage_cap)))
+   {
+      free(seg);
+      return;
+   }
+
+   seg->data                     = cold->stage;
+   seg->size                     = cold->stage_size;
+   seg->raw_size                 = cold->stage_size;
+   seg->entries                  = cold->stage_entries;
+   cold->segments[cold->count++] = seg;
+   cold->bytes                  += seg->size;
+   cold->entries                += seg->entries;
+
+   cold->stage                   = stage;
+   cold->stage_size              = 0;
+   cold->stage_cost              = 0;
+   cold->stage_entries           = 0;
+
+#ifdef HAVE_THREADS
+   if (state->pool)
+   {
+      state_manager_deflate_job_t *job = (state_manager_deflate_job_t*)
+         malloc(sizeof(*job));
+
+      if (job)
+      {
+         job->cold = cold;
+         job->seg  = seg;
+         if (tpool_add_work(state->pool, state_manager_deflate_job, job))
+         {
+            cold->pending++;
+            state_manager_cold_trim(cold);
+            return;
+         }
+         free(job);
+      }
+   }
+#endif
+
+   state_manager_segment_deflate(cold, seg);
+   cold->bytes += seg->size;
+   cold->bytes -= seg->raw_size;
+   state_manager_cold_trim(cold);
+}
+
+/* Called before the tail entry of the ring is discarded */
+static void state_manager_evict(state_manager_t *state)
+{
+   struct state_manager_cold *cold = state->cold;
+   const uint8_t *patch            = NULL;
+   uint32_t size                   = 0;
+   size_t cost                     = 0;
+
+   if (!cold)
+      return;
+
+   patch = state->tail + sizeof(size_t);
+   size  = (uint32_t)state_manager_raw_patch_size(patch);
+   cost  = size + sizeof(size_t) * 2;
+
+   if (cold->stage_cost + cost > cold->stage_limit)
+      state_manager_cold_seal(state);
+
+   if (cold->stage_size + sizeof(size) + size > cold->stage_cap)
+   {
+      /* A single patch bigger than a segment */
+      size_t cap     = cold->stage_size + sizeof(size) + size;
+      uint8_t *stage = (uint8_t*)realloc(cold->stage, cap);
+      if (!stage)
+         return;
+      cold->stage     = stage;
+      cold->stage_cap = cap;
+   }
+
+   memcpy(cold->stage + cold->stage_size, &size, sizeof(size));
+   memcpy(cold->stage + cold->stage_size + sizeof(size), patch, size);
+   cold->stage_size += sizeof(size) + size;
+   cold->stage_cost += cost;
+   cold->stage_entries++;
+}
+
+/* Writes the newest cold records back into the (empty) ring */
+static bool state_manager_cold_refill(state_manager_t *state)
+{
+   struct state_manager_cold *cold = state->cold;
+   state_manager_segment_t *seg    = NULL;
+   uint8_t *inflated               = NULL;
+   const uint8_t *records          = NULL;
+   size_t records_size             = 0;
+   size_t pos                      = 0;
+
+   if (!cold)
+      return false;
+
+   state_manager_cold_wait(state);
+
+   if (cold->stage_entries)
+   {
+      records      = cold->stage;
+      records_size = cold->stage_size;
+   }
+   else if (cold->count)
+   {
+      seg          = cold->segments[cold->count - 1];
+      records      = state_manager_segment_bytes(cold, seg);
+      records_size = seg->raw_size;
+
+#ifdef HAVE_ZLIB
+      if (seg->deflated)
+      {
+         uint32_t rd, wn;
+         enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+         const struct trans_stream_backend *backend =
+            trans_stream_get_zlib_inflate_backend();
+
+         if (!cold->inflate_stream)
+            state_manager_cold_stream_reset(cold, false);
+         if (!cold->inflate_stream)
+            return false;
+         if (!(inflated = (uint8_t*)malloc(seg->raw_size)))
+            return false;
+
+         backend->set_in(cold->inflate_stream, records, (uint32_t)seg->size);
+         backend->set_out(cold->inflate_stream, inflated,
+               (uint32_t)seg->raw_size);
+
+         if (     !backend->trans(cold->inflate_stream, true, &rd, &wn, &err)
+               || err != TRANS_STREAM_ERROR_NONE
+               || wn  != seg->raw_size)
+         {
+            RARCH_ERR("[Rewind]: Failed to inflate cold segment.\n");
+            free(inflated);
+            /* Don't let one bad segment take down the ones before it */
+            if (err != TRANS_STREAM_ERROR_NONE)
+               state_manager_cold_stream_reset(cold, false);
+            return false;
+         }
+
+         records   = inflated;
+      }
+#endif
+   }
+   else
+      return false;
+
+   state->head    = state->data + sizeof(size_t);
+   state->tail    = state->data + sizeof(size_t);
+   state->entries = 0;
+
+   while (pos < records_size)
+   {
+      uint32_t size;
+
+      memcpy(&size, records + pos, sizeof(size));
+      memcpy(state->head + sizeof(size_t),
+            records + pos + sizeof(size), size);
+      state_manager_commit(state, size);
+      state->entries++;
+      pos += sizeof(size) + size;
+   }
+
+   if (seg)
+   {
+      if (cold->count == cold->spilled)
+      {
+         cold->spilled--;
+         cold->map_bytes   -= seg->size;
+         cold->map_entries -= seg->entries;
+         /* The map is now free up to this segment */
+         cold->map_write    = seg->offset;
+      }
+      else
+      {
+         cold->bytes       -= seg->size;
+         cold->entries     -= seg->entries;
+      }
+      state_manager_segment_free(seg);
+      cold->count--;
+   }
+   else
+   {
+      cold->stage_size     = 0;
+      cold->stage_cost     = 0;
+      cold->stage_entries  = 0;
+   }
+
+   if (inflated)
+      free(inflated);
+
+   return true;
+}
+
+static void state_manager_cold_free(struct state_manager_cold *cold)
+{
+   size_t i;
+
+   if (!cold)
+      return;
+
+   for (i = 0; i < cold->count; i++)
+      state_manager_segment_free(cold->segments[i]);
+   free(cold->segments);
+   free(cold->stage);
+
+#ifdef HAVE_MMAN
+   if (cold->map)
+      munmap(cold->map, cold->map_size);
+#endif
+#ifdef HAVE_ZLIB
+   if (cold->deflate_stream)
+      trans_stream_get_zlib_deflate_backend()->stream_free(
+            cold->deflate_stream);
+   if (cold->inflate_stream)
+      trans_stream_get_zlib_inflate_backend()->stream_free(
+            cold->inflate_stream);
+#endif
+   free(cold);
+}
+
+/* Creates the spill file in 'dir' and maps it. The name is
+ * unique, so several instances can share a cache directory.
+ * The file is unlinked right away; the mapping keeps it alive,
+ * and nothing is left behind in the cache directory. */
+static uint8_t *state_manager_spill_map(const char *dir, size_t size)
+{
+#ifdef HAVE_MMAN
+   int fd;
+   char path[PATH_MAX_LENGTH];
+   void *map = MAP_FAILED;
+
+   if (string_is_empty(dir))
+      return NULL;
+
+   fill_pathname_join_special(path, dir, "rewind.spill.XXXXXX",
+         sizeof(path));
+
+   if ((fd = mkstemp(path)) < 0)
+      return NULL;
+
+   /* Reserve the blocks now, so a full disk shows up here
+    * and not as SIGBUS on a later write through the map */
+#if defined(__linux__)
+   if (posix_fallocate(fd, 0, (off_t)size) == 0)
+#else
+   if (ftruncate(fd, (off_t)size) == 0)
+#endif
+      map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+   close(fd);
+   unlink(path);
+
+   if (map != MAP_FAILED)
+      return (uint8_t*)map;
+#endif
+   return NULL;
+}
+
+static struct state_manager_cold *state_manager_cold_new(
+      size_t capacity, size_t maxcompsize,
+      size_t budget, size_t spill_size, const char *spill_dir)
+{
+   struct state_manager_cold *cold = NULL;
+
+   /* A refilled segment has to fit in the ring with room
+    * to spare for the next patch */
+   if (capacity < maxcompsize * 4)
+   {
+      RARCH_WARN("[Rewind]: Buffer too small for a cold tier.\n");
+      return NULL;
+   }
+
+   if (!(cold = (struct state_manager_cold*)calloc(1, sizeof(*cold))))
+      return NULL;
+
+   cold->budget      = budget;
+   cold->stage_limit = MIN(STATE_MANAGER_SEGMENT_SIZE, capacity / 2);
+   cold->stage_cap   = cold->stage_limit;
+
+   if (!(cold->stage = (uint8_t*)malloc(cold->stage_cap)))
+      goto error;
+
+#ifdef HAVE_ZLIB
+   if (!(cold->deflate_stream =
+            trans_stream_get_zlib_deflate_backend()->stream_new()))
+      goto error;
+   if (!(cold->inflate_stream =
+            trans_stream_get_zlib_inflate_backend()->stream_new()))
+      goto error;
+   /* Favour speed, this runs every few frames */
+   trans_stream_get_zlib_deflate_backend()->define(
+         cold->deflate_stream, "level", 1);
+#endif
+
+   if (spill_size)
+   {
+      if ((cold->map = state_manager_spill_map(spill_dir, spill_size)))
+         cold->map_size = spill_size;
+      else
+         RARCH_WARN("[Rewind]: Could not create spill file in \"%s\".\n",
+               spill_dir ? spill_dir : "");
+   }
+
+   RARCH_LOG("[Rewind]: Cold tier: %u MB in RAM, %u MB spill file.\n",
+         (unsigned)(budget >> 20), (unsigned)(cold->map_size >> 20));
+
+   return cold;
+
+error:
+   state_manager_cold_free(cold);
+   return NULL;
+}
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   /* The worker may still be writing into the ring */
+   if (state->pool)
+   {
+      tpool_wait(state->pool);
+      tpool_destroy(state->pool);
+   }
+   if (state->spareblock)
+      free(state->spareblock);
+   state->pool       = NULL;
+   state->spareblock = NULL;
+#endif
+
+   state_manager_cold_free(state->cold);
+   state->cold       = NULL;
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
@@ -397,7 +1243,8 @@ static void state_manager_free(state_manager_t *state)
 }
 
 static state_manager_t *state_manager_new(
-      size_t state_size, size_t buffer_size)
+      size_t state_size, size_t buffer_size, bool threaded,
+      size_t cold_size, size_t spill_size, const char *spill_dir)
 {
    size_t max_comp_size, block_size;
    uint8_t *next_block    = NULL;
@@ -408,6 +1255,12 @@ static state_manager_t *state_manager_new(
    if (!state)
       return NULL;
 
+#ifdef STATE_MANAGER_AVX2
+   state_manager_avx2 = (cpu_features_get()
+         & (RETRO_SIMD_AVX | RETRO_SIMD_AVX2))
+      == (RETRO_SIMD_AVX | RETRO_SIMD_AVX2);
+#endif
+
    block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
    /* the compressed data is surrounded by pointers to the other side */
    max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
@@ -432,6 +1285,21 @@ static state_manager_t *state_manager_new(
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
 
+   if (cold_size)
+      state->cold     = state_manager_cold_new(buffer_size, max_comp_size,
+            cold_size, spill_size, spill_dir);
+
+#ifdef HAVE_THREADS
+   /* Falls back to compressing on the calling thread
+    * if the worker can't be set up */
+   if (threaded)
+   {
+      state->spareblock = (uint8_t*)state_manager_raw_alloc(state_size, 2);
+      if (state->spareblock && (state->pool = tpool_create(1)))
+         RARCH_LOG("[Rewind]: Compressing states on a worker thread.\n");
+   }
+#endif
+
 #if STRICT_BUF_SIZE
    state->debugsize   = state_size;
    state->debugblock  = (uint8_t*)malloc(state_size);
@@ -448,6 +1316,53 @@ error:
    return NULL;
 }
 
+/* Links the patch of 'size' bytes written at head + sizeof(size_t)
+ * into the ring, wrapping head around if the next patch might not
+ * fit before the end of the buffer. */
+static void state_manager_commit(state_manager_t *state, size_t size)
+{
+   uint8_t *compressed = state->head + sizeof(size_t) + size;
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed     = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+      {
+         state_manager_evict(state);
+         state->tail = state->data + read_size_t(state->tail);
+         state->entries--;
+      }
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed       += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head       = compressed;
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_compress_job(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   state->job_size        = state_manager_raw_compress(state->job_src,
+         state->job_dst, state->blocksize, state->job_patch);
+}
+#endif
+
+/* Waits for the patch in flight, if any, and links it into the
+ * ring. Anything that looks at head/tail must call this first. */
+static void state_manager_flush(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (state->job_pending)
+   {
+      tpool_wait(state->pool);
+      state->job_pending = false;
+      state_manager_commit(state, state->job_size);
+   }
+#endif
+}
+
 static bool state_manager_pop(state_manager_t *state, const void **data)
 {
    size_t start;
@@ -456,6 +1371,8 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
 
    *data                        = NULL;
 
+   state_manager_flush(state);
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid    = false;
@@ -465,7 +1382,8 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    }
 
    *data                        = state->thisblock;
-   if (state->head == state->tail)
+   if (     state->head == state->tail
+         && !state_manager_cold_refill(state))
       return false;
 
    start                        = read_size_t(state->head - sizeof(size_t));
@@ -512,9 +1430,10 @@ static void state_manager_push_do(state_manager_t *state)
 
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
       size_t headpos, tailpos, remaining;
+
+      state_manager_flush(state);
+
       if (state->capacity < sizeof(size_t) + state->maxcompsize) {
          RARCH_ERR("State capacity insufficient\n");
          return;
@@ -528,28 +1447,36 @@ recheckcapacity:;
 
       if (remaining <= state->maxcompsize)
       {
+         state_manager_evict(state);
          state->tail = state->data + read_size_t(state->tail);
          state->entries--;
          goto recheckcapacity;
       }
 
-      oldb              = state->thisblock;
-      newb              = state->nextblock;
-      compressed        = state->head + sizeof(size_t);
-
-      compressed       += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
-
-      if (compressed - state->data + state->maxcompsize > state->capacity)
+#ifdef HAVE_THREADS
+      if (state->pool)
       {
-         compressed     = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         state->job_src     = state->thisblock;
+         state->job_dst     = state->nextblock;
+         state->job_patch   = state->head + sizeof(size_t);
+         state->job_pending = tpool_add_work(state->pool,
+               state_manager_compress_job, state);
+
+         if (state->job_pending)
+         {
+            swap              = state->spareblock;
+            state->spareblock = state->thisblock;
+            state->thisblock  = state->nextblock;
+            state->nextblock  = swap;
+            state->entries++;
+            return;
+         }
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed       += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head       = compressed;
+#endif
+
+      state_manager_commit(state, state_manager_raw_compress(
+               state->thisblock, state->nextblock, state->blocksize,
+               state->head + sizeof(size_t)));
    }
    else
       state->thisblock_valid = true;
@@ -581,7 +1508,9 @@ static void state_manager_capacity(state_manager_t *state,
 
 void state_manager_event_init(
       struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size)
+      unsigned rewind_buffer_size, bool rewind_threaded,
+      size_t rewind_cold_size, size_t rewind_spill_size,
+      const char *spill_dir)
 {
    core_info_t *core_info = NULL;
    void *state            = NULL;
@@ -634,7 +1563,8 @@ void state_manager_event_init(
          (unsigned)(rewind_buffer_size / 1000000));
 
    rewind_st->state = state_manager_new(rewind_st->size,
-         rewind_buffer_size);
+         rewind_buffer_size, rewind_threaded,
+         rewind_cold_size, rewind_spill_size, spill_dir);
 
    if (!rewind_st->state)
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
@@ -646,6 +1576,36 @@ void state_manager_event_init(
    state_manager_push_do(rewind_st->state);
 }
 
+bool state_manager_get_tier_stats(
+      struct state_manager_rewind_state *rewind_st,
+      struct state_manager_tier_stats *stats)
+{
+   size_t headpos, tailpos;
+   state_manager_t *state = rewind_st ? rewind_st->state : NULL;
+
+   memset(stats, 0, sizeof(*stats));
+
+   if (!state)
+      return false;
+
+   headpos              = state->head - state->data;
+   tailpos              = state->tail - state->data;
+   stats->hot_bytes     = (headpos + state->capacity - tailpos)
+      % state->capacity;
+   stats->hot_entries   = state->entries;
+
+   if (state->cold)
+   {
+      stats->cold_bytes    = state->cold->bytes + state->cold->stage_size;
+      stats->cold_entries  = state->cold->entries
+         + state->cold->stage_entries;
+      stats->spill_bytes   = state->cold->map_bytes;
+      stats->spill_entries = state->cold->map_entries;
+   }
+
+   return true;
+}
+
 void state_manager_event_deinit(
       struct state_manager_rewind_state *rewind_st,
       struct retro_core_t *current_core)
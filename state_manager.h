@@ -59,12 +59,43 @@ struct state_manager
     * (yes, the math is a bit ugly). */
    size_t maxcompsize;
 
+   /* Older deltas, deflated and/or spilled to disk;
+    * NULL unless a cold tier size is set. */
+   struct state_manager_cold *cold;
+
+#ifdef HAVE_THREADS
+   /* Threaded compression: the patch against the previous state
+    * is written to the ring by a worker while the core runs the
+    * next frame, and linked in on the next push or pop. */
+   struct tpool *pool;
+   /* The old block of the patch in flight, kept away from
+    * push_where until the worker is done with it. */
+   uint8_t *spareblock;
+   const uint8_t *job_src;
+   const uint8_t *job_dst;
+   uint8_t *job_patch;
+   size_t job_size;
+   bool job_pending;
+#endif
+
    unsigned entries;
    bool thisblock_valid;
 };
 
 typedef struct state_manager state_manager_t;
 
+/* Size of each tier of the rewind buffer, in bytes
+ * and in number of states. */
+struct state_manager_tier_stats
+{
+   size_t hot_bytes;
+   size_t cold_bytes;
+   size_t spill_bytes;
+   unsigned hot_entries;
+   unsigned cold_entries;
+   unsigned spill_entries;
+};
+
 struct state_manager_rewind_state
 {
    /* Rewind support. */
@@ -80,7 +111,19 @@ void state_manager_event_deinit(
       struct retro_core_t *current_core);
 
 void state_manager_event_init(struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size);
+      unsigned rewind_buffer_size, bool rewind_threaded,
+      size_t rewind_cold_size, size_t rewind_spill_size,
+      const char *spill_dir);
+
+/**
+ * state_manager_get_tier_stats:
+ * @stats                : filled with the current tier sizes
+ *
+ * Returns false if the rewind buffer is not initialised.
+ **/
+bool state_manager_get_tier_stats(
+      struct state_manager_rewind_state *rewind_st,
+      struct state_manager_tier_stats *stats);
 
 /**
  * check_rewind:
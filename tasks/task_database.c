@@ -24,6 +24,7 @@
 #include <lists/dir_list.h>
 #include <file/file_path.h>
 #include <encodings/crc32.h>
+#include <features/features_cpu.h>
 #include <streams/file_stream.h>
 #include <streams/chd_stream.h>
 #include <streams/interface_stream.h>
@@ -43,11 +44,13 @@
 #include "../retroarch.h"
 #include "../verbosity.h"
 #include "task_database_cue.h"
+#include "task_database_hash.h"
 
 typedef struct database_state_handle
 {
    database_info_list_t *info;
    struct string_list *list;
+   database_hash_t *hash; /* Directory scans only */
    uint8_t *buf;
    size_t list_index;
    size_t entry_index;
@@ -62,7 +65,8 @@ enum db_flags_enum
    DB_HANDLE_FLAG_IS_DIRECTORY            = (1 << 0),
    DB_HANDLE_FLAG_SCAN_STARTED            = (1 << 1),
    DB_HANDLE_FLAG_SCAN_WITHOUT_CORE_MATCH = (1 << 2),
-   DB_HANDLE_FLAG_SHOW_HIDDEN_FILES       = (1 << 3)
+   DB_HANDLE_FLAG_SHOW_HIDDEN_FILES       = (1 << 3),
+   DB_HANDLE_FLAG_RESUME                  = (1 << 4)
 };
 
 typedef struct db_handle
@@ -73,6 +77,8 @@ typedef struct db_handle
    database_info_handle_t *handle;
    database_state_handle_t state;
    playlist_config_t playlist_config; /* size_t alignment */
+   retro_time_t start_time;
+   size_t start_index;     /* Where an interrupted scan was resumed */
    unsigned status;
    uint8_t flags;
 } db_handle_t;
@@ -585,6 +591,41 @@ static enum msg_file_type extension_to_file_type(const char *ext)
    return FILE_TYPE_NONE;
 }
 
+/* Entries of a directory scan whose whole file CRC is hashed ahead.
+ * Track files are left out, most of them get pruned by their
+ * cue or gdi sheet and would be read for nothing. */
+static bool task_database_hash_filter(const char *path)
+{
+   const char *ext = path_get_extension(path);
+
+   if (path_contains_compressed_file(path))
+      return false;
+
+   switch (extension_to_file_type(ext))
+   {
+      case FILE_TYPE_NONE:
+         return !string_is_equal_noncase(ext, "bin")
+             && !string_is_equal_noncase(ext, "img");
+#ifdef HAVE_COMPRESSION
+      case FILE_TYPE_COMPRESSED:
+         return true;
+#endif
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static bool task_database_get_file_crc(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name, uint32_t *crc)
+{
+   if (db_state->hash)
+      return database_hash_get_crc(db_state->hash, db->list_ptr, name, crc);
+   return intfstream_file_get_crc(name, 0, SIZE_MAX, crc);
+}
+
 static int task_database_iterate_playlist(
       database_state_handle_t *db_state,
       database_info_handle_t *db, const char *name)
@@ -595,8 +636,8 @@ static int task_database_iterate_playlist(
 #ifdef HAVE_COMPRESSION
          db->type = DATABASE_TYPE_CRC_LOOKUP;
          /* first check crc of archive itself */
-         return intfstream_file_get_crc(name,
-               0, SIZE_MAX, &db_state->archive_crc);
+         return task_database_get_file_crc(db_state, db, name,
+               &db_state->archive_crc);
 #else
          break;
 #endif
@@ -647,7 +688,8 @@ static int task_database_iterate_playlist(
       default:
          db_state->serial[0] = '\0';
          db->type            = DATABASE_TYPE_CRC_LOOKUP;
-         return intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+         return task_database_get_file_crc(db_state, db, name,
+               &db_state->crc);
    }
 
    return 1;
@@ -1122,7 +1164,8 @@ static int task_database_iterate_serial_lookup(
             if (task_database_check_serial_and_crc(db_state))
             {
                if (db_state->crc == 0)
-                  intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+                  task_database_get_file_crc(db_state, db, name,
+                        &db_state->crc);
                if (db_state->crc == db_info_entry->crc32)
                   return database_info_list_iterate_found_match(_db,
                         db_state, db, NULL);
@@ -1198,6 +1241,36 @@ static void task_database_cleanup_state(
    db_state->buf = NULL;
 }
 
+#ifdef RARCH_INTERNAL
+static void task_database_log_throughput(db_handle_t *db)
+{
+   char msg[256];
+   struct database_hash_stats stats;
+   size_t files    = db->handle->list->size - db->start_index;
+   double secs     = (cpu_features_get_time_usec() - db->start_time)
+      / 1000000.0;
+   double mbytes;
+
+   if (!db->state.hash)
+      return;
+
+   database_hash_get_stats(db->state.hash, &stats);
+   mbytes = stats.bytes / (1024.0 * 1024.0);
+   if (secs <= 0.0)
+      secs = 0.000001;
+
+   snprintf(msg, sizeof(msg),
+         "%u files in %.2f s (%.1f files/s), %.1f MB hashed (%.1f MB/s), "
+         "%u CRCs from cache",
+         (unsigned)files, secs, files / secs, mbytes, mbytes / secs,
+         stats.cached);
+
+   RARCH_LOG("[Scanner]: %s.\n", msg);
+   if (retroarch_override_setting_is_set(RARCH_OVERRIDE_SETTING_DATABASE_SCAN, NULL))
+      printf("%s.\n", msg);
+}
+#endif
+
 static void task_database_handler(retro_task_t *task)
 {
    const char *name                 = NULL;
@@ -1294,6 +1367,50 @@ static void task_database_handler(retro_task_t *task)
                   }
                }
             }
+
+            db->start_time = cpu_features_get_time_usec();
+
+            /* Hash ahead of the scanner, and pick up where an
+             * interrupted scan of the same directory stopped if
+             * asked to. A scan started over forgets about it, so
+             * a later resume can't skip files it never got to. */
+            if (     (db->flags & DB_HANDLE_FLAG_IS_DIRECTORY)
+                  && !dbstate->hash)
+            {
+               char cache_path[PATH_MAX_LENGTH];
+               unsigned threads = 0;
+
+               cache_path[0]    = '\0';
+               if (!string_is_empty(db->playlist_directory))
+                  fill_pathname_join_special(cache_path,
+                        db->playlist_directory, DATABASE_HASH_CACHE_FILE,
+                        sizeof(cache_path));
+
+               if ((dbstate->hash = database_hash_new(cache_path,
+                           dbinfo->list, task_database_hash_filter)))
+               {
+                  size_t resume = 0;
+
+                  if (db->flags & DB_HANDLE_FLAG_RESUME)
+                     resume = database_hash_get_resume(dbstate->hash,
+                           db->fullpath);
+                  else
+                     database_hash_clear_resume(dbstate->hash);
+
+                  if (resume)
+                  {
+                     dbinfo->list_ptr = resume;
+                     db->start_index  = resume;
+                     RARCH_LOG("[Scanner]: Resuming scan at %u/%u.\n",
+                           (unsigned)resume + 1, (unsigned)dbinfo->list->size);
+                  }
+
+#ifdef HAVE_THREADS
+                  threads = MIN(cpu_features_get_core_amount(), 4);
+#endif
+                  database_hash_start(dbstate->hash, resume, threads);
+               }
+            }
          }
          dbinfo->status = DATABASE_STATUS_ITERATE_START;
          break;
@@ -1328,6 +1445,9 @@ static void task_database_handler(retro_task_t *task)
       case DATABASE_STATUS_ITERATE_NEXT:
          dbinfo->list_ptr++;
 
+         database_hash_checkpoint(dbstate->hash, db->fullpath,
+               dbinfo->list_ptr, dbinfo->list_ptr >= dbinfo->list->size);
+
          if (dbinfo->list_ptr < dbinfo->list->size)
          {
             dbinfo->status = DATABASE_STATUS_ITERATE_START;
@@ -1348,6 +1468,7 @@ static void task_database_handler(retro_task_t *task)
             RARCH_LOG("[Scanner]: %s\n", msg);
             if (retroarch_override_setting_is_set(RARCH_OVERRIDE_SETTING_DATABASE_SCAN, NULL))
                printf("%s\n", msg);
+            task_database_log_throughput(db);
 #else
             fprintf(stderr, "msg: %s\n", msg);
 #endif
@@ -1370,6 +1491,7 @@ task_finished:
    {
       if (dbstate->list)
          dir_list_free(dbstate->list);
+      database_hash_free(dbstate->hash);
    }
 
    if (db)
@@ -1407,6 +1529,7 @@ bool task_push_dbscan(
       const char *fullpath,
       bool directory,
       bool db_dir_show_hidden_files,
+      bool resume,
       retro_task_callback_t cb)
 {
    retro_task_t *t                         = task_init();
@@ -1424,6 +1547,7 @@ bool task_push_dbscan(
    t->title                                = strdup(msg_hash_to_str(
             MSG_PREPARING_FOR_CONTENT_SCAN));
    t->alternative_look                     = true;
+   t->priority                             = TASK_PRIORITY_BACKGROUND;
 
 #ifdef RARCH_INTERNAL
    t->progress_cb                          = task_database_progress_cb;
@@ -1445,6 +1569,8 @@ bool task_push_dbscan(
       db->flags |= DB_HANDLE_FLAG_SHOW_HIDDEN_FILES;
    if (directory)
       db->flags |= DB_HANDLE_FLAG_IS_DIRECTORY;
+   if (resume)
+      db->flags |= DB_HANDLE_FLAG_RESUME;
    db->fullpath                            = strdup(fullpath);
    db->playlist_directory                  = strdup(playlist_directory);
    db->content_database_path               = strdup(content_database);
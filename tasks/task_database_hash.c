@@ -0,0 +1,715 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <array/rhmap.h>
+#include <compat/posix_string.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "../verbosity.h"
+#include "task_database_hash.h"
+
+#define DATABASE_HASH_CACHE_HEADER  "# RetroArch content scan hash cache v1"
+/* Large sequential reads, files are read once from start to end */
+#define DATABASE_HASH_CHUNK_SIZE    (1024 * 1024)
+/* Append to the cache after that many new CRCs or microseconds */
+#define DATABASE_HASH_SAVE_FILES    256
+#define DATABASE_HASH_SAVE_INTERVAL (10 * 1000000)
+
+enum database_hash_state
+{
+   DATABASE_HASH_IDLE = 0,
+   DATABASE_HASH_BUSY,
+   DATABASE_HASH_DONE,
+   DATABASE_HASH_FAILED
+};
+
+struct database_hash_entry
+{
+   int64_t size;
+   int64_t mtime;
+   uint32_t crc;
+   bool seen;     /* Looked up by this scan, not saved */
+};
+
+struct database_hash
+{
+   struct database_hash_entry *cache; /* RHMAP keyed by path */
+   char **paths;                      /* Scan list, NULL if not hashed ahead */
+   uint8_t *states;
+   uint32_t *crcs;
+   uint8_t *buf;                      /* Scanner thread read buffer */
+   char *cache_path;
+   char *pending;                     /* Cache lines not written yet */
+   char *resume_scan_path;
+   char *resume_entry;
+#ifdef HAVE_THREADS
+   sthread_t **threads;
+   slock_t *lock;
+   scond_t *cond;
+   unsigned num_threads;
+#endif
+   struct database_hash_stats stats;
+   retro_time_t last_save;
+   size_t count;
+   size_t start;                      /* Where the scan was resumed */
+   size_t next;
+   size_t resume_index;
+   size_t resume_count;
+   size_t pending_len;
+   size_t pending_cap;
+   unsigned dirty;
+   bool appendable;                   /* Cache file is ours to append to */
+   bool resume_dirty;
+   bool quit;
+};
+
+static void database_hash_lock(database_hash_t *hash)
+{
+#ifdef HAVE_THREADS
+   slock_lock(hash->lock);
+#endif
+}
+
+static void database_hash_unlock(database_hash_t *hash)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(hash->lock);
+#endif
+}
+
+static bool database_hash_quit(database_hash_t *hash)
+{
+   bool quit;
+   database_hash_lock(hash);
+   quit = hash->quit;
+   database_hash_unlock(hash);
+   return quit;
+}
+
+static bool database_hash_file(database_hash_t *hash, const char *path,
+      uint8_t *buf, uint32_t *crc, uint64_t *bytes)
+{
+   int64_t ret;
+   uint32_t acc = 0;
+   RFILE *file  = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return false;
+
+   while ((ret = filestream_read(file, buf, DATABASE_HASH_CHUNK_SIZE)) > 0)
+   {
+      acc    = encoding_crc32(acc, buf, (size_t)ret);
+      *bytes += (uint64_t)ret;
+      /* Scan cancelled, don't finish reading a large file */
+      if (database_hash_quit(hash))
+      {
+         ret = -1;
+         break;
+      }
+   }
+
+   filestream_close(file);
+
+   if (ret < 0)
+      return false;
+
+   *crc = acc;
+   return true;
+}
+
+/* Queues the cache line of a new CRC for the next append.
+ * Called with the lock held. */
+static void database_hash_queue_entry(database_hash_t *hash,
+      const char *path, const struct database_hash_entry *entry)
+{
+   char line[64];
+   size_t path_len = strlen(path);
+   size_t len      = (size_t)snprintf(line, sizeof(line), "%08lX %lld %lld ",
+         (unsigned long)entry->crc,
+         (long long)entry->size,
+         (long long)entry->mtime);
+   size_t need     = hash->pending_len + len + path_len + 1;
+
+   if (need > hash->pending_cap)
+   {
+      size_t cap = MAX(need, hash->pending_cap * 2);
+      char *tmp  = (char*)realloc(hash->pending, cap);
+
+      /* Out of memory, the next save rewrites the whole file */
+      if (!tmp)
+      {
+         hash->appendable = false;
+         return;
+      }
+      hash->pending     = tmp;
+      hash->pending_cap = cap;
+   }
+
+   memcpy(hash->pending + hash->pending_len, line, len);
+   memcpy(hash->pending + hash->pending_len + len, path, path_len);
+   hash->pending_len           = need;
+   hash->pending[need - 1]     = '\n';
+}
+
+/* Looks the file up in the cache, hashing it if it isn't there
+ * or changed since. Called without the lock held. */
+static bool database_hash_compute(database_hash_t *hash,
+      const char *path, uint8_t *buf, uint32_t *crc)
+{
+   struct database_hash_entry entry;
+   ptrdiff_t idx;
+   uint64_t bytes = 0;
+
+   if (!path_get_size_mtime(path, &entry.size, &entry.mtime))
+      return false;
+
+   database_hash_lock(hash);
+   idx = RHMAP_IDX_STR(hash->cache, path);
+   if (     idx != -1
+         && hash->cache[idx].size  == entry.size
+         && hash->cache[idx].mtime == entry.mtime)
+   {
+      *crc                   = hash->cache[idx].crc;
+      hash->cache[idx].seen  = true;
+      hash->stats.cached++;
+      database_hash_unlock(hash);
+      return true;
+   }
+   database_hash_unlock(hash);
+
+   if (!database_hash_file(hash, path, buf, &entry.crc, &bytes))
+      return false;
+
+   entry.seen = true;
+
+   database_hash_lock(hash);
+   RHMAP_SET_STR(hash->cache, path, entry);
+   database_hash_queue_entry(hash, path, &entry);
+   hash->stats.bytes += bytes;
+   hash->stats.hashed++;
+   hash->dirty++;
+   database_hash_unlock(hash);
+
+   *crc = entry.crc;
+   return true;
+}
+
+#ifdef HAVE_THREADS
+static void database_hash_thread(void *data)
+{
+   database_hash_t *hash = (database_hash_t*)data;
+   uint8_t *buf          = (uint8_t*)malloc(DATABASE_HASH_CHUNK_SIZE);
+
+   if (!buf)
+      return;
+
+   for (;;)
+   {
+      size_t i;
+      uint32_t crc = 0;
+      bool ok      = false;
+
+      slock_lock(hash->lock);
+      while (     hash->next < hash->count
+            && (  !hash->paths[hash->next]
+               || hash->states[hash->next] != DATABASE_HASH_IDLE))
+         hash->next++;
+      if (hash->quit || hash->next >= hash->count)
+      {
+         slock_unlock(hash->lock);
+         break;
+      }
+      i                = hash->next++;
+      hash->states[i]  = DATABASE_HASH_BUSY;
+      slock_unlock(hash->lock);
+
+      ok               = database_hash_compute(hash, hash->paths[i], buf, &crc);
+
+      slock_lock(hash->lock);
+      hash->crcs[i]    = crc;
+      hash->states[i]  = ok ? DATABASE_HASH_DONE : DATABASE_HASH_FAILED;
+      scond_broadcast(hash->cond);
+      slock_unlock(hash->lock);
+   }
+
+   free(buf);
+}
+#endif
+
+static void database_hash_load(database_hash_t *hash)
+{
+   char *line;
+   char *save       = NULL;
+   void *buf        = NULL;
+   int64_t len      = 0;
+
+   if (     !path_is_valid(hash->cache_path)
+         || !filestream_read_file(hash->cache_path, &buf, &len)
+         || !buf)
+      return;
+
+   line = strtok_r((char*)buf, "\n", &save);
+   if (!line || !string_is_equal(line, DATABASE_HASH_CACHE_HEADER))
+   {
+      free(buf);
+      return;
+   }
+
+   hash->appendable = true;
+
+   while ((line = strtok_r(NULL, "\n", &save)))
+   {
+      char *end = NULL;
+
+      if (*line == '@')
+      {
+         /* @ <index> <count> <scan path>\t<entry at index>,
+          * the last one wins and a bare @ clears it */
+         char *tab;
+         size_t index      = (size_t)strtoul(line + 1, &end, 10);
+         size_t count      = (size_t)strtoul(end, &end, 10);
+
+         free(hash->resume_scan_path);
+         free(hash->resume_entry);
+         hash->resume_scan_path = NULL;
+         hash->resume_entry     = NULL;
+
+         if (*end == ' ' && (tab = strchr(end + 1, '\t')))
+         {
+            *tab                   = '\0';
+            hash->resume_scan_path = strdup(end + 1);
+            hash->resume_entry     = strdup(tab + 1);
+            hash->resume_index     = index;
+            hash->resume_count     = count;
+         }
+      }
+      else
+      {
+         /* <crc> <size> <mtime> <path>, later lines replace
+          * earlier ones for the same path */
+         struct database_hash_entry entry;
+
+         entry.seen  = false;
+         entry.crc   = (uint32_t)strtoul(line, &end, 16);
+         entry.size  = (int64_t)strtoll(end, &end, 10);
+         entry.mtime = (int64_t)strtoll(end, &end, 10);
+
+         if (*end == ' ' && end[1])
+            RHMAP_SET_STR(hash->cache, end + 1, entry);
+      }
+   }
+
+   free(buf);
+}
+
+static void database_hash_write_resume(database_hash_t *hash, RFILE *file)
+{
+   if (hash->resume_scan_path && hash->resume_entry)
+      filestream_printf(file, "@%u %u %s\t%s\n",
+            (unsigned)hash->resume_index, (unsigned)hash->resume_count,
+            hash->resume_scan_path, hash->resume_entry);
+   else
+      filestream_printf(file, "@\n");
+}
+
+/* Returns true if @path is @dir or lies below it */
+static bool database_hash_path_is_under(const char *path, const char *dir)
+{
+   size_t len = strlen(dir);
+
+   if (!len || strncmp(path, dir, len))
+      return false;
+
+   return     path[len] == '\0'
+           || path[len] == '/'
+           || path[len] == '\\'
+           || dir[len - 1] == '/'
+           || dir[len - 1] == '\\';
+}
+
+/* Appends the CRCs hashed since the last save, and the resume
+ * point if it moved, so a long scan doesn't rewrite the whole
+ * cache over and over. Called with the lock held. */
+static bool database_hash_append(database_hash_t *hash)
+{
+   RFILE *file;
+
+   if (!(file = filestream_open(hash->cache_path,
+         RETRO_VFS_FILE_ACCESS_WRITE | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END);
+
+   if (hash->pending_len)
+      filestream_write(file, hash->pending, hash->pending_len);
+   if (hash->resume_dirty)
+      database_hash_write_resume(hash, file);
+
+   filestream_close(file);
+   return true;
+}
+
+/* Writes the whole cache. When a scan of @prune_dir finished,
+ * entries below it that the scan didn't come across belong to
+ * files that were deleted or moved, and are left out.
+ * Called with the lock held. */
+static bool database_hash_rewrite(database_hash_t *hash,
+      const char *prune_dir)
+{
+   size_t i, cap;
+   RFILE *file;
+   unsigned pruned = 0;
+   char tmp_path[PATH_MAX_LENGTH];
+
+   strlcpy(tmp_path, hash->cache_path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (!(file = filestream_open(tmp_path,
+         RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   filestream_printf(file, "%s\n", DATABASE_HASH_CACHE_HEADER);
+   database_hash_write_resume(hash, file);
+
+   for (i = 0, cap = RHMAP_CAP(hash->cache); i != cap; i++)
+   {
+      if (!RHMAP_KEY(hash->cache, i))
+         continue;
+
+      if (     prune_dir
+            && !hash->cache[i].seen
+            && database_hash_path_is_under(
+               RHMAP_KEY_STR(hash->cache, i), prune_dir))
+      {
+         pruned++;
+         continue;
+      }
+
+      filestream_printf(file, "%08lX %lld %lld %s\n",
+            (unsigned long)hash->cache[i].crc,
+            (long long)hash->cache[i].size,
+            (long long)hash->cache[i].mtime,
+            RHMAP_KEY_STR(hash->cache, i));
+   }
+
+   filestream_close(file);
+
+   filestream_delete(hash->cache_path);
+   if (filestream_rename(tmp_path, hash->cache_path) != 0)
+      return false;
+
+   if (pruned)
+      RARCH_LOG("[Scanner]: Dropped %u stale entries from the hash cache.\n",
+            pruned);
+   return true;
+}
+
+/* Called with the lock held */
+static void database_hash_save(database_hash_t *hash, const char *prune_dir)
+{
+   if (string_is_empty(hash->cache_path))
+      return;
+
+   if (!prune_dir && !hash->pending_len && !hash->resume_dirty)
+      return;
+
+   if (!prune_dir && hash->appendable && path_is_valid(hash->cache_path))
+   {
+      if (!database_hash_append(hash))
+         return;
+   }
+   else
+   {
+      if (!(hash->appendable = database_hash_rewrite(hash, prune_dir)))
+         return;
+   }
+
+   hash->pending_len  = 0;
+   hash->dirty        = 0;
+   hash->resume_dirty = false;
+   hash->last_save    = cpu_features_get_time_usec();
+}
+
+database_hash_t *database_hash_new(const char *cache_path,
+      const struct string_list *list, database_hash_filter_t filter)
+{
+   size_t i;
+   database_hash_t *hash = (database_hash_t*)calloc(1, sizeof(*hash));
+
+   if (!hash)
+      return NULL;
+
+   hash->count           = list ? list->size : 0;
+   if (hash->count)
+   {
+      hash->paths        = (char**)calloc(hash->count, sizeof(char*));
+      hash->states       = (uint8_t*)calloc(hash->count, sizeof(uint8_t));
+      hash->crcs         = (uint32_t*)calloc(hash->count, sizeof(uint32_t));
+      if (!hash->paths || !hash->states || !hash->crcs)
+         goto error;
+
+      for (i = 0; i < hash->count; i++)
+      {
+         const char *path = list->elems[i].data;
+         if (!string_is_empty(path) && (!filter || filter(path)))
+            hash->paths[i] = strdup(path);
+      }
+   }
+
+#ifdef HAVE_THREADS
+   if (     !(hash->lock = slock_new())
+         || !(hash->cond = scond_new()))
+      goto error;
+#endif
+
+   if (!string_is_empty(cache_path))
+   {
+      hash->cache_path   = strdup(cache_path);
+      database_hash_load(hash);
+   }
+
+   hash->last_save       = cpu_features_get_time_usec();
+   return hash;
+
+error:
+   database_hash_free(hash);
+   return NULL;
+}
+
+size_t database_hash_get_resume(database_hash_t *hash,
+      const char *scan_path)
+{
+   /* Only if the list didn't change since */
+   if (     hash
+         && hash->resume_scan_path
+         && hash->resume_index  < hash->count
+         && hash->resume_count == hash->count
+         && string_is_equal(hash->resume_scan_path, scan_path)
+         && hash->paths[hash->resume_index]
+         && string_is_equal(hash->resume_entry,
+               hash->paths[hash->resume_index]))
+      return hash->resume_index;
+   return 0;
+}
+
+void database_hash_clear_resume(database_hash_t *hash)
+{
+   if (!hash)
+      return;
+
+   database_hash_lock(hash);
+   free(hash->resume_scan_path);
+   free(hash->resume_entry);
+   hash->resume_scan_path = NULL;
+   hash->resume_entry     = NULL;
+   hash->resume_dirty     = true;
+   database_hash_unlock(hash);
+}
+
+void database_hash_start(database_hash_t *hash, size_t start,
+      unsigned threads)
+{
+   if (!hash)
+      return;
+
+   hash->start = start;
+   hash->next  = start;
+
+#ifdef HAVE_THREADS
+   if (threads && hash->count > start)
+   {
+      unsigned i;
+
+      if (!(hash->threads = (sthread_t**)calloc(threads, sizeof(sthread_t*))))
+         return;
+
+      for (i = 0; i < threads; i++)
+      {
+         if (!(hash->threads[i] = sthread_create(
+                     database_hash_thread, hash)))
+            break;
+         hash->num_threads++;
+      }
+   }
+#endif
+}
+
+bool database_hash_get_crc(database_hash_t *hash, size_t index,
+      const char *path, uint32_t *crc)
+{
+   bool ok;
+
+   if (!hash || string_is_empty(path))
+      return false;
+
+   if (!hash->buf && !(hash->buf = (uint8_t*)malloc(DATABASE_HASH_CHUNK_SIZE)))
+      return false;
+
+   /* Appended after the scan started (archive contents)
+    * or not hashed ahead */
+   if (     index >= hash->count
+         || !hash->paths[index]
+         || !string_is_equal(hash->paths[index], path))
+      return database_hash_compute(hash, path, hash->buf, crc);
+
+   database_hash_lock(hash);
+#ifdef HAVE_THREADS
+   while (hash->states[index] == DATABASE_HASH_BUSY)
+      scond_wait(hash->cond, hash->lock);
+#endif
+
+   switch (hash->states[index])
+   {
+      case DATABASE_HASH_DONE:
+         *crc = hash->crcs[index];
+         database_hash_unlock(hash);
+         return true;
+      case DATABASE_HASH_FAILED:
+         database_hash_unlock(hash);
+         return false;
+      default:
+         break;
+   }
+
+   /* The workers haven't got there yet, don't wait for them */
+   hash->states[index] = DATABASE_HASH_BUSY;
+   database_hash_unlock(hash);
+
+   ok = database_hash_compute(hash, path, hash->buf, crc);
+
+   database_hash_lock(hash);
+   hash->crcs[index]   = *crc;
+   hash->states[index] = ok ? DATABASE_HASH_DONE : DATABASE_HASH_FAILED;
+#ifdef HAVE_THREADS
+   scond_broadcast(hash->cond);
+#endif
+   database_hash_unlock(hash);
+
+   return ok;
+}
+
+void database_hash_checkpoint(database_hash_t *hash,
+      const char *scan_path, size_t index, bool finished)
+{
+   if (!hash)
+      return;
+
+   database_hash_lock(hash);
+
+   free(hash->resume_scan_path);
+   free(hash->resume_entry);
+   hash->resume_scan_path = NULL;
+   hash->resume_entry     = NULL;
+   hash->resume_dirty     = true;
+
+   /* Resuming is only possible within the original list */
+   if (     !finished
+         && index < hash->count
+         && hash->paths[index]
+         && !string_is_empty(scan_path))
+   {
+      hash->resume_scan_path = strdup(scan_path);
+      hash->resume_entry     = strdup(hash->paths[index]);
+      hash->resume_index     = index;
+      hash->resume_count     = hash->count;
+   }
+
+   /* A resumed scan never came across the files before
+    * its start, so it can't tell which entries went stale */
+   if (finished)
+      database_hash_save(hash, hash->start ? NULL : scan_path);
+   else if (hash->dirty >= DATABASE_HASH_SAVE_FILES
+         || (hash->dirty && cpu_features_get_time_usec()
+            - hash->last_save >= DATABASE_HASH_SAVE_INTERVAL))
+      database_hash_save(hash, NULL);
+
+   database_hash_unlock(hash);
+}
+
+void database_hash_get_stats(database_hash_t *hash,
+      struct database_hash_stats *stats)
+{
+   if (!hash)
+   {
+      memset(stats, 0, sizeof(*stats));
+      return;
+   }
+
+   database_hash_lock(hash);
+   *stats = hash->stats;
+   database_hash_unlock(hash);
+}
+
+void database_hash_free(database_hash_t *hash)
+{
+   size_t i;
+
+   if (!hash)
+      return;
+
+#ifdef HAVE_THREADS
+   if (hash->lock)
+   {
+      slock_lock(hash->lock);
+      hash->quit = true;
+      slock_unlock(hash->lock);
+   }
+
+   for (i = 0; i < hash->num_threads; i++)
+      sthread_join(hash->threads[i]);
+   free(hash->threads);
+#endif
+
+   database_hash_lock(hash);
+   database_hash_save(hash, NULL);
+   database_hash_unlock(hash);
+
+#ifdef HAVE_THREADS
+   if (hash->cond)
+      scond_free(hash->cond);
+   if (hash->lock)
+      slock_free(hash->lock);
+#endif
+
+   if (hash->paths)
+      for (i = 0; i < hash->count; i++)
+         free(hash->paths[i]);
+
+   RHMAP_FREE(hash->cache);
+   free(hash->paths);
+   free(hash->states);
+   free(hash->crcs);
+   free(hash->buf);
+   free(hash->cache_path);
+   free(hash->pending);
+   free(hash->resume_scan_path);
+   free(hash->resume_entry);
+   free(hash);
+}
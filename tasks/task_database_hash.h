@@ -0,0 +1,125 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TASK_DATABASE_HASH
+#define TASK_DATABASE_HASH
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <lists/string_list.h>
+
+RETRO_BEGIN_DECLS
+
+/* Name of the hash cache, kept in the playlist directory */
+#define DATABASE_HASH_CACHE_FILE "content_scan.hashcache"
+
+/* Hashes the files of a content scan ahead of the scanner on
+ * worker threads, and remembers their CRCs across scans, keyed
+ * by path, size and modification time.
+ *
+ * The cache also holds where an interrupted scan stopped, so
+ * that a scan of the same path asked to resume picks up from
+ * there. */
+typedef struct database_hash database_hash_t;
+
+/* Returns true for entries of the scan list whose whole
+ * file CRC the scanner will ask for */
+typedef bool (*database_hash_filter_t)(const char *path);
+
+struct database_hash_stats
+{
+   uint64_t bytes;    /* Read from disk for hashing */
+   unsigned hashed;   /* Files read and hashed */
+   unsigned cached;   /* Files whose CRC came from the cache */
+};
+
+/**
+ * database_hash_new:
+ * @cache_path : Path of the hash cache file, can be NULL.
+ * @list       : Scan list, copied: entries appended to it later
+ *               are hashed on demand.
+ * @filter     : Selects the entries to hash ahead.
+ *
+ * Loads the cache. Hashing starts with database_hash_start().
+ **/
+database_hash_t *database_hash_new(const char *cache_path,
+      const struct string_list *list, database_hash_filter_t filter);
+
+/**
+ * database_hash_get_resume:
+ *
+ * Returns: index at which a previous scan of @scan_path over the
+ * same list was interrupted, or 0.
+ **/
+size_t database_hash_get_resume(database_hash_t *hash,
+      const char *scan_path);
+
+/**
+ * database_hash_clear_resume:
+ *
+ * Forgets where a previous scan was interrupted, for a scan
+ * that starts over.
+ **/
+void database_hash_clear_resume(database_hash_t *hash);
+
+/**
+ * database_hash_start:
+ * @start   : First index of the list to hash.
+ * @threads : Number of worker threads, 0 to hash on demand only.
+ **/
+void database_hash_start(database_hash_t *hash, size_t start,
+      unsigned threads);
+
+/**
+ * database_hash_get_crc:
+ * @index : Index of @path in the scan list.
+ *
+ * Gets the CRC32 of the whole file, from the cache, from a worker
+ * (waiting for it if it's busy with that file) or by hashing the
+ * file right away.
+ *
+ * Returns: true on success, false if the file couldn't be read.
+ **/
+bool database_hash_get_crc(database_hash_t *hash, size_t index,
+      const char *path, uint32_t *crc);
+
+/**
+ * database_hash_checkpoint:
+ * @index    : Next index the scanner will process.
+ * @finished : True once the scan is complete.
+ *
+ * Records scan progress; appends new CRCs to the cache every few
+ * hundred files or seconds. Once the scan is finished the cache
+ * is rewritten, leaving out entries below @scan_path for files
+ * the scan didn't come across.
+ **/
+void database_hash_checkpoint(database_hash_t *hash,
+      const char *scan_path, size_t index, bool finished);
+
+void database_hash_get_stats(database_hash_t *hash,
+      struct database_hash_stats *stats);
+
+/**
+ * database_hash_free:
+ *
+ * Stops the workers and writes the cache, keeping the last
+ * checkpoint so an unfinished scan can be resumed.
+ **/
+void database_hash_free(database_hash_t *hash);
+
+RETRO_END_DECLS
+
+#endif
@@ -325,6 +325,8 @@ static void *task_push_http_transfer_generic(
    t->cleanup              = task_http_transfer_cleanup;
    t->user_data            = user_data;
    t->progress             = -1;
+   t->priority             = TASK_PRIORITY_NETWORK;
+   t->parallel             = true;
 
    task_queue_push(t);
 
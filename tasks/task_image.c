@@ -25,6 +25,7 @@
 #include <features/features_cpu.h>
 
 #include "task_file_transfer.h"
+#include "task_image_cache.h"
 #include "tasks_internal.h"
 
 #include "../configuration.h"
@@ -42,7 +43,8 @@ enum image_flags_enum
 {
    IMAGE_FLAG_IS_BLOCKING                = (1 << 0),
    IMAGE_FLAG_IS_BLOCKING_ON_PROCESSING  = (1 << 1),
-   IMAGE_FLAG_IS_FINISHED                = (1 << 2)
+   IMAGE_FLAG_IS_FINISHED                = (1 << 2),
+   IMAGE_FLAG_CACHE                      = (1 << 3)
 };
 
 struct nbio_image_handle
@@ -50,6 +52,7 @@ struct nbio_image_handle
    void *handle;
    transfer_cb_t  cb;
    struct texture_image ti; /* ptr alignment */
+   struct image_cache_key cache_key;
    size_t size;
    int processing_final_state;
    unsigned frame_duration;
@@ -372,6 +375,9 @@ bool task_image_load_handler(retro_task_t *task)
             }
          }
 
+         if (image->flags & IMAGE_FLAG_CACHE)
+            image_cache_store(nbio->path, &image->cache_key, &image->ti);
+
          img->width         = image->ti.width;
          img->height        = image->ti.height;
          img->pixels        = image->ti.pixels;
@@ -386,13 +392,44 @@ bool task_image_load_handler(retro_task_t *task)
    return true;
 }
 
-bool task_push_image_load(const char *fullpath, 
+/* First iteration of image tasks when the image cache is
+ * enabled: a cached image is handed over as is, otherwise the
+ * source file gets loaded (and written to the cache) */
+static void task_image_load_cached_handler(retro_task_t *task)
+{
+   nbio_handle_t            *nbio  = (nbio_handle_t*)task->state;
+   struct nbio_image_handle *image = (struct nbio_image_handle*)nbio->data;
+   struct texture_image *img       = NULL;
+
+   task->handler = task_file_load_handler;
+
+   if (!image_cache_get_key(nbio->path, image->upscale_threshold,
+            &image->cache_key))
+      image->flags &= ~IMAGE_FLAG_CACHE;
+   else if ((img = (struct texture_image*)calloc(1, sizeof(*img))))
+   {
+      if (image_cache_load(nbio->path, &image->cache_key, img))
+      {
+         image->flags &= ~IMAGE_FLAG_CACHE;
+         task_set_data(task, img);
+         task_set_finished(task, true);
+         return;
+      }
+      free(img);
+   }
+
+   task_file_load_handler(task);
+}
+
+static bool task_push_image_load_internal(const char *fullpath,
       bool supports_rgba, unsigned upscale_threshold,
+      enum task_priority priority,
       retro_task_callback_t cb, void *user_data)
 {
    nbio_handle_t             *nbio   = NULL;
    struct nbio_image_handle   *image = NULL;
    retro_task_t                   *t = task_init();
+   settings_t                *settings = config_get_ptr();
 
    if (!t)
       return false;
@@ -431,6 +468,7 @@ bool task_push_image_load(const char *fullpath,
    image->size                       = 0;
    image->upscale_threshold          = upscale_threshold;
    image->handle                     = NULL;
+   image->flags                      = 0;
 
    image->ti.width                   = 0;
    image->ti.height                  = 0;
@@ -459,13 +497,38 @@ bool task_push_image_load(const char *fullpath,
 
    nbio->data          = (struct nbio_image_handle*)image;
 
+   image_cache_set_dir(settings->paths.directory_cache,
+         (uint64_t)settings->uints.image_cache_size << 20);
+   if (image_cache_is_enabled())
+      image->flags   |= IMAGE_FLAG_CACHE;
+
    t->state           = nbio;
-   t->handler         = task_file_load_handler;
+   t->handler         = (image->flags & IMAGE_FLAG_CACHE)
+      ? task_image_load_cached_handler
+      : task_file_load_handler;
    t->cleanup         = task_image_load_free;
    t->callback        = cb;
    t->user_data       = user_data;
+   t->priority        = priority;
+   t->parallel        = true;
 
    task_queue_push(t);
 
    return true;
 }
+
+bool task_push_image_load(const char *fullpath, 
+      bool supports_rgba, unsigned upscale_threshold,
+      retro_task_callback_t cb, void *user_data)
+{
+   return task_push_image_load_internal(fullpath, supports_rgba,
+         upscale_threshold, TASK_PRIORITY_INTERACTIVE, cb, user_data);
+}
+
+bool task_push_image_load_background(const char *fullpath,
+      bool supports_rgba, unsigned upscale_threshold,
+      retro_task_callback_t cb, void *user_data)
+{
+   return task_push_image_load_internal(fullpath, supports_rgba,
+         upscale_threshold, TASK_PRIORITY_BACKGROUND, cb, user_data);
+}
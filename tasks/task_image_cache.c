@@ -0,0 +1,533 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <array/rhmap.h>
+#include <compat/strl.h>
+#include <file/file_path.h>
+#include <retro_dirent.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "../verbosity.h"
+
+#include "task_image_cache.h"
+
+#define IMAGE_CACHE_MAGIC      "RAIMGCCH"
+#define IMAGE_CACHE_VERSION    1
+#define IMAGE_CACHE_BYTE_ORDER 0x01020304
+#define IMAGE_CACHE_MAX_DIM    16384
+
+/* Header of a cached image, in the byte order of the machine
+ * that wrote it (others fail the byte order check). The source
+ * path follows, then the pixels at 'pixels_offset', as 32-bit
+ * words in the layout image tasks hand to texture uploads. */
+struct image_cache_header
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t byte_order;
+   int64_t size;
+   int64_t mtime;
+   uint32_t upscale_threshold;
+   uint32_t width;
+   uint32_t height;
+   uint32_t supports_rgba;
+   uint32_t path_len;
+   uint32_t pixels_offset;
+};
+
+struct image_cache_entry
+{
+   uint64_t size;
+   int64_t last_used; /* Time of last use, or of writing */
+};
+
+struct image_cache_victim
+{
+   char name[24];
+   uint64_t size;
+   int64_t last_used;
+};
+
+struct image_cache_state
+{
+   struct image_cache_entry *entries; /* RHMAP keyed by file name */
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   struct image_cache_stats stats;
+   uint64_t max_size;
+   uint64_t total_size;
+   unsigned tmp_counter;
+   char dir[PATH_MAX_LENGTH];
+   bool scanned;
+};
+
+static struct image_cache_state image_cache_st;
+
+static void image_cache_lock(struct image_cache_state *st)
+{
+#ifdef HAVE_THREADS
+   slock_lock(st->lock);
+#endif
+}
+
+static void image_cache_unlock(struct image_cache_state *st)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(st->lock);
+#endif
+}
+
+/* 64-bit FNV-1a */
+static uint64_t image_cache_hash(uint64_t hash, const void *data, size_t len)
+{
+   const uint8_t *p = (const uint8_t*)data;
+
+   while (len--)
+   {
+      hash ^= *p++;
+      hash *= 0x100000001b3ULL;
+   }
+
+   return hash;
+}
+
+/* Copies the directory, which the main thread may change */
+static bool image_cache_get_dir(struct image_cache_state *st,
+      char *s, size_t len)
+{
+   image_cache_lock(st);
+   strlcpy(s, st->dir, len);
+   image_cache_unlock(st);
+   return !string_is_empty(s);
+}
+
+static void image_cache_forget(struct image_cache_state *st,
+      const char *name)
+{
+   ptrdiff_t idx = RHMAP_IDX_STR(st->entries, name);
+
+   if (idx >= 0)
+   {
+      st->total_size -= st->entries[idx].size;
+      (void)RHMAP_DEL_STR(st->entries, name);
+   }
+}
+
+/* Builds the index of the images already in the cache, the
+ * first time one is written; called with the lock held */
+static void image_cache_scan(struct image_cache_state *st)
+{
+   struct RDIR *dir;
+
+   st->scanned = true;
+
+   if (!path_is_directory(st->dir))
+   {
+      path_mkdir(st->dir);
+      return;
+   }
+
+   if (!(dir = retro_opendir(st->dir)))
+      return;
+
+   while (retro_readdir(dir))
+   {
+      char file_path[PATH_MAX_LENGTH];
+      struct image_cache_entry entry;
+      int64_t size, mtime;
+      const char *name = retro_dirent_get_name(dir);
+
+      if (retro_dirent_is_dir(dir, NULL))
+         continue;
+
+      fill_pathname_join_special(file_path, st->dir, name,
+            sizeof(file_path));
+
+      /* Left over by an interrupted write */
+      if (string_ends_with(name, ".tmp"))
+      {
+         filestream_delete(file_path);
+         continue;
+      }
+
+      if (     !string_ends_with(name, IMAGE_CACHE_FILE_EXTENSION)
+            || !path_get_size_mtime(file_path, &size, &mtime))
+         continue;
+
+      entry.size      = (uint64_t)size;
+      entry.last_used = mtime;
+      image_cache_forget(st, name);
+      RHMAP_SET_STR(st->entries, name, entry);
+      st->total_size += entry.size;
+   }
+
+   retro_closedir(dir);
+}
+
+static int image_cache_victim_cmp(const void *a, const void *b)
+{
+   const struct image_cache_victim *va = (const struct image_cache_victim*)a;
+   const struct image_cache_victim *vb = (const struct image_cache_victim*)b;
+
+   if (va->last_used != vb->last_used)
+      return (va->last_used < vb->last_used) ? -1 : 1;
+   return 0;
+}
+
+/* Deletes the least recently used images until the cache is
+ * back to 3/4 of its size limit; called with the lock held */
+static void image_cache_evict(struct image_cache_state *st)
+{
+   size_t i;
+   size_t count                      = 0;
+   size_t cap                        = RHMAP_CAP(st->entries);
+   uint64_t target                   = st->max_size - st->max_size / 4;
+   struct image_cache_victim *victims = (struct image_cache_victim*)
+      malloc(RHMAP_LEN(st->entries) * sizeof(*victims));
+
+   if (!victims)
+      return;
+
+   for (i = 0; i < cap; i++)
+   {
+      if (!RHMAP_KEY(st->entries, i))
+         continue;
+      strlcpy(victims[count].name, RHMAP_KEY_STR(st->entries, i),
+            sizeof(victims[count].name));
+      victims[count].size      = st->entries[i].size;
+      victims[count].last_used = st->entries[i].last_used;
+      count++;
+   }
+
+   qsort(victims, count, sizeof(*victims), image_cache_victim_cmp);
+
+   for (i = 0; i < count && st->total_size > target; i++)
+   {
+      char file_path[PATH_MAX_LENGTH];
+
+      fill_pathname_join_special(file_path, st->dir, victims[i].name,
+            sizeof(file_path));
+      filestream_delete(file_path);
+      image_cache_forget(st, victims[i].name);
+      st->stats.evictions++;
+   }
+
+   free(victims);
+}
+
+void image_cache_set_dir(const char *dir, uint64_t max_size)
+{
+   struct image_cache_state *st = &image_cache_st;
+   char cache_dir[PATH_MAX_LENGTH];
+
+   cache_dir[0] = '\0';
+
+   if (!string_is_empty(dir) && max_size)
+      fill_pathname_join_special(cache_dir, dir, IMAGE_CACHE_DIR,
+            sizeof(cache_dir));
+
+#ifdef HAVE_THREADS
+   if (!st->lock && !(st->lock = slock_new()))
+      return;
+#endif
+
+   image_cache_lock(st);
+
+   if (!string_is_equal(cache_dir, st->dir))
+   {
+      strlcpy(st->dir, cache_dir, sizeof(st->dir));
+      RHMAP_FREE(st->entries);
+      st->total_size = 0;
+      st->scanned    = false;
+   }
+
+   st->max_size = max_size;
+
+   image_cache_unlock(st);
+}
+
+bool image_cache_is_enabled(void)
+{
+   /* Only changed on the main thread */
+   return !string_is_empty(image_cache_st.dir);
+}
+
+bool image_cache_get_key(const char *path, unsigned upscale_threshold,
+      struct image_cache_key *key)
+{
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   if (   string_is_empty(path)
+       || !path_get_size_mtime(path, &key->size, &key->mtime))
+      return false;
+
+   key->upscale_threshold = upscale_threshold;
+
+   hash = image_cache_hash(hash, path, strlen(path));
+   hash = image_cache_hash(hash, &key->size, sizeof(key->size));
+   hash = image_cache_hash(hash, &key->mtime, sizeof(key->mtime));
+   hash = image_cache_hash(hash, &upscale_threshold,
+         sizeof(upscale_threshold));
+
+   snprintf(key->name, sizeof(key->name), "%08x%08x"
+         IMAGE_CACHE_FILE_EXTENSION,
+         (unsigned)(hash >> 32), (unsigned)(hash & 0xffffffff));
+   return true;
+}
+
+bool image_cache_load(const char *path, const struct image_cache_key *key,
+      struct texture_image *img)
+{
+   struct image_cache_header header;
+   char file_path[PATH_MAX_LENGTH];
+   char src_path[PATH_MAX_LENGTH];
+   struct image_cache_state *st = &image_cache_st;
+   size_t path_len              = strlen(path);
+   size_t pixels_size           = 0;
+   uint32_t *pixels             = NULL;
+   RFILE *file                  = NULL;
+   bool found                   = false;
+
+   if (!image_cache_get_dir(st, file_path, sizeof(file_path)))
+      return false;
+
+   fill_pathname_join_special(file_path, file_path, key->name,
+         sizeof(file_path));
+
+   if (!(file = filestream_open(file_path, RETRO_VFS_FILE_ACCESS_READ,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      goto end;
+
+   found = true;
+
+   if (     filestream_read(file, &header, sizeof(header)) != sizeof(header)
+         || memcmp(header.magic, IMAGE_CACHE_MAGIC, sizeof(header.magic))
+         || header.version           != IMAGE_CACHE_VERSION
+         || header.byte_order        != IMAGE_CACHE_BYTE_ORDER
+         || header.size              != key->size
+         || header.mtime             != key->mtime
+         || header.upscale_threshold != key->upscale_threshold
+         || header.path_len          != path_len
+         || header.path_len          >= sizeof(src_path)
+         || header.pixels_offset     <  sizeof(header) + header.path_len
+         || header.width  < 1 || header.width  > IMAGE_CACHE_MAX_DIM
+         || header.height < 1 || header.height > IMAGE_CACHE_MAX_DIM)
+      goto end;
+
+   /* Another image with the same key */
+   if (     filestream_read(file, src_path, path_len) != (int64_t)path_len
+         || memcmp(src_path, path, path_len))
+   {
+      found = false;
+      goto end;
+   }
+
+   pixels_size = (size_t)header.width * header.height * sizeof(uint32_t);
+
+   /* Read straight into the buffer the texture upload takes */
+   if (     filestream_seek(file, header.pixels_offset,
+               RETRO_VFS_SEEK_POSITION_START) != 0
+         || !(pixels = (uint32_t*)malloc(pixels_size))
+         || filestream_read(file, pixels, pixels_size) != (int64_t)pixels_size)
+      goto end;
+
+   img->pixels        = pixels;
+   img->width         = header.width;
+   img->height        = header.height;
+   img->supports_rgba = header.supports_rgba ? true : false;
+   pixels             = NULL;
+
+end:
+   if (file)
+      filestream_close(file);
+   free(pixels);
+
+   image_cache_lock(st);
+
+   if (found && !img->pixels)
+   {
+      /* Broken or outdated, it gets written again */
+      filestream_delete(file_path);
+      image_cache_forget(st, key->name);
+   }
+
+   if (found && img->pixels)
+   {
+      ptrdiff_t idx = RHMAP_IDX_STR(st->entries, key->name);
+
+      if (idx >= 0)
+         st->entries[idx].last_used = (int64_t)time(NULL);
+
+      st->stats.hits++;
+      st->stats.bytes_read  += pixels_size;
+      st->stats.bytes_saved += (uint64_t)key->size;
+   }
+   else
+      st->stats.misses++;
+
+   image_cache_unlock(st);
+
+   return found && img->pixels;
+}
+
+void image_cache_store(const char *path, const struct image_cache_key *key,
+      const struct texture_image *img)
+{
+   struct image_cache_header header;
+   struct image_cache_entry entry;
+   char dir[PATH_MAX_LENGTH];
+   char file_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH + 16];
+   static const uint8_t padding[16] = {0};
+   struct image_cache_state *st     = &image_cache_st;
+   size_t path_len                  = strlen(path);
+   size_t pixels_size;
+   unsigned tmp_counter;
+   RFILE *file;
+   bool written;
+
+   if (     !img->pixels
+         || img->width  < 1 || img->width  > IMAGE_CACHE_MAX_DIM
+         || img->height < 1 || img->height > IMAGE_CACHE_MAX_DIM
+         || path_len >= PATH_MAX_LENGTH)
+      return;
+
+   image_cache_lock(st);
+   if (!string_is_empty(st->dir) && !st->scanned)
+      image_cache_scan(st);
+   strlcpy(dir, st->dir, sizeof(dir));
+   tmp_counter = st->tmp_counter++;
+   image_cache_unlock(st);
+
+   if (string_is_empty(dir))
+      return;
+
+   pixels_size = (size_t)img->width * img->height * sizeof(uint32_t);
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, IMAGE_CACHE_MAGIC, sizeof(header.magic));
+   header.version           = IMAGE_CACHE_VERSION;
+   header.byte_order        = IMAGE_CACHE_BYTE_ORDER;
+   header.size              = key->size;
+   header.mtime             = key->mtime;
+   header.upscale_threshold = key->upscale_threshold;
+   header.width             = img->width;
+   header.height            = img->height;
+   header.supports_rgba     = img->supports_rgba ? 1 : 0;
+   header.path_len          = (uint32_t)path_len;
+   /* Pixels start 16 byte aligned in the file */
+   header.pixels_offset     = (uint32_t)((sizeof(header) + path_len + 15)
+         & ~(size_t)15);
+
+   fill_pathname_join_special(file_path, dir, key->name, sizeof(file_path));
+   /* Unique, two tasks may write the same image */
+   snprintf(tmp_path, sizeof(tmp_path), "%s.%u.tmp", file_path, tmp_counter);
+
+   if (!(file = filestream_open(tmp_path, RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return;
+
+   written =
+         filestream_write(file, &header, sizeof(header)) == sizeof(header)
+      && filestream_write(file, path, path_len) == (int64_t)path_len
+      && filestream_write(file, padding,
+            header.pixels_offset - sizeof(header) - path_len)
+         == (int64_t)(header.pixels_offset - sizeof(header) - path_len)
+      && filestream_write(file, img->pixels, pixels_size)
+         == (int64_t)pixels_size;
+
+   if (filestream_close(file) != 0)
+      written = false;
+
+   image_cache_lock(st);
+
+   /* The directory changed while writing */
+   if (!string_is_equal(dir, st->dir))
+      written = false;
+
+   if (written)
+   {
+      filestream_delete(file_path);
+      written = (filestream_rename(tmp_path, file_path) == 0);
+   }
+
+   if (!written)
+      filestream_delete(tmp_path);
+   else
+   {
+      entry.size      = header.pixels_offset + (uint64_t)pixels_size;
+      entry.last_used = (int64_t)time(NULL);
+
+      image_cache_forget(st, key->name);
+      RHMAP_SET_STR(st->entries, key->name, entry);
+      st->total_size          += entry.size;
+      st->stats.bytes_written += entry.size;
+
+      if (st->total_size > st->max_size)
+         image_cache_evict(st);
+   }
+
+   image_cache_unlock(st);
+}
+
+void image_cache_get_stats(struct image_cache_stats *stats)
+{
+   struct image_cache_state *st = &image_cache_st;
+
+#ifdef HAVE_THREADS
+   if (!st->lock)
+   {
+      memset(stats, 0, sizeof(*stats));
+      return;
+   }
+#endif
+
+   image_cache_lock(st);
+   *stats = st->stats;
+   image_cache_unlock(st);
+}
+
+void image_cache_deinit(void)
+{
+   struct image_cache_state *st = &image_cache_st;
+   unsigned loads               = st->stats.hits + st->stats.misses;
+
+   if (loads)
+      RARCH_LOG("[Image Cache]: %u of %u image loads from the cache (%.1f%%), "
+            "%.1f MB of source images not decoded, %.1f MB read, "
+            "%.1f MB written, %u images evicted.\n",
+            st->stats.hits, loads, 100.0 * st->stats.hits / loads,
+            st->stats.bytes_saved   / (1024.0 * 1024.0),
+            st->stats.bytes_read    / (1024.0 * 1024.0),
+            st->stats.bytes_written / (1024.0 * 1024.0),
+            st->stats.evictions);
+
+   RHMAP_FREE(st->entries);
+#ifdef HAVE_THREADS
+   if (st->lock)
+      slock_free(st->lock);
+#endif
+   memset(st, 0, sizeof(*st));
+}
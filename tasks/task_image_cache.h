@@ -0,0 +1,106 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TASK_IMAGE_CACHE
+#define TASK_IMAGE_CACHE
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <formats/image.h>
+
+RETRO_BEGIN_DECLS
+
+/* Directory of the image cache, inside the cache directory */
+#define IMAGE_CACHE_DIR            "image_cache"
+#define IMAGE_CACHE_FILE_EXTENSION ".tex"
+
+/* Keeps images loaded by image tasks on disk, decoded and scaled
+ * the way they are handed to texture uploads, so that loading
+ * them again skips decoding. Images are keyed by path, size and
+ * modification time of the source file and by the upscale
+ * threshold. The least recently used images are deleted when
+ * the cache grows past its size limit. */
+struct image_cache_key
+{
+   int64_t size;               /* Of the source file */
+   int64_t mtime;
+   unsigned upscale_threshold;
+   char name[24];              /* Name of the cached image file */
+};
+
+struct image_cache_stats
+{
+   uint64_t bytes_read;        /* Pixels read from the cache */
+   uint64_t bytes_saved;       /* Source files not decoded */
+   uint64_t bytes_written;
+   unsigned hits;
+   unsigned misses;
+   unsigned evictions;
+};
+
+/**
+ * image_cache_set_dir:
+ * @dir      : Cache directory, NULL or empty to disable the cache.
+ * @max_size : Size limit of the cache, in bytes.
+ *
+ * Must be called on the main thread (task_push_image_load()
+ * does it with the current settings).
+ **/
+void image_cache_set_dir(const char *dir, uint64_t max_size);
+
+bool image_cache_is_enabled(void);
+
+/**
+ * image_cache_get_key:
+ * @path : Source image file.
+ *
+ * Returns: false if @path can't be read.
+ **/
+bool image_cache_get_key(const char *path, unsigned upscale_threshold,
+      struct image_cache_key *key);
+
+/**
+ * image_cache_load:
+ * @img : Filled with the cached image, whose pixels are
+ *        released with image_texture_free().
+ *
+ * Returns: true on a cache hit.
+ **/
+bool image_cache_load(const char *path, const struct image_cache_key *key,
+      struct texture_image *img);
+
+/**
+ * image_cache_store:
+ *
+ * Writes @img to the cache, then deletes the least recently
+ * used images if the cache is over its size limit.
+ **/
+void image_cache_store(const char *path, const struct image_cache_key *key,
+      const struct texture_image *img);
+
+void image_cache_get_stats(struct image_cache_stats *stats);
+
+/**
+ * image_cache_deinit:
+ *
+ * Logs the cache statistics and frees the index. No image task
+ * may be running.
+ **/
+void image_cache_deinit(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -20,23 +20,53 @@
 #include <string.h>
 #include <ctype.h>
 
+#include <features/features_cpu.h>
+#include <retro_miscellaneous.h>
+#include <retro_timers.h>
 #include <string/stdstring.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "tasks_internal.h"
 
 #include "../menu/menu_driver.h"
+#include "../verbosity.h"
 
 typedef struct menu_explore_init_handle
 {
    explore_state_t *state;
+   explore_build_t *build;
    char *directory_playlist;
    char *directory_database;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   retro_time_t start_time;
+   size_t scan_count;
+   size_t scan_next;       /* Next database to scan */
+   unsigned helpers;       /* Helper tasks not done yet */
+   bool cancelled;
 } menu_explore_init_handle_t;
 
 /*********************/
 /* Utility Functions */
 /*********************/
 
+static void menu_explore_init_lock(menu_explore_init_handle_t *menu_explore)
+{
+#ifdef HAVE_THREADS
+   slock_lock(menu_explore->lock);
+#endif
+}
+
+static void menu_explore_init_unlock(menu_explore_init_handle_t *menu_explore)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(menu_explore->lock);
+#endif
+}
+
 static void free_menu_explore_init_handle(
       menu_explore_init_handle_t *menu_explore)
 {
@@ -62,6 +92,14 @@ static void free_menu_explore_init_handle(
       menu_explore->state = NULL;
    }
 
+   menu_explore_build_free(menu_explore->build);
+   menu_explore->build = NULL;
+
+#ifdef HAVE_THREADS
+   if (menu_explore->lock)
+      slock_free(menu_explore->lock);
+#endif
+
    free(menu_explore);
    menu_explore = NULL;
 }
@@ -80,6 +118,11 @@ static void cb_task_menu_explore_init(
    if (!(menu_explore = (menu_explore_init_handle_t*)task->state))
       return;
 
+   if (menu_explore->state)
+      RARCH_LOG("[Explore]: List ready %u ms after it was requested.\n",
+            (unsigned)((cpu_features_get_time_usec()
+                  - menu_explore->start_time) / 1000));
+
    /* Assign global menu explore state object */
    menu_explore_set_state(menu_explore->state);
    menu_explore->state = NULL;
@@ -128,25 +171,133 @@ static void task_menu_explore_init_free(retro_task_t *task)
 /* Explore Menu Initialisation */
 /*******************************/
 
+/* Scans databases until none are left to take */
+static void menu_explore_init_scan(menu_explore_init_handle_t *menu_explore,
+      retro_task_t *task)
+{
+   for (;;)
+   {
+      size_t i = 0;
+      bool got = false;
+
+      menu_explore_init_lock(menu_explore);
+      if (task_get_cancelled(task))
+         menu_explore->cancelled = true;
+      if (     !menu_explore->cancelled
+            && menu_explore->scan_next < menu_explore->scan_count)
+      {
+         i   = menu_explore->scan_next++;
+         got = true;
+      }
+      menu_explore_init_unlock(menu_explore);
+
+      if (!got)
+         break;
+
+      menu_explore_build_scan(menu_explore->build, i);
+   }
+}
+
+static void task_menu_explore_scan_handler(retro_task_t *task)
+{
+   if (task)
+   {
+      menu_explore_init_handle_t *menu_explore =
+         (menu_explore_init_handle_t*)task->state;
+
+      menu_explore_init_scan(menu_explore, task);
+
+      /* The handle isn't touched past this point, the
+       * init task only finishes once all helpers are done */
+      menu_explore_init_lock(menu_explore);
+      menu_explore->helpers--;
+      menu_explore_init_unlock(menu_explore);
+
+      task_set_finished(task, true);
+   }
+}
+
+/* Helpers scanning databases next to the init task, on
+ * other task workers */
+static void menu_explore_init_push_helpers(
+      menu_explore_init_handle_t *menu_explore)
+{
+#ifdef HAVE_THREADS
+   unsigned i, count;
+
+   if (     !task_queue_is_threaded()
+         || !(menu_explore->lock = slock_new()))
+      return;
+
+   count = (unsigned)MIN(task_queue_get_worker_count(),
+         menu_explore->scan_count);
+
+   for (i = 1; i < count; i++)
+   {
+      retro_task_t *task = task_init();
+
+      if (!task)
+         break;
+
+      task->handler      = task_menu_explore_scan_handler;
+      task->state        = menu_explore;
+      task->mute         = true;
+      task->title        = NULL;
+      task->progress     = 0;
+
+      menu_explore_init_lock(menu_explore);
+      menu_explore->helpers++;
+      menu_explore_init_unlock(menu_explore);
+
+      task_queue_push(task);
+   }
+#endif
+}
+
 static void task_menu_explore_init_handler(retro_task_t *task)
 {
    if (task)
    {
+      bool done                                = true;
       menu_explore_init_handle_t *menu_explore = NULL;
       if ((menu_explore = (menu_explore_init_handle_t*)task->state))
       {
-         if (!task_get_cancelled(task))
+         /* Playlists and the cache are read in one go, the
+          * databases the cache can't answer for are then
+          * scanned by this task and a few helpers */
+         if (!menu_explore->build && !task_get_cancelled(task))
          {
-            /* TODO/FIXME: It could be beneficial to
-             * initialise the explore menu iteratively,
-             * but this would require a non-trivial rewrite
-             * of the menu_explore code. For now, we will
-             * do it in a single shot (the most important
-             * consideration here is to place this
-             * initialisation on a background thread) */
-            menu_explore->state = menu_explore_build_list(
+            if ((menu_explore->build = menu_explore_build_begin(
                   menu_explore->directory_playlist,
-                  menu_explore->directory_database);
+                  menu_explore->directory_database)))
+            {
+               menu_explore->scan_count =
+                  menu_explore_build_get_scan_count(menu_explore->build);
+               menu_explore_init_push_helpers(menu_explore);
+            }
+         }
+
+         if (menu_explore->build)
+         {
+            menu_explore_init_scan(menu_explore, task);
+
+            menu_explore_init_lock(menu_explore);
+            done = (menu_explore->helpers == 0);
+            menu_explore_init_unlock(menu_explore);
+
+            if (!done)
+            {
+               /* Helpers are finishing their last database */
+               retro_sleep(1);
+               return;
+            }
+
+            if (!menu_explore->cancelled)
+            {
+               menu_explore->state = menu_explore_build_end(
+                     menu_explore->build);
+               menu_explore->build = NULL;
+            }
 
             task_set_progress(task, 100);
          }
@@ -192,6 +343,7 @@ bool task_push_menu_explore_init(const char *directory_playlist,
 
    /* Configure handle */
    menu_explore->state              = NULL;
+   menu_explore->start_time         = cpu_features_get_time_usec();
    menu_explore->directory_playlist = strdup(directory_playlist);
    menu_explore->directory_database = strdup(directory_database);
 
@@ -572,6 +572,7 @@ bool task_push_pl_thumbnail_download(
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->alternative_look        = true;
+   task->priority                = TASK_PRIORITY_BACKGROUND;
    task->progress                = 0;
    
    task_queue_push(task);
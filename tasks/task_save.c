@@ -20,6 +20,7 @@
 #include <time.h>
 
 #include <compat/strl.h>
+#include <features/features_cpu.h>
 #include <lists/string_list.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
@@ -59,6 +60,14 @@
 #define SAVE_STATE_CHUNK 4096
 #endif
 
+/* Written per iteration when compression threads
+ * are running, so that each write hands a whole
+ * chunk over to them */
+#define SAVE_STATE_THREADED_CHUNK 131072
+
+/* Threads compressing a state file, at most */
+#define SAVE_STATE_COMPRESSION_THREADS 8
+
 #define RASTATE_VERSION 1
 #define RASTATE_MEM_BLOCK "MEM "
 #define RASTATE_CHEEVOS_BLOCK "ACHV"
@@ -94,7 +103,8 @@ enum save_task_state_flags
    SAVE_TASK_FLAG_MUTE                  = (1 << 4),
    SAVE_TASK_FLAG_THUMBNAIL_ENABLE      = (1 << 5),
    SAVE_TASK_FLAG_HAS_VALID_FB          = (1 << 6),
-   SAVE_TASK_FLAG_COMPRESS_FILES        = (1 << 7)
+   SAVE_TASK_FLAG_COMPRESS_FILES        = (1 << 7),
+   SAVE_TASK_FLAG_COMPRESS_THREADS      = (1 << 8)
 };
 
 typedef struct
@@ -106,8 +116,11 @@ typedef struct
    ssize_t undo_size;
    ssize_t written;
    ssize_t bytes_read;
+   retro_time_t start_time;
+   /* Time spent by the main thread on this save */
+   retro_time_t stall_time;
    int state_slot;
-   uint8_t flags;
+   uint16_t flags;
    char path[PATH_MAX_LENGTH];
 } save_task_state_t;
 
@@ -299,15 +312,37 @@ static void task_save_handler_finished(retro_task_t *task,
       save_task_state_t *state)
 {
    save_task_state_t *task_data = NULL;
+   retro_time_t close_start      = cpu_features_get_time_usec();
 
    task_set_finished(task, true);
 
+   /* Waits for the last chunks to be compressed */
    intfstream_close(state->file);
    free(state->file);
 
+   if (!task_queue_is_threaded())
+      state->stall_time += cpu_features_get_time_usec() - close_start;
+
    if (!task_get_error(task) && task_get_cancelled(task))
       task_set_error(task, strdup("Task canceled"));
 
+   if (     (state->flags & SAVE_TASK_FLAG_COMPRESS_FILES)
+         && !task_get_error(task)
+         &&  state->written > 0)
+   {
+      retro_time_t elapsed = cpu_features_get_time_usec() - state->start_time;
+      RARCH_LOG("[State]: Compressed %.1f MB in %.1f ms (%.1f MB/s, %s),"
+            " main thread stalled for %.2f ms.\n",
+            state->written / (1024.0 * 1024.0),
+            elapsed / 1000.0,
+            elapsed > 0
+                  ? (state->written / (1024.0 * 1024.0)) / (elapsed / 1000000.0)
+                  : 0.0,
+            (state->flags & SAVE_TASK_FLAG_COMPRESS_THREADS)
+                  ? "threaded" : "single thread",
+            state->stall_time / 1000.0);
+   }
+
    task_data = (save_task_state_t*)calloc(1, sizeof(*task_data));
    memcpy(task_data, state, sizeof(*state));
 
@@ -482,12 +517,26 @@ static void task_save_handler(retro_task_t *task)
    ssize_t remaining;
    int written              = 0;
    save_task_state_t *state = (save_task_state_t*)task->state;
+   retro_time_t start       = cpu_features_get_time_usec();
 
    if (!state->file)
    {
       if (state->flags & SAVE_TASK_FLAG_COMPRESS_FILES)
+      {
          state->file   = intfstream_open_rzip_file(
                state->path, RETRO_VFS_FILE_ACCESS_WRITE);
+
+#ifdef HAVE_THREADS
+         /* Chunks are compressed on separate threads
+          * and written as they complete, so neither
+          * the main thread nor the task thread waits
+          * for zlib */
+         if (state->file && intfstream_set_compression_threads(
+               state->file, MIN(cpu_features_get_core_amount(),
+                  SAVE_STATE_COMPRESSION_THREADS)))
+            state->flags |= SAVE_TASK_FLAG_COMPRESS_THREADS;
+#endif
+      }
       else
          state->file   = intfstream_open_file(
                state->path, RETRO_VFS_FILE_ACCESS_WRITE,
@@ -495,6 +544,8 @@ static void task_save_handler(retro_task_t *task)
 
       if (!state->file)
          return;
+
+      state->start_time = start;
    }
 
    if (!state->data)
@@ -504,7 +555,10 @@ static void task_save_handler(retro_task_t *task)
       state->size = (ssize_t)size;
    }
 
-   remaining       = MIN(state->size - state->written, SAVE_STATE_CHUNK);
+   remaining       = MIN(state->size - state->written,
+         (state->flags & SAVE_TASK_FLAG_COMPRESS_THREADS)
+         ? MAX(SAVE_STATE_CHUNK, SAVE_STATE_THREADED_CHUNK)
+         : SAVE_STATE_CHUNK);
 
    if (state->data)
    {
@@ -513,6 +567,9 @@ static void task_save_handler(retro_task_t *task)
       state->written += written;
    }
 
+   if (!task_queue_is_threaded())
+      state->stall_time += cpu_features_get_time_usec() - start;
+
    task_set_progress(task, (state->written / (float)state->size) * 100);
 
    if (task_get_cancelled(task) || written != remaining)
@@ -1144,10 +1201,12 @@ static void save_state_cb(retro_task_t *task,
  * @path : file path of the save state
  * @data : the save state data to write
  * @size : the total size of the save state
+ * @stall_time : time the main thread spent serializing the state
  *
  * Create a new task to save the content state.
  **/
-static void task_push_save_state(const char *path, void *data, size_t size, bool autosave)
+static void task_push_save_state(const char *path, void *data, size_t size,
+      bool autosave, retro_time_t stall_time)
 {
    settings_t     *settings        = config_get_ptr();
    retro_task_t       *task        = task_init();
@@ -1160,6 +1219,7 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    strlcpy(state->path, path, sizeof(state->path));
    state->data                   = data;
    state->size                   = size;
+   state->stall_time             = stall_time;
    /* Don't show OSD messages if we are auto-saving */
    if (autosave)
       state->flags              |= (SAVE_TASK_FLAG_AUTOSAVE |
@@ -1233,7 +1293,7 @@ static void content_load_and_save_state_cb(retro_task_t *task,
 
    content_load_state_cb(task, task_data, user_data, error);
 
-   task_push_save_state(path, data, size, autosave);
+   task_push_save_state(path, data, size, autosave, load_data->stall_time);
 
    free(path);
 }
@@ -1244,12 +1304,14 @@ static void content_load_and_save_state_cb(retro_task_t *task,
  * @data : the save state data to write
  * @size : the total size of the save state
  * @load_to_backup_buffer : If true, the state will be loaded into undo_save_buf.
+ * @stall_time : time the main thread spent serializing the state
  *
  * Create a new task to load current state first into a backup buffer (for undo)
  * and then save the content state.
  **/
 static void task_push_load_and_save_state(const char *path, void *data,
-      size_t size, bool load_to_backup_buffer, bool autosave)
+      size_t size, bool load_to_backup_buffer, bool autosave,
+      retro_time_t stall_time)
 {
    retro_task_t      *task         = NULL;
    settings_t        *settings     = config_get_ptr();
@@ -1272,6 +1334,7 @@ static void task_push_load_and_save_state(const char *path, void *data,
       state->flags              |= SAVE_TASK_FLAG_LOAD_TO_BACKUP_BUFF;
    state->undo_size              = size;
    state->undo_data              = data;
+   state->stall_time             = stall_time;
    /* Don't show OSD messages if we are auto-saving */
    if (autosave)
       state->flags              |= (SAVE_TASK_FLAG_AUTOSAVE |
@@ -1341,7 +1404,15 @@ bool content_auto_save_state(const char *path)
 
 #if defined(HAVE_ZLIB)
    if (settings->bools.savestate_file_compression)
+   {
       file = intfstream_open_rzip_file(path, RETRO_VFS_FILE_ACCESS_WRITE);
+#ifdef HAVE_THREADS
+      if (file)
+         intfstream_set_compression_threads(file,
+               MIN(cpu_features_get_core_amount(),
+                  SAVE_STATE_COMPRESSION_THREADS));
+#endif
+   }
    else
 #endif
       file = intfstream_open_file(path, RETRO_VFS_FILE_ACCESS_WRITE,
@@ -1392,7 +1463,8 @@ bool content_auto_save_state(const char *path)
 bool content_save_state(const char *path, bool save_to_disk)
 {
    size_t serial_size;
-   void *data  = NULL;
+   void *data              = NULL;
+   retro_time_t stall_time = 0;
 
    if (!core_info_current_supports_savestate())
    {
@@ -1408,6 +1480,8 @@ bool content_save_state(const char *path, bool save_to_disk)
 
    if (!save_state_in_background)
    {
+      retro_time_t start = cpu_features_get_time_usec();
+
       if (!(data = content_get_serialized_data(&serial_size)))
       {
          RARCH_ERR("[State]: %s \"%s\".\n",
@@ -1421,6 +1495,8 @@ bool content_save_state(const char *path, bool save_to_disk)
             path,
             (unsigned)serial_size,
             msg_hash_to_str(MSG_BYTES));
+
+      stall_time = cpu_features_get_time_usec() - start;
    }
 
    if (save_to_disk)
@@ -1432,10 +1508,11 @@ bool content_save_state(const char *path, bool save_to_disk)
          /* TODO/FIXME - Use msg_hash_to_str here */
          RARCH_LOG("[State]: %s ...\n",
                msg_hash_to_str(MSG_FILE_ALREADY_EXISTS_SAVING_TO_BACKUP_BUFFER));
-         task_push_load_and_save_state(path, data, serial_size, true, false);
+         task_push_load_and_save_state(path, data, serial_size, true, false,
+               stall_time);
       }
       else
-         task_push_save_state(path, data, serial_size, false);
+         task_push_save_state(path, data, serial_size, false, stall_time);
    }
    else
    {
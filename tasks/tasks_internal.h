@@ -215,12 +215,21 @@ bool task_push_image_load(const char *fullpath,
       bool supports_rgba, unsigned upscale_threshold,
       retro_task_callback_t cb, void *userdata);
 
+/* Same as task_push_image_load(), for images loaded
+ * ahead of time: runs after interactive tasks */
+bool task_push_image_load_background(const char *fullpath,
+      bool supports_rgba, unsigned upscale_threshold,
+      retro_task_callback_t cb, void *userdata);
+
 #ifdef HAVE_LIBRETRODB
+/* @resume picks up where an interrupted scan of @fullpath
+ * stopped, otherwise the scan starts over */
 bool task_push_dbscan(
       const char *playlist_directory,
       const char *content_database,
       const char *fullpath,
       bool directory, bool show_hidden_files,
+      bool resume,
       retro_task_callback_t cb);
 #endif
 
@@ -1923,6 +1923,7 @@ void MainWindow::onFileBrowserTreeContextMenuRequested(const QPoint&)
          path_content_db,
          fullpath, true,
          m_settings->value("show_hidden_files", true).toBool(),
+         false,
          scan_finished_handler);
 #endif
 }